@@ -0,0 +1,50 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+
+// Keeps the optimizer from discarding a value computed inside a benchmark loop
+template <typename T>
+inline void DoNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+// Runs fn() `iterations` times (after a short warm-up) and returns ns per call
+template <typename Fn>
+double MeasureNsPerOp(size_t iterations, Fn&& fn)
+{
+    for (size_t i = 0; i < iterations / 10 + 1; i++) {
+        fn();
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        fn();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / (double)iterations;
+}
+
+inline void PrintResult(const char* name, double ns_per_op, const char* extra = "")
+{
+    printf("  %-40s %10.1f ns/op  %s\n", name, ns_per_op, extra);
+}
+
+// One entry per benchmark suite, see main.cpp
+void BenchSerializer();
+void BenchOutputBuffer();
+void BenchDatarefs();
+void BenchFrameStats();
+void BenchRegistration();
+void BenchRecorder();
+void BenchLanding();
+void BenchFlightPhase();
+void BenchTrack();
+void BenchSharedState();
+void BenchBinaryTelemetry();
+void BenchRref();
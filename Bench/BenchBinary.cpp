@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Bench.h"
+#include "BinaryTelemetry.h"
+
+namespace {
+
+#define BENCH_EARTH_RADIUS_M 6371008.8
+#define BENCH_DEG_TO_RAD 0.017453292519943295
+
+const TelemetrySource kSource = { "xp12", "12.320" };
+
+// Ten minutes at 60 fps: taxi, takeoff, a climbing turn, with the small
+// frame to frame noise a real sim has on attitude, frame rate and wind
+std::vector<TelemetrySnapshot> FrameRateFlight()
+{
+    std::minstd_rand rng(20);
+    std::normal_distribution<float> noise(0.0f, 1.0f);
+    std::vector<TelemetrySnapshot> frames;
+    double latitude = 45.63, longitude = 8.72, altitude = 230.0, heading = 350.0;
+    float fuel = 8000.0f;
+    for (int i = 0; i < 36000; i++) {
+        double t = i / 60.0;
+        bool on_ground = t < 240.0;
+        double knots = t < 180.0 ? 15.0 : t < 240.0 ? 15.0 + (t - 180.0) * 2.5 : 250.0;
+        double fpm = on_ground ? 0.0 : 2000.0;
+        double turn = t > 300.0 && t < 420.0 ? 1.5 : 0.0;
+
+        heading = std::fmod(heading + turn / 60.0 + 360.0, 360.0);
+        double speed = knots / MPS_TO_KNOTS;
+        latitude += speed * std::cos(heading * BENCH_DEG_TO_RAD) / 60.0 / BENCH_EARTH_RADIUS_M / BENCH_DEG_TO_RAD;
+        longitude += speed * std::sin(heading * BENCH_DEG_TO_RAD) / 60.0 / (BENCH_EARTH_RADIUS_M * std::cos(latitude * BENCH_DEG_TO_RAD)) / BENCH_DEG_TO_RAD;
+        altitude += fpm / 60.0 / METERS_TO_FT / 60.0;
+        fuel -= 0.7f / 60.0f;
+
+        TelemetrySnapshot s = {};
+        s.latitude = latitude;
+        s.longitude = longitude;
+        s.altitude_amsl = altitude;
+        s.altitude_agl = altitude - 230.0;
+        s.pitch = (on_ground ? 0.0f : 8.0f) + noise(rng) * 0.05f;
+        s.bank = (float)(turn * 15.0) + noise(rng) * 0.1f;
+        s.heading_true = (float)heading;
+        s.ground_speed = (float)speed;
+        s.vertical_speed = (float)fpm + noise(rng) * 20.0f;
+        s.fuel_kg = fuel;
+        s.gravity = 1.0f;
+        s.fps = 60.0f + noise(rng) * 2.0f;
+        s.time_acceleration = 1.0f;
+        s.parking_brake = t < 60.0 ? 1.0f : 0.0f;
+        s.wind_speed = 12.0f + noise(rng) * 0.3f;
+        s.wind_direction = 270.0f + noise(rng) * 2.0f;
+        s.transponder = 7000;
+        s.on_ground = on_ground;
+        s.engines_running = t > 30.0;
+        s.autopilot_engaged = t > 330.0;
+        frames.push_back(s);
+    }
+    return frames;
+}
+
+// What a consumer without the binary format does at the very least: find
+// each key and strtod its value
+double ScanJson(const char* json)
+{
+    double sum = 0.0;
+    for (const TelemetryField& field : kPositionSchema) {
+        char key[40];
+        snprintf(key, sizeof(key), "\"%.*s\":", (int)field.key.size(), field.key.data());
+        const char* at = strstr(json, key);
+        if (at != nullptr) {
+            at += strlen(key);
+            sum += *at == '"' ? atoi(at + 1) : *at == 't' ? 1.0 : strtod(at, nullptr);
+        }
+    }
+    return sum;
+}
+
+} // namespace
+
+void BenchBinaryTelemetry()
+{
+    std::vector<TelemetrySnapshot> frames = FrameRateFlight();
+
+    // Reference JSON for every frame, and the whole binary stream
+    std::vector<std::string> json(frames.size());
+    char buffer[TELEMETRY_MAX_MESSAGE];
+    size_t json_bytes = 0;
+    for (size_t i = 0; i < frames.size(); i++) {
+        size_t length = SerializePositionUpdate(frames[i], kSource, buffer, sizeof(buffer));
+        json[i].assign(buffer, length);
+        json_bytes += length + 1;
+    }
+
+    BinaryTelemetryEncoder encoder;
+    std::vector<uint8_t> stream(BINARY_TELEMETRY_MAX_RECORD);
+    stream.resize(encoder.Header(kSource, stream.data(), stream.size()));
+    size_t header_bytes = stream.size();
+    std::vector<size_t> record_end;
+    for (const TelemetrySnapshot& frame : frames) {
+        size_t at = stream.size();
+        stream.resize(at + BINARY_TELEMETRY_MAX_RECORD);
+        stream.resize(at + encoder.Position(frame, stream.data() + at, BINARY_TELEMETRY_MAX_RECORD));
+        record_end.push_back(stream.size());
+    }
+    size_t binary_bytes = stream.size() - header_bytes;
+
+    char extra[160];
+    snprintf(extra, sizeof(extra), "JSON %.1f B, binary %.1f B per frame (%.1fx smaller), %zu B header, key every %d",
+        (double)json_bytes / (double)frames.size(),
+        (double)binary_bytes / (double)frames.size(),
+        (double)json_bytes / (double)binary_bytes,
+        header_bytes,
+        BINARY_TELEMETRY_KEY_INTERVAL);
+    PrintResult("Frame size", 0.0, extra);
+
+    // Encoding
+    size_t next = 0;
+    double json_ns = MeasureNsPerOp(1000000, [&] {
+        DoNotOptimize(SerializePositionUpdate(frames[next], kSource, buffer, sizeof(buffer)));
+        next = next + 1 < frames.size() ? next + 1 : 0;
+    });
+    PrintResult("SerializePositionUpdate", json_ns);
+    BinaryTelemetryEncoder timed;
+    uint8_t record[BINARY_TELEMETRY_MAX_RECORD];
+    next = 0;
+    double encode_ns = MeasureNsPerOp(1000000, [&] {
+        DoNotOptimize(timed.Position(frames[next], record, sizeof(record)));
+        next = next + 1 < frames.size() ? next + 1 : 0;
+    });
+    PrintResult("BinaryTelemetryEncoder::Position", encode_ns);
+
+    // Decoding: the binary stream in order (deltas need their predecessor),
+    // against scanning the JSON
+    next = 0;
+    double scan_ns = MeasureNsPerOp(200000, [&] {
+        DoNotOptimize(ScanJson(json[next].c_str()));
+        next = next + 1 < frames.size() ? next + 1 : 0;
+    });
+    PrintResult("JSON key scan + strtod", scan_ns);
+    BinaryTelemetryDecoder decoder;
+    size_t offset = 0;
+    size_t used;
+    decoder.Next(stream.data(), stream.size(), used);
+    offset = used;
+    double decode_ns = MeasureNsPerOp(1000000, [&] {
+        if (offset == stream.size()) {
+            offset = header_bytes;  // the first record after the header is a key frame
+        }
+        DoNotOptimize(decoder.Next(stream.data() + offset, stream.size() - offset, used));
+        offset += used;
+    });
+    snprintf(extra, sizeof(extra), "%.0fx cheaper than the scan", scan_ns / decode_ns);
+    PrintResult("BinaryTelemetryDecoder::Next", decode_ns, extra);
+
+    // Round trip: every decoded frame must serialize to the original JSON
+    BinaryTelemetryDecoder check;
+    size_t mismatches = 0;
+    offset = 0;
+    check.Next(stream.data(), stream.size(), used);
+    offset = used;
+    for (size_t i = 0; i < frames.size(); i++) {
+        if (check.Next(stream.data() + offset, stream.size() - offset, used) != BinaryRecord::Position) {
+            mismatches++;
+        }
+        else {
+            size_t length = SerializePositionUpdate(check.Snapshot(), check.Source(), buffer, sizeof(buffer));
+            mismatches += json[i] != std::string_view(buffer, length);
+        }
+        offset += used;
+    }
+    snprintf(extra, sizeof(extra), "%zu of %zu frames differ from the original JSON", mismatches, frames.size());
+    PrintResult("Round trip", 0.0, extra);
+
+    // The converter on the stream in arbitrary chunks, as a socket delivers it
+    std::minstd_rand rng(7);
+    BinaryTelemetryDecoder converter;
+    std::string lines;
+    std::vector<uint8_t> pending;
+    bool ok = true;
+    for (size_t at = 0; at < stream.size() && ok;) {
+        size_t chunk = std::min<size_t>(1 + rng() % 1500, stream.size() - at);
+        pending.insert(pending.end(), stream.begin() + (long)at, stream.begin() + (long)(at + chunk));
+        at += chunk;
+        size_t consumed;
+        ok = ConvertBinaryTelemetry(converter, pending.data(), pending.size(), consumed, lines);
+        pending.erase(pending.begin(), pending.begin() + (long)consumed);
+    }
+    std::string expected;
+    for (const std::string& line : json) {
+        expected += line;
+        expected += '\n';
+    }
+    PrintResult("ConvertBinaryTelemetry (chunked)", 0.0, ok && lines == expected ? "identical to the JSON stream" : "DIFFERS");
+
+    // A subscriber that lost 5% of its records to a full queue: deltas after
+    // a gap are skipped until the next key frame, and nothing wrong comes out
+    BinaryTelemetryDecoder lossy;
+    size_t delivered = 0, skipped = 0, wrong = 0;
+    lossy.Next(stream.data(), stream.size(), used);
+    for (size_t i = 0; i < frames.size(); i++) {
+        size_t begin = i == 0 ? header_bytes : record_end[i - 1];
+        if (rng() % 20 == 0) {
+            continue;
+        }
+        BinaryRecord kind = lossy.Next(stream.data() + begin, record_end[i] - begin, used);
+        if (kind == BinaryRecord::Skipped) {
+            skipped++;
+        }
+        else if (kind == BinaryRecord::Position) {
+            delivered++;
+            size_t length = SerializePositionUpdate(lossy.Snapshot(), lossy.Source(), buffer, sizeof(buffer));
+            wrong += json[i] != std::string_view(buffer, length);
+        }
+    }
+    snprintf(extra, sizeof(extra), "%zu decoded, %zu skipped after gaps, %zu wrong", delivered, skipped, wrong);
+    PrintResult("5% of records dropped", 0.0, extra);
+
+    // Garbage must be refused, not crash or produce a position
+    size_t refused = 0, positions = 0, ignored = 0;
+    for (int trial = 0; trial < 10000; trial++) {
+        BinaryTelemetryDecoder fuzz;
+        fuzz.Next(stream.data(), header_bytes, used);
+        size_t begin = record_end[trial % 64];
+        size_t length = record_end[trial % 64 + 1] - begin;
+        std::vector<uint8_t> bad(stream.begin() + (long)begin, stream.begin() + (long)(begin + length));
+        bad[rng() % bad.size()] ^= (uint8_t)(1 + rng() % 255);
+        BinaryRecord kind = fuzz.Next(bad.data(), bad.size(), used);
+        refused += kind == BinaryRecord::Invalid || kind == BinaryRecord::NeedMore;
+        positions += kind == BinaryRecord::Position;
+        ignored += kind == BinaryRecord::Skipped || kind == BinaryRecord::Json || kind == BinaryRecord::Header;
+    }
+    // Flips inside a value still decode (to a wrong value): the format has
+    // no checksum, TCP does that
+    snprintf(extra, sizeof(extra), "10000 bit flips: %zu refused, %zu skipped or not a position, %zu decoded",
+        refused, ignored, positions);
+    PrintResult("Corruption", 0.0, extra);
+}
@@ -0,0 +1,114 @@
+#include <cstdio>
+
+#include "Bench.h"
+#include "DatarefRegistry.h"
+#include "Mock/XPLMMock.h"
+
+namespace {
+
+// What X-Plane would publish for the snapshot datarefs
+void PublishSampleDatarefs()
+{
+    MockResetDatarefs();
+    for (size_t i = 0; i < kSnapshotDatarefCount; i++) {
+        const DatarefSpec& spec = kSnapshotDatarefs[i];
+        switch (spec.source) {
+            case xplmType_Double: MockPublishDatad(spec.name, 45.0 + (double)i); break;
+            case xplmType_Float:  MockPublishDataf(spec.name, 1.5f * (float)i); break;
+            case xplmType_Int:    MockPublishDatai(spec.name, (int)i); break;
+            case xplmType_IntArray: {
+                int values[8] = { 0, 1, 0, 0, 0, 0, 0, 0 };
+                MockPublishDatavi(spec.name, values, 8);
+                break;
+            }
+        }
+    }
+}
+
+// The previous flight loop: one global and one scalar getter per field
+struct LegacyDatarefs {
+    XPLMDataRef lat, lon, alt_amsl, alt_agl, pitch, bank, heading, gs, vs, fuel_kg, gravity;
+    XPLMDataRef transponder, on_ground, slew, paused, replay, taccel, ap_engaged, eng_running, parking_brake;
+    XPLMDataRef wind_speed, wind_dir;
+
+    void Find()
+    {
+        lat = XPLMFindDataRef("sim/flightmodel/position/latitude");
+        lon = XPLMFindDataRef("sim/flightmodel/position/longitude");
+        alt_amsl = XPLMFindDataRef("sim/flightmodel/position/elevation");
+        alt_agl = XPLMFindDataRef("sim/flightmodel/position/y_agl");
+        pitch = XPLMFindDataRef("sim/flightmodel/position/theta");
+        bank = XPLMFindDataRef("sim/flightmodel/position/phi");
+        heading = XPLMFindDataRef("sim/flightmodel/position/psi");
+        gs = XPLMFindDataRef("sim/flightmodel/position/groundspeed");
+        vs = XPLMFindDataRef("sim/flightmodel/position/vh_ind_fpm");
+        fuel_kg = XPLMFindDataRef("sim/flightmodel/weight/m_fuel_total");
+        gravity = XPLMFindDataRef("sim/physics/gravity_normal");
+        transponder = XPLMFindDataRef("sim/cockpit/radios/transponder_code");
+        on_ground = XPLMFindDataRef("sim/flightmodel/failures/onground_any");
+        slew = XPLMFindDataRef("sim/operation/override/override_planepath");
+        paused = XPLMFindDataRef("sim/time/paused");
+        replay = XPLMFindDataRef("sim/operation/prefs/replay_mode");
+        taccel = XPLMFindDataRef("sim/time/time_accel");
+        ap_engaged = XPLMFindDataRef("sim/cockpit/autopilot/autopilot_mode");
+        eng_running = XPLMFindDataRef("sim/flightmodel/engine/ENGN_running");
+        parking_brake = XPLMFindDataRef("sim/cockpit2/controls/parking_brake_ratio");
+        wind_speed = XPLMFindDataRef("sim/weather/wind_speed_kt");
+        wind_dir = XPLMFindDataRef("sim/weather/wind_direction_degt");
+    }
+
+    void Read(TelemetrySnapshot& s) const
+    {
+        s.latitude = XPLMGetDatad(lat);
+        s.longitude = XPLMGetDatad(lon);
+        s.altitude_amsl = XPLMGetDatad(alt_amsl);
+        s.altitude_agl = XPLMGetDatad(alt_agl);
+        s.pitch = XPLMGetDataf(pitch);
+        s.bank = XPLMGetDataf(bank);
+        s.heading_true = XPLMGetDataf(heading);
+        s.ground_speed = XPLMGetDataf(gs);
+        s.vertical_speed = XPLMGetDataf(vs);
+        s.fuel_kg = XPLMGetDataf(fuel_kg);
+        s.gravity = XPLMGetDataf(gravity);
+        s.transponder = XPLMGetDatai(transponder);
+        s.on_ground = XPLMGetDatai(on_ground);
+        s.slew = XPLMGetDatai(slew);
+        s.paused = XPLMGetDatai(paused);
+        s.in_replay_mode = XPLMGetDatai(replay);
+        s.time_acceleration = XPLMGetDataf(taccel);
+        s.autopilot_engaged = XPLMGetDatai(ap_engaged);
+        s.engines_running = XPLMGetDatai(eng_running);
+        s.parking_brake = XPLMGetDataf(parking_brake);
+        s.wind_speed = XPLMGetDataf(wind_speed);
+        s.wind_direction = XPLMGetDataf(wind_dir);
+    }
+};
+
+} // namespace
+
+void BenchDatarefs()
+{
+    PublishSampleDatarefs();
+    char extra[96];
+
+    LegacyDatarefs legacy;
+    legacy.Find();
+    TelemetrySnapshot legacy_snapshot = {};
+    double legacy_ns = MeasureNsPerOp(2000000, [&] {
+        legacy.Read(legacy_snapshot);
+        DoNotOptimize(legacy_snapshot);
+    });
+    snprintf(extra, sizeof(extra), "engines_running=%d", (int)legacy_snapshot.engines_running);
+    PrintResult("scalar getters per global", legacy_ns, extra);
+
+    DatarefRegistry registry(kSnapshotDatarefs, kSnapshotDatarefCount);
+    registry.Resolve(NULL);
+    TelemetrySnapshot snapshot = {};
+    double registry_ns = MeasureNsPerOp(2000000, [&] {
+        registry.Read(&snapshot);
+        DoNotOptimize(snapshot);
+    });
+    snprintf(extra, sizeof(extra), "%zu datarefs, engines_running=%d",
+        registry.Resolved(), (int)snapshot.engines_running);
+    PrintResult("registry table read", registry_ns, extra);
+}
@@ -0,0 +1,102 @@
+#include <cstdio>
+#include <random>
+#include <string>
+
+#include "Bench.h"
+#include "FlightPhase.h"
+
+namespace {
+
+// A whole short flight at 10 Hz with noisy vertical speed and a bump on the
+// takeoff roll, as (duration, state) legs
+struct Leg {
+    double seconds;
+    float  agl_ft_start;
+    float  agl_ft_end;
+    float  knots;
+    int    on_ground;
+    int    engines;
+    float  brake;
+};
+
+const Leg kFlight[] = {
+    {  120,     0,     0,   0, 1, 0, 1.0f },   // parked, cold
+    {   60,     0,     0,   0, 1, 1, 1.0f },   // engines started, brake set
+    {  300,     0,     0,  15, 1, 1, 0.0f },   // taxi
+    {   60,     0,     0,   0, 1, 1, 0.0f },   // holding short
+    {   35,     0,     0, 100, 1, 1, 0.0f },   // takeoff roll
+    {  600,     0, 18000, 250, 0, 1, 0.0f },   // climb
+    { 1800, 18000, 18000, 420, 0, 1, 0.0f },   // cruise, turbulent
+    {  900, 18000,  1800, 300, 0, 1, 0.0f },   // descent
+    {   60,  1800,  1800, 200, 0, 1, 0.0f },   // level at the intercept altitude
+    {  150,  1800,     0, 140, 0, 1, 0.0f },   // final
+    {   25,     0,     0,  90, 1, 1, 0.0f },   // rollout
+    {  240,     0,     0,  15, 1, 1, 0.0f },   // taxi in
+    {   60,     0,     0,   0, 1, 0, 1.0f },   // shut down
+};
+
+const char* kExpected = "parked taxi takeoff climb cruise descent approach landed taxi parked";
+
+} // namespace
+
+void BenchFlightPhase()
+{
+    std::minstd_rand rng(3);
+    std::normal_distribution<float> turbulence(0.0f, 150.0f);
+
+    PhaseConfig config;
+    config.ground_speed_to_knots = 1.0f;
+    FlightPhaseTracker tracker(config);
+
+    std::string sequence;
+    size_t naive_changes = 0;
+    FlightPhase naive_last = FlightPhase::Unknown;
+    PhaseConfig undebounced = config;
+    undebounced.debounce_s = 0.0f;
+    undebounced.edge_debounce_s = 0.0f;
+    FlightPhaseTracker naive(undebounced);
+
+    double t = 0.0;
+    for (const Leg& leg : kFlight) {
+        for (double s = 0.0; s < leg.seconds; s += 0.1, t += 0.1) {
+            float progress = (float)(s / leg.seconds);
+            float agl = leg.agl_ft_start + (leg.agl_ft_end - leg.agl_ft_start) * progress;
+            TelemetrySnapshot snap = {};
+            snap.altitude_agl = agl / METERS_TO_FT;
+            snap.vertical_speed = (leg.agl_ft_end - leg.agl_ft_start) / (float)leg.seconds * 60.0f + (leg.on_ground ? 0.0f : turbulence(rng));
+            snap.ground_speed = leg.knots;
+            snap.on_ground = leg.on_ground;
+            snap.engines_running = leg.engines;
+            snap.parking_brake = leg.brake;
+            // A bump on the takeoff roll
+            if (leg.knots == 100 && s > 20.0 && s < 20.3) {
+                snap.on_ground = 0;
+            }
+            if (tracker.Update(snap, t)) {
+                if (!sequence.empty()) {
+                    sequence += ' ';
+                }
+                sequence += FlightPhaseName(tracker.Phase());
+            }
+            naive.Update(snap, t);
+            if (naive.Phase() != naive_last) {
+                naive_changes++;
+                naive_last = naive.Phase();
+            }
+        }
+    }
+
+    printf("  %-40s %s\n", "phases", sequence.c_str());
+    printf("  %-40s %s, %zu transitions without debounce\n", "", sequence == kExpected ? "as expected" : "UNEXPECTED", naive_changes);
+
+    TelemetrySnapshot cruise = {};
+    cruise.altitude_agl = 10000.0;
+    cruise.ground_speed = 420.0f;
+    cruise.engines_running = 1;
+    double now = 0.0;
+    double ns = MeasureNsPerOp(10000000, [&] {
+        now += 0.1;
+        DoNotOptimize(tracker.Update(cruise, now));
+    });
+    PrintResult("Update", ns);
+}
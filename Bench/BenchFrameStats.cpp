@@ -0,0 +1,46 @@
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "Bench.h"
+#include "FrameStats.h"
+
+void BenchFrameStats()
+{
+    // ~60 fps with jitter and an occasional stutter, like a loaded sim
+    std::minstd_rand rng(42);
+    std::normal_distribution<double> jitter(16.7, 1.5);
+    std::vector<double> frames(100000);
+    for (size_t i = 0; i < frames.size(); i++) {
+        double ms = jitter(rng);
+        if (rng() % 200 == 0) {
+            ms += 40.0 + (double)(rng() % 60);
+        }
+        frames[i] = std::max(ms, 1.0) / 1000.0;
+    }
+
+    FrameStats stats;
+    size_t next = 0;
+    double ns = MeasureNsPerOp(10000000, [&] {
+        stats.Record(frames[next]);
+        next = next + 1 < frames.size() ? next + 1 : 0;
+    });
+    PrintResult("Record", ns);
+
+    stats.ResetWindow();
+    for (double frame : frames) {
+        stats.Record(frame);
+    }
+    FramePercentiles p = stats.Window();
+
+    std::vector<double> sorted(frames);
+    std::sort(sorted.begin(), sorted.end());
+    auto exact = [&](double rank) { return sorted[(size_t)(rank * (double)(sorted.size() - 1))] * 1000.0; };
+
+    char extra[128];
+    snprintf(extra, sizeof(extra), "p50 %.2f/%.2f  p95 %.2f/%.2f  p99 %.2f/%.2f ms (histogram/exact)",
+        p.p50_ms, exact(0.50), p.p95_ms, exact(0.95), p.p99_ms, exact(0.99));
+    double window_ns = MeasureNsPerOp(10000, [&] { DoNotOptimize(stats.Window()); });
+    PrintResult("Window", window_ns, extra);
+}
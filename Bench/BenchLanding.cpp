@@ -0,0 +1,169 @@
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "Bench.h"
+#include "LandingDetector.h"
+
+namespace {
+
+#define FPM_PER_MPS (METERS_TO_FT * 60.0)
+
+// One synthetic landing: constant descent until the gear touches at
+// `contact_s`, then the oleos absorb it over ~`tau_s`. AGL is the CG height,
+// as y_agl is, with a little measurement noise.
+struct Touchdown {
+    double rate_fpm;
+    double contact_s;
+    double contact_agl_m = 2.5;
+    double tau_s = 0.15;
+
+    void Fill(double t, std::minstd_rand& rng, TelemetrySnapshot& s) const {
+        std::normal_distribution<double> noise(0.0, 0.01);
+        double v = rate_fpm / FPM_PER_MPS;
+        double agl, vs, g;
+        if (t < contact_s) {
+            agl = contact_agl_m + v * (t - contact_s);
+            vs = v;
+            g = 1.0;
+        }
+        else {
+            double decay = std::exp(-(t - contact_s) / tau_s);
+            agl = contact_agl_m + v * tau_s * (1.0 - decay);
+            vs = v * decay;
+            g = 1.0 - v * decay / tau_s / 9.81;
+        }
+        s = {};
+        s.altitude_agl = agl + noise(rng);
+        s.vertical_speed = (float)(vs * FPM_PER_MPS);
+        s.g_load = (float)g;
+        s.gear_deflection = (float)(agl < contact_agl_m ? contact_agl_m - agl : 0.0);
+        s.pitch = 3.0f;
+        s.ground_speed = 70.0f;
+        s.heading_true = 359.5f;
+        s.on_ground = t >= contact_s;
+    }
+};
+
+// What LandingRate.lua computes on the contact frame: current AGL against
+// the average of the last 30 frames, over half their time span
+struct LuaEstimator {
+    double agl[30];
+    double ts[30];
+    int count = 0;
+
+    void Push(double value, double t) {
+        for (int i = 29; i > 0; i--) {
+            agl[i] = agl[i - 1];
+            ts[i] = ts[i - 1];
+        }
+        agl[0] = value;
+        ts[0] = t;
+        count = count < 30 ? count + 1 : 30;
+    }
+
+    double Rate(double current) const {
+        double avg = 0.0;
+        for (int i = 0; i < count; i++) {
+            avg += agl[i];
+        }
+        avg /= count;
+        double slice = ts[0] - ts[count - 1];
+        return (current - avg) / (slice / 2.0) * FPM_PER_MPS;
+    }
+};
+
+struct ErrorStats {
+    double sum = 0.0;
+    double max = 0.0;
+    int n = 0;
+
+    void Add(double error) {
+        sum += std::fabs(error);
+        max = std::fabs(error) > max ? std::fabs(error) : max;
+        n++;
+    }
+};
+
+void RunLandings(double fps, const char* label)
+{
+    std::minstd_rand rng(7);
+    std::uniform_real_distribution<double> rate(-700.0, -50.0);
+    std::uniform_real_distribution<double> phase(0.0, 1.0);
+    std::uniform_real_distribution<double> jitter(0.9, 1.1);
+
+    ErrorStats detector, lua, dataref, detector_time, edge_time;
+    int missed = 0, extra = 0;
+    for (int landing = 0; landing < 1000; landing++) {
+        Touchdown td;
+        td.rate_fpm = rate(rng);
+        td.contact_s = 20.0 + phase(rng) / fps;
+
+        LandingDetector detect{ LandingConfig() };
+        LuaEstimator lua_ring;
+        int events = 0;
+        bool seen_edge = false;
+        TelemetrySnapshot s;
+
+        // Approach from 200 ft, then a few seconds of rollout
+        double t = 0.0;
+        td.Fill(t, rng, s);
+        s.altitude_agl = 200.0 / METERS_TO_FT;
+        s.on_ground = 0;
+        LandingEvent event;
+        detect.Update(s, t, event);
+        double prev_t = t;
+        for (t = td.contact_s - 3.0; t < td.contact_s + 3.0; t += jitter(rng) / fps) {
+            td.Fill(t, rng, s);
+            bool edge = s.on_ground && !seen_edge;
+            if (edge) {
+                seen_edge = true;
+                lua.Add(lua_ring.Rate(s.altitude_agl) - td.rate_fpm);
+                dataref.Add(s.vertical_speed - td.rate_fpm);
+                edge_time.Add((t - td.contact_s) * 1000.0);
+            }
+            lua_ring.Push(s.altitude_agl, t);
+            if (detect.Update(s, t, event)) {
+                events++;
+                detector.Add(event.landing_rate - td.rate_fpm);
+            }
+            if (edge) {
+                detector_time.Add((prev_t + detect.TouchdownOffset() - td.contact_s) * 1000.0);
+            }
+            prev_t = t;
+        }
+        missed += events == 0;
+        extra += events > 1;
+    }
+
+    char line[160];
+    snprintf(line, sizeof(line), "mean %.1f / max %.1f fpm error, %d missed, %d duplicate", detector.sum / detector.n, detector.max, missed, extra);
+    printf("  %-40s %s\n", label, line);
+    snprintf(line, sizeof(line), "touchdown instant mean %.2f / max %.2f ms off (contact frame: %.2f / %.2f ms)",
+        detector_time.sum / detector_time.n, detector_time.max, edge_time.sum / edge_time.n, edge_time.max);
+    printf("  %-40s %s\n", "", line);
+    snprintf(line, sizeof(line), "mean %.1f / max %.1f fpm error", lua.sum / lua.n, lua.max);
+    printf("  %-40s %s\n", "  LandingRate.lua (30 frame average)", line);
+    snprintf(line, sizeof(line), "mean %.1f / max %.1f fpm error", dataref.sum / dataref.n, dataref.max);
+    printf("  %-40s %s\n", "  vh_ind_fpm on the contact frame", line);
+}
+
+} // namespace
+
+void BenchLanding()
+{
+    RunLandings(60.0, "LandingDetector, 60 fps");
+    RunLandings(25.0, "LandingDetector, 25 fps");
+
+    // Per-frame cost while flying
+    LandingDetector detect{ LandingConfig() };
+    TelemetrySnapshot s = {};
+    s.altitude_agl = 300.0;
+    double t = 0.0;
+    LandingEvent event;
+    double ns = MeasureNsPerOp(10000000, [&] {
+        t += 1.0 / 60.0;
+        DoNotOptimize(detect.Update(s, t, event));
+    });
+    PrintResult("Update (airborne frame)", ns);
+}
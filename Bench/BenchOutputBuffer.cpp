@@ -0,0 +1,133 @@
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include "Bench.h"
+#include "OutputBuffer.h"
+#include "Telemetry.h"
+
+#ifdef _WIN32
+
+void BenchOutputBuffer()
+{
+    printf("  (needs socketpair, skipped on Windows)\n");
+}
+
+#else
+
+namespace {
+
+// Plays Volanta: reads the stream slowly through a tiny receive buffer and
+// checks that every newline terminated frame arrives whole
+struct SlowReader {
+    socket_t sock;
+    size_t frame_length;
+    std::atomic<bool> done{ false };
+    uint64_t frames = 0;
+    uint64_t torn = 0;
+
+    void Run()
+    {
+        char chunk[1024];
+        size_t current = 0;
+        for (;;) {
+            ssize_t received = recv(sock, chunk, sizeof(chunk), 0);
+            if (received <= 0) {
+                break;
+            }
+            for (ssize_t i = 0; i < received; i++) {
+                if (chunk[i] == '\n') {
+                    frames++;
+                    torn += current != frame_length ? 1 : 0;
+                    current = 0;
+                }
+                else {
+                    current++;
+                }
+            }
+        }
+        done = true;
+    }
+};
+
+TelemetrySnapshot SampleSnapshot()
+{
+    TelemetrySnapshot s = {};
+    s.latitude = 45.4697233;
+    s.longitude = 9.1762548;
+    s.altitude_amsl = 1250.5;
+    s.ground_speed = 140.2f;
+    s.heading_true = 271.4f;
+    s.engines_running = 1;
+    return s;
+}
+
+void RunCase(const char* name, size_t frames_per_flush, bool buffered)
+{
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    int small = 4096;
+    setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+    setsockopt(fds[1], SOL_SOCKET, SO_RCVBUF, &small, sizeof(small));
+    SetNonBlocking(fds[0]);
+
+    char json[TELEMETRY_MAX_MESSAGE];
+    const TelemetrySource source = { "xp12", "12.320" };
+    size_t length = SerializePositionUpdate(SampleSnapshot(), source, json, sizeof(json));
+
+    SlowReader reader;
+    reader.sock = fds[1];
+    reader.frame_length = length;
+    std::thread thread([&] { reader.Run(); });
+
+    OutputBuffer out(64 * 1024, 256, true);
+    uint64_t naive_sends = 0;
+    const size_t rounds = 20000;
+    double ns = MeasureNsPerOp(rounds, [&] {
+        if (buffered) {
+            for (size_t i = 0; i < frames_per_flush; i++) {
+                out.Append(json, length);
+            }
+            int error;
+            while (out.Flush(fds[0], error) == OutputBuffer::FlushResult::WouldBlock) {
+                struct pollfd pfd = { fds[0], POLLOUT, 0 };
+                poll(&pfd, 1, 100);
+            }
+        }
+        else {
+            // The old path: one send per message, whatever it manages to write
+            for (size_t i = 0; i < frames_per_flush; i++) {
+                send(fds[0], json, length, SOCKET_SEND_FLAGS);
+                send(fds[0], "\n", 1, SOCKET_SEND_FLAGS);
+                naive_sends += 2;
+            }
+        }
+    });
+
+    shutdown(fds[0], SHUT_WR);
+    thread.join();
+    close(fds[0]);
+    close(fds[1]);
+
+    const OutputBuffer::Counters& c = out.Stats();
+    uint64_t sends = buffered ? c.sends : naive_sends;
+    char extra[160];
+    snprintf(extra, sizeof(extra), "%.2f sends/delivered, %llu delivered, %llu torn",
+        (double)sends / (double)reader.frames,
+        (unsigned long long)reader.frames,
+        (unsigned long long)reader.torn);
+    PrintResult(name, ns / (double)frames_per_flush, extra);
+}
+
+} // namespace
+
+void BenchOutputBuffer()
+{
+    RunCase("direct send, 1 msg/round", 1, false);
+    RunCase("direct send, 4 msgs/round", 4, false);
+    RunCase("output buffer, 1 msg/flush", 1, true);
+    RunCase("output buffer, 4 msgs/flush", 4, true);
+}
+
+#endif
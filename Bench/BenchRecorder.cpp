@@ -0,0 +1,152 @@
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Bench.h"
+#include "FlightRecorder.h"
+#include "SpscRing.h"
+
+namespace {
+
+struct RecordedFrame {
+    double            now_s;
+    TelemetrySnapshot snapshot;
+};
+
+TelemetrySnapshot SampleSnapshot(size_t i)
+{
+    TelemetrySnapshot s = {};
+    s.latitude = 45.0 + (double)i * 1e-6;
+    s.longitude = 9.0 + (double)i * 1e-6;
+    s.altitude_amsl = 3000.0;
+    s.heading_true = 270.0f;
+    s.ground_speed = 120.0f;
+    s.transponder = 7000;
+    return s;
+}
+
+std::filesystem::path FreshDirectory()
+{
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "openvolanta-bench-recorder";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    return dir;
+}
+
+// Opens the single .ovr in `dir` and checks it the way a reader recovering
+// from a crash would: header count, then every slot's sequence number
+bool VerifySegment(const std::filesystem::path& dir, uint64_t expected, char* extra, size_t extra_size)
+{
+    for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+        std::ifstream in(entry.path(), std::ios::binary);
+        std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (data.size() < RECORDER_HEADER_SIZE) {
+            break;
+        }
+        RecorderHeader header;
+        memcpy(&header, data.data(), sizeof(header));
+        uint64_t valid = 0;
+        for (uint64_t i = 0; i < header.records; i++) {
+            RecorderRecord record;
+            size_t offset = RECORDER_HEADER_SIZE + (size_t)i * sizeof(RecorderRecord);
+            if (offset + sizeof(record) > data.size()) {
+                break;
+            }
+            memcpy(&record, data.data() + offset, sizeof(record));
+            valid += record.sequence == i + 1 && record.snapshot.transponder == 7000;
+        }
+        snprintf(extra, extra_size, "%llu/%llu records recovered, closed=%u, %zu fields, file %zu KB",
+            (unsigned long long)valid, (unsigned long long)expected, header.closed,
+            (size_t)header.field_count, data.size() / 1024);
+        return valid == expected && header.records == expected;
+    }
+    snprintf(extra, extra_size, "no segment written");
+    return false;
+}
+
+} // namespace
+
+void BenchRecorder()
+{
+    // Sim thread side: one queue push per frame
+    SpscRing<RecordedFrame, 1024> frames;
+    RecordedFrame frame = { 0.0, SampleSnapshot(0) };
+    double push_ns = MeasureNsPerOp(10000000, [&] {
+        frames.TryPush(frame);
+        RecordedFrame out;
+        frames.TryPop(out);
+        DoNotOptimize(out);
+    });
+    PrintResult("queue push + pop (per frame)", push_ns);
+
+    // Writer thread side, syncing only at the end
+    {
+        RecorderConfig config;
+        config.directory = FreshDirectory().string();
+        config.sync_interval_ms = 1000000;
+        FlightRecorder recorder(config);
+        size_t i = 0;
+        double ns = MeasureNsPerOp(200000, [&] {
+            recorder.Append(SampleSnapshot(i), (double)i / 60.0);
+            i++;
+        });
+        PrintResult("Append (mapped, unsynced)", ns);
+    }
+
+    // Every 250 ms at 60 fps: 15 new records per msync
+    {
+        RecorderConfig config;
+        config.directory = FreshDirectory().string();
+        FlightRecorder recorder(config);
+        size_t i = 0;
+        double ns = MeasureNsPerOp(400, [&] {
+            for (int k = 0; k < 15; k++, i++) {
+                recorder.Append(SampleSnapshot(i), (double)i / 60.0);
+            }
+            recorder.Sync(true);
+        });
+        char extra[96];
+        snprintf(extra, sizeof(extra), "%.2f ms max msync", (double)recorder.Counters().sync_ns_max / 1e6);
+        PrintResult("15 x Append + msync (250 ms at 60 fps)", ns, extra);
+    }
+
+    // The sim dies mid-flight: the child records and is SIGKILLed without
+    // closing, the parent recovers what it wrote
+    std::filesystem::path dir = FreshDirectory();
+    const uint64_t crash_records = 5000;
+    pid_t child = fork();
+    if (child == 0) {
+        RecorderConfig config;
+        config.directory = dir.string();
+        FlightRecorder recorder(config);
+        for (uint64_t i = 0; i < crash_records; i++) {
+            recorder.Append(SampleSnapshot(i), (double)i / 60.0);
+        }
+        kill(getpid(), SIGKILL);
+        _exit(1);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    char extra[160];
+    bool ok = VerifySegment(dir, crash_records, extra, sizeof(extra));
+    printf("  %-40s %10s        %s\n", "SIGKILL before Close", ok ? "ok" : "FAILED", extra);
+
+    {
+        RecorderConfig config;
+        config.directory = FreshDirectory().string();
+        FlightRecorder recorder(config);
+        for (uint64_t i = 0; i < crash_records; i++) {
+            recorder.Append(SampleSnapshot(i), (double)i / 60.0);
+        }
+        recorder.Close();
+        ok = VerifySegment(config.directory, crash_records, extra, sizeof(extra));
+        printf("  %-40s %10s        %s\n", "Close", ok ? "ok" : "FAILED", extra);
+    }
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,189 @@
+#include <cstdio>
+#include <cstring>
+#include <regex>
+#include <string>
+
+#include "Bench.h"
+#include "Registration.h"
+
+namespace {
+
+// Livery folders as they ship with the default fleet, ToLiSS, Zibo/LevelUp
+// 737 packs, FlightFactor and popular repaints, with the registration painted
+// on the aircraft ("" where the name doesn't carry one)
+struct LiveryCase {
+    const char* path;
+    const char* expected;
+};
+
+const LiveryCase kCorpus[] = {
+    { "Aircraft/Laminar Research/Boeing 737-800/liveries/Ryanair EI-DCL/", "EI-DCL" },
+    { "Aircraft/Laminar Research/Boeing 737-800/liveries/Southwest N8710M Heart/", "N8710M" },
+    { "Aircraft/Laminar Research/Boeing 737-800/liveries/KLM PH-BXA/", "PH-BXA" },
+    { "Aircraft/Laminar Research/Airbus A330-300/liveries/Delta N801NW/", "N801NW" },
+    { "Aircraft/Laminar Research/Airbus A330-300/liveries/Qantas VH-QPJ/", "VH-QPJ" },
+    { "Aircraft/Laminar Research/Airbus A330-300/liveries/Lufthansa D-AIKO/", "D-AIKO" },
+    { "Aircraft/Laminar Research/Cessna 172 SP/liveries/N2035K Blue/", "N2035K" },
+    { "Aircraft/Laminar Research/Cessna 172 SP/liveries/Default/", "" },
+    { "Aircraft/Laminar Research/Cirrus SR22/liveries/G-EGKM Orange/", "G-EGKM" },
+    { "Aircraft/Laminar Research/Boeing 747-400/liveries/British Airways G-CIVB Negus/", "G-CIVB" },
+    { "Aircraft/Laminar Research/Boeing 747-400/liveries/Cathay Pacific B-HUJ/", "B-HUJ" },
+    { "Aircraft/Laminar Research/Boeing 747-400/liveries/Air China B-2447/", "B-2447" },
+    { "Aircraft/Laminar Research/McDonnell Douglas MD-82/liveries/American N455AA/", "N455AA" },
+    { "Aircraft/Laminar Research/McDonnell Douglas MD-82/liveries/SAS SE-DIL/", "SE-DIL" },
+    { "Aircraft/ToLiSS A321/liveries/Wizz Air HA-LXK/", "HA-LXK" },
+    { "Aircraft/ToLiSS A321/liveries/Lufthansa D-AIDA (2018)/", "D-AIDA" },
+    { "Aircraft/ToLiSS A321/liveries/Turkish Airlines TC-JRO/", "TC-JRO" },
+    { "Aircraft/ToLiSS A321/liveries/Aeroflot VP-BOC/", "VP-BOC" },
+    { "Aircraft/ToLiSS A321/liveries/Vietnam Airlines VN-A321/", "VN-A321" },
+    { "Aircraft/ToLiSS A321/liveries/Middle East Airlines OD-MRO/", "OD-MRO" },
+    { "Aircraft/ToLiSS A321/liveries/Iberia Express EC-JLI/", "EC-JLI" },
+    { "Aircraft/ToLiSS A321/liveries/American Airlines N117AN/", "N117AN" },
+    { "Aircraft/ToLiSS A319/liveries/easyJet G-EZBA/", "G-EZBA" },
+    { "Aircraft/ToLiSS A319/liveries/Swiss HB-IPX/", "HB-IPX" },
+    { "Aircraft/ToLiSS A319/liveries/Air Canada C-FYKC/", "C-FYKC" },
+    { "Aircraft/ToLiSS A319/liveries/Frontier N952FR Flo the Flamingo/", "N952FR" },
+    { "Aircraft/ToLiSS A319/liveries/Tap Air Portugal CS-TTA/", "CS-TTA" },
+    { "Aircraft/ToLiSS A319/liveries/Air Malta 9H-AEJ/", "9H-AEJ" },
+    { "Aircraft/ToLiSS A319/liveries/Brussels Airlines OO-SSC/", "OO-SSC" },
+    { "Aircraft/ToLiSS A319/liveries/Czech Airlines OK-NEP/", "OK-NEP" },
+    { "Aircraft/ToLiSS A320neo/liveries/IndiGo VT-ITA/", "VT-ITA" },
+    { "Aircraft/ToLiSS A320neo/liveries/ANA JA211A/", "JA211A" },
+    { "Aircraft/ToLiSS A320neo/liveries/Jetstar Japan JA01VA/", "JA01VA" },
+    { "Aircraft/ToLiSS A320neo/liveries/Volaris XA-VRA/", "XA-VRA" },
+    { "Aircraft/ToLiSS A320neo/liveries/Avianca N724AV/", "N724AV" },
+    { "Aircraft/ToLiSS A320neo/liveries/LATAM PR-XBA/", "PR-XBA" },
+    { "Aircraft/ToLiSS A320neo/liveries/Aerolineas Argentinas LV-FVH/", "LV-FVH" },
+    { "Aircraft/ToLiSS A320neo/liveries/Qatar Airways A7-AHX/", "A7-AHX" },
+    { "Aircraft/ToLiSS A320neo/liveries/Air Astana P4-KBA/", "P4-KBA" },
+    { "Aircraft/ToLiSS A320neo/liveries/Pegasus TC-NBA/", "TC-NBA" },
+    { "Aircraft/ToLiSS A320neo/liveries/AirAsia 9M-AGA/", "9M-AGA" },
+    { "Aircraft/ToLiSS A320neo/liveries/Jetstar VH-VFN/", "VH-VFN" },
+    { "Aircraft/ToLiSS A320neo/liveries/Air New Zealand ZK-NHA/", "ZK-NHA" },
+    { "Aircraft/ToLiSS A340-600/liveries/Lufthansa D-AIHZ/", "D-AIHZ" },
+    { "Aircraft/ToLiSS A340-600/liveries/Iberia EC-LEU/", "EC-LEU" },
+    { "Aircraft/ToLiSS A340-600/liveries/Etihad A6-EHJ/", "A6-EHJ" },
+    { "Aircraft/ToLiSS A340-600/liveries/South African ZS-SNC/", "ZS-SNC" },
+    { "Aircraft/ToLiSS A340-600/liveries/Virgin Atlantic G-VYOU/", "G-VYOU" },
+    { "Aircraft/ToLiSS A340-600/liveries/Mahan Air EP-MMB/", "EP-MMB" },
+    { "Aircraft/ToLiSS A340-600/liveries/Azerbaijan Airlines 4K-AZ86/", "4K-AZ86" },
+    { "Aircraft/Zibo 737-800/liveries/Norwegian LN-NOL/", "LN-NOL" },
+    { "Aircraft/Zibo 737-800/liveries/Ukraine International UR-PSA/", "UR-PSA" },
+    { "Aircraft/Zibo 737-800/liveries/Belavia EW-254PA/", "EW-254PA" },
+    { "Aircraft/Zibo 737-800/liveries/UTair RA-73030/", "RA-73030" },
+    { "Aircraft/Zibo 737-800/liveries/El Al 4X-EKA/", "4X-EKA" },
+    { "Aircraft/Zibo 737-800/liveries/Royal Air Maroc CN-RGF/", "CN-RGF" },
+    { "Aircraft/Zibo 737-800/liveries/Ethiopian ET-AOA/", "ET-AOA" },
+    { "Aircraft/Zibo 737-800/liveries/Kenya Airways 5Y-KZE/", "5Y-KZE" },
+    { "Aircraft/Zibo 737-800/liveries/Garuda PK-GFQ/", "PK-GFQ" },
+    { "Aircraft/Zibo 737-800/liveries/Philippine Airlines RP-C7272/", "RP-C7272" },
+    { "Aircraft/Zibo 737-800/liveries/Korean Air HL7560/", "HL7560" },
+    { "Aircraft/Zibo 737-800/liveries/Xiamen Airlines B-5498/", "B-5498" },
+    { "Aircraft/Zibo 737-800/liveries/China Airlines B-18605/", "B-18605" },
+    { "Aircraft/Zibo 737-800/liveries/Smartwings OK-TVO/", "OK-TVO" },
+    { "Aircraft/Zibo 737-800/liveries/LOT SP-LWA/", "SP-LWA" },
+    { "Aircraft/Zibo 737-800/liveries/airBaltic YL-BBN/", "YL-BBN" },
+    { "Aircraft/Zibo 737-800/liveries/Sunwing C-FPRP/", "C-FPRP" },
+    { "Aircraft/Zibo 737-800/liveries/GOL PR-GXA/", "PR-GXA" },
+    { "Aircraft/Zibo 737-800/liveries/Aeromexico XA-AMX/", "XA-AMX" },
+    { "Aircraft/Zibo 737-800/liveries/Copa HP-1849CMP/", "HP-1849CMP" },
+    { "Aircraft/Zibo 737-800/liveries/Air India Express VT-AXD/", "VT-AXD" },
+    { "Aircraft/Zibo 737-800/liveries/Air Algerie 7T-VKA/", "7T-VKA" },
+    { "Aircraft/Zibo 737-800/liveries/Transavia F-GZHA/", "F-GZHA" },
+    { "Aircraft/Zibo 737-800/liveries/Jet2 G-GDFJ/", "G-GDFJ" },
+    { "Aircraft/Zibo 737-800/liveries/Alitalia I-BIKE/", "I-BIKE" },
+    { "Aircraft/Zibo 737-800/liveries/Oman Air A4O-BAB/", "A4O-BAB" },
+    { "Aircraft/Zibo 737-800/liveries/Gulf Air A9C-AJ/", "A9C-AJ" },
+    { "Aircraft/Zibo 737-800/liveries/Aeroflot VQ-BWD/", "VQ-BWD" },
+    { "Aircraft/Zibo 737-800/liveries/Fiji Airways DQ-FJH/", "DQ-FJH" },
+    { "Aircraft/Zibo 737-800/liveries/House Livery/", "" },
+    { "Aircraft/Zibo 737-800/liveries/Boeing House Colors 4K HD/", "" },
+    { "Aircraft/Zibo 737-800/liveries/Ryanair Sharklets (hi-res)/", "" },
+    { "Aircraft/Zibo 737-800/liveries/BBJ2 VIP/", "" },
+    { "Aircraft/FlightFactor 757/liveries/Icelandair TF-FIA Hekla Aurora/", "TF-FIA" },
+    { "Aircraft/FlightFactor 757/liveries/Condor D-ABOM/", "D-ABOM" },
+    { "Aircraft/FlightFactor 757/liveries/United N14102/", "N14102" },
+    { "Aircraft/FlightFactor 757/liveries/UPS N401UP/", "N401UP" },
+    { "Aircraft/FlightFactor 757/liveries/DHL G-DHKF/", "G-DHKF" },
+    { "Aircraft/FlightFactor 767/liveries/Austrian OE-LAE/", "OE-LAE" },
+    { "Aircraft/FlightFactor 767/liveries/LATAM CC-CXJ/", "CC-CXJ" },
+    { "Aircraft/FlightFactor 767/liveries/Azur Air VP-BUX/", "VP-BUX" },
+    { "Aircraft/FlightFactor 767/liveries/Japan Airlines JA601J/", "JA601J" },
+    { "Aircraft/FlightFactor 767/liveries/Uzbekistan UK-67001/", "UK-67001" },
+    { "Aircraft/FlightFactor 767/liveries/Air Tanzania 5H-TCO/", "5H-TCO" },
+    { "Aircraft/FlightFactor A350/liveries/Singapore Airlines 9V-SMA/", "9V-SMA" },
+    { "Aircraft/FlightFactor A350/liveries/Thai HS-THB/", "HS-THB" },
+    { "Aircraft/FlightFactor A350/liveries/Finnair OH-LWA/", "OH-LWA" },
+    { "Aircraft/FlightFactor A350/liveries/Sichuan B-301D/", "B-301D" },
+    { "Aircraft/FlightFactor A350/liveries/Ethiopian ET-ATQ/", "ET-ATQ" },
+    { "Aircraft/FlightFactor A350/liveries/Starlux B-58501/", "B-58501" },
+    { "Aircraft/FlightFactor A350/liveries/Prototype F-WWCF/", "F-WWCF" },
+    { "Aircraft/FlightFactor A350/liveries/Air Mauritius 3B-NBQ/", "3B-NBQ" },
+    { "Aircraft/FlightFactor A350/liveries/Aeroflot Retro/", "" },
+};
+
+constexpr size_t kCorpusSize = sizeof(kCorpus) / sizeof(kCorpus[0]);
+
+// The previous implementation from XPlane/main.cpp, regex built per call
+bool LegacyExtractRegistration(const std::string& livery_name, char* output_buffer, size_t buffer_size)
+{
+    output_buffer[0] = '\0';
+    const std::regex registration_regex(
+        "[A-Z]-[A-Z]{4}|"
+        "([A-Z]|[1-9]){2}-[A-Z]{3}|"
+        "N[0-9]{1,5}[A-Z]{0,2}",
+        std::regex::ECMAScript
+    );
+    std::smatch match_results;
+    if (std::regex_search(livery_name, match_results, registration_regex)) {
+        const std::string registration = match_results[0].str();
+        size_t copy_len = registration.length() < buffer_size - 1 ? registration.length() : buffer_size - 1;
+        memcpy(output_buffer, registration.c_str(), copy_len);
+        output_buffer[copy_len] = '\0';
+        return true;
+    }
+    return false;
+}
+
+template <typename Fn>
+void Score(const char* name, size_t iterations, Fn&& extract)
+{
+    size_t correct = 0;
+    size_t found = 0;
+    size_t wrong = 0;
+    for (const LiveryCase& c : kCorpus) {
+        char reg[64];
+        bool ok = extract(c.path, reg, sizeof(reg));
+        found += ok && c.expected[0] != '\0';
+        if (strcmp(ok ? reg : "", c.expected) == 0) {
+            correct++;
+        }
+        else if (ok) {
+            wrong++;   // false positive or wrong registration
+        }
+    }
+
+    size_t next = 0;
+    double ns = MeasureNsPerOp(iterations, [&] {
+        char reg[64];
+        DoNotOptimize(extract(kCorpus[next].path, reg, sizeof(reg)));
+        next = next + 1 < kCorpusSize ? next + 1 : 0;
+    });
+
+    char extra[96];
+    snprintf(extra, sizeof(extra), "%zu/%zu correct, %zu wrong, %zu missed",
+        correct, kCorpusSize, wrong, kCorpusSize - correct - wrong);
+    PrintResult(name, ns, extra);
+}
+
+} // namespace
+
+void BenchRegistration()
+{
+    Score("std::regex, built per call, full path", 20000, [](const char* path, char* reg, size_t size) {
+        return LegacyExtractRegistration(path, reg, size);
+    });
+    Score("FindRegistration, livery folder", 2000000, [](const char* path, char* reg, size_t size) {
+        return FindRegistration(LiveryFolderName(path), reg, size);
+    });
+}
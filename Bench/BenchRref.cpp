@@ -0,0 +1,201 @@
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Bench.h"
+#include "XPlaneUdp.h"
+
+namespace {
+
+std::vector<uint8_t> MakePacket(size_t values, std::minstd_rand& rng)
+{
+    std::uniform_real_distribution<float> value(-500.0f, 500.0f);
+    std::vector<uint8_t> packet(RREF_HEADER_SIZE + values * 8);
+    memcpy(packet.data(), "RREF,", RREF_HEADER_SIZE);
+    for (size_t i = 0; i < values; i++) {
+        int32_t index = (int32_t)(i % kRrefDatarefCount);
+        float v = value(rng);
+        memcpy(packet.data() + RREF_HEADER_SIZE + i * 8, &index, 4);
+        memcpy(packet.data() + RREF_HEADER_SIZE + i * 8 + 4, &v, 4);
+    }
+    return packet;
+}
+
+// What the Go bridge does per value: index -> name, then name -> value in a
+// string keyed map (without its mutex and binary.Read reflection)
+struct NamedValues {
+    std::map<int, std::string>             names;
+    std::unordered_map<std::string, float> values;
+
+    void Decode(const uint8_t* packet, size_t size)
+    {
+        for (size_t at = RREF_HEADER_SIZE; at + 8 <= size; at += 8) {
+            int32_t index;
+            float value;
+            memcpy(&index, packet + at, 4);
+            memcpy(&value, packet + at + 4, 4);
+            auto name = names.find(index);
+            if (name != names.end()) {
+                values[name->second] = value;
+            }
+        }
+    }
+};
+
+} // namespace
+
+void BenchRref()
+{
+    std::minstd_rand rng(22);
+    // One sample of every subscription, as X-Plane sends them at 10 Hz, and
+    // a full datagram
+    std::vector<uint8_t> sample = MakePacket(kRrefDatarefCount, rng);
+    std::vector<uint8_t> full = MakePacket(RREF_MAX_VALUES, rng);
+
+    RrefTable table;
+    char extra[96];
+    double ns = MeasureNsPerOp(2000000, [&] {
+        DoNotOptimize(table.Decode(sample.data(), sample.size()));
+    });
+    snprintf(extra, sizeof(extra), "%.2f ns/value, %zu values", ns / (double)kRrefDatarefCount, kRrefDatarefCount);
+    PrintResult("RrefTable::Decode (one sample)", ns, extra);
+    ns = MeasureNsPerOp(500000, [&] {
+        DoNotOptimize(table.Decode(full.data(), full.size()));
+    });
+    snprintf(extra, sizeof(extra), "%.2f ns/value, %d values", ns / RREF_MAX_VALUES, RREF_MAX_VALUES);
+    PrintResult("RrefTable::Decode (full datagram)", ns, extra);
+
+    NamedValues named;
+    for (size_t i = 0; i < kRrefDatarefCount; i++) {
+        named.names[(int)i] = kRrefDatarefs[i].name;
+    }
+    double named_ns = MeasureNsPerOp(500000, [&] {
+        named.Decode(sample.data(), sample.size());
+        DoNotOptimize(named.values);
+    });
+    snprintf(extra, sizeof(extra), "%.2f ns/value", named_ns / (double)kRrefDatarefCount);
+    PrintResult("Index -> name -> map (Go bridge)", named_ns, extra);
+
+    // Building the snapshot each send: the flat table against looking every
+    // dataref up by name
+    TelemetrySnapshot snapshot = {};
+    float frame_period = 0.0f;
+    ns = MeasureNsPerOp(2000000, [&] {
+        ApplyRrefValues(kRrefDatarefs, kRrefDatarefCount, table, snapshot, frame_period);
+        DoNotOptimize(snapshot);
+    });
+    PrintResult("ApplyRrefValues", ns);
+    ns = MeasureNsPerOp(500000, [&] {
+        float sum = 0.0f;
+        for (size_t i = 0; i < kRrefDatarefCount; i++) {
+            auto value = named.values.find(kRrefDatarefs[i].name);
+            sum += value != named.values.end() ? value->second : 0.0f;
+        }
+        DoNotOptimize(sum);
+    });
+    PrintResult("23 lookups by name (Go bridge)", ns);
+
+    // Both must agree on every value
+    RrefTable check;
+    check.Decode(sample.data(), sample.size());
+    named.values.clear();
+    named.Decode(sample.data(), sample.size());
+    size_t mismatches = 0;
+    for (size_t i = 0; i < kRrefDatarefCount; i++) {
+        mismatches += check.Value((int32_t)i) != named.values[kRrefDatarefs[i].name];
+    }
+    snprintf(extra, sizeof(extra), "%zu of %zu values differ", mismatches, kRrefDatarefCount);
+    PrintResult("Flat table vs named map", 0.0, extra);
+
+    // Position and attitude in one datagram each, against the nine RREF
+    // values for the same fields
+    std::vector<uint8_t> position = MakePacket(0, rng);
+    for (size_t i = 0; i < kRrefDatarefCount; i++) {
+        if (kRrefDatarefs[i].position) {
+            uint8_t pair[8];
+            int32_t index = (int32_t)i;
+            float value = 100.0f + (float)i;
+            memcpy(pair, &index, 4);
+            memcpy(pair + 4, &value, 4);
+            position.insert(position.end(), pair, pair + 8);
+        }
+    }
+    ns = MeasureNsPerOp(2000000, [&] {
+        table.Decode(position.data(), position.size());
+        ApplyRrefValues(kRrefDatarefs, kRrefDatarefCount, table, snapshot, frame_period);
+        DoNotOptimize(snapshot);
+    });
+    snprintf(extra, sizeof(extra), "%zu bytes", position.size());
+    PrintResult("RREF position rows, decode + apply", ns, extra);
+
+    RposPacket rpos = { 8.72, 45.63, 457.0, 337.0, 2.0f, 90.0f, 15.0f, 78.5f, 1.5f, -3.0f, 0.0f, 0.0f, 0.0f };
+    uint8_t rpos_packet[RPOS_PACKET_SIZE];
+    BuildRposPacket(rpos, rpos_packet, sizeof(rpos_packet));
+    ns = MeasureNsPerOp(5000000, [&] {
+        RposPacket parsed;
+        if (ParseRpos(rpos_packet, sizeof(rpos_packet), parsed)) {
+            ApplyRpos(parsed, snapshot);
+        }
+        DoNotOptimize(snapshot);
+    });
+    snprintf(extra, sizeof(extra), "%d bytes", RPOS_PACKET_SIZE);
+    PrintResult("ParseRpos + ApplyRpos", ns, extra);
+
+    uint8_t data_packet[5 + 4 * DATA_RECORD_SIZE];
+    memcpy(data_packet, "DATA*", 5);
+    const int32_t groups[] = { DATA_GROUP_SPEEDS, DATA_GROUP_VVI, DATA_GROUP_ATTITUDE, DATA_GROUP_POSITION };
+    size_t data_size = 5;
+    for (int32_t group : groups) {
+        float values[8] = { 45.63f, 8.72f, 1500.0f, 1100.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+        data_size += AppendDataRecord(group, values, data_packet + data_size, sizeof(data_packet) - data_size);
+    }
+    ns = MeasureNsPerOp(5000000, [&] {
+        DoNotOptimize(ApplyDataPacket(data_packet, data_size, snapshot));
+        DoNotOptimize(snapshot);
+    });
+    snprintf(extra, sizeof(extra), "%zu bytes, 4 groups", data_size);
+    PrintResult("ApplyDataPacket", ns, extra);
+
+    // The identity fetch: every byte request in one buffer, then reading a
+    // complete livery path back out of the table
+    static uint8_t requests[400 * RREF_REQUEST_SIZE];
+    ns = MeasureNsPerOp(2000, [&] {
+        size_t count = 0;
+        for (size_t i = 0; i < kRrefIdentityCount; i++) {
+            count += BuildRrefStringRequests(kRrefIdentity[i], RrefStringBytes::All, table, 30,
+                requests + count * RREF_REQUEST_SIZE, sizeof(requests) - count * RREF_REQUEST_SIZE);
+        }
+        DoNotOptimize(count);
+    });
+    PrintResult("BuildRrefStringRequests (336 bytes)", ns);
+
+    const char* livery_path = "Aircraft/Laminar Research/Boeing 737-800/liveries/Ryanair EI-DCL (Sharklets)/";
+    const RrefString& livery = kRrefIdentity[RREF_IDENTITY_LIVERY];
+    std::vector<uint8_t> bytes = MakePacket(0, rng);
+    for (int32_t i = 0; i < livery.length; i++) {
+        int32_t index = livery.first_index + i;
+        float value = i < (int32_t)strlen(livery_path) ? (float)livery_path[i] : 0.0f;
+        uint8_t pair[8];
+        memcpy(pair, &index, 4);
+        memcpy(pair + 4, &value, 4);
+        bytes.insert(bytes.end(), pair, pair + 8);
+    }
+    RrefTable strings;
+    strings.Decode(bytes.data(), bytes.size());
+    char text[300] = "";
+    ns = MeasureNsPerOp(1000000, [&] {
+        DoNotOptimize(ReadRrefString(livery, strings, text, sizeof(text)));
+    });
+    snprintf(extra, sizeof(extra), "%s", strcmp(text, livery_path) == 0 ? "matches" : "DIFFERS");
+    PrintResult("ReadRrefString (livery path)", ns, extra);
+
+    // A round trip must give back what went in
+    RposPacket parsed = {};
+    ParseRpos(rpos_packet, sizeof(rpos_packet), parsed);
+    snprintf(extra, sizeof(extra), "%s", memcmp(&parsed, &rpos, sizeof(rpos)) == 0 ? "identical" : "DIFFERS");
+    PrintResult("BuildRposPacket -> ParseRpos", 0.0, extra);
+}
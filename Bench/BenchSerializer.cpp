@@ -0,0 +1,117 @@
+#include <cstdio>
+#include <cstring>
+
+#include "Bench.h"
+#include "Telemetry.h"
+
+// The snprintf based formatter that SendPosition used before the shared
+// serializer, kept here as the baseline.
+static size_t LegacySerializePositionUpdate(const TelemetrySnapshot& s, char* json, size_t size)
+{
+    int n = snprintf(json, size,
+        "{\"type\":\"STREAM\",\"name\":\"POSITION_UPDATE\",\"data\":{"
+        "\"altitude_amsl\":%.6f,"
+        "\"altitude_agl\":%.6f,"
+        "\"latitude\":%.6f,"
+        "\"longitude\":%.6f,"
+        "\"pitch\":%.6f,"
+        "\"bank\":%.6f,"
+        "\"heading_true\":%.6f,"
+        "\"ground_speed\":%.6f,"
+        "\"vertical_speed\":%.6f,"
+        "\"fuel_kg\":%.6f,"
+        "\"gravity\":%.6f,"
+        "\"transponder\":\"%04d\","
+        "\"on_ground\":%s,"
+        "\"slew\":%s,"
+        "\"paused\":%s,"
+        "\"in_replay_mode\":%s,"
+        "\"fps\":%.6f,"
+        "\"time_acceleration\":%.6f,"
+        "\"autopilot_engaged\":%s,"
+        "\"engines_running\":%s,"
+        "\"parking_brake\":%s,"
+        "\"sim_abbreviation\":\"xp12\","
+        "\"sim_version\":\"12.320\","
+        "\"wind_speed\":%.6f,"
+        "\"wind_direction\":%.6f"
+        "}}",
+        s.altitude_amsl * METERS_TO_FT,
+        s.altitude_agl * METERS_TO_FT,
+        s.latitude,
+        s.longitude,
+        s.pitch, s.bank, s.heading_true,
+        s.ground_speed, s.vertical_speed, s.fuel_kg, s.gravity,
+        s.transponder,
+        s.on_ground ? "true" : "false",
+        s.slew ? "true" : "false",
+        s.paused ? "true" : "false",
+        s.in_replay_mode ? "true" : "false",
+        s.fps, s.time_acceleration,
+        s.autopilot_engaged ? "true" : "false",
+        s.engines_running ? "true" : "false",
+        s.parking_brake > 0.5f ? "true" : "false",
+        s.wind_speed, s.wind_direction
+    );
+    return n > 0 ? (size_t)n : 0;
+}
+
+static TelemetrySnapshot SampleSnapshot()
+{
+    TelemetrySnapshot s = {};
+    s.latitude = 47.4647189;
+    s.longitude = 8.5491753;
+    s.altitude_amsl = 10972.8;
+    s.altitude_agl = 10540.2;
+    s.pitch = 2.31f;
+    s.bank = -0.42f;
+    s.heading_true = 271.6f;
+    s.ground_speed = 231.4f;
+    s.vertical_speed = -12.5f;
+    s.fuel_kg = 8421.7f;
+    s.gravity = 1.002f;
+    s.fps = 58.3f;
+    s.time_acceleration = 1.0f;
+    s.parking_brake = 0.0f;
+    s.wind_speed = 42.0f;
+    s.wind_direction = 265.0f;
+    s.transponder = 1000;
+    s.autopilot_engaged = 2;
+    s.engines_running = 1;
+    return s;
+}
+
+void BenchSerializer()
+{
+    const size_t iterations = 500000;
+    TelemetrySnapshot snapshot = SampleSnapshot();
+    const TelemetrySource source = { "xp12", "12.320" };
+    char json[TELEMETRY_MAX_MESSAGE];
+
+    size_t legacy_len = 0;
+    double legacy_ns = MeasureNsPerOp(iterations, [&] {
+        // Nudge the input so nothing gets hoisted out of the loop
+        snapshot.latitude += 1e-9;
+        legacy_len = LegacySerializePositionUpdate(snapshot, json, sizeof(json));
+        DoNotOptimize(json);
+    });
+
+    size_t schema_len = 0;
+    double schema_ns = MeasureNsPerOp(iterations, [&] {
+        snapshot.latitude += 1e-9;
+        schema_len = SerializePositionUpdate(snapshot, source, json, sizeof(json));
+        DoNotOptimize(json);
+    });
+
+    char extra[64];
+    snprintf(extra, sizeof(extra), "%zu bytes", legacy_len);
+    PrintResult("position_update/snprintf", legacy_ns, extra);
+    snprintf(extra, sizeof(extra), "%zu bytes, %.2fx", schema_len, legacy_ns / schema_ns);
+    PrintResult("position_update/schema", schema_ns, extra);
+
+    const AircraftInfo aircraft = { "", "B738", "B738", "EI-DCL", "" };
+    double aircraft_ns = MeasureNsPerOp(iterations, [&] {
+        DoNotOptimize(SerializeAircraftUpdate(aircraft, json, sizeof(json)));
+    });
+    PrintResult("aircraft_update/schema", aircraft_ns);
+}
@@ -0,0 +1,167 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+#include "Bench.h"
+#include "SharedState.h"
+
+namespace {
+
+// Every field derived from the update number, so a reader can tell a torn
+// copy from a good one
+TelemetrySnapshot NumberedSnapshot(uint64_t n)
+{
+    TelemetrySnapshot s = {};
+    s.latitude = (double)n;
+    s.longitude = -(double)n;
+    s.altitude_amsl = (double)n * 0.5;
+    s.heading_true = (float)(n % 360);
+    s.transponder = (int32_t)(n % 10000);
+    s.engines_running = (int32_t)(n & 1);
+    return s;
+}
+
+// `update` counts the writer's publishes, which started before the numbered
+// ones, so the number is taken from the latitude
+bool Consistent(const SharedState& state)
+{
+    uint64_t n = (uint64_t)state.snapshot.latitude;
+    return state.time_s == (double)n
+        && state.snapshot.latitude == (double)n
+        && state.snapshot.longitude == -(double)n
+        && state.snapshot.altitude_amsl == (double)n * 0.5
+        && state.snapshot.heading_true == (float)(n % 360)
+        && state.snapshot.transponder == (int32_t)(n % 10000)
+        && state.snapshot.engines_running == (int32_t)(n & 1);
+}
+
+struct ReaderRun {
+    uint64_t reads = 0;
+    uint64_t failed = 0;
+    uint64_t torn = 0;
+    uint64_t retries = 0;
+    double   seconds = 0.0;
+};
+
+// Reads flat out for `seconds` while the writer does whatever it does
+ReaderRun ReadFor(const char* name, double seconds)
+{
+    ReaderRun run;
+    SharedStateReader reader;
+    if (!reader.Open(name)) {
+        return run;
+    }
+    SharedState state;
+    auto start = std::chrono::steady_clock::now();
+    auto end = start + std::chrono::duration<double>(seconds);
+    while (std::chrono::steady_clock::now() < end) {
+        // The clock is checked every 1024 reads, not every one
+        for (int i = 0; i < 1024; i++) {
+            if (!reader.Read(state)) {
+                run.failed++;
+            }
+            else if (!Consistent(state)) {
+                run.torn++;
+            }
+            run.reads++;
+        }
+    }
+    run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    run.retries = reader.Retries();
+    return run;
+}
+
+void PrintRun(const char* label, const ReaderRun& run)
+{
+    char extra[160];
+    snprintf(extra, sizeof(extra), "%.1f M reads/s, %llu torn, %llu failed, %llu retries",
+        (double)run.reads / run.seconds / 1e6,
+        (unsigned long long)run.torn,
+        (unsigned long long)run.failed,
+        (unsigned long long)run.retries);
+    PrintResult(label, run.reads > 0 ? run.seconds * 1e9 / (double)run.reads : 0.0, extra);
+}
+
+} // namespace
+
+void BenchSharedState()
+{
+    std::string name = "OpenVolantaBench-" + std::to_string((long)getpid());
+    SharedStateWriter writer;
+    if (!writer.Open(name.c_str())) {
+        printf("  could not create shared memory segment %s\n", name.c_str());
+        return;
+    }
+
+    uint64_t n = 0;
+    TelemetrySnapshot snapshot = NumberedSnapshot(0);
+    double ns = MeasureNsPerOp(10000000, [&] {
+        // Reuses one snapshot: what is measured is the publish, not building it
+        n++;
+        snapshot.latitude = (double)n;
+        writer.Publish(snapshot, (double)n);
+    });
+    PrintResult("Publish (no readers)", ns);
+
+    // Back to numbered states for the readers to check
+    n = 1;
+    writer.Publish(NumberedSnapshot(n), (double)n);
+
+    SharedStateReader reader;
+    reader.Open(name.c_str());
+    SharedState state;
+    double read_ns = MeasureNsPerOp(10000000, [&] {
+        reader.Read(state);
+        DoNotOptimize(state);
+    });
+    char extra[64];
+    snprintf(extra, sizeof(extra), "%.1f M reads/s", 1000.0 / read_ns);
+    PrintResult("Read (writer idle)", read_ns, extra);
+
+    // A 60 fps sim on one thread, a reader on another
+    std::atomic<bool> running{true};
+    std::thread paced([&] {
+        auto next = std::chrono::steady_clock::now();
+        uint64_t update = n;
+        while (running.load(std::memory_order_relaxed)) {
+            update++;
+            writer.Publish(NumberedSnapshot(update), (double)update);
+            next += std::chrono::microseconds(16667);
+            std::this_thread::sleep_until(next);
+        }
+        n = update;
+    });
+    PrintRun("Read (writer at 60 fps)", ReadFor(name.c_str(), 1.0));
+    running = false;
+    paced.join();
+
+    // Worst case: the writer never stops
+    running = true;
+    uint64_t publishes = 0;
+    double publish_s = 0.0;
+    std::thread flat_out([&] {
+        uint64_t update = n;
+        auto start = std::chrono::steady_clock::now();
+        while (running.load(std::memory_order_relaxed)) {
+            update++;
+            writer.Publish(NumberedSnapshot(update), (double)update);
+            publishes++;
+        }
+        publish_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    });
+    ReaderRun contended = ReadFor(name.c_str(), 1.0);
+    running = false;
+    flat_out.join();
+    PrintRun("Read (writer flat out)", contended);
+    snprintf(extra, sizeof(extra), "%.1f M publishes/s while read", (double)publishes / publish_s / 1e6);
+    PrintResult("Publish (reader flat out)", publish_s * 1e9 / (double)publishes, extra);
+
+    writer.Close();
+    PrintResult("Live after the writer closed", 0.0, reader.Live() ? "yes (wrong)" : "no");
+    SharedStateReader late;
+    PrintResult("Open after the writer closed", 0.0, late.Open(name.c_str()) ? "opened (wrong)" : "refused");
+}
@@ -0,0 +1,146 @@
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "Bench.h"
+#include "TrackSimplifier.h"
+
+namespace {
+
+#define BENCH_EARTH_RADIUS_M 6371008.8
+#define BENCH_DEG_TO_RAD 0.017453292519943295
+
+// A flight at 10 Hz flown by integrating speed, turn rate and vertical speed
+// through a 40 kt crosswind, so the track differs from the heading, with a
+// little heading and altitude noise in the air
+struct Leg {
+    double seconds;
+    float  knots;
+    float  turn_deg_s;
+    float  fpm;
+    int    on_ground;
+};
+
+const Leg kFlight[] = {
+    {  120,   0,    0,     0, 1 },   // parked
+    {   60,  15,    0,     0, 1 },   // taxi
+    {   30,  10,    3,     0, 1 },   // turn onto the taxiway
+    {  180,  15,    0,     0, 1 },
+    {   20,  10, -4.5,     0, 1 },   // line up
+    {   35,  90,    0,     0, 1 },   // takeoff roll
+    {  120, 180,    0,  2500, 0 },
+    {   60, 210,    3,  2000, 0 },   // departure turn
+    {  600, 280,    0,  1800, 0 },
+    { 2400, 450,    0,     0, 0 },   // cruise
+    {   30, 450, -1.5,     0, 0 },   // airway turn
+    { 1200, 450,    0,     0, 0 },
+    {  900, 320,    0, -1500, 0 },   // descent
+    {   60, 200,    3,  -800, 0 },   // base turn
+    {  180, 140,    0,  -700, 0 },   // final
+    {   25,  80,    0,     0, 1 },   // rollout
+    {  240,  15,    0,     0, 1 },   // taxi in
+};
+
+struct Sample {
+    double            t;
+    TelemetrySnapshot snapshot;
+};
+
+std::vector<Sample> FlyScript()
+{
+    std::minstd_rand rng(12);
+    std::normal_distribution<float> heading_noise(0.0f, 0.3f);
+    std::normal_distribution<float> altitude_noise(0.0f, 0.5f);
+    const double wind_east = 40.0 / MPS_TO_KNOTS;   // from the west
+
+    std::vector<Sample> samples;
+    double t = 0.0, latitude = 45.0, longitude = 7.0, altitude = 300.0;
+    double heading = 90.0;
+    for (const Leg& leg : kFlight) {
+        for (double s = 0.0; s < leg.seconds; s += 0.1, t += 0.1) {
+            heading = std::fmod(heading + leg.turn_deg_s * 0.1 + 360.0, 360.0);
+            double air = leg.knots / MPS_TO_KNOTS;
+            double east = air * std::sin(heading * BENCH_DEG_TO_RAD) + (leg.on_ground ? 0.0 : wind_east);
+            double north = air * std::cos(heading * BENCH_DEG_TO_RAD);
+            latitude += north * 0.1 / BENCH_EARTH_RADIUS_M / BENCH_DEG_TO_RAD;
+            longitude += east * 0.1 / (BENCH_EARTH_RADIUS_M * std::cos(latitude * BENCH_DEG_TO_RAD)) / BENCH_DEG_TO_RAD;
+            altitude += leg.fpm / 60.0 / METERS_TO_FT * 0.1;
+
+            Sample sample = { t, {} };
+            TelemetrySnapshot& snap = sample.snapshot;
+            snap.latitude = latitude;
+            snap.longitude = longitude;
+            snap.altitude_amsl = altitude + (leg.on_ground ? 0.0f : altitude_noise(rng));
+            snap.heading_true = (float)std::fmod(heading + (leg.on_ground ? 0.0f : heading_noise(rng)) + 360.0, 360.0);
+            snap.ground_speed = (float)std::sqrt(east * east + north * north);
+            snap.vertical_speed = leg.fpm;
+            snap.on_ground = leg.on_ground;
+            snap.engines_running = 1;
+            samples.push_back(sample);
+        }
+    }
+    return samples;
+}
+
+// Worst horizontal distance of any sample from the straight lines between
+// the ones that were sent
+double MaxChordError(const std::vector<Sample>& samples, const std::vector<size_t>& sent)
+{
+    double worst = 0.0;
+    for (size_t k = 1; k < sent.size(); k++) {
+        const TelemetrySnapshot& a = samples[sent[k - 1]].snapshot;
+        const TelemetrySnapshot& b = samples[sent[k]].snapshot;
+        double scale = BENCH_DEG_TO_RAD * BENCH_EARTH_RADIUS_M;
+        double cos_lat = std::cos(a.latitude * BENCH_DEG_TO_RAD);
+        double be = (b.longitude - a.longitude) * scale * cos_lat, bn = (b.latitude - a.latitude) * scale;
+        double length2 = be * be + bn * bn;
+        for (size_t i = sent[k - 1] + 1; i < sent[k]; i++) {
+            const TelemetrySnapshot& p = samples[i].snapshot;
+            double pe = (p.longitude - a.longitude) * scale * cos_lat, pn = (p.latitude - a.latitude) * scale;
+            double u = length2 > 0.0 ? (pe * be + pn * bn) / length2 : 0.0;
+            u = u < 0.0 ? 0.0 : (u > 1.0 ? 1.0 : u);
+            worst = std::fmax(worst, std::hypot(pe - u * be, pn - u * bn));
+        }
+    }
+    return worst;
+}
+
+} // namespace
+
+void BenchTrack()
+{
+    std::vector<Sample> samples = FlyScript();
+
+    TrackSimplifier track{ SimplifyConfig() };
+    std::vector<size_t> sent;
+    for (size_t i = 0; i < samples.size(); i++) {
+        if (track.Offer(samples[i].snapshot, samples[i].t)) {
+            sent.push_back(i);
+        }
+    }
+    const SimplifyStats& stats = track.Stats();
+    char line[160];
+    snprintf(line, sizeof(line), "%llu/%llu points (%.1f:1), max error %.1f m, %.1f ft",
+        (unsigned long long)stats.sent, (unsigned long long)stats.offered, stats.Ratio(),
+        stats.max_position_error_m, stats.max_altitude_error_ft);
+    printf("  %-40s %s\n", "dead band, 10 Hz in", line);
+    printf("  %-40s %.1f m (independent check)\n", "", MaxChordError(samples, sent));
+
+    // The same number of points at a fixed interval, for comparison
+    size_t step = samples.size() / sent.size();
+    std::vector<size_t> fixed;
+    for (size_t i = 0; i < samples.size(); i += step) {
+        fixed.push_back(i);
+    }
+    snprintf(line, sizeof(line), "%zu points every %.1f s, max error %.1f m", fixed.size(), step * 0.1, MaxChordError(samples, fixed));
+    printf("  %-40s %s\n", "fixed interval", line);
+
+    size_t i = 0;
+    double ns = MeasureNsPerOp(samples.size() * 10, [&] {
+        const Sample& sample = samples[i % samples.size()];
+        DoNotOptimize(track.Offer(sample.snapshot, sample.t + (double)(i / samples.size()) * 1e5));
+        i++;
+    });
+    PrintResult("Offer", ns);
+}
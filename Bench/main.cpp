@@ -0,0 +1,43 @@
+#include <cstdio>
+#include <cstring>
+
+#include "Bench.h"
+
+struct BenchSuite {
+    const char* name;
+    void (*run)();
+};
+
+static const BenchSuite suites[] = {
+    { "serializer", BenchSerializer },
+    { "output", BenchOutputBuffer },
+    { "datarefs", BenchDatarefs },
+    { "frames", BenchFrameStats },
+    { "registration", BenchRegistration },
+    { "recorder", BenchRecorder },
+    { "landing", BenchLanding },
+    { "phase", BenchFlightPhase },
+    { "track", BenchTrack },
+    { "shm", BenchSharedState },
+    { "binary", BenchBinaryTelemetry },
+    { "rref", BenchRref },
+};
+
+// Usage: bench [suite...]   (no arguments runs every suite)
+int main(int argc, char* argv[])
+{
+    for (const BenchSuite& suite : suites) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; i++) {
+            if (strcmp(argv[i], suite.name) == 0) {
+                selected = true;
+            }
+        }
+        if (!selected) {
+            continue;
+        }
+        printf("[%s]\n", suite.name);
+        suite.run();
+    }
+    return 0;
+}
@@ -0,0 +1,427 @@
+#include "include/BinaryTelemetry.h"
+
+#include <cmath>
+#include <cstring>
+#include <iterator>
+
+#define RECORD_HEADER 'H'
+#define RECORD_KEY 'K'
+#define RECORD_DELTA 'D'
+#define RECORD_JSON 'J'
+
+#define VARINT_MAX_BYTES 10
+
+namespace {
+
+// Which kPositionSchema entries go on the wire, and how
+struct WireSchema {
+    uint8_t numbers[BINARY_TELEMETRY_MAX_FIELDS];
+    size_t  number_count;
+    uint8_t bools[BINARY_TELEMETRY_MAX_FIELDS];
+    size_t  bool_count;
+};
+
+constexpr WireSchema BuildWireSchema()
+{
+    WireSchema wire = {};
+    for (size_t i = 0; i < std::size(kPositionSchema); i++) {
+        switch (kPositionSchema[i].format) {
+            case FieldFormat::Number:
+            case FieldFormat::Transponder:
+                wire.numbers[wire.number_count++] = (uint8_t)i;
+                break;
+            case FieldFormat::Bool:
+                wire.bools[wire.bool_count++] = (uint8_t)i;
+                break;
+            case FieldFormat::SimAbbreviation:
+            case FieldFormat::SimVersion:
+                break;  // in the header
+        }
+    }
+    return wire;
+}
+
+constexpr WireSchema kWire = BuildWireSchema();
+static_assert(kWire.number_count <= BINARY_TELEMETRY_MAX_FIELDS && kWire.bool_count <= BINARY_TELEMETRY_MAX_FIELDS,
+    "raise BINARY_TELEMETRY_MAX_FIELDS");
+
+constexpr size_t kPresenceBytes = (kWire.number_count + 7) / 8;
+constexpr size_t kBoolBytes = (kWire.bool_count + 7) / 8;
+
+const double kPow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+
+double ReadValue(const TelemetrySnapshot& snapshot, const TelemetryField& field)
+{
+    const char* base = (const char*)&snapshot + field.offset;
+    switch (field.type) {
+        case FieldType::F64: { double v;  memcpy(&v, base, sizeof(v)); return v; }
+        case FieldType::F32: { float v;   memcpy(&v, base, sizeof(v)); return v; }
+        case FieldType::I32: { int32_t v; memcpy(&v, base, sizeof(v)); return v; }
+    }
+    return 0.0;
+}
+
+void WriteValue(TelemetrySnapshot& snapshot, const TelemetryField& field, double value)
+{
+    char* base = (char*)&snapshot + field.offset;
+    switch (field.type) {
+        case FieldType::F64: { double v = value;                    memcpy(base, &v, sizeof(v)); break; }
+        case FieldType::F32: { float v = (float)value;              memcpy(base, &v, sizeof(v)); break; }
+        case FieldType::I32: { int32_t v = (int32_t)llround(value); memcpy(base, &v, sizeof(v)); break; }
+    }
+}
+
+// The integer the JSON serializer prints, decimal point removed
+int64_t Quantize(const TelemetrySnapshot& snapshot, const TelemetryField& field)
+{
+    if (field.format == FieldFormat::Transponder) {
+        return snapshot.transponder < 0 ? 0 : snapshot.transponder;
+    }
+    double value = ReadValue(snapshot, field) * field.scale;
+    if (!std::isfinite(value)) {
+        return 0;
+    }
+    int precision = field.precision < 0 ? 0 : field.precision > 9 ? 9 : field.precision;
+    return (int64_t)std::llround(value * kPow10[precision]);
+}
+
+void Dequantize(TelemetrySnapshot& snapshot, const TelemetryField& field, int64_t value)
+{
+    if (field.format == FieldFormat::Transponder) {
+        snapshot.transponder = (int32_t)value;
+        return;
+    }
+    int precision = field.precision < 0 ? 0 : field.precision > 9 ? 9 : field.precision;
+    WriteValue(snapshot, field, (double)value / kPow10[precision] / field.scale);
+}
+
+uint64_t ZigZag(int64_t value)
+{
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+int64_t UnZigZag(uint64_t value)
+{
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+// Appends to a fixed buffer, like the serializer's JsonWriter
+class ByteWriter {
+public:
+    ByteWriter(uint8_t* out, size_t size) : cur_(out), end_(out + size) {}
+
+    void Byte(uint8_t value)
+    {
+        if (cur_ == end_) {
+            overflow_ = true;
+            return;
+        }
+        *cur_++ = value;
+    }
+
+    void Bytes(const void* data, size_t length)
+    {
+        if ((size_t)(end_ - cur_) < length) {
+            overflow_ = true;
+            return;
+        }
+        memcpy(cur_, data, length);
+        cur_ += length;
+    }
+
+    void Varint(uint64_t value)
+    {
+        while (value >= 0x80) {
+            Byte((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        Byte((uint8_t)value);
+    }
+
+    void Short(std::string_view text)
+    {
+        size_t length = text.size() < 255 ? text.size() : 255;
+        Byte((uint8_t)length);
+        Bytes(text.data(), length);
+    }
+
+    uint8_t* Position() const { return cur_; }
+    bool Overflow() const { return overflow_; }
+
+private:
+    uint8_t* cur_;
+    uint8_t* end_;
+    bool     overflow_ = false;
+};
+
+// Bytes read, 0 if the varint isn't complete within `size`, or more than
+// VARINT_MAX_BYTES if it never ends
+size_t ReadVarint(const uint8_t* p, size_t size, uint64_t& value)
+{
+    value = 0;
+    for (size_t i = 0; i < size && i < VARINT_MAX_BYTES; i++) {
+        value |= (uint64_t)(p[i] & 0x7F) << (7 * i);
+        if (!(p[i] & 0x80)) {
+            return i + 1;
+        }
+    }
+    return size >= VARINT_MAX_BYTES ? VARINT_MAX_BYTES + 1 : 0;
+}
+
+// Prefixes `body` with its varint length in `out`
+size_t FinishRecord(const uint8_t* body, size_t length, uint8_t* out, size_t out_size)
+{
+    ByteWriter w(out, out_size);
+    w.Varint(length);
+    w.Bytes(body, length);
+    return w.Overflow() ? 0 : (size_t)(w.Position() - out);
+}
+
+} // namespace
+
+BinaryTelemetryEncoder::BinaryTelemetryEncoder(uint32_t key_interval)
+    : key_interval_(key_interval > 0 ? key_interval : 1)
+{
+}
+
+size_t BinaryTelemetryEncoder::Header(const TelemetrySource& source, uint8_t* out, size_t out_size) const
+{
+    uint8_t body[BINARY_TELEMETRY_MAX_RECORD];
+    ByteWriter w(body, sizeof(body));
+    w.Byte(RECORD_HEADER);
+    w.Bytes(BINARY_TELEMETRY_MAGIC, 4);
+    w.Byte(BINARY_TELEMETRY_VERSION);
+    w.Byte((uint8_t)kWire.number_count);
+    for (size_t i = 0; i < kWire.number_count; i++) {
+        const TelemetryField& field = kPositionSchema[kWire.numbers[i]];
+        w.Short(field.key);
+        w.Byte((uint8_t)field.precision);
+    }
+    w.Byte((uint8_t)kWire.bool_count);
+    for (size_t i = 0; i < kWire.bool_count; i++) {
+        w.Short(kPositionSchema[kWire.bools[i]].key);
+    }
+    w.Short(source.abbreviation);
+    w.Short(source.version);
+    if (w.Overflow()) {
+        return 0;
+    }
+    return FinishRecord(body, (size_t)(w.Position() - body), out, out_size);
+}
+
+size_t BinaryTelemetryEncoder::Position(const TelemetrySnapshot& snapshot, uint8_t* out, size_t out_size)
+{
+    bool key = until_key_ == 0;
+    int64_t values[BINARY_TELEMETRY_MAX_FIELDS];
+    uint8_t presence[kPresenceBytes] = {};
+    uint8_t bools[kBoolBytes] = {};
+    for (size_t i = 0; i < kWire.number_count; i++) {
+        values[i] = Quantize(snapshot, kPositionSchema[kWire.numbers[i]]);
+        if (key ? values[i] != 0 : values[i] != previous_[i]) {
+            presence[i / 8] |= (uint8_t)(1 << (i % 8));
+        }
+    }
+    for (size_t i = 0; i < kWire.bool_count; i++) {
+        const TelemetryField& field = kPositionSchema[kWire.bools[i]];
+        if (ReadValue(snapshot, field) > field.threshold) {
+            bools[i / 8] |= (uint8_t)(1 << (i % 8));
+        }
+    }
+
+    uint8_t body[BINARY_TELEMETRY_MAX_RECORD];
+    ByteWriter w(body, sizeof(body));
+    uint16_t sequence = (uint16_t)(sequence_ + 1);
+    w.Byte(key ? RECORD_KEY : RECORD_DELTA);
+    w.Byte((uint8_t)(sequence & 0xFF));
+    w.Byte((uint8_t)(sequence >> 8));
+    w.Bytes(presence, sizeof(presence));
+    w.Bytes(bools, sizeof(bools));
+    for (size_t i = 0; i < kWire.number_count; i++) {
+        if (presence[i / 8] & (1 << (i % 8))) {
+            w.Varint(ZigZag(key ? values[i] : values[i] - previous_[i]));
+        }
+    }
+    size_t written = w.Overflow() ? 0 : FinishRecord(body, (size_t)(w.Position() - body), out, out_size);
+    if (written == 0) {
+        return 0;   // nothing changes, so the next call encodes against the same frame
+    }
+
+    sequence_ = sequence;
+    memcpy(previous_, values, kWire.number_count * sizeof(values[0]));
+    until_key_ = key ? key_interval_ - 1 : until_key_ - 1;
+    return written;
+}
+
+size_t BinaryTelemetryEncoder::Json(const char* json, size_t length, uint8_t* out, size_t out_size)
+{
+    ByteWriter w(out, out_size);
+    w.Varint(length + 1);
+    w.Byte(RECORD_JSON);
+    w.Bytes(json, length);
+    return w.Overflow() ? 0 : (size_t)(w.Position() - out);
+}
+
+BinaryRecord BinaryTelemetryDecoder::Next(const uint8_t* data, size_t size, size_t& used)
+{
+    used = 0;
+    uint64_t length;
+    size_t prefix = ReadVarint(data, size, length);
+    if (prefix == 0) {
+        return BinaryRecord::NeedMore;
+    }
+    if (prefix > VARINT_MAX_BYTES || length == 0 || length > TELEMETRY_MAX_MESSAGE + 1) {
+        return BinaryRecord::Invalid;
+    }
+    if (size - prefix < length) {
+        return BinaryRecord::NeedMore;
+    }
+    used = prefix + (size_t)length;
+    const uint8_t* p = data + prefix + 1;
+    const uint8_t* end = data + used;
+
+    switch (data[prefix]) {
+        case RECORD_HEADER:
+            return ReadHeader(p, end) ? BinaryRecord::Header : BinaryRecord::Invalid;
+        case RECORD_KEY:
+        case RECORD_DELTA: {
+            bool key = data[prefix] == RECORD_KEY;
+            if (!have_header_) {
+                return BinaryRecord::Invalid;
+            }
+            if (!ReadFrame(p, end, key)) {
+                return BinaryRecord::Invalid;
+            }
+            return synced_ ? BinaryRecord::Position : BinaryRecord::Skipped;
+        }
+        case RECORD_JSON:
+            json_ = std::string_view((const char*)p, (size_t)(end - p));
+            return BinaryRecord::Json;
+    }
+    return BinaryRecord::Invalid;
+}
+
+bool BinaryTelemetryDecoder::ReadHeader(const uint8_t* p, const uint8_t* end)
+{
+    auto short_string = [&](std::string_view& out) {
+        if (p == end || (size_t)(end - p - 1) < *p) {
+            return false;
+        }
+        out = std::string_view((const char*)p + 1, *p);
+        p += 1 + *p;
+        return true;
+    };
+
+    if (end - p < 6 || memcmp(p, BINARY_TELEMETRY_MAGIC, 4) != 0 || p[4] != BINARY_TELEMETRY_VERSION) {
+        return false;
+    }
+    p += 5;
+    // The schema must be the one compiled in: same fields, same order, same
+    // decimals
+    if (*p++ != kWire.number_count) {
+        return false;
+    }
+    for (size_t i = 0; i < kWire.number_count; i++) {
+        std::string_view key;
+        const TelemetryField& field = kPositionSchema[kWire.numbers[i]];
+        if (!short_string(key) || key != field.key || p == end || (int8_t)*p++ != field.precision) {
+            return false;
+        }
+    }
+    if (p == end || *p++ != kWire.bool_count) {
+        return false;
+    }
+    for (size_t i = 0; i < kWire.bool_count; i++) {
+        std::string_view key;
+        if (!short_string(key) || key != kPositionSchema[kWire.bools[i]].key) {
+            return false;
+        }
+    }
+    std::string_view abbreviation, version;
+    if (!short_string(abbreviation) || !short_string(version) || p != end) {
+        return false;
+    }
+    abbreviation_.assign(abbreviation);
+    version_.assign(version);
+    have_header_ = true;
+    synced_ = false;
+    return true;
+}
+
+// Returns false if the frame is malformed. A well formed delta that doesn't
+// follow the last frame clears synced_ instead.
+bool BinaryTelemetryDecoder::ReadFrame(const uint8_t* p, const uint8_t* end, bool key)
+{
+    if ((size_t)(end - p) < 2 + kPresenceBytes + kBoolBytes) {
+        return false;
+    }
+    uint16_t sequence = (uint16_t)(p[0] | (p[1] << 8));
+    const uint8_t* presence = p + 2;
+    const uint8_t* bools = presence + kPresenceBytes;
+    p = bools + kBoolBytes;
+
+    // Decoded in full before anything is applied
+    int64_t values[BINARY_TELEMETRY_MAX_FIELDS];
+    for (size_t i = 0; i < kWire.number_count; i++) {
+        int64_t base = key ? 0 : values_[i];
+        if (!(presence[i / 8] & (1 << (i % 8)))) {
+            values[i] = base;
+            continue;
+        }
+        uint64_t raw;
+        size_t n = ReadVarint(p, (size_t)(end - p), raw);
+        if (n == 0 || n > VARINT_MAX_BYTES) {
+            return false;
+        }
+        p += n;
+        values[i] = base + UnZigZag(raw);
+    }
+    if (p != end) {
+        return false;
+    }
+
+    if (!key && (!synced_ || sequence != (uint16_t)(sequence_ + 1))) {
+        synced_ = false;
+        return true;
+    }
+    synced_ = true;
+    sequence_ = sequence;
+    memcpy(values_, values, kWire.number_count * sizeof(values[0]));
+
+    for (size_t i = 0; i < kWire.number_count; i++) {
+        Dequantize(snapshot_, kPositionSchema[kWire.numbers[i]], values_[i]);
+    }
+    for (size_t i = 0; i < kWire.bool_count; i++) {
+        WriteValue(snapshot_, kPositionSchema[kWire.bools[i]], (bools[i / 8] & (1 << (i % 8))) ? 1.0 : 0.0);
+    }
+    return true;
+}
+
+bool ConvertBinaryTelemetry(BinaryTelemetryDecoder& decoder, const uint8_t* data, size_t size, size_t& used, std::string& lines)
+{
+    used = 0;
+    char json[TELEMETRY_MAX_MESSAGE];
+    for (;;) {
+        size_t record;
+        BinaryRecord kind = decoder.Next(data + used, size - used, record);
+        used += record;
+        switch (kind) {
+            case BinaryRecord::NeedMore:
+                return true;
+            case BinaryRecord::Invalid:
+                return false;
+            case BinaryRecord::Position: {
+                size_t length = SerializePositionUpdate(decoder.Snapshot(), decoder.Source(), json, sizeof(json));
+                lines.append(json, length);
+                lines.push_back('\n');
+                break;
+            }
+            case BinaryRecord::Json:
+                lines.append(decoder.JsonText());
+                lines.push_back('\n');
+                break;
+            case BinaryRecord::Header:
+            case BinaryRecord::Skipped:
+                break;
+        }
+    }
+}
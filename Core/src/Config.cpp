@@ -0,0 +1,120 @@
+#include "include/Config.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+std::string Trim(const char* begin, const char* end)
+{
+    while (begin < end && (*begin == ' ' || *begin == '\t')) {
+        begin++;
+    }
+    while (end > begin && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r' || end[-1] == '\n')) {
+        end--;
+    }
+    return std::string(begin, end);
+}
+
+// strcasecmp is POSIX only
+bool IsAnyOf(const char* value, const char* const* words)
+{
+    for (; *words; words++) {
+        const char* a = value;
+        const char* b = *words;
+        while (*a && tolower((unsigned char)*a) == *b) {
+            a++;
+            b++;
+        }
+        if (*a == '\0' && *b == '\0') {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+bool ConfigFile::Load(const char* path)
+{
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        return false;
+    }
+    char line[512];
+    while (fgets(line, sizeof(line), file)) {
+        const char* end = line + strlen(line);
+        const char* comment = strpbrk(line, "#;");
+        if (comment) {
+            end = comment;
+        }
+        const char* equals = (const char*)memchr(line, '=', (size_t)(end - line));
+        if (!equals) {
+            continue;   // blank, comment or [section]
+        }
+        std::string key = Trim(line, equals);
+        if (key.empty()) {
+            continue;
+        }
+        std::string value = Trim(equals + 1, end);
+        // Later lines win, like every other ini reader
+        bool replaced = false;
+        for (auto& entry : values_) {
+            if (entry.first == key) {
+                entry.second = value;
+                replaced = true;
+            }
+        }
+        if (!replaced) {
+            values_.emplace_back(std::move(key), std::move(value));
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+const std::string* ConfigFile::Find(const char* key) const
+{
+    for (const auto& entry : values_) {
+        if (entry.first == key) {
+            return &entry.second;
+        }
+    }
+    return nullptr;
+}
+
+const char* ConfigFile::GetString(const char* key, const char* fallback) const
+{
+    const std::string* value = Find(key);
+    return value ? value->c_str() : fallback;
+}
+
+double ConfigFile::GetNumber(const char* key, double fallback) const
+{
+    const std::string* value = Find(key);
+    if (!value || value->empty()) {
+        return fallback;
+    }
+    char* end = nullptr;
+    double number = strtod(value->c_str(), &end);
+    return *end == '\0' ? number : fallback;
+}
+
+bool ConfigFile::GetBool(const char* key, bool fallback) const
+{
+    const std::string* value = Find(key);
+    if (!value) {
+        return fallback;
+    }
+    static const char* const kTrue[] = { "1", "true", "yes", "on", nullptr };
+    static const char* const kFalse[] = { "0", "false", "no", "off", nullptr };
+    if (IsAnyOf(value->c_str(), kTrue)) {
+        return true;
+    }
+    if (IsAnyOf(value->c_str(), kFalse)) {
+        return false;
+    }
+    return fallback;
+}
@@ -0,0 +1,259 @@
+#include "include/Connection.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+const char* ConnectionStateName(ConnectionState state)
+{
+    switch (state) {
+        case ConnectionState::Disconnected: return "disconnected";
+        case ConnectionState::Connecting:   return "connecting";
+        case ConnectionState::Connected:    return "connected";
+        case ConnectionState::BackingOff:   return "backing off";
+    }
+    return "unknown";
+}
+
+Connection::Connection(const ConnectionConfig& config)
+    : config_(config),
+      rng_((uint32_t)Clock::now().time_since_epoch().count()),
+      out_(config.send_buffer_bytes, config.send_buffer_messages, config.newline_delimited)
+{
+    SocketStartup();
+}
+
+Connection::~Connection()
+{
+    CloseSocket(sock_);
+    SocketCleanup();
+}
+
+void Connection::Log(const char* format, ...)
+{
+    if (!config_.log) {
+        return;
+    }
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    config_.log(line);
+}
+
+bool Connection::PreparePoll(struct pollfd& pfd) const
+{
+    if (sock_ == SOCKET_INVALID) {
+        return false;
+    }
+    pfd.fd = sock_;
+    // While connecting we wait for writability (the connect finished);
+    // afterwards for the peer closing, and for room when a write was short
+    if (state_ == ConnectionState::Connecting) {
+        pfd.events = POLLOUT;
+    }
+    else {
+        pfd.events = out_.Empty() ? POLLIN : POLLIN | POLLOUT;
+    }
+    pfd.revents = 0;
+    return true;
+}
+
+int Connection::PollTimeoutMs(Clock::time_point now, int idle_ms) const
+{
+    if (state_ == ConnectionState::Disconnected) {
+        return 0;
+    }
+    if (state_ == ConnectionState::Connected) {
+        return idle_ms;
+    }
+    // Round up, or we'd spin through the last partial millisecond
+    auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline_ - now).count();
+    if (remaining < 0) {
+        return 0;
+    }
+    return remaining < idle_ms ? (int)remaining : idle_ms;
+}
+
+void Connection::StartConnect(Clock::time_point now)
+{
+    counters_.connect_attempts++;
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(config_.port);
+    if (inet_pton(AF_INET, config_.host, &addr.sin_addr) != 1) {
+        Fail(now, "Invalid address", 0);
+        return;
+    }
+
+    sock_ = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (sock_ == SOCKET_INVALID) {
+        Fail(now, "Unable to create socket", SocketLastError());
+        return;
+    }
+    ConfigureStreamSocket(sock_);
+
+    state_ = ConnectionState::Connecting;
+    deadline_ = now + std::chrono::milliseconds(config_.connect_timeout_ms);
+
+    if (connect(sock_, (struct sockaddr*)&addr, sizeof(addr)) == 0) {
+        OnConnected();
+        return;
+    }
+    int error = SocketLastError();
+    if (error != SOCKET_EINPROGRESS && !SocketWouldBlock(error)) {
+        Fail(now, "Unable to connect to", error);
+    }
+}
+
+void Connection::OnConnected()
+{
+    state_ = ConnectionState::Connected;
+    failures_ = 0;
+    just_connected_ = true;
+    counters_.connects++;
+    Log("OpenVolanta: Connected to %s:%u\n", config_.host, (unsigned)config_.port);
+}
+
+void Connection::Fail(Clock::time_point now, const char* what, int error)
+{
+    bool was_connected = state_ == ConnectionState::Connected;
+    CloseSocket(sock_);
+    // A half written frame can't be continued on the next connection
+    discarded_ += out_.PendingFrames();
+    out_.Clear();
+    SyncCounters();
+    if (was_connected) {
+        counters_.disconnects++;
+    }
+    else {
+        counters_.connect_failures++;
+    }
+
+    // 250ms, 500ms, 1s, ... capped, then "equal jitter": half fixed, half random
+    failures_++;
+    uint32_t shift = failures_ - 1 < 16 ? failures_ - 1 : 16;
+    uint64_t delay = (uint64_t)config_.backoff_initial_ms << shift;
+    if (delay > config_.backoff_max_ms) {
+        delay = config_.backoff_max_ms;
+    }
+    delay = delay / 2 + rng_() % (delay / 2 + 1);
+
+    state_ = ConnectionState::BackingOff;
+    deadline_ = now + std::chrono::milliseconds(delay);
+
+    // A steady stream of "refused" while Volanta is closed isn't news, so only
+    // the first failure of a streak is reported
+    if (was_connected || failures_ == 1) {
+        Log("OpenVolanta: %s %s:%u (error %d), retrying with backoff\n",
+            what, config_.host, (unsigned)config_.port, error);
+    }
+}
+
+void Connection::Update(Clock::time_point now, short revents)
+{
+    switch (state_) {
+        case ConnectionState::Disconnected:
+            StartConnect(now);
+            break;
+
+        case ConnectionState::BackingOff:
+            if (now >= deadline_) {
+                StartConnect(now);
+            }
+            break;
+
+        case ConnectionState::Connecting: {
+            if (revents & (POLLOUT | POLLERR | POLLHUP)) {
+                int error = 0;
+                socklen_t len = sizeof(error);
+                getsockopt(sock_, SOL_SOCKET, SO_ERROR, (char*)&error, &len);
+                if (error == 0 && !(revents & POLLERR)) {
+                    OnConnected();
+                }
+                else {
+                    Fail(now, "Unable to connect to", error);
+                }
+            }
+            else if (now >= deadline_) {
+                Fail(now, "Timed out connecting to", 0);
+            }
+            break;
+        }
+
+        case ConnectionState::Connected: {
+            if (revents & (POLLERR | POLLHUP | POLLNVAL)) {
+                Fail(now, "Lost connection to", SocketLastError());
+                break;
+            }
+            if (revents & POLLIN) {
+                // Nothing is expected from the peer; drain it and watch for EOF
+                char scratch[512];
+                int received = (int)recv(sock_, scratch, sizeof(scratch), 0);
+                if (received == 0) {
+                    Fail(now, "Connection closed by", 0);
+                }
+                else if (received < 0 && !SocketWouldBlock(SocketLastError())) {
+                    Fail(now, "Lost connection to", SocketLastError());
+                    break;
+                }
+            }
+            if (revents & POLLOUT) {
+                Flush(now);
+            }
+            break;
+        }
+    }
+}
+
+bool Connection::Send(const char* data, size_t length)
+{
+    if (state_ != ConnectionState::Connected) {
+        not_connected_++;
+        SyncCounters();
+        return false;
+    }
+    bool queued = out_.Append(data, length);
+    SyncCounters();
+    return queued;
+}
+
+void Connection::Flush(Clock::time_point now)
+{
+    if (state_ != ConnectionState::Connected || out_.Empty()) {
+        return;
+    }
+    int error = 0;
+    OutputBuffer::FlushResult result = out_.Flush(sock_, error);
+    SyncCounters();
+    if (result == OutputBuffer::FlushResult::Error) {
+        Fail(now, "Lost connection to", error);
+    }
+}
+
+void Connection::SyncCounters()
+{
+    const OutputBuffer::Counters& out = out_.Stats();
+    counters_.messages_dropped = not_connected_ + out.frames_rejected + out.frames_evicted + discarded_;
+    counters_.messages_sent = out.frames_sent;
+    counters_.bytes_sent = out.bytes_sent;
+    counters_.send_calls = out.sends;
+    counters_.partial_writes = out.partial_writes;
+}
+
+void Connection::Disconnect(Clock::time_point now)
+{
+    if (state_ == ConnectionState::Connected || state_ == ConnectionState::Connecting) {
+        Fail(now, "Disconnected from", 0);
+    }
+}
+
+bool Connection::TakeJustConnected()
+{
+    bool result = just_connected_;
+    just_connected_ = false;
+    return result;
+}
@@ -0,0 +1,460 @@
+#include "include/FanoutServer.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#ifdef __linux__
+    #include <sys/epoll.h>
+#endif
+
+#define FANOUT_BACKLOG 8
+#define FANOUT_EPOLL_EVENTS 32
+
+// One message as every subscriber sees it, delimiter included. Only the
+// owning thread touches `refs`, so it needs no atomics.
+struct FanoutServer::Frame {
+    uint32_t refs;
+    uint32_t length;
+
+    const char* Data() const { return (const char*)(this + 1); }
+};
+
+FanoutConfig ReadFanoutConfig(const ConfigFile& file)
+{
+    FanoutConfig config;
+    config.enabled = file.GetBool("fanout", config.enabled);
+    config.bind_address = file.GetString("fanout_bind", config.bind_address);
+    config.port = (uint16_t)file.GetNumber("fanout_port", config.port);
+    config.max_clients = (uint32_t)file.GetNumber("fanout_max_clients", config.max_clients);
+    config.queue_frames = (uint32_t)file.GetNumber("fanout_queue", config.queue_frames);
+    config.binary = strcmp(file.GetString("fanout_format", "json"), "binary") == 0;
+    return config;
+}
+
+FanoutServer::FanoutServer(const FanoutConfig& config)
+    : config_(config)
+{
+    if (config_.queue_frames == 0) {
+        config_.queue_frames = 1;
+    }
+#ifndef __linux__
+    // Every subscriber is its own pollfd here
+    if (config_.max_clients > FANOUT_MAX_POLL - 1) {
+        config_.max_clients = FANOUT_MAX_POLL - 1;
+    }
+#endif
+    SocketStartup();
+}
+
+FanoutServer::~FanoutServer()
+{
+    while (!clients_.empty()) {
+        Close(clients_.size() - 1, nullptr);
+    }
+    CloseSocket(listener_);
+#ifdef __linux__
+    if (epoll_ >= 0) {
+        close(epoll_);
+    }
+#endif
+    SocketCleanup();
+}
+
+void FanoutServer::Log(const char* format, ...)
+{
+    if (!config_.log) {
+        return;
+    }
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    config_.log(line);
+}
+
+bool FanoutServer::Start()
+{
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(config_.port);
+    if (inet_pton(AF_INET, config_.bind_address, &addr.sin_addr) != 1) {
+        Log("OpenVolanta: Invalid fan-out address %s\n", config_.bind_address);
+        return false;
+    }
+
+    listener_ = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listener_ == SOCKET_INVALID) {
+        Log("OpenVolanta: Unable to create fan-out socket (error %d)\n", SocketLastError());
+        return false;
+    }
+    // A restarted plugin must not wait out TIME_WAIT from the last session
+    int one = 1;
+    setsockopt(listener_, SOL_SOCKET, SO_REUSEADDR, (const char*)&one, sizeof(one));
+    if (bind(listener_, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(listener_, FANOUT_BACKLOG) != 0 ||
+        !SetNonBlocking(listener_)) {
+        Log("OpenVolanta: Unable to listen on %s:%u for fan-out (error %d)\n",
+            config_.bind_address, (unsigned)config_.port, SocketLastError());
+        CloseSocket(listener_);
+        return false;
+    }
+
+#ifdef __linux__
+    epoll_ = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = listener_;
+    if (epoll_ < 0 || epoll_ctl(epoll_, EPOLL_CTL_ADD, listener_, &event) != 0) {
+        Log("OpenVolanta: Unable to set up epoll for fan-out (error %d)\n", SocketLastError());
+        CloseSocket(listener_);
+        return false;
+    }
+#endif
+    Log("OpenVolanta: Fan-out listening on %s:%u\n", config_.bind_address, (unsigned)config_.port);
+    return true;
+}
+
+size_t FanoutServer::PreparePoll(struct pollfd* fds, size_t max) const
+{
+    if (listener_ == SOCKET_INVALID || max == 0) {
+        return 0;
+    }
+#ifdef __linux__
+    // Readable whenever any socket in the set has something for Update
+    fds[0].fd = epoll_;
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    return 1;
+#else
+    fds[0].fd = listener_;
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    size_t count = 1;
+    for (size_t i = 0; i < clients_.size() && count < max; i++, count++) {
+        fds[count].fd = clients_[i].sock;
+        fds[count].events = clients_[i].want_write ? POLLIN | POLLOUT : POLLIN;
+        fds[count].revents = 0;
+    }
+    return count;
+#endif
+}
+
+void FanoutServer::Update(const struct pollfd* fds, size_t count)
+{
+    for (Client& client : clients_) {
+        client.fresh = false;
+    }
+    if (listener_ == SOCKET_INVALID) {
+        return;
+    }
+
+    // Collected first: handling an event can close a subscriber and reorder
+    // clients_
+    struct Ready {
+        socket_t sock;
+        bool     readable;
+        bool     writable;
+    };
+#ifdef __linux__
+    if (count == 0 || fds[0].revents == 0) {
+        return;
+    }
+    struct epoll_event events[FANOUT_EPOLL_EVENTS];
+    int n = epoll_wait(epoll_, events, FANOUT_EPOLL_EVENTS, 0);
+    Ready ready[FANOUT_EPOLL_EVENTS];
+    size_t ready_count = 0;
+    for (int i = 0; i < n; i++) {
+        ready[ready_count++] = Ready{ events[i].data.fd,
+            (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0,
+            (events[i].events & EPOLLOUT) != 0 };
+    }
+#else
+    Ready ready[FANOUT_MAX_POLL];
+    size_t ready_count = 0;
+    for (size_t i = 0; i < count && i < FANOUT_MAX_POLL; i++) {
+        if (fds[i].revents != 0) {
+            ready[ready_count++] = Ready{ fds[i].fd,
+                (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) != 0,
+                (fds[i].revents & POLLOUT) != 0 };
+        }
+    }
+#endif
+
+    for (size_t r = 0; r < ready_count; r++) {
+        if (ready[r].sock == listener_) {
+            Accept();
+            continue;
+        }
+        size_t index = 0;
+        while (index < clients_.size() && clients_[index].sock != ready[r].sock) {
+            index++;
+        }
+        if (index == clients_.size()) {
+            continue;
+        }
+        if (ready[r].readable) {
+            // Subscribers have nothing to say; read only to notice them leave
+            char scratch[512];
+            for (;;) {
+                long received = (long)recv(clients_[index].sock, scratch, (int)sizeof(scratch), 0);
+                if (received > 0) {
+                    continue;
+                }
+                if (received < 0 && SocketWouldBlock(SocketLastError())) {
+                    break;
+                }
+                Close(index, received == 0 ? "closed the connection" : "failed");
+                index = clients_.size();
+                break;
+            }
+        }
+        if (index < clients_.size() && ready[r].writable) {
+            if (!FlushClient(clients_[index])) {
+                Close(index, "failed");
+            }
+        }
+    }
+}
+
+void FanoutServer::Accept()
+{
+    for (;;) {
+        socket_t sock = accept(listener_, nullptr, nullptr);
+        if (sock == SOCKET_INVALID) {
+            return;
+        }
+        if (clients_.size() >= config_.max_clients) {
+            CloseSocket(sock);
+            counters_.rejected++;
+            continue;
+        }
+        ConfigureStreamSocket(sock);
+#ifdef __linux__
+        struct epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.fd = sock;
+        if (epoll_ctl(epoll_, EPOLL_CTL_ADD, sock, &event) != 0) {
+            CloseSocket(sock);
+            counters_.rejected++;
+            continue;
+        }
+#endif
+        clients_.emplace_back();
+        Client& client = clients_.back();
+        client.sock = sock;
+        client.queue.assign(config_.queue_frames, nullptr);
+        client.fresh = true;
+        new_clients_ = true;
+        counters_.accepted++;
+        Log("OpenVolanta: Fan-out subscriber connected, %u now\n", (unsigned)clients_.size());
+    }
+}
+
+void FanoutServer::Close(size_t index, const char* why)
+{
+    Client& client = clients_[index];
+    if (client.partial) {
+        Release(client.partial);
+    }
+    for (size_t i = 0; i < client.count; i++) {
+        Release(client.queue[(client.head + i) % client.queue.size()]);
+    }
+#ifdef __linux__
+    epoll_ctl(epoll_, EPOLL_CTL_DEL, client.sock, nullptr);
+#endif
+    CloseSocket(client.sock);
+    uint64_t dropped = client.dropped;
+    clients_[index] = std::move(clients_.back());
+    clients_.pop_back();
+    if (why) {
+        counters_.disconnected++;
+        Log("OpenVolanta: Fan-out subscriber %s after %llu dropped frames, %u left\n",
+            why, (unsigned long long)dropped, (unsigned)clients_.size());
+    }
+}
+
+bool FanoutServer::TakeNewClients()
+{
+    bool result = new_clients_;
+    new_clients_ = false;
+    return result;
+}
+
+FanoutServer::Frame* FanoutServer::NewFrame(const char* data, size_t length)
+{
+    // Binary records carry their own length
+    size_t delimiter = config_.binary ? 0 : 1;
+    Frame* frame = (Frame*)malloc(sizeof(Frame) + length + delimiter);
+    if (!frame) {
+        return nullptr;
+    }
+    frame->refs = 1;    // ours until the caller has handed it out
+    frame->length = (uint32_t)(length + delimiter);
+    char* bytes = (char*)(frame + 1);
+    memcpy(bytes, data, length);
+    if (delimiter) {
+        bytes[length] = '\n';
+    }
+    counters_.frames++;
+    return frame;
+}
+
+void FanoutServer::Release(Frame* frame)
+{
+    if (--frame->refs == 0) {
+        free(frame);
+    }
+}
+
+void FanoutServer::Enqueue(Client& client, Frame* frame)
+{
+    size_t capacity = client.queue.size();
+    if (client.count == capacity) {
+        // Oldest first; a frame already partly written lives in `partial`
+        // and always goes out whole
+        Release(client.queue[client.head]);
+        client.head = (client.head + 1) % capacity;
+        client.count--;
+        client.dropped++;
+        counters_.frames_dropped++;
+    }
+    frame->refs++;
+    client.queue[(client.head + client.count) % capacity] = frame;
+    client.count++;
+}
+
+void FanoutServer::Broadcast(const char* data, size_t length)
+{
+    if (clients_.empty() || length == 0) {
+        return;
+    }
+    Frame* frame = NewFrame(data, length);
+    if (!frame) {
+        return;
+    }
+    for (Client& client : clients_) {
+        Enqueue(client, frame);
+    }
+    Release(frame);
+}
+
+void FanoutServer::Greet(const char* data, size_t length)
+{
+    if (length == 0) {
+        return;
+    }
+    Frame* frame = nullptr;
+    for (Client& client : clients_) {
+        if (!client.fresh) {
+            continue;
+        }
+        if (!frame && !(frame = NewFrame(data, length))) {
+            return;
+        }
+        Enqueue(client, frame);
+    }
+    if (frame) {
+        Release(frame);
+    }
+}
+
+void FanoutServer::WatchWrites(Client& client, bool want)
+{
+    if (client.want_write == want) {
+        return;
+    }
+    client.want_write = want;
+#ifdef __linux__
+    struct epoll_event event = {};
+    event.events = want ? EPOLLIN | EPOLLOUT : EPOLLIN;
+    event.data.fd = client.sock;
+    epoll_ctl(epoll_, EPOLL_CTL_MOD, client.sock, &event);
+#endif
+}
+
+bool FanoutServer::FlushClient(Client& client)
+{
+    size_t capacity = client.queue.size();
+    while (client.partial || client.count > 0) {
+        SocketSlice slices[SOCKET_MAX_SLICES];
+        size_t slice_count = 0;
+        size_t total = 0;
+        if (client.partial) {
+            slices[slice_count++] = SocketSlice{ client.partial->Data() + client.partial_sent,
+                client.partial->length - client.partial_sent };
+        }
+        for (size_t i = 0; i < client.count && slice_count < SOCKET_MAX_SLICES; i++) {
+            const Frame* frame = client.queue[(client.head + i) % capacity];
+            slices[slice_count++] = SocketSlice{ frame->Data(), frame->length };
+        }
+        for (size_t i = 0; i < slice_count; i++) {
+            total += slices[i].length;
+        }
+
+        long sent = SendGather(client.sock, slices, slice_count);
+        if (sent < 0) {
+            int error = SocketLastError();
+            if (SocketWouldBlock(error) || error == SOCKET_EINTR) {
+                WatchWrites(client, true);
+                return true;
+            }
+            return false;
+        }
+        counters_.send_calls++;
+        counters_.bytes_sent += (uint64_t)sent;
+
+        size_t left = (size_t)sent;
+        if (client.partial) {
+            size_t remaining = client.partial->length - client.partial_sent;
+            size_t taken = left < remaining ? left : remaining;
+            client.partial_sent += taken;
+            left -= taken;
+            if (client.partial_sent == client.partial->length) {
+                Release(client.partial);
+                client.partial = nullptr;
+                client.partial_sent = 0;
+            }
+        }
+        while (left > 0) {
+            Frame* frame = client.queue[client.head];
+            client.head = (client.head + 1) % capacity;
+            client.count--;
+            if (left >= frame->length) {
+                left -= frame->length;
+                Release(frame);
+            }
+            else {
+                client.partial = frame;
+                client.partial_sent = left;
+                left = 0;
+            }
+        }
+        if ((size_t)sent < total) {
+            // The socket buffer is full; wait until it drains
+            WatchWrites(client, true);
+            return true;
+        }
+    }
+    WatchWrites(client, false);
+    return true;
+}
+
+void FanoutServer::Flush()
+{
+    // Backwards, since closing moves the last subscriber into the gap
+    for (size_t i = clients_.size(); i > 0; i--) {
+        Client& client = clients_[i - 1];
+        // Those waiting for POLLOUT are written from Update
+        if (client.want_write) {
+            continue;
+        }
+        if (!FlushClient(client)) {
+            Close(i - 1, "failed");
+        }
+    }
+}
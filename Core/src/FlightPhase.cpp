@@ -0,0 +1,113 @@
+#include "include/FlightPhase.h"
+
+const char* FlightPhaseName(FlightPhase phase)
+{
+    switch (phase) {
+        case FlightPhase::Unknown:  return "unknown";
+        case FlightPhase::Parked:   return "parked";
+        case FlightPhase::Taxi:     return "taxi";
+        case FlightPhase::Takeoff:  return "takeoff";
+        case FlightPhase::Climb:    return "climb";
+        case FlightPhase::Cruise:   return "cruise";
+        case FlightPhase::Descent:  return "descent";
+        case FlightPhase::Approach: return "approach";
+        case FlightPhase::Landed:   return "landed";
+    }
+    return "unknown";
+}
+
+PhaseConfig ReadPhaseConfig(const ConfigFile& file, float ground_speed_to_knots)
+{
+    PhaseConfig config;
+    config.taxi_kt = (float)file.GetNumber("phase_taxi_kt", config.taxi_kt);
+    config.takeoff_kt = (float)file.GetNumber("phase_takeoff_kt", config.takeoff_kt);
+    config.climb_fpm = (float)file.GetNumber("phase_climb_fpm", config.climb_fpm);
+    config.descent_fpm = (float)file.GetNumber("phase_descent_fpm", config.descent_fpm);
+    config.approach_agl_ft = (float)file.GetNumber("phase_approach_agl_ft", config.approach_agl_ft);
+    config.debounce_s = (float)file.GetNumber("phase_debounce_s", config.debounce_s);
+    config.edge_debounce_s = (float)file.GetNumber("phase_edge_debounce_s", config.edge_debounce_s);
+    config.ground_speed_to_knots = ground_speed_to_knots;
+    return config;
+}
+
+static bool IsAirborne(FlightPhase phase)
+{
+    switch (phase) {
+        case FlightPhase::Climb:
+        case FlightPhase::Cruise:
+        case FlightPhase::Descent:
+        case FlightPhase::Approach:
+            return true;
+        default:
+            return false;
+    }
+}
+
+FlightPhase FlightPhaseTracker::Candidate(const TelemetrySnapshot& snapshot) const
+{
+    if (snapshot.on_ground) {
+        float knots = snapshot.ground_speed * config_.ground_speed_to_knots;
+        if (knots >= config_.takeoff_kt) {
+            // Fast on the ground after flying is a rollout (or a touch and go)
+            bool landing = IsAirborne(phase_) || phase_ == FlightPhase::Landed;
+            return landing ? FlightPhase::Landed : FlightPhase::Takeoff;
+        }
+        if (knots >= config_.taxi_kt) {
+            return FlightPhase::Taxi;
+        }
+        if (!snapshot.engines_running || ParkingBrakeSet(snapshot)) {
+            return FlightPhase::Parked;
+        }
+        // Holding short or waiting in line
+        return phase_ == FlightPhase::Parked ? FlightPhase::Parked : FlightPhase::Taxi;
+    }
+
+    float vs = snapshot.vertical_speed;
+    if (vs >= config_.climb_fpm) {
+        return FlightPhase::Climb;
+    }
+    bool low = snapshot.altitude_agl * METERS_TO_FT < config_.approach_agl_ft;
+    if (low && (vs <= -config_.descent_fpm || phase_ == FlightPhase::Approach)) {
+        return FlightPhase::Approach;
+    }
+    if (vs <= -config_.descent_fpm) {
+        return FlightPhase::Descent;
+    }
+    return FlightPhase::Cruise;
+}
+
+bool FlightPhaseTracker::Update(const TelemetrySnapshot& snapshot, double now_s)
+{
+    if (snapshot.paused || snapshot.slew || snapshot.in_replay_mode) {
+        return false;
+    }
+
+    FlightPhase candidate = Candidate(snapshot);
+    if (candidate == phase_) {
+        pending_ = phase_;
+        return false;
+    }
+    if (candidate != pending_) {
+        pending_ = candidate;
+        pending_since_ = now_s;
+    }
+
+    double debounce = IsAirborne(candidate) != IsAirborne(phase_) ? config_.edge_debounce_s : config_.debounce_s;
+    if (phase_ != FlightPhase::Unknown && now_s - pending_since_ < debounce) {
+        return false;
+    }
+    previous_ = phase_;
+    phase_ = candidate;
+    return true;
+}
+
+PhaseChangeEvent FlightPhaseTracker::Event(const TelemetrySnapshot& snapshot) const
+{
+    PhaseChangeEvent event;
+    event.phase = FlightPhaseName(phase_);
+    event.previous = FlightPhaseName(previous_);
+    event.latitude = snapshot.latitude;
+    event.longitude = snapshot.longitude;
+    event.altitude_amsl = snapshot.altitude_amsl;
+    return event;
+}
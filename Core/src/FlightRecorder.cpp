@@ -0,0 +1,309 @@
+#include "include/FlightRecorder.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+
+#ifdef _WIN32
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+#define RECORDER_RETRY_S 10.0   // after a failed open, don't retry every frame
+
+static uint64_t ElapsedNs(std::chrono::steady_clock::time_point start)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void FillSchema(RecorderHeader& header)
+{
+    uint32_t count = 0;
+    for (const TelemetryField& field : kPositionSchema) {
+        if (field.format == FieldFormat::SimAbbreviation || field.format == FieldFormat::SimVersion) {
+            continue;
+        }
+        if (count == RECORDER_MAX_FIELDS) {
+            break;
+        }
+        RecorderField& out = header.fields[count++];
+        size_t length = field.key.size() < sizeof(out.key) - 1 ? field.key.size() : sizeof(out.key) - 1;
+        memcpy(out.key, field.key.data(), length);
+        out.type = (uint8_t)field.type;
+        out.format = (uint8_t)field.format;
+        out.offset = (uint16_t)(offsetof(RecorderRecord, snapshot) + field.offset);
+        out.scale = (float)field.scale;
+    }
+    header.field_count = count;
+}
+
+RecorderConfig ReadRecorderConfig(const ConfigFile& file, const std::string& directory)
+{
+    RecorderConfig config;
+    config.enabled = file.GetBool("recorder", config.enabled);
+    config.directory = file.GetString("recorder_dir", directory.c_str());
+    config.segment_mb = (uint32_t)file.GetNumber("recorder_segment_mb", config.segment_mb);
+    config.sync_interval_ms = (uint32_t)file.GetNumber("recorder_sync_ms", config.sync_interval_ms);
+    return config;
+}
+
+bool ReadRecording(const char* path, RecorderHeader& header, std::vector<RecorderRecord>& records)
+{
+    records.clear();
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return false;
+    }
+    bool valid = fread(&header, sizeof(header), 1, file) == 1
+        && memcmp(header.magic, RECORDER_MAGIC, sizeof(header.magic)) == 0
+        && header.version == RECORDER_VERSION
+        && header.header_size == RECORDER_HEADER_SIZE
+        && header.record_size == sizeof(RecorderRecord)
+        && fseek(file, RECORDER_HEADER_SIZE, SEEK_SET) == 0;
+    if (valid) {
+        records.reserve((size_t)header.records);
+        RecorderRecord record;
+        while (records.size() < header.capacity && fread(&record, sizeof(record), 1, file) == 1) {
+            if (record.sequence != records.size() + 1) {
+                break;
+            }
+            records.push_back(record);
+        }
+    }
+    fclose(file);
+    return valid;
+}
+
+FlightRecorder::FlightRecorder(const RecorderConfig& config)
+    : config_(config)
+{
+}
+
+FlightRecorder::~FlightRecorder()
+{
+    Close();
+}
+
+void FlightRecorder::NewFlight(const char* aircraft)
+{
+    Close();
+    flight_name_.clear();
+    segment_ = 0;
+    snprintf(aircraft_, sizeof(aircraft_), "%s", aircraft ? aircraft : "");
+}
+
+bool FlightRecorder::OpenSegment()
+{
+    if (flight_name_.empty()) {
+        time_t now = time(nullptr);
+        struct tm local;
+#ifdef _WIN32
+        localtime_s(&local, &now);
+#else
+        localtime_r(&now, &local);
+#endif
+        char name[64];
+        strftime(name, sizeof(name), "flight_%Y%m%d-%H%M%S", &local);
+        flight_name_ = name;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(config_.directory, ec);
+
+    char suffix[16] = "";
+    if (segment_ > 0) {
+        snprintf(suffix, sizeof(suffix), "-%u", segment_);
+    }
+    path_ = config_.directory + "/" + flight_name_ + suffix + ".ovr";
+
+    uint64_t segment_bytes = (uint64_t)(config_.segment_mb > 0 ? config_.segment_mb : 1) * 1024 * 1024;
+    uint64_t capacity = segment_bytes > RECORDER_HEADER_SIZE ? (segment_bytes - RECORDER_HEADER_SIZE) / sizeof(RecorderRecord) : 1;
+    size_t size = (size_t)(RECORDER_HEADER_SIZE + capacity * sizeof(RecorderRecord));
+
+    void* view = nullptr;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path_.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    // Creating the mapping with an explicit size extends the file to it
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)(size & 0xFFFFFFFF), NULL);
+    if (mapping != NULL) {
+        view = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+    }
+    if (view == nullptr) {
+        if (mapping != NULL) {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        DeleteFileA(path_.c_str());
+        return false;
+    }
+    file_ = file;
+    mapping_ = mapping;
+#else
+    int fd = open(path_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    // Allocate the blocks up front where we can: a sparse file that runs out
+    // of disk space halfway would SIGBUS on the next write into the mapping
+#ifdef __linux__
+    bool sized = posix_fallocate(fd, 0, (off_t)size) == 0;
+#else
+    bool sized = ftruncate(fd, (off_t)size) == 0;
+#endif
+    if (sized) {
+        view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (view == MAP_FAILED) {
+            view = nullptr;
+        }
+    }
+    if (view == nullptr) {
+        close(fd);
+        unlink(path_.c_str());
+        return false;
+    }
+    fd_ = fd;
+#endif
+
+    mapped_size_ = size;
+    header_ = (RecorderHeader*)view;
+    records_ = (RecorderRecord*)((char*)view + RECORDER_HEADER_SIZE);
+
+    memcpy(header_->magic, RECORDER_MAGIC, sizeof(header_->magic));
+    header_->version = RECORDER_VERSION;
+    header_->header_size = RECORDER_HEADER_SIZE;
+    header_->record_size = sizeof(RecorderRecord);
+    header_->capacity = capacity;
+    header_->records = 0;
+    header_->start_unix_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    header_->segment = segment_;
+    header_->closed = 0;
+    memcpy(header_->aircraft, aircraft_, sizeof(header_->aircraft));
+    FillSchema(*header_);
+
+    synced_ = 0;
+    counters_.segments++;
+    return true;
+}
+
+bool FlightRecorder::Append(const TelemetrySnapshot& snapshot, double now_s)
+{
+    if (header_ != nullptr && header_->records == header_->capacity) {
+        Close();
+        segment_++;
+    }
+    if (header_ == nullptr) {
+        if (now_s < retry_s_) {
+            return false;
+        }
+        if (!OpenSegment()) {
+            counters_.open_failures++;
+            retry_s_ = now_s + RECORDER_RETRY_S;
+            return false;
+        }
+        start_s_ = now_s;
+        last_sync_ = std::chrono::steady_clock::now();
+    }
+
+    uint64_t index = header_->records;
+    RecorderRecord& record = records_[index];
+    record.time_s = now_s - start_s_;
+    record.snapshot = snapshot;
+    record.sequence = index + 1;
+    header_->records = index + 1;
+    counters_.records++;
+    return true;
+}
+
+void FlightRecorder::Sync(bool force)
+{
+    if (header_ == nullptr || header_->records == synced_) {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (!force && now - last_sync_ < std::chrono::milliseconds(config_.sync_interval_ms)) {
+        return;
+    }
+    last_sync_ = now;
+
+    // Only the pages written since the last sync, plus the header page
+    uint64_t records = header_->records;
+    size_t first = RECORDER_HEADER_SIZE + (size_t)synced_ * sizeof(RecorderRecord);
+    size_t last = RECORDER_HEADER_SIZE + (size_t)records * sizeof(RecorderRecord);
+#ifndef _WIN32
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);   // msync wants an aligned start
+    first -= first % page;
+#endif
+
+    auto start = std::chrono::steady_clock::now();
+#ifdef _WIN32
+    // FlushViewOfFile only hands the pages to the cache manager; like
+    // MS_SYNC, FlushFileBuffers waits until they are on disk
+    FlushViewOfFile((char*)header_ + first, last - first);
+    FlushViewOfFile(header_, RECORDER_HEADER_SIZE);
+    FlushFileBuffers((HANDLE)file_);
+#else
+    msync((char*)header_ + first, last - first, MS_SYNC);
+    msync(header_, RECORDER_HEADER_SIZE, MS_SYNC);
+#endif
+    uint64_t elapsed = ElapsedNs(start);
+
+    synced_ = records;
+    counters_.syncs++;
+    counters_.sync_ns_total += elapsed;
+    if (elapsed > counters_.sync_ns_max) {
+        counters_.sync_ns_max = elapsed;
+    }
+}
+
+void FlightRecorder::Close()
+{
+    if (header_ == nullptr) {
+        return;
+    }
+    Sync(true);
+    header_->closed = 1;
+#ifdef _WIN32
+    FlushViewOfFile(header_, RECORDER_HEADER_SIZE);
+    FlushFileBuffers((HANDLE)file_);
+#else
+    msync(header_, RECORDER_HEADER_SIZE, MS_SYNC);
+#endif
+
+    size_t used = RECORDER_HEADER_SIZE + (size_t)header_->records * sizeof(RecorderRecord);
+#ifdef _WIN32
+    UnmapViewOfFile(header_);
+    CloseHandle((HANDLE)mapping_);
+    LARGE_INTEGER end;
+    end.QuadPart = (LONGLONG)used;
+    if (SetFilePointerEx((HANDLE)file_, end, NULL, FILE_BEGIN)) {
+        SetEndOfFile((HANDLE)file_);
+    }
+    CloseHandle((HANDLE)file_);
+    file_ = nullptr;
+    mapping_ = nullptr;
+#else
+    munmap(header_, mapped_size_);
+    if (ftruncate(fd_, (off_t)used) != 0) {
+        // Keeps the preallocated tail; readers go by the record count anyway
+    }
+    close(fd_);
+    fd_ = -1;
+#endif
+    header_ = nullptr;
+    records_ = nullptr;
+    mapped_size_ = 0;
+}
@@ -0,0 +1,54 @@
+#include "include/FrameStats.h"
+
+void FrameStats::Record(double frame_s)
+{
+    if (!(frame_s > 0.0)) {
+        return;   // first call after scheduling, or a clock hiccup
+    }
+    ema_s_ = ema_s_ > 0.0 ? ema_s_ + alpha_ * (frame_s - ema_s_) : frame_s;
+
+    size_t bucket = (size_t)(frame_s * 1000.0 / FRAME_BUCKET_MS);
+    buckets_[bucket < FRAME_BUCKETS ? bucket : FRAME_BUCKETS]++;
+    frames_++;
+    total_s_ += frame_s;
+    if (frame_s > max_s_) {
+        max_s_ = frame_s;
+    }
+}
+
+FramePercentiles FrameStats::Window() const
+{
+    FramePercentiles result = {};
+    result.frames = frames_;
+    if (frames_ == 0) {
+        return result;
+    }
+    result.max_ms = max_s_ * 1000.0;
+    result.mean_fps = (double)frames_ / total_s_;
+
+    // Upper edge of the bucket holding the rank, i.e. "at most this long";
+    // the overflow bucket reports the worst frame seen
+    const double ranks[3] = { 0.50, 0.95, 0.99 };
+    double* outputs[3] = { &result.p50_ms, &result.p95_ms, &result.p99_ms };
+    uint64_t seen = 0;
+    size_t next = 0;
+    for (size_t i = 0; i <= FRAME_BUCKETS && next < 3; i++) {
+        seen += buckets_[i];
+        while (next < 3 && (double)seen >= ranks[next] * (double)frames_) {
+            double edge = (double)(i + 1) * FRAME_BUCKET_MS;
+            *outputs[next] = (i == FRAME_BUCKETS || edge > result.max_ms) ? result.max_ms : edge;
+            next++;
+        }
+    }
+    return result;
+}
+
+void FrameStats::ResetWindow()
+{
+    for (uint32_t& bucket : buckets_) {
+        bucket = 0;
+    }
+    frames_ = 0;
+    total_s_ = 0.0;
+    max_s_ = 0.0;
+}
@@ -0,0 +1,131 @@
+#include "include/LandingDetector.h"
+
+#include <cmath>
+
+#define FPM_PER_MPS (METERS_TO_FT * 60.0)
+
+LandingConfig ReadLandingConfig(const ConfigFile& file)
+{
+    LandingConfig config;
+    config.arm_agl_ft = (float)file.GetNumber("landing_arm_agl_ft", config.arm_agl_ft);
+    config.fit_window_s = (float)file.GetNumber("landing_fit_s", config.fit_window_s);
+    config.g_window_s = (float)file.GetNumber("landing_g_window_s", config.g_window_s);
+    return config;
+}
+
+static float Lerp(float a, float b, double f)
+{
+    return (float)(a + (b - a) * f);
+}
+
+// Headings wrap, so interpolate along the short way round
+static float LerpHeading(float a, float b, double f)
+{
+    float diff = fmodf(b - a + 540.0f, 360.0f) - 180.0f;
+    return fmodf(a + diff * (float)f + 360.0f, 360.0f);
+}
+
+bool LandingDetector::Update(const TelemetrySnapshot& snapshot, double now_s, LandingEvent& event)
+{
+    // Frames where the sim isn't flying say nothing about the landing and
+    // would leave a gap in the history, so start over afterwards
+    if (snapshot.paused || snapshot.slew || snapshot.in_replay_mode) {
+        if (snapshot.slew || snapshot.in_replay_mode) {
+            state_ = State::Disarmed;
+        }
+        head_ = 0;
+        last_on_ground_ = snapshot.on_ground;
+        return false;
+    }
+
+    bool landed = false;
+    switch (state_) {
+        case State::Disarmed:
+            if (!snapshot.on_ground && snapshot.altitude_agl * METERS_TO_FT > config_.arm_agl_ft) {
+                state_ = State::Armed;
+            }
+            break;
+        case State::Armed:
+            if (last_on_ground_ == 0 && snapshot.on_ground && head_ > 0) {
+                Touch(snapshot, now_s);
+                state_ = State::Touchdown;
+            }
+            break;
+        case State::Touchdown:
+            if (snapshot.g_load > pending_.gforce) {
+                pending_.gforce = snapshot.g_load;
+            }
+            if (now_s >= g_until_s_ || !snapshot.on_ground) {
+                event = pending_;
+                state_ = State::Disarmed;
+                landed = true;
+            }
+            break;
+    }
+
+    Sample& sample = history_[head_ & (LANDING_HISTORY - 1)];
+    sample.t = now_s;
+    sample.agl_m = snapshot.altitude_agl;
+    sample.vs_fpm = snapshot.vertical_speed;
+    sample.g_load = snapshot.g_load;
+    sample.pitch = snapshot.pitch;
+    sample.bank = snapshot.bank;
+    sample.ground_speed = snapshot.ground_speed;
+    sample.heading = snapshot.heading_true;
+    sample.latitude = snapshot.latitude;
+    sample.longitude = snapshot.longitude;
+    head_++;
+    last_on_ground_ = snapshot.on_ground;
+    return landed;
+}
+
+void LandingDetector::Touch(const TelemetrySnapshot& snapshot, double now_s)
+{
+    const Sample& prev = Back(0);
+    double dt = now_s - prev.t;
+
+    // Least squares line through the airborne AGL samples just before
+    // contact, with time measured from the last of them
+    size_t available = head_ < LANDING_HISTORY ? head_ : LANDING_HISTORY;
+    double n = 0.0, sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+    for (size_t age = 0; age < available; age++) {
+        const Sample& s = Back(age);
+        double x = s.t - prev.t;
+        if (x < -config_.fit_window_s) {
+            break;
+        }
+        n += 1.0;
+        sx += x;
+        sy += s.agl_m;
+        sxx += x * x;
+        sxy += x * s.agl_m;
+    }
+    double denominator = n * sxx - sx * sx;
+
+    double slope = prev.vs_fpm / FPM_PER_MPS;
+    if (n >= 2.0 && denominator > 0.0) {
+        slope = (n * sxy - sx * sy) / denominator;     // m/s
+    }
+    pending_.landing_rate = (float)(slope * FPM_PER_MPS);
+
+    // The gear has been compressing at about the descent rate since it
+    // touched, so its deflection on this frame says how long ago that was
+    double offset = dt;
+    if (slope < 0.0 && snapshot.gear_deflection > 0.0f) {
+        offset = dt + snapshot.gear_deflection / slope;
+    }
+    offset = offset < 0.0 ? 0.0 : (offset > dt ? dt : offset);
+    double f = dt > 0.0 ? offset / dt : 1.0;
+    touchdown_offset_s_ = offset;
+
+    pending_.pitch = Lerp(prev.pitch, snapshot.pitch, f);
+    pending_.roll = Lerp(prev.bank, snapshot.bank, f);
+    pending_.ground_speed = Lerp(prev.ground_speed, snapshot.ground_speed, f) * config_.ground_speed_to_knots;
+    pending_.heading = LerpHeading(prev.heading, snapshot.heading_true, f);
+    pending_.latitude = prev.latitude + (snapshot.latitude - prev.latitude) * f;
+    pending_.longitude = prev.longitude + (snapshot.longitude - prev.longitude) * f;
+    pending_.wind_heading = snapshot.wind_direction;
+    pending_.wind_speed = snapshot.wind_speed;
+    pending_.gforce = snapshot.g_load;
+    g_until_s_ = prev.t + offset + config_.g_window_s;
+}
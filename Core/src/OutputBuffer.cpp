@@ -0,0 +1,114 @@
+#include "include/OutputBuffer.h"
+
+#include <cstring>
+
+OutputBuffer::OutputBuffer(size_t capacity, size_t max_frames, bool newline_delimited)
+    : data_(capacity), frames_(max_frames > 0 ? max_frames : 1), newline_delimited_(newline_delimited)
+{
+}
+
+void OutputBuffer::Clear()
+{
+    begin_ = end_ = 0;
+    frame_head_ = frame_count_ = 0;
+    front_sent_ = 0;
+}
+
+void OutputBuffer::EvictFrame(size_t index)
+{
+    // Byte offset of the frame inside [begin_, end_)
+    size_t offset = begin_;
+    for (size_t i = 0; i < index; i++) {
+        offset += FrameAt(i) - (i == 0 ? front_sent_ : 0);
+    }
+    size_t size = FrameAt(index);
+    memmove(&data_[offset], &data_[offset + size], end_ - offset - size);
+    end_ -= size;
+
+    for (size_t i = index; i + 1 < frame_count_; i++) {
+        FrameAt(i) = FrameAt(i + 1);
+    }
+    frame_count_--;
+    counters_.frames_evicted++;
+}
+
+bool OutputBuffer::MakeRoom(size_t needed)
+{
+    if (needed > data_.size()) {
+        return false;
+    }
+    for (;;) {
+        bool frame_slot = frame_count_ < frames_.size();
+        if (frame_slot && data_.size() - end_ >= needed) {
+            return true;
+        }
+        if (frame_slot && data_.size() - (end_ - begin_) >= needed) {
+            // Enough space overall, just not at the tail
+            memmove(&data_[0], &data_[begin_], end_ - begin_);
+            end_ -= begin_;
+            begin_ = 0;
+            continue;
+        }
+        // Drop the oldest frame that hasn't touched the wire yet
+        size_t victim = front_sent_ > 0 ? 1 : 0;
+        if (victim >= frame_count_) {
+            return false;
+        }
+        EvictFrame(victim);
+    }
+}
+
+bool OutputBuffer::Append(const char* data, size_t length)
+{
+    size_t needed = length + (newline_delimited_ ? 1 : 0);
+    if (length == 0 || !MakeRoom(needed)) {
+        counters_.frames_rejected++;
+        return false;
+    }
+    memcpy(&data_[end_], data, length);
+    end_ += length;
+    if (newline_delimited_) {
+        data_[end_++] = '\n';
+    }
+    FrameAt(frame_count_) = (uint32_t)needed;
+    frame_count_++;
+    counters_.frames_queued++;
+    return true;
+}
+
+OutputBuffer::FlushResult OutputBuffer::Flush(socket_t sock, int& error)
+{
+    error = 0;
+    while (begin_ < end_) {
+        int sent = (int)send(sock, &data_[begin_], (int)(end_ - begin_), SOCKET_SEND_FLAGS);
+        counters_.sends++;
+        if (sent < 0) {
+            error = SocketLastError();
+            if (error == SOCKET_EINTR) {
+                continue;
+            }
+            return SocketWouldBlock(error) ? FlushResult::WouldBlock : FlushResult::Error;
+        }
+        if ((size_t)sent < end_ - begin_) {
+            counters_.partial_writes++;
+        }
+        begin_ += (size_t)sent;
+        counters_.bytes_sent += (uint64_t)sent;
+
+        // Retire every frame the write completed
+        size_t progress = front_sent_ + (size_t)sent;
+        while (frame_count_ > 0 && progress >= FrameAt(0)) {
+            progress -= FrameAt(0);
+            frame_head_ = (frame_head_ + 1) % frames_.size();
+            frame_count_--;
+            counters_.frames_sent++;
+        }
+        front_sent_ = progress;
+
+        if ((size_t)sent == 0) {
+            return FlushResult::WouldBlock;
+        }
+    }
+    begin_ = end_ = 0;
+    return FlushResult::Done;
+}
@@ -0,0 +1,139 @@
+#include "include/RateController.h"
+
+#include <cmath>
+
+const char* SampleTierName(SampleTier tier)
+{
+    switch (tier) {
+        case SampleTier::Idle:     return "idle";
+        case SampleTier::Cruise:   return "cruise";
+        case SampleTier::Ground:   return "ground";
+        case SampleTier::Climb:    return "climb/descent";
+        case SampleTier::Approach: return "approach";
+    }
+    return "unknown";
+}
+
+RateConfig ReadRateConfig(const ConfigFile& file)
+{
+    RateConfig config;
+    config.cruise_hz = (float)file.GetNumber("cruise_hz", config.cruise_hz);
+    config.ground_hz = (float)file.GetNumber("ground_hz", config.ground_hz);
+    config.climb_hz = (float)file.GetNumber("climb_hz", config.climb_hz);
+    config.climb_enter_fpm = (float)file.GetNumber("climb_enter_fpm", config.climb_enter_fpm);
+    config.climb_exit_fpm = (float)file.GetNumber("climb_exit_fpm", config.climb_exit_fpm);
+    config.approach_agl_ft = (float)file.GetNumber("approach_agl_ft", config.approach_agl_ft);
+    config.approach_exit_agl_ft = (float)file.GetNumber("approach_exit_agl_ft", config.approach_agl_ft * 1.5f);
+    config.touchdown_hold_s = (float)file.GetNumber("touchdown_hold_s", config.touchdown_hold_s);
+    config.slowdown_delay_s = (float)file.GetNumber("slowdown_delay_s", config.slowdown_delay_s);
+    return config;
+}
+
+float RateController::TierHz(SampleTier tier) const
+{
+    switch (tier) {
+        case SampleTier::Idle:     return config_.cruise_hz;
+        case SampleTier::Cruise:   return config_.cruise_hz;
+        case SampleTier::Ground:   return config_.ground_hz;
+        case SampleTier::Climb:    return config_.climb_hz;
+        case SampleTier::Approach: return INFINITY;
+    }
+    return config_.cruise_hz;
+}
+
+float RateController::IntervalSeconds() const
+{
+    float hz = TierHz(tier_);
+    if (std::isinf(hz)) {
+        return 0.0f;
+    }
+    return hz > 0.0f ? 1.0f / hz : 1.0f;
+}
+
+SampleTier RateController::Wanted(const TelemetrySnapshot& snapshot, double now_s)
+{
+    if (last_on_ground_ >= 0 && snapshot.on_ground != last_on_ground_) {
+        hold_until_ = now_s + config_.touchdown_hold_s;
+    }
+    last_on_ground_ = snapshot.on_ground;
+
+    if (snapshot.paused || snapshot.slew || snapshot.in_replay_mode) {
+        return SampleTier::Idle;
+    }
+    if (now_s < hold_until_) {
+        return SampleTier::Approach;
+    }
+    if (snapshot.on_ground) {
+        in_approach_ = false;
+        in_climb_ = false;
+        return SampleTier::Ground;
+    }
+
+    double agl_ft = snapshot.altitude_agl * METERS_TO_FT;
+    in_approach_ = agl_ft < (in_approach_ ? config_.approach_exit_agl_ft : config_.approach_agl_ft);
+    if (in_approach_) {
+        return SampleTier::Approach;
+    }
+
+    float vs = fabsf(snapshot.vertical_speed);
+    in_climb_ = vs > (in_climb_ ? config_.climb_exit_fpm : config_.climb_enter_fpm);
+    return in_climb_ ? SampleTier::Climb : SampleTier::Cruise;
+}
+
+float RateController::Update(const TelemetrySnapshot& snapshot, double now_s)
+{
+    SampleTier wanted = Wanted(snapshot, now_s);
+    bool switch_now = false;
+    if (wanted == tier_ || TierHz(wanted) > TierHz(tier_)) {
+        switch_now = true;
+    }
+    else if (pending_ != wanted) {
+        pending_ = wanted;
+        pending_since_ = now_s;
+    }
+    else if (now_s - pending_since_ >= config_.slowdown_delay_s) {
+        switch_now = true;
+    }
+
+    if (switch_now) {
+        changed_ |= wanted != tier_;
+        tier_ = wanted;
+        pending_ = wanted;
+    }
+    return IntervalSeconds();
+}
+
+bool RateController::TakeChanged()
+{
+    bool result = changed_;
+    changed_ = false;
+    return result;
+}
+
+void RateStats::Record(double now_s, size_t message_bytes)
+{
+    // A long gap means nothing was being sent (disconnected, sim paused by
+    // the OS, ...), which the baseline wouldn't have sent either
+    if (last_s >= 0.0) {
+        double gap = now_s - last_s;
+        elapsed_s += gap < 2.0 ? gap : 2.0;
+    }
+    last_s = now_s;
+    updates++;
+    bytes += message_bytes;
+}
+
+double RateStats::EffectiveHz() const
+{
+    return elapsed_s > 0.0 ? (double)(updates > 0 ? updates - 1 : 0) / elapsed_s : 0.0;
+}
+
+int64_t RateStats::BytesSaved(double baseline_hz) const
+{
+    if (updates == 0) {
+        return 0;
+    }
+    double average = (double)bytes / (double)updates;
+    double baseline = (elapsed_s * baseline_hz + 1.0) * average;
+    return (int64_t)llround(baseline) - (int64_t)bytes;
+}
@@ -0,0 +1,246 @@
+#include "include/Registration.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+enum class Suffix : uint8_t {
+    Letters,   // A-Z
+    Digits,    // 0-9
+    Alnum,     // A-Z and 0-9
+    USN,       // [1-9][0-9]{0,4}[A-Z]{0,2}, at most 5 characters
+};
+
+struct Rule {
+    const char* prefix;    // 1 to 3 characters
+    bool        hyphen;    // prefix-SUFFIX vs PREFIXSUFFIX
+    uint8_t     min;       // suffix length
+    uint8_t     max;
+    Suffix      suffix;
+};
+
+// ICAO nationality marks in common use by airlines flying in the sims, with
+// the suffix shape each state allocates. Most two character prefixes mix
+// letters and digits in their suffixes (UR-PSA, EW-252PA, 4K-AZ81, EK-32001),
+// so those are Alnum; the old single letter European states are four letters.
+constexpr Rule kRules[] = {
+    // Americas
+    { "N",   false, 2, 5, Suffix::USN },
+    { "C",   true,  4, 4, Suffix::Letters },
+    { "XA",  true,  3, 3, Suffix::Letters }, { "XB", true, 3, 3, Suffix::Letters }, { "XC", true, 3, 3, Suffix::Letters },
+    { "TG",  true,  3, 4, Suffix::Alnum }, { "TI", true, 3, 4, Suffix::Alnum }, { "HP", true, 3, 7, Suffix::Alnum },
+    { "YS",  true,  3, 4, Suffix::Alnum }, { "HR", true, 3, 4, Suffix::Alnum }, { "YN", true, 3, 4, Suffix::Alnum },
+    { "HI",  true,  3, 4, Suffix::Alnum }, { "CU", true, 3, 5, Suffix::Alnum }, { "6Y", true, 3, 3, Suffix::Letters },
+    { "8P",  true,  3, 3, Suffix::Letters }, { "9Y", true, 3, 3, Suffix::Letters }, { "J6", true, 3, 3, Suffix::Letters },
+    { "VP",  true,  3, 3, Suffix::Letters }, { "VQ", true, 3, 3, Suffix::Letters }, { "P4", true, 3, 3, Suffix::Letters },
+    { "PJ",  true,  3, 3, Suffix::Letters }, { "PZ", true, 3, 3, Suffix::Alnum }, { "8R", true, 3, 4, Suffix::Alnum },
+    { "HC",  true,  3, 4, Suffix::Alnum }, { "HK", true, 4, 5, Suffix::Alnum }, { "YV", true, 3, 5, Suffix::Alnum },
+    { "OB",  true,  4, 5, Suffix::Alnum }, { "CP", true, 4, 5, Suffix::Alnum }, { "CC", true, 3, 4, Suffix::Alnum },
+    { "LV",  true,  3, 4, Suffix::Alnum }, { "LQ", true, 3, 4, Suffix::Alnum }, { "CX", true, 3, 4, Suffix::Alnum },
+    { "ZP",  true,  3, 4, Suffix::Alnum }, { "PP", true, 3, 3, Suffix::Letters }, { "PR", true, 3, 3, Suffix::Letters },
+    { "PS",  true,  3, 3, Suffix::Letters }, { "PT", true, 3, 3, Suffix::Letters }, { "PU", true, 3, 3, Suffix::Letters },
+    // Europe
+    { "D",   true,  4, 4, Suffix::Letters }, { "F", true, 4, 4, Suffix::Letters }, { "G", true, 4, 4, Suffix::Letters },
+    { "I",   true,  4, 4, Suffix::Letters }, { "M", true, 4, 4, Suffix::Letters },
+    { "EI",  true,  3, 3, Suffix::Letters }, { "EC", true, 3, 3, Suffix::Letters }, { "CS", true, 3, 3, Suffix::Letters },
+    { "HB",  true,  3, 3, Suffix::Letters }, { "OE", true, 3, 3, Suffix::Letters }, { "OO", true, 3, 3, Suffix::Letters },
+    { "PH",  true,  3, 4, Suffix::Alnum }, { "LX", true, 3, 3, Suffix::Letters }, { "LN", true, 3, 3, Suffix::Letters },
+    { "SE",  true,  3, 3, Suffix::Letters }, { "OY", true, 3, 3, Suffix::Letters }, { "OH", true, 3, 3, Suffix::Letters },
+    { "TF",  true,  3, 3, Suffix::Letters }, { "SP", true, 3, 4, Suffix::Alnum }, { "OK", true, 3, 4, Suffix::Alnum },
+    { "OM",  true,  3, 4, Suffix::Alnum }, { "HA", true, 3, 4, Suffix::Alnum }, { "YR", true, 3, 4, Suffix::Alnum },
+    { "LZ",  true,  3, 4, Suffix::Alnum }, { "SX", true, 3, 3, Suffix::Letters }, { "9H", true, 3, 3, Suffix::Letters },
+    { "5B",  true,  3, 3, Suffix::Letters }, { "TC", true, 3, 3, Suffix::Letters }, { "9A", true, 3, 3, Suffix::Letters },
+    { "S5",  true,  3, 3, Suffix::Letters }, { "E7", true, 3, 3, Suffix::Letters }, { "YU", true, 3, 3, Suffix::Letters },
+    { "4O",  true,  3, 3, Suffix::Letters }, { "Z3", true, 3, 3, Suffix::Letters }, { "ZA", true, 3, 3, Suffix::Letters },
+    { "LY",  true,  3, 3, Suffix::Letters }, { "YL", true, 3, 3, Suffix::Letters }, { "ES", true, 3, 3, Suffix::Letters },
+    { "ER",  true,  3, 5, Suffix::Alnum }, { "UR", true, 3, 5, Suffix::Alnum }, { "EW", true, 3, 5, Suffix::Alnum },
+    { "RA",  true,  4, 5, Suffix::Alnum }, { "3A", true, 3, 3, Suffix::Alnum },
+    // Middle East, Caucasus, Central Asia
+    { "4X",  true,  3, 3, Suffix::Letters }, { "OD", true, 3, 3, Suffix::Letters }, { "JY", true, 3, 3, Suffix::Letters },
+    { "HZ",  true,  3, 4, Suffix::Alnum }, { "A6", true, 3, 3, Suffix::Letters }, { "A7", true, 3, 3, Suffix::Letters },
+    { "A9C", true,  2, 3, Suffix::Alnum }, { "A4O", true, 2, 3, Suffix::Alnum }, { "9K", true, 3, 3, Suffix::Letters },
+    { "YI",  true,  3, 3, Suffix::Letters }, { "EP", true, 3, 3, Suffix::Letters }, { "YK", true, 3, 3, Suffix::Letters },
+    { "4L",  true,  3, 3, Suffix::Letters }, { "EK", true, 3, 5, Suffix::Alnum }, { "4K", true, 3, 5, Suffix::Alnum },
+    { "UP",  true,  3, 5, Suffix::Alnum }, { "UK", true, 3, 5, Suffix::Alnum }, { "EX", true, 3, 5, Suffix::Alnum },
+    { "EY",  true,  3, 5, Suffix::Alnum }, { "EZ", true, 3, 5, Suffix::Alnum }, { "YA", true, 3, 3, Suffix::Letters },
+    { "AP",  true,  3, 3, Suffix::Letters },
+    // Africa
+    { "SU",  true,  3, 3, Suffix::Letters }, { "CN", true, 3, 3, Suffix::Letters }, { "7T", true, 3, 3, Suffix::Letters },
+    { "TS",  true,  3, 3, Suffix::Letters }, { "5A", true, 3, 3, Suffix::Letters }, { "ST", true, 3, 3, Suffix::Alnum },
+    { "ET",  true,  3, 3, Suffix::Letters }, { "5Y", true, 3, 3, Suffix::Letters }, { "5H", true, 3, 3, Suffix::Letters },
+    { "5N",  true,  3, 3, Suffix::Letters }, { "9G", true, 3, 3, Suffix::Letters }, { "TU", true, 3, 3, Suffix::Letters },
+    { "6V",  true,  3, 3, Suffix::Letters }, { "ZS", true, 3, 3, Suffix::Letters }, { "V5", true, 3, 3, Suffix::Letters },
+    { "A2",  true,  3, 3, Suffix::Letters }, { "9J", true, 3, 3, Suffix::Letters }, { "Z",  true, 3, 3, Suffix::Letters },
+    { "7Q",  true,  3, 3, Suffix::Letters }, { "C9", true, 3, 3, Suffix::Letters }, { "D2", true, 3, 3, Suffix::Letters },
+    { "9XR", true,  2, 2, Suffix::Letters }, { "3B", true, 3, 3, Suffix::Letters }, { "5R", true, 3, 3, Suffix::Letters },
+    { "S7",  true,  3, 3, Suffix::Letters }, { "D4", true, 3, 3, Suffix::Letters }, { "TT", true, 3, 3, Suffix::Letters },
+    { "TR",  true,  3, 3, Suffix::Letters }, { "TJ", true, 3, 3, Suffix::Letters }, { "9Q", true, 3, 3, Suffix::Letters },
+    // Asia and Pacific
+    { "B",   true,  3, 5, Suffix::Alnum },
+    { "JA",  false, 4, 4, Suffix::Alnum }, { "HL", false, 4, 4, Suffix::Digits },
+    { "VT",  true,  3, 3, Suffix::Letters }, { "S2", true, 3, 3, Suffix::Letters },
+    { "4R",  true,  3, 3, Suffix::Letters }, { "9N", true, 3, 3, Suffix::Letters }, { "8Q", true, 3, 3, Suffix::Letters },
+    { "A5",  true,  3, 3, Suffix::Letters }, { "XY", true, 3, 3, Suffix::Letters }, { "HS", true, 3, 3, Suffix::Letters },
+    { "XU",  true,  3, 3, Suffix::Letters }, { "VN", true, 4, 4, Suffix::Alnum }, { "9M", true, 3, 3, Suffix::Letters },
+    { "9V",  true,  3, 3, Suffix::Letters }, { "PK", true, 3, 3, Suffix::Letters }, { "RP", true, 4, 5, Suffix::Alnum },
+    { "4W",  true,  3, 3, Suffix::Letters }, { "P2", true, 3, 3, Suffix::Letters }, { "DQ", true, 3, 3, Suffix::Letters },
+    { "VH",  true,  3, 3, Suffix::Letters }, { "ZK", true, 3, 3, Suffix::Letters }, { "YJ", true, 3, 3, Suffix::Letters },
+    { "H4",  true,  3, 3, Suffix::Letters }, { "5W", true, 3, 3, Suffix::Letters }, { "A3", true, 3, 3, Suffix::Letters },
+    { "T3",  true,  3, 3, Suffix::Letters }, { "V7", true, 3, 4, Suffix::Alnum }, { "C2", true, 3, 3, Suffix::Letters },
+    { "UN",  true,  3, 5, Suffix::Alnum }, { "JU", true, 4, 4, Suffix::Alnum },
+};
+
+constexpr size_t kRuleCount = sizeof(kRules) / sizeof(kRules[0]);
+
+// A-Z -> 0..25, 0-9 -> 26..35, anything else -> -1
+constexpr int CharIndex(char c)
+{
+    if (c >= 'A' && c <= 'Z') {
+        return c - 'A';
+    }
+    if (c >= '0' && c <= '9') {
+        return 26 + (c - '0');
+    }
+    return -1;
+}
+
+#define REG_SYMBOLS 36
+#define REG_SINGLE REG_SYMBOLS   // second index for one character prefixes
+
+// [first char][second char or REG_SINGLE] -> rule index + 1, 0 when no
+// nationality mark starts that way. Built at compile time from kRules.
+struct PrefixTable {
+    uint8_t next[REG_SYMBOLS][REG_SYMBOLS + 1] = {};
+};
+
+constexpr PrefixTable BuildPrefixTable()
+{
+    PrefixTable table;
+    for (size_t i = 0; i < kRuleCount; i++) {
+        const char* p = kRules[i].prefix;
+        int second = p[1] == '\0' ? REG_SINGLE : CharIndex(p[1]);
+        // First declaration wins, so a duplicate can't shadow an earlier rule
+        if (table.next[CharIndex(p[0])][second] == 0) {
+            table.next[CharIndex(p[0])][second] = (uint8_t)(i + 1);
+        }
+    }
+    return table;
+}
+
+constexpr PrefixTable kPrefixTable = BuildPrefixTable();
+static_assert(kRuleCount < 255, "rule index must fit the table");
+
+inline bool IsAlnum(char c)
+{
+    return CharIndex(c) >= 0 || (c >= 'a' && c <= 'z');
+}
+
+inline bool IsKind(char c, Suffix kind)
+{
+    switch (kind) {
+        case Suffix::Letters: return c >= 'A' && c <= 'Z';
+        case Suffix::Digits:  return c >= '0' && c <= '9';
+        case Suffix::Alnum:   return CharIndex(c) >= 0;
+        case Suffix::USN:     break;   // handled in MatchSuffix
+    }
+    return false;
+}
+
+// Length of the suffix at text[start], or 0 if it doesn't fit the rule or
+// runs into more letters/digits
+size_t MatchSuffix(std::string_view text, size_t start, const Rule& rule)
+{
+    size_t n = 0;
+    if (rule.suffix == Suffix::USN) {
+        // N-number: no leading zero, up to five digits, up to two letters at the end
+        size_t digits = 0;
+        if (start < text.size() && text[start] >= '1' && text[start] <= '9') {
+            while (start + digits < text.size() && digits < 5 && text[start + digits] >= '0' && text[start + digits] <= '9') {
+                digits++;
+            }
+        }
+        if (digits == 0) {
+            return 0;
+        }
+        size_t letters = 0;
+        while (start + digits + letters < text.size() && letters < 2 && digits + letters < 5
+               && text[start + digits + letters] >= 'A' && text[start + digits + letters] <= 'Z') {
+            letters++;
+        }
+        n = digits + letters;
+    }
+    else {
+        while (start + n < text.size() && n < rule.max && IsKind(text[start + n], rule.suffix)) {
+            n++;
+        }
+    }
+    if (n < rule.min) {
+        return 0;
+    }
+    if (start + n < text.size() && IsAlnum(text[start + n])) {
+        return 0;
+    }
+    return n;
+}
+
+// Tries one rule at text[i]; returns the full registration length or 0
+size_t MatchRule(std::string_view text, size_t i, uint8_t entry)
+{
+    if (entry == 0) {
+        return 0;
+    }
+    const Rule& rule = kRules[entry - 1];
+    size_t prefix = strlen(rule.prefix);
+    if (text.size() - i < prefix || text.compare(i, prefix, rule.prefix) != 0) {
+        return 0;
+    }
+    size_t start = i + prefix;
+    if (rule.hyphen) {
+        if (start >= text.size() || text[start] != '-') {
+            return 0;
+        }
+        start++;
+    }
+    size_t suffix = MatchSuffix(text, start, rule);
+    return suffix > 0 ? start + suffix - i : 0;
+}
+
+} // namespace
+
+bool FindRegistration(std::string_view text, char* out, size_t out_size)
+{
+    if (out_size > 0) {
+        out[0] = '\0';
+    }
+    for (size_t i = 0; i + 1 < text.size(); i++) {
+        int first = CharIndex(text[i]);
+        if (first < 0 || (i > 0 && IsAlnum(text[i - 1]))) {
+            continue;
+        }
+        // Longer prefixes first: "DQ-FJA" is Fiji, not a malformed "D-"
+        int second = CharIndex(text[i + 1]);
+        size_t length = second >= 0 ? MatchRule(text, i, kPrefixTable.next[first][second]) : 0;
+        if (length == 0) {
+            length = MatchRule(text, i, kPrefixTable.next[first][REG_SINGLE]);
+        }
+        if (length > 0) {
+            if (out_size > 0) {
+                size_t copy = length < out_size - 1 ? length : out_size - 1;
+                memcpy(out, text.data() + i, copy);
+                out[copy] = '\0';
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string_view LiveryFolderName(std::string_view path)
+{
+    while (!path.empty() && (path.back() == '/' || path.back() == '\\' || path.back() == ':')) {
+        path.remove_suffix(1);
+    }
+    size_t slash = path.find_last_of("/\\:");
+    return slash == std::string_view::npos ? path : path.substr(slash + 1);
+}
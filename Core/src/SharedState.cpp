@@ -0,0 +1,203 @@
+#include "include/SharedState.h"
+
+#include <cstring>
+
+#ifdef _WIN32
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+SharedStateConfig ReadSharedStateConfig(const ConfigFile& file)
+{
+    SharedStateConfig config;
+    config.enabled = file.GetBool("shared_memory", config.enabled);
+    config.name = file.GetString("shared_memory_name", config.name);
+    return config;
+}
+
+static std::string SegmentName(const char* name)
+{
+#ifdef _WIN32
+    return std::string("Local\\") + name;
+#else
+    return std::string("/") + name;
+#endif
+}
+
+bool SharedStateWriter::Open(const char* name)
+{
+    Close();
+    name_ = SegmentName(name);
+    void* view = nullptr;
+#ifdef _WIN32
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, sizeof(SharedStateBlock), name_.c_str());
+    if (mapping == NULL) {
+        return false;
+    }
+    view = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, sizeof(SharedStateBlock));
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        return false;
+    }
+    mapping_ = mapping;
+#else
+    // Not O_EXCL: a segment left behind by a crashed simulator is reused
+    int fd = shm_open(name_.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    if (ftruncate(fd, (off_t)sizeof(SharedStateBlock)) == 0) {
+        view = mmap(nullptr, sizeof(SharedStateBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (view == MAP_FAILED) {
+            view = nullptr;
+        }
+    }
+    // The mapping keeps the segment alive
+    close(fd);
+    if (view == nullptr) {
+        shm_unlink(name_.c_str());
+        return false;
+    }
+#endif
+
+    block_ = (SharedStateBlock*)view;
+    block_->live.store(0, std::memory_order_relaxed);
+    block_->sequence.store(0, std::memory_order_relaxed);
+    block_->magic = SHARED_STATE_MAGIC | SHARED_STATE_VERSION;
+    block_->state_size = sizeof(SharedState);
+    update_ = 0;
+    block_->live.store(1, std::memory_order_release);
+    return true;
+}
+
+void SharedStateWriter::Publish(const TelemetrySnapshot& snapshot, double time_s)
+{
+    SharedState state;
+    state.update = ++update_;
+    state.time_s = time_s;
+    state.snapshot = snapshot;
+    uint64_t words[SHARED_STATE_WORDS];
+    memcpy(words, &state, sizeof(words));
+
+    // Only this thread writes `sequence`, so a plain increment is enough
+    uint64_t sequence = block_->sequence.load(std::memory_order_relaxed);
+    block_->sequence.store(sequence + 1, std::memory_order_relaxed);
+    // Odd must be visible before any of the words change
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < SHARED_STATE_WORDS; i++) {
+        block_->words[i].store(words[i], std::memory_order_relaxed);
+    }
+    block_->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+void SharedStateWriter::Close()
+{
+    if (block_ == nullptr) {
+        return;
+    }
+    block_->live.store(0, std::memory_order_release);
+#ifdef _WIN32
+    UnmapViewOfFile(block_);
+    CloseHandle((HANDLE)mapping_);
+    mapping_ = nullptr;
+#else
+    munmap(block_, sizeof(SharedStateBlock));
+    // Readers keep what they have mapped; new ones find nothing
+    shm_unlink(name_.c_str());
+#endif
+    block_ = nullptr;
+}
+
+bool SharedStateReader::Open(const char* name)
+{
+    Close();
+    std::string segment = SegmentName(name);
+    void* view = nullptr;
+#ifdef _WIN32
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, segment.c_str());
+    if (mapping == NULL) {
+        return false;
+    }
+    view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, sizeof(SharedStateBlock));
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        return false;
+    }
+    mapping_ = mapping;
+#else
+    int fd = shm_open(segment.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && (size_t)info.st_size >= sizeof(SharedStateBlock)) {
+        view = mmap(nullptr, sizeof(SharedStateBlock), PROT_READ, MAP_SHARED, fd, 0);
+        if (view == MAP_FAILED) {
+            view = nullptr;
+        }
+    }
+    close(fd);
+    if (view == nullptr) {
+        return false;
+    }
+#endif
+
+    block_ = (const SharedStateBlock*)view;
+    // A writer still setting up, or one built with a different layout
+    if (!Live() || block_->magic != (SHARED_STATE_MAGIC | SHARED_STATE_VERSION) || block_->state_size != sizeof(SharedState)) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void SharedStateReader::Close()
+{
+    if (block_ == nullptr) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(block_);
+    CloseHandle((HANDLE)mapping_);
+    mapping_ = nullptr;
+#else
+    munmap((void*)block_, sizeof(SharedStateBlock));
+#endif
+    block_ = nullptr;
+}
+
+bool SharedStateReader::Read(SharedState& out) const
+{
+    uint64_t words[SHARED_STATE_WORDS];
+    for (int attempt = 0; attempt < SHARED_STATE_MAX_RETRIES; attempt++) {
+        uint64_t before = block_->sequence.load(std::memory_order_acquire);
+        if (before == 0) {
+            return false;
+        }
+        if (before & 1) {
+            retries_++;
+            continue;
+        }
+        for (size_t i = 0; i < SHARED_STATE_WORDS; i++) {
+            words[i] = block_->words[i].load(std::memory_order_relaxed);
+        }
+        // The words must be read before `sequence` is checked again
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (block_->sequence.load(std::memory_order_relaxed) == before) {
+            memcpy(&out, words, sizeof(out));
+            return true;
+        }
+        retries_++;
+    }
+    return false;
+}
@@ -0,0 +1,132 @@
+#include "include/Socket.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#ifndef _WIN32
+    #include <sys/uio.h>
+#endif
+
+static std::atomic<int> gSocketUsers{0};
+
+bool SocketStartup()
+{
+#ifdef _WIN32
+    if (gSocketUsers.fetch_add(1) == 0) {
+        WSADATA wsa;
+        if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+            gSocketUsers.fetch_sub(1);
+            return false;
+        }
+    }
+#else
+    gSocketUsers.fetch_add(1);
+#endif
+    return true;
+}
+
+void SocketCleanup()
+{
+    if (gSocketUsers.fetch_sub(1) == 1) {
+#ifdef _WIN32
+        WSACleanup();
+#endif
+    }
+}
+
+int SocketLastError()
+{
+#ifdef _WIN32
+    return WSAGetLastError();
+#else
+    return errno;
+#endif
+}
+
+bool SocketWouldBlock(int error)
+{
+#ifdef _WIN32
+    return error == WSAEWOULDBLOCK;
+#else
+    return error == EWOULDBLOCK || error == EAGAIN;
+#endif
+}
+
+bool SetNonBlocking(socket_t sock)
+{
+#ifdef _WIN32
+    u_long mode = 1;
+    return ioctlsocket(sock, FIONBIO, &mode) == 0;
+#else
+    int flags = fcntl(sock, F_GETFL, 0);
+    return flags >= 0 && fcntl(sock, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+bool ConfigureStreamSocket(socket_t sock)
+{
+    int one = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (const char*)&one, sizeof(one));
+#ifdef SO_NOSIGPIPE
+    setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, (const char*)&one, sizeof(one));
+#endif
+    return SetNonBlocking(sock);
+}
+
+void CloseSocket(socket_t& sock)
+{
+    if (sock == SOCKET_INVALID) {
+        return;
+    }
+#ifdef _WIN32
+    closesocket(sock);
+#else
+    close(sock);
+#endif
+    sock = SOCKET_INVALID;
+}
+
+int PollSockets(struct pollfd* fds, size_t count, int timeout_ms)
+{
+    if (count == 0) {
+        if (timeout_ms > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+        }
+        return 0;
+    }
+#ifdef _WIN32
+    return WSAPoll(fds, (ULONG)count, timeout_ms);
+#else
+    return poll(fds, (nfds_t)count, timeout_ms);
+#endif
+}
+
+long SendGather(socket_t sock, const SocketSlice* slices, size_t count)
+{
+    if (count > SOCKET_MAX_SLICES) {
+        count = SOCKET_MAX_SLICES;
+    }
+#ifdef _WIN32
+    WSABUF buffers[SOCKET_MAX_SLICES];
+    for (size_t i = 0; i < count; i++) {
+        buffers[i].buf = (CHAR*)slices[i].data;
+        buffers[i].len = (ULONG)slices[i].length;
+    }
+    DWORD sent = 0;
+    if (WSASend(sock, buffers, (DWORD)count, &sent, 0, NULL, NULL) != 0) {
+        return -1;
+    }
+    return (long)sent;
+#else
+    struct iovec buffers[SOCKET_MAX_SLICES];
+    for (size_t i = 0; i < count; i++) {
+        buffers[i].iov_base = (void*)slices[i].data;
+        buffers[i].iov_len = slices[i].length;
+    }
+    struct msghdr message = {};
+    message.msg_iov = buffers;
+    message.msg_iovlen = count;
+    return (long)sendmsg(sock, &message, SOCKET_SEND_FLAGS);
+#endif
+}
@@ -0,0 +1,235 @@
+#include "include/Telemetry.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Appends to a fixed buffer and remembers whether anything was cut off, so the
+// hot path doesn't need a bounds check result at every call site.
+class JsonWriter {
+public:
+    JsonWriter(char* out, size_t out_size)
+        : begin_(out), cur_(out), end_(out_size > 0 ? out + out_size - 1 : out), size_(out_size), overflow_(out_size == 0) {}
+
+    void Raw(std::string_view text) {
+        if ((size_t)(end_ - cur_) < text.size()) {
+            overflow_ = true;
+            return;
+        }
+        memcpy(cur_, text.data(), text.size());
+        cur_ += text.size();
+    }
+
+    void Char(char c) {
+        if (cur_ == end_) {
+            overflow_ = true;
+            return;
+        }
+        *cur_++ = c;
+    }
+
+    void Key(std::string_view key) {
+        Char('"');
+        Raw(key);
+        Raw("\":");
+    }
+
+    void Number(double value, int precision) {
+        // JSON has no representation for NaN/inf; report them as zero
+        if (!std::isfinite(value)) {
+            value = 0.0;
+        }
+        // Telemetry values are small, so a scaled integer covers nearly every
+        // call and is several times cheaper than the generic fixed formatter
+        static const double pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+        if (precision >= 0 && precision <= 9 && std::fabs(value) < 1e9) {
+            long long scaled = std::llround(std::fabs(value) * pow10[precision]);
+            long long unit = (long long)pow10[precision];
+            if (value < 0 && scaled != 0) {
+                Char('-');
+            }
+            Integer(scaled / unit);
+            if (precision > 0) {
+                char frac[16];
+                long long rem = scaled % unit;
+                for (int i = precision - 1; i >= 0; i--) {
+                    frac[i] = (char)('0' + rem % 10);
+                    rem /= 10;
+                }
+                Char('.');
+                Raw(std::string_view(frac, (size_t)precision));
+            }
+            return;
+        }
+        std::to_chars_result r = precision < 0
+            ? std::to_chars(cur_, end_, value)
+            : std::to_chars(cur_, end_, value, std::chars_format::fixed, precision);
+        if (r.ec != std::errc()) {
+            overflow_ = true;
+            return;
+        }
+        cur_ = r.ptr;
+    }
+
+    void Integer(long long value) {
+        std::to_chars_result r = std::to_chars(cur_, end_, value);
+        if (r.ec != std::errc()) {
+            overflow_ = true;
+            return;
+        }
+        cur_ = r.ptr;
+    }
+
+    void Bool(bool value) {
+        Raw(value ? std::string_view("true") : std::string_view("false"));
+    }
+
+    void Transponder(int32_t code) {
+        char digits[16];
+        std::to_chars_result r = std::to_chars(digits, digits + sizeof(digits), code < 0 ? 0 : code);
+        size_t len = (size_t)(r.ptr - digits);
+        Char('"');
+        for (size_t i = len; i < 4; i++) {
+            Char('0');
+        }
+        Raw(std::string_view(digits, len));
+        Char('"');
+    }
+
+    void String(const char* value) {
+        Char('"');
+        for (const char* p = value ? value : ""; *p; p++) {
+            unsigned char c = (unsigned char)*p;
+            if (c == '"' || c == '\\') {
+                Char('\\');
+                Char((char)c);
+            }
+            else if (c < 0x20) {
+                static const char hex[] = "0123456789abcdef";
+                Raw("\\u00");
+                Char(hex[c >> 4]);
+                Char(hex[c & 0xF]);
+            }
+            else {
+                Char((char)c);
+            }
+        }
+        Char('"');
+    }
+
+    size_t Finish() {
+        if (overflow_) {
+            if (size_ > 0) {
+                *begin_ = '\0';
+            }
+            return 0;
+        }
+        *cur_ = '\0';
+        return (size_t)(cur_ - begin_);
+    }
+
+private:
+    char* begin_;
+    char* cur_;
+    char* end_;
+    size_t size_;
+    bool  overflow_;
+};
+
+double ReadField(const TelemetrySnapshot& snapshot, const TelemetryField& field) {
+    const char* base = reinterpret_cast<const char*>(&snapshot) + field.offset;
+    switch (field.type) {
+        case FieldType::F64: { double v;  memcpy(&v, base, sizeof(v)); return v; }
+        case FieldType::F32: { float v;   memcpy(&v, base, sizeof(v)); return v; }
+        case FieldType::I32: { int32_t v; memcpy(&v, base, sizeof(v)); return v; }
+    }
+    return 0.0;
+}
+
+} // namespace
+
+size_t SerializePositionUpdate(const TelemetrySnapshot& snapshot, const TelemetrySource& source, char* out, size_t out_size)
+{
+    JsonWriter w(out, out_size);
+    w.Raw("{\"type\":\"STREAM\",\"name\":\"POSITION_UPDATE\",\"data\":{");
+
+    bool first = true;
+    for (const TelemetryField& field : kPositionSchema) {
+        if (!first) {
+            w.Char(',');
+        }
+        first = false;
+        w.Key(field.key);
+
+        switch (field.format) {
+            case FieldFormat::Number:
+                w.Number(ReadField(snapshot, field) * field.scale, field.precision);
+                break;
+            case FieldFormat::Bool:
+                w.Bool(ReadField(snapshot, field) > field.threshold);
+                break;
+            case FieldFormat::Transponder:
+                w.Transponder(snapshot.transponder);
+                break;
+            case FieldFormat::SimAbbreviation:
+                w.Char('"');
+                w.Raw(source.abbreviation);
+                w.Char('"');
+                break;
+            case FieldFormat::SimVersion:
+                w.Char('"');
+                w.Raw(source.version);
+                w.Char('"');
+                break;
+        }
+    }
+
+    w.Raw("}}");
+    return w.Finish();
+}
+
+size_t SerializeAircraftUpdate(const AircraftInfo& aircraft, char* out, size_t out_size)
+{
+    JsonWriter w(out, out_size);
+    w.Raw("{\"type\":\"STREAM\",\"name\":\"AIRCRAFT_UPDATE\",\"data\":{");
+    w.Key("title");        w.String(aircraft.title);        w.Char(',');
+    w.Key("type");         w.String(aircraft.type);         w.Char(',');
+    w.Key("model");        w.String(aircraft.model);        w.Char(',');
+    w.Key("registration"); w.String(aircraft.registration); w.Char(',');
+    w.Key("airline");      w.String(aircraft.airline);
+    w.Raw("}}");
+    return w.Finish();
+}
+
+size_t SerializeLandingEvent(const LandingEvent& landing, char* out, size_t out_size)
+{
+    JsonWriter w(out, out_size);
+    w.Raw("{\"type\":\"STREAM\",\"name\":\"EVENT_LANDING\",\"data\":{");
+    w.Key("landing_rate"); w.Number(landing.landing_rate, 6); w.Char(',');
+    w.Key("gforce");       w.Number(landing.gforce, 6);       w.Char(',');
+    w.Key("pitch");        w.Number(landing.pitch, 6);        w.Char(',');
+    w.Key("roll");         w.Number(landing.roll, 6);         w.Char(',');
+    w.Key("ground_speed"); w.Number(landing.ground_speed, 6); w.Char(',');
+    w.Key("latitude");     w.Number(landing.latitude, 6);     w.Char(',');
+    w.Key("longitude");    w.Number(landing.longitude, 6);    w.Char(',');
+    w.Key("heading");      w.Number(landing.heading, 6);      w.Char(',');
+    w.Key("wind_heading"); w.Number(landing.wind_heading, 6); w.Char(',');
+    w.Key("wind_speed");   w.Number(landing.wind_speed, 6);
+    w.Raw("}}");
+    return w.Finish();
+}
+
+size_t SerializePhaseChange(const PhaseChangeEvent& change, char* out, size_t out_size)
+{
+    JsonWriter w(out, out_size);
+    w.Raw("{\"type\":\"STREAM\",\"name\":\"PHASE_CHANGE\",\"data\":{");
+    w.Key("phase");          w.String(change.phase);                               w.Char(',');
+    w.Key("previous_phase"); w.String(change.previous);                            w.Char(',');
+    w.Key("latitude");       w.Number(change.latitude, 7);                         w.Char(',');
+    w.Key("longitude");      w.Number(change.longitude, 7);                        w.Char(',');
+    w.Key("altitude_amsl");  w.Number(change.altitude_amsl * METERS_TO_FT, 2);
+    w.Raw("}}");
+    return w.Finish();
+}
@@ -0,0 +1,140 @@
+#include "include/TrackSimplifier.h"
+
+#include <cmath>
+
+#define EARTH_RADIUS_M 6371008.8
+#define DEG_TO_RAD 0.017453292519943295
+
+SimplifyConfig ReadSimplifyConfig(const ConfigFile& file)
+{
+    SimplifyConfig config;
+    config.enabled = file.GetBool("track_simplify", config.enabled);
+    config.position_m = (float)file.GetNumber("track_position_m", config.position_m);
+    config.altitude_ft = (float)file.GetNumber("track_altitude_ft", config.altitude_ft);
+    config.heading_deg = (float)file.GetNumber("track_heading_deg", config.heading_deg);
+    config.max_interval_s = (float)file.GetNumber("track_max_interval_s", config.max_interval_s);
+    return config;
+}
+
+// Meters east/north of (origin_latitude, origin_longitude)
+static void Project(double origin_latitude, double origin_longitude, double latitude, double longitude, double& east, double& north)
+{
+    double dlon = longitude - origin_longitude;
+    if (dlon > 180.0) {
+        dlon -= 360.0;
+    }
+    else if (dlon < -180.0) {
+        dlon += 360.0;
+    }
+    east = dlon * DEG_TO_RAD * EARTH_RADIUS_M * std::cos(origin_latitude * DEG_TO_RAD);
+    north = (latitude - origin_latitude) * DEG_TO_RAD * EARTH_RADIUS_M;
+}
+
+static float HeadingDifference(float a, float b)
+{
+    float d = std::fabs(a - b);
+    return d > 180.0f ? 360.0f - d : d;
+}
+
+static bool DiscreteChanged(const TelemetrySnapshot& a, const TelemetrySnapshot& b)
+{
+    return a.on_ground != b.on_ground
+        || a.paused != b.paused
+        || a.slew != b.slew
+        || a.in_replay_mode != b.in_replay_mode
+        || a.engines_running != b.engines_running
+        || a.autopilot_engaged != b.autopilot_engaged
+        || a.transponder != b.transponder
+        || ParkingBrakeSet(a) != ParkingBrakeSet(b);
+}
+
+bool TrackSimplifier::Offer(const TelemetrySnapshot& snapshot, double now_s, bool keep)
+{
+    stats_.offered++;
+    const Point current = { now_s, snapshot.latitude, snapshot.longitude, snapshot.altitude_amsl };
+
+    bool send = keep || force_ || !config_.enabled;
+    if (!send) {
+        double dt = now_s - anchor_t_;
+        if (dt >= config_.max_interval_s || pending_count_ == TRACK_PENDING_MAX || DiscreteChanged(snapshot, anchor_)) {
+            send = true;
+        }
+        else {
+            double east, north;
+            Project(anchor_.latitude, anchor_.longitude, snapshot.latitude, snapshot.longitude, east, north);
+            double error_east = east - velocity_east_ * dt;
+            double error_north = north - velocity_north_ * dt;
+            double climb_mps = anchor_.vertical_speed / 60.0 / METERS_TO_FT;
+            double altitude_error_ft = std::fabs(snapshot.altitude_amsl - (anchor_.altitude_amsl + climb_mps * dt)) * METERS_TO_FT;
+            send = error_east * error_east + error_north * error_north > (double)config_.position_m * config_.position_m
+                || altitude_error_ft > config_.altitude_ft
+                || HeadingDifference(snapshot.heading_true, anchor_.heading_true) > config_.heading_deg;
+        }
+    }
+
+    if (send) {
+        Sent(snapshot, now_s);
+    }
+    else {
+        pending_[pending_count_++] = current;
+    }
+    previous_ = current;
+    have_previous_ = true;
+    return send;
+}
+
+void TrackSimplifier::Sent(const TelemetrySnapshot& snapshot, double now_s)
+{
+    stats_.sent++;
+    const Point current = { now_s, snapshot.latitude, snapshot.longitude, snapshot.altitude_amsl };
+    if (force_) {
+        // Whatever was held back before a reconnect never reached anyone
+        force_ = false;
+    }
+    else {
+        MeasureChord(current);
+    }
+    pending_count_ = 0;
+
+    // Velocity over the last sample interval, so extrapolation follows the
+    // track over the ground rather than the heading
+    velocity_east_ = 0.0;
+    velocity_north_ = 0.0;
+    if (have_previous_ && now_s > previous_.t) {
+        double east, north;
+        Project(snapshot.latitude, snapshot.longitude, previous_.latitude, previous_.longitude, east, north);
+        velocity_east_ = -east / (now_s - previous_.t);
+        velocity_north_ = -north / (now_s - previous_.t);
+    }
+    anchor_ = snapshot;
+    anchor_t_ = now_s;
+}
+
+void TrackSimplifier::MeasureChord(const Point& end)
+{
+    double end_east, end_north;
+    Project(anchor_.latitude, anchor_.longitude, end.latitude, end.longitude, end_east, end_north);
+    double length2 = end_east * end_east + end_north * end_north;
+    double duration = end.t - anchor_t_;
+
+    for (size_t i = 0; i < pending_count_; i++) {
+        const Point& p = pending_[i];
+        double east, north;
+        Project(anchor_.latitude, anchor_.longitude, p.latitude, p.longitude, east, north);
+        double u = length2 > 0.0 ? (east * end_east + north * end_north) / length2 : 0.0;
+        u = u < 0.0 ? 0.0 : (u > 1.0 ? 1.0 : u);
+        double de = east - u * end_east;
+        double dn = north - u * end_north;
+        double position_error = std::sqrt(de * de + dn * dn);
+        if (position_error > stats_.max_position_error_m) {
+            stats_.max_position_error_m = position_error;
+        }
+
+        double f = duration > 0.0 ? (p.t - anchor_t_) / duration : 0.0;
+        double altitude = anchor_.altitude_amsl + (end.altitude_m - anchor_.altitude_amsl) * f;
+        double altitude_error_ft = std::fabs(p.altitude_m - altitude) * METERS_TO_FT;
+        if (altitude_error_ft > stats_.max_altitude_error_ft) {
+            stats_.max_altitude_error_ft = altitude_error_ft;
+        }
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "Telemetry.h"
+
+// Compact binary form of the POSITION_UPDATE stream, for our own consumers
+// (the local fan-out), never for Volanta. It carries exactly what the JSON
+// carries: every Number field is quantized to the decimals the serializer
+// prints, so a decoded frame serializes back to byte for byte the same JSON.
+//
+// A stream is a sequence of records, each `varint length, kind, payload`:
+//
+//   'H' header    "OVBT", version, the numeric and boolean keys in wire
+//                 order with their decimals, sim abbreviation and version.
+//                 A decoder refuses a schema it wasn't built with.
+//   'K' key       u16 sequence, presence bitmap, boolean bitmap, then a
+//                 zigzag varint of every present (non-zero) value
+//   'D' delta     same layout, values are differences to the previous
+//                 frame and only the fields that changed are present
+//   'J' json      any other message (aircraft, phase, landing) as text
+//
+// Numeric fields are the schema's Number fields plus the transponder;
+// booleans are packed one bit each. Deltas only apply on top of the frame
+// with the previous sequence number; after a gap (a subscriber that had
+// frames dropped) the decoder skips deltas until the next key frame.
+
+#define BINARY_TELEMETRY_MAGIC "OVBT"
+#define BINARY_TELEMETRY_VERSION 1
+#define BINARY_TELEMETRY_KEY_INTERVAL 64    // frames between key frames
+#define BINARY_TELEMETRY_MAX_FIELDS 32
+#define BINARY_TELEMETRY_MAX_RECORD 512     // any header or position record
+
+class BinaryTelemetryEncoder {
+public:
+    explicit BinaryTelemetryEncoder(uint32_t key_interval = BINARY_TELEMETRY_KEY_INTERVAL);
+
+    // Each returns the bytes written, or 0 if `out` is too small
+    size_t Header(const TelemetrySource& source, uint8_t* out, size_t out_size) const;
+    size_t Position(const TelemetrySnapshot& snapshot, uint8_t* out, size_t out_size);
+    static size_t Json(const char* json, size_t length, uint8_t* out, size_t out_size);
+
+    // The next Position is a key frame (a new subscriber has to start somewhere)
+    void ForceKeyFrame() { until_key_ = 0; }
+
+private:
+    uint32_t key_interval_;
+    uint32_t until_key_ = 0;
+    uint16_t sequence_ = 0;
+    int64_t  previous_[BINARY_TELEMETRY_MAX_FIELDS] = {};
+};
+
+enum class BinaryRecord : uint8_t {
+    NeedMore,   // not a whole record yet
+    Header,
+    Position,   // Snapshot() holds it
+    Json,       // JsonText() holds it
+    Skipped,    // a delta with nothing to apply it to
+    Invalid,    // malformed, or a schema this build doesn't know
+};
+
+class BinaryTelemetryDecoder {
+public:
+    // Decodes the record at the start of `data`. `used` is how many bytes it
+    // took (0 for NeedMore; the rest of the stream is useless after Invalid).
+    BinaryRecord Next(const uint8_t* data, size_t size, size_t& used);
+
+    const TelemetrySnapshot& Snapshot() const { return snapshot_; }
+    TelemetrySource Source() const { return { abbreviation_, version_ }; }
+    std::string_view JsonText() const { return json_; }
+
+private:
+    bool ReadHeader(const uint8_t* p, const uint8_t* end);
+    bool ReadFrame(const uint8_t* p, const uint8_t* end, bool key);
+
+    bool              have_header_ = false;
+    bool              synced_ = false;
+    uint16_t          sequence_ = 0;
+    int64_t           values_[BINARY_TELEMETRY_MAX_FIELDS] = {};
+    TelemetrySnapshot snapshot_ = {};
+    std::string       abbreviation_;
+    std::string       version_;
+    std::string_view  json_;
+};
+
+// Converter for consumers that want the JSON back: decodes every whole record
+// in `data` and appends one line per position or text message to `lines`.
+// Returns false on an invalid record; `used` is what was consumed either way.
+bool ConvertBinaryTelemetry(BinaryTelemetryDecoder& decoder, const uint8_t* data, size_t size, size_t& used, std::string& lines);
@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+#include <utility>
+#include <vector>
+
+// Settings from OpenVolanta.ini: one `key = value` per line, '#' or ';'
+// start a comment, [section] headers are accepted and ignored. A missing file
+// or key simply means "use the built-in default", so every Get* takes one.
+//
+// Loaded once at startup; returned strings stay valid for the lifetime of the
+// object.
+class ConfigFile {
+public:
+    bool Load(const char* path);
+
+    const char* GetString(const char* key, const char* fallback) const;
+    double      GetNumber(const char* key, double fallback) const;
+    bool        GetBool(const char* key, bool fallback) const;
+
+    size_t Size() const { return values_.size(); }
+
+private:
+    const std::string* Find(const char* key) const;
+
+    std::vector<std::pair<std::string, std::string>> values_;
+};
+
+#define CONFIG_FILE_NAME "OpenVolanta.ini"
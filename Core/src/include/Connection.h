@@ -0,0 +1,118 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+
+#include "OutputBuffer.h"
+#include "Socket.h"
+
+// Outgoing TCP connection to Volanta (or anything else listening on 6746).
+//
+//   Disconnected -> Connecting -> Connected
+//        ^              |             |
+//        +-- BackingOff <-------------+   (connect failure, timeout or peer loss)
+//
+// Connects are non-blocking and completed through poll. Failed attempts back
+// off exponentially with jitter, so while Volanta is not running the owner
+// wakes up a handful of times per minute instead of creating a socket per tick.
+//
+// Outgoing messages go through an OutputBuffer: Send only queues, Flush (and
+// Update on POLLOUT) writes everything pending in one call and resumes short
+// writes, so a slow peer never sees half a message followed by the next one.
+
+enum class ConnectionState : uint8_t {
+    Disconnected,
+    Connecting,
+    Connected,
+    BackingOff,
+};
+
+const char* ConnectionStateName(ConnectionState state);
+
+struct ConnectionCounters {
+    uint64_t connect_attempts = 0;
+    uint64_t connects = 0;
+    uint64_t connect_failures = 0;
+    uint64_t disconnects = 0;
+    uint64_t messages_sent = 0;      // completely written to the socket
+    uint64_t bytes_sent = 0;
+    uint64_t messages_dropped = 0;   // not connected, evicted from a full buffer or lost on disconnect
+    uint64_t send_calls = 0;
+    uint64_t partial_writes = 0;
+};
+
+struct ConnectionConfig {
+    const char* host = "127.0.0.1";
+    uint16_t    port = 6746;
+    uint32_t    connect_timeout_ms = 2000;
+    uint32_t    backoff_initial_ms = 250;
+    uint32_t    backoff_max_ms = 15000;
+    // Volanta reads a stream of JSON objects; a '\n' after each one matches
+    // what the FlyWithLua script sends and lets line based tools split it
+    bool        newline_delimited = true;
+    uint32_t    send_buffer_bytes = 64 * 1024;
+    uint32_t    send_buffer_messages = 256;
+    void        (*log)(const char* line) = nullptr;
+};
+
+class Connection {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    explicit Connection(const ConnectionConfig& config);
+    ~Connection();
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    // Fills in the descriptor and events to wait for. Returns false when
+    // there is nothing to poll (disconnected or backing off).
+    bool PreparePoll(struct pollfd& pfd) const;
+
+    // Advances the state machine. `revents` comes from the pollfd filled by
+    // PreparePoll, or 0 if the poll timed out / wasn't used.
+    void Update(Clock::time_point now, short revents = 0);
+
+    // How long the owner may sleep before Update has to run again
+    int PollTimeoutMs(Clock::time_point now, int idle_ms) const;
+
+    // Queues one complete message. Returns false (and counts a drop) if the
+    // connection is not up or the message doesn't fit in the send buffer.
+    bool Send(const char* data, size_t length);
+
+    // Writes as much of the queue as the socket takes. Call after a batch of
+    // Sends; whatever is left goes out from Update once the socket is writable.
+    void Flush(Clock::time_point now);
+
+    // Drops the connection and backs off before the next attempt
+    void Disconnect(Clock::time_point now);
+
+    ConnectionState State() const { return state_; }
+    bool IsConnected() const { return state_ == ConnectionState::Connected; }
+    const ConnectionCounters& Counters() const { return counters_; }
+
+    // True exactly once after each successful connect, so the owner can
+    // replay state the peer needs up front (e.g. the current aircraft)
+    bool TakeJustConnected();
+
+    socket_t Socket() const { return sock_; }
+
+private:
+    void StartConnect(Clock::time_point now);
+    void OnConnected();
+    void Fail(Clock::time_point now, const char* what, int error);
+    void Log(const char* format, ...);
+    void SyncCounters();
+
+    ConnectionConfig   config_;
+    ConnectionState    state_ = ConnectionState::Disconnected;
+    socket_t           sock_ = SOCKET_INVALID;
+    Clock::time_point  deadline_;          // connect timeout or end of backoff
+    uint32_t           failures_ = 0;      // consecutive, drives the backoff
+    bool               just_connected_ = false;
+    std::minstd_rand   rng_;
+    OutputBuffer       out_;
+    uint64_t           not_connected_ = 0; // Sends while not connected
+    uint64_t           discarded_ = 0;     // frames queued when the connection went away
+    ConnectionCounters counters_;
+};
@@ -0,0 +1,113 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Config.h"
+#include "Socket.h"
+
+// Local telemetry fan-out: listens on its own port and hands every message
+// the plugin sends to Volanta (and every position, not just the simplified
+// track) to any number of subscribers, e.g. a moving map or a stream
+// overlay. Subscribers only read; anything they send is discarded.
+//
+// Each message is copied once into a reference counted frame that every
+// subscriber queue points at. A queue holds at most `queue_frames`; when a
+// subscriber can't keep up, its oldest frames that have not started going
+// out are dropped, so one slow client never holds up the others or the
+// thread that broadcasts.
+//
+// On Linux the sockets live in an epoll set and the owner waits on that one
+// descriptor; elsewhere it polls the listener and every subscriber.
+//
+// Not thread safe: the owning thread does everything.
+
+struct FanoutConfig {
+    bool        enabled = false;
+    const char* bind_address = "127.0.0.1";
+    uint16_t    port = 6747;
+    uint32_t    max_clients = 16;
+    uint32_t    queue_frames = 256;
+    bool        binary = false;         // BinaryTelemetry records instead of JSON lines
+    void        (*log)(const char* line) = nullptr;
+};
+
+// fanout, fanout_bind, fanout_port, fanout_max_clients, fanout_queue,
+// fanout_format (json or binary) from OpenVolanta.ini
+FanoutConfig ReadFanoutConfig(const ConfigFile& file);
+
+#define FANOUT_MAX_POLL 17      // listener plus 16 subscribers without epoll
+
+struct FanoutCounters {
+    uint64_t accepted = 0;
+    uint64_t rejected = 0;          // over max_clients
+    uint64_t disconnected = 0;
+    uint64_t frames = 0;            // broadcast or greeted
+    uint64_t frames_dropped = 0;    // evicted from a full subscriber queue
+    uint64_t bytes_sent = 0;
+    uint64_t send_calls = 0;
+};
+
+class FanoutServer {
+public:
+    explicit FanoutServer(const FanoutConfig& config);
+    ~FanoutServer();
+    FanoutServer(const FanoutServer&) = delete;
+    FanoutServer& operator=(const FanoutServer&) = delete;
+
+    // Binds and listens. Returns false (and logs) if the port is taken.
+    bool Start();
+
+    // Fills in up to `max` descriptors to wait on; returns how many
+    size_t PreparePoll(struct pollfd* fds, size_t max) const;
+
+    // Accepts, reaps subscribers that went away and writes what the sockets
+    // take. `fds` is what PreparePoll filled, after the wait.
+    void Update(const struct pollfd* fds, size_t count);
+
+    // True once after Update accepted someone. Greet() then reaches only
+    // the new subscribers (the current aircraft, phase, ...).
+    bool TakeNewClients();
+    void Greet(const char* data, size_t length);
+
+    // Queues one message (plus '\n' unless binary) for every subscriber
+    void Broadcast(const char* data, size_t length);
+
+    // Writes as much of every queue as the sockets take
+    void Flush();
+
+    size_t Clients() const { return clients_.size(); }
+    const FanoutCounters& Counters() const { return counters_; }
+
+private:
+    struct Frame;
+    struct Client {
+        socket_t            sock = SOCKET_INVALID;
+        std::vector<Frame*> queue;          // ring of unsent frames, `queue_frames` slots
+        size_t              head = 0;
+        size_t              count = 0;
+        Frame*              partial = nullptr;  // started going out, must finish
+        size_t              partial_sent = 0;
+        bool                fresh = false;  // accepted in the last Update
+        bool                want_write = false;
+        uint64_t            dropped = 0;
+    };
+
+    Frame* NewFrame(const char* data, size_t length);
+    void Release(Frame* frame);
+    void Enqueue(Client& client, Frame* frame);
+    bool FlushClient(Client& client);      // false: the socket is gone
+    void Accept();
+    void Close(size_t index, const char* why);
+    void WatchWrites(Client& client, bool want);
+    void Log(const char* format, ...);
+
+    FanoutConfig        config_;
+    FanoutCounters      counters_;
+    socket_t            listener_ = SOCKET_INVALID;
+    std::vector<Client> clients_;
+    bool                new_clients_ = false;
+#ifdef __linux__
+    int                 epoll_ = -1;
+#endif
+};
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+
+#include "Config.h"
+#include "Telemetry.h"
+
+// What the aircraft is doing, derived incrementally from the snapshots a
+// bridge already builds. Each Update is O(1): the snapshot picks a candidate
+// phase, which has to hold for a debounce window before it becomes the
+// phase, so a bump on the runway or a few seconds of level flight in a
+// climb don't produce events.
+//
+//   Parked    on the ground, stopped, engines off or parking brake set
+//   Taxi      on the ground below takeoff_kt (or stopped with engines on)
+//   Takeoff   takeoff roll, on the ground at or above takeoff_kt
+//   Climb     airborne, vs >= climb_fpm
+//   Cruise    airborne, neither climbing nor descending
+//   Descent   airborne, vs <= -descent_fpm
+//   Approach  descending below approach_agl_ft, kept through level segments
+//             until a climb (go-around) or touchdown
+//   Landed    rollout, on the ground at speed after being airborne
+//
+// Crossing between ground and air phases uses the shorter edge_debounce_s.
+// Paused, slewing and replay frames are ignored.
+
+enum class FlightPhase : uint8_t {
+    Unknown,
+    Parked,
+    Taxi,
+    Takeoff,
+    Climb,
+    Cruise,
+    Descent,
+    Approach,
+    Landed,
+};
+
+const char* FlightPhaseName(FlightPhase phase);
+
+struct PhaseConfig {
+    float taxi_kt = 3.0f;
+    float takeoff_kt = 40.0f;
+    float climb_fpm = 400.0f;
+    float descent_fpm = 400.0f;
+    float approach_agl_ft = 2000.0f;
+    float debounce_s = 5.0f;
+    float edge_debounce_s = 1.0f;
+    // TelemetrySnapshot::ground_speed to knots (m/s on X-Plane, 1 on MSFS)
+    float ground_speed_to_knots = (float)MPS_TO_KNOTS;
+};
+
+// phase_taxi_kt, phase_takeoff_kt, phase_climb_fpm, phase_descent_fpm,
+// phase_approach_agl_ft, phase_debounce_s, phase_edge_debounce_s
+PhaseConfig ReadPhaseConfig(const ConfigFile& file, float ground_speed_to_knots);
+
+class FlightPhaseTracker {
+public:
+    explicit FlightPhaseTracker(const PhaseConfig& config) : config_(config) {}
+
+    // Returns true when the phase changed with this snapshot. `now_s` is any
+    // monotonic clock in seconds.
+    bool Update(const TelemetrySnapshot& snapshot, double now_s);
+
+    FlightPhase Phase() const { return phase_; }
+    FlightPhase Previous() const { return previous_; }
+
+    // PHASE_CHANGE payload for the last transition, positioned at `snapshot`
+    PhaseChangeEvent Event(const TelemetrySnapshot& snapshot) const;
+
+private:
+    FlightPhase Candidate(const TelemetrySnapshot& snapshot) const;
+
+    PhaseConfig config_;
+    FlightPhase phase_ = FlightPhase::Unknown;
+    FlightPhase previous_ = FlightPhase::Unknown;
+    FlightPhase pending_ = FlightPhase::Unknown;
+    double      pending_since_ = 0.0;
+};
@@ -0,0 +1,143 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Config.h"
+#include "Telemetry.h"
+
+// Local full-rate flight log. Every captured snapshot is appended to a
+// preallocated, memory-mapped segment file, so writing a record is a memcpy
+// and nothing is lost if Volanta drops data.
+//
+// Segment layout (little endian, as mapped):
+//
+//   RecorderHeader      one page: magic, sizes, record count, schema
+//   RecorderRecord[]    fixed size, `capacity` slots preallocated
+//
+// The record count in the header is bumped after each record is copied in
+// and every record carries its 1-based sequence number, so after a crash a
+// reader takes the header count and may continue while `sequence` still
+// matches the slot. Dirty pages are msync'd (FlushViewOfFile and
+// FlushFileBuffers on Windows) every `sync_interval_ms`; the mapping itself
+// survives a crash of the simulator process, the sync bounds what an OS
+// crash or power loss can take. A cleanly closed segment is truncated to the
+// records it holds.
+//
+// Not thread safe: one writer thread owns the recorder.
+
+#define RECORDER_MAGIC "OVREC\0\0\1"
+#define RECORDER_VERSION 2
+#define RECORDER_HEADER_SIZE 4096
+#define RECORDER_MAX_FIELDS 64
+
+struct RecorderField {
+    char     key[32];
+    uint8_t  type;      // FieldType
+    uint8_t  format;    // FieldFormat
+    uint16_t offset;    // into RecorderRecord
+    float    scale;     // what the POSITION_UPDATE serializer multiplies by
+};
+
+struct RecorderHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t record_size;
+    uint32_t field_count;
+    uint64_t capacity;          // record slots in this segment
+    uint64_t records;           // written so far
+    int64_t  start_unix_ms;     // wall clock at the first record
+    uint32_t segment;           // 0-based index within the flight
+    uint32_t closed;            // 1 once closed cleanly
+    char     aircraft[64];      // "ICAO REG", informational
+    RecorderField fields[RECORDER_MAX_FIELDS];
+};
+
+struct RecorderRecord {
+    uint64_t sequence;          // 1-based slot number, 0 = never written
+    double   time_s;            // seconds since the first record of the segment
+    TelemetrySnapshot snapshot;
+};
+
+static_assert(sizeof(RecorderHeader) <= RECORDER_HEADER_SIZE, "RecorderHeader must fit in its page");
+static_assert(sizeof(RecorderRecord) == 136, "RecorderRecord changed size, bump RECORDER_VERSION");
+
+struct RecorderConfig {
+    bool        enabled = true;
+    std::string directory;              // created if missing
+    uint32_t    segment_mb = 64;        // ~2.3 h at 60 fps per segment
+    uint32_t    sync_interval_ms = 250;
+};
+
+// recorder, recorder_dir, recorder_segment_mb, recorder_sync_ms from
+// OpenVolanta.ini; `directory` is used when recorder_dir is not set
+RecorderConfig ReadRecorderConfig(const ConfigFile& file, const std::string& directory);
+
+// Reads a segment back, including one that was never closed: past the
+// header's count, records are taken while their sequence number still
+// matches the slot. Returns false if `path` is not a segment of this version.
+bool ReadRecording(const char* path, RecorderHeader& header, std::vector<RecorderRecord>& records);
+
+struct RecorderCounters {
+    uint64_t records = 0;
+    uint64_t segments = 0;
+    uint64_t open_failures = 0;
+    uint64_t syncs = 0;
+    uint64_t sync_ns_total = 0;
+    uint64_t sync_ns_max = 0;
+};
+
+class FlightRecorder {
+public:
+    explicit FlightRecorder(const RecorderConfig& config);
+    ~FlightRecorder();
+    FlightRecorder(const FlightRecorder&) = delete;
+    FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+    // Starts a new flight: the next Append opens flight_<date>-<time>.ovr.
+    // `aircraft` is stored in every segment header.
+    void NewFlight(const char* aircraft);
+
+    // Copies one record into the mapping, opening or rolling over to the
+    // next segment as needed. `now_s` is a monotonic clock in seconds.
+    // Returns false if no segment could be opened.
+    bool Append(const TelemetrySnapshot& snapshot, double now_s);
+
+    // msync's what was written since the last sync if the interval is up
+    // (or always with force). The interval runs on the steady clock, not the
+    // `now_s` records are stamped with. Call regularly from the writer thread.
+    void Sync(bool force = false);
+
+    // Syncs, unmaps and trims the current segment
+    void Close();
+
+    bool IsOpen() const { return header_ != nullptr; }
+    const std::string& CurrentPath() const { return path_; }
+    const RecorderCounters& Counters() const { return counters_; }
+
+private:
+    bool OpenSegment();
+
+    RecorderConfig   config_;
+    RecorderCounters counters_;
+    std::string      path_;
+    std::string      flight_name_;
+    char             aircraft_[64] = "";
+    uint32_t         segment_ = 0;
+    RecorderHeader*  header_ = nullptr;
+    RecorderRecord*  records_ = nullptr;
+    size_t           mapped_size_ = 0;
+    uint64_t         synced_ = 0;           // records covered by the last sync
+    double           start_s_ = 0.0;
+    std::chrono::steady_clock::time_point last_sync_;
+    double           retry_s_ = 0.0;        // no open attempts before this
+#ifdef _WIN32
+    void*            file_ = nullptr;
+    void*            mapping_ = nullptr;
+#else
+    int              fd_ = -1;
+#endif
+};
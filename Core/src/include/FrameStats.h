@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Frame time collector fed once per simulator frame. Record is O(1): an EMA
+// for the live FPS figure plus one counter increment in a fixed histogram
+// (0.25 ms buckets up to 128 ms, one overflow bucket), from which the
+// percentiles are read at report time.
+
+#define FRAME_BUCKET_MS 0.25
+#define FRAME_BUCKETS 512
+
+struct FramePercentiles {
+    uint64_t frames;
+    double   p50_ms;
+    double   p95_ms;
+    double   p99_ms;
+    double   max_ms;
+    double   mean_fps;   // frames / total time over the window
+};
+
+class FrameStats {
+public:
+    // `alpha` weights the newest frame in the EMA; 0.05 settles in ~1s at 60 fps
+    explicit FrameStats(double alpha = 0.05) : alpha_(alpha) {}
+
+    void Record(double frame_s);
+
+    // Smoothed over the last few dozen frames, 0 until the first frame
+    float Fps() const { return ema_s_ > 0.0 ? (float)(1.0 / ema_s_) : 0.0f; }
+    double FrameMs() const { return ema_s_ * 1000.0; }
+
+    // Percentiles since the last ResetWindow (the EMA carries on)
+    FramePercentiles Window() const;
+    void ResetWindow();
+
+private:
+    double   alpha_;
+    double   ema_s_ = 0.0;
+    uint32_t buckets_[FRAME_BUCKETS + 1] = {};
+    uint64_t frames_ = 0;
+    double   total_s_ = 0.0;
+    double   max_s_ = 0.0;
+};
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "Config.h"
+#include "Telemetry.h"
+
+// Native touchdown detector, replacing the LandingRate.lua FlyWithLua script.
+//
+// Fed every frame, it keeps the last LANDING_HISTORY samples of AGL,
+// vertical speed, G load and attitude in a fixed ring. On the airborne ->
+// on ground edge of onground_any it fits a line through the AGL samples of
+// the last `fit_window_s` before contact, which gives the descent rate
+// without the gear's reaction in it, and places the touchdown instant
+// between the two frames from how far the gear has compressed at that rate.
+// Attitude and ground speed are interpolated to that instant.
+// The event is completed with the peak G load over `g_window_s` after
+// touchdown (or until a bounce) and reported once; the detector then
+// disarms until the aircraft climbs above `arm_agl_ft` again, so bounces,
+// taxiing and loading on a runway don't produce landings.
+
+#define LANDING_HISTORY 64     // ~1 s at 60 fps, power of two
+
+struct LandingConfig {
+    float arm_agl_ft = 50.0f;
+    float fit_window_s = 0.25f;
+    float g_window_s = 0.5f;
+    // TelemetrySnapshot::ground_speed to knots (m/s on X-Plane)
+    float ground_speed_to_knots = (float)MPS_TO_KNOTS;
+};
+
+// landing_arm_agl_ft, landing_fit_s, landing_g_window_s from OpenVolanta.ini
+LandingConfig ReadLandingConfig(const ConfigFile& file);
+
+class LandingDetector {
+public:
+    explicit LandingDetector(const LandingConfig& config) : config_(config) {}
+
+    // Feeds one frame. `now_s` is any monotonic clock in seconds. Returns
+    // true exactly once per landing, with `event` filled in.
+    bool Update(const TelemetrySnapshot& snapshot, double now_s, LandingEvent& event);
+
+    bool Armed() const { return state_ == State::Armed; }
+    // Seconds from the last frame before contact to the estimated touchdown
+    double TouchdownOffset() const { return touchdown_offset_s_; }
+
+private:
+    enum class State : uint8_t {
+        Disarmed,   // on the ground or too low since the last landing
+        Armed,      // flying, waiting for contact
+        Touchdown,  // contact seen, collecting the peak G load
+    };
+
+    struct Sample {
+        double t;
+        double agl_m;
+        float  vs_fpm;
+        float  g_load;
+        float  pitch;
+        float  bank;
+        float  ground_speed;
+        float  heading;
+        double latitude;
+        double longitude;
+    };
+
+    void Touch(const TelemetrySnapshot& snapshot, double now_s);
+    const Sample& Back(size_t age) const { return history_[(head_ - 1 - age) & (LANDING_HISTORY - 1)]; }
+
+    LandingConfig config_;
+    State         state_ = State::Disarmed;
+    Sample        history_[LANDING_HISTORY] = {};
+    size_t        head_ = 0;                // total samples pushed
+    int32_t       last_on_ground_ = -1;
+    LandingEvent  pending_ = {};
+    double        g_until_s_ = 0.0;
+    double        touchdown_offset_s_ = 0.0;
+};
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Socket.h"
+
+// Per-connection send queue that keeps message boundaries intact on a
+// non-blocking stream socket.
+//
+// Frames are stored back to back in one contiguous buffer, so everything that
+// is pending goes out in a single send() (no writev needed). A short write just
+// advances the read position and the rest is retried on the next writable
+// event. When the buffer fills up because the peer stalls, whole frames that
+// have not started transmitting are evicted oldest first; a frame that is
+// partially on the wire is always completed, so the stream never desyncs.
+class OutputBuffer {
+public:
+    enum class FlushResult {
+        Done,        // nothing left to send
+        WouldBlock,  // socket full, wait for POLLOUT
+        Error,       // connection broken, see `error`
+    };
+
+    struct Counters {
+        uint64_t frames_queued = 0;
+        uint64_t frames_sent = 0;      // fully written to the socket
+        uint64_t frames_evicted = 0;   // dropped to make room for newer ones
+        uint64_t frames_rejected = 0;  // larger than the whole buffer
+        uint64_t bytes_sent = 0;
+        uint64_t sends = 0;            // send() calls
+        uint64_t partial_writes = 0;
+    };
+
+    OutputBuffer(size_t capacity, size_t max_frames, bool newline_delimited);
+
+    // Queues one complete message (plus '\n' when newline delimited).
+    // Returns false if it cannot fit even after evicting older frames.
+    bool Append(const char* data, size_t length);
+
+    FlushResult Flush(socket_t sock, int& error);
+
+    // Forget everything, including a half sent frame. Used when the
+    // connection is replaced so the new stream starts on a frame boundary.
+    void Clear();
+
+    bool   Empty() const { return frame_count_ == 0; }
+    size_t PendingBytes() const { return end_ - begin_; }
+    size_t PendingFrames() const { return frame_count_; }
+    const Counters& Stats() const { return counters_; }
+
+private:
+    bool MakeRoom(size_t needed);
+    void EvictFrame(size_t index);
+    uint32_t& FrameAt(size_t index) { return frames_[(frame_head_ + index) % frames_.size()]; }
+
+    std::vector<char>     data_;
+    size_t                begin_ = 0;          // first unsent byte
+    size_t                end_ = 0;            // one past the last queued byte
+    std::vector<uint32_t> frames_;             // ring of frame sizes, oldest first
+    size_t                frame_head_ = 0;
+    size_t                frame_count_ = 0;
+    size_t                front_sent_ = 0;     // bytes of the oldest frame already written
+    bool                  newline_delimited_;
+    Counters              counters_;
+};
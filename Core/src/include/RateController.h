@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+
+#include "Config.h"
+#include "Telemetry.h"
+
+// Picks how often position updates are sampled from what the aircraft is
+// doing, instead of a flat 10 Hz:
+//
+//   Idle      paused, slew or replay       cruise_hz
+//   Cruise    level flight                 cruise_hz   (1 Hz)
+//   Ground    taxiing                      ground_hz   (2 Hz)
+//   Climb     |vs| above climb_enter_fpm   climb_hz    (5 Hz)
+//   Approach  airborne below approach_agl  every frame, also for
+//             touchdown_hold_s after any touchdown or liftoff
+//
+// Every threshold has an exit value past the entry one, and dropping to a
+// slower tier waits until it has been wanted for slowdown_delay_s, so a
+// bumpy cruise or a go-around at the approach boundary doesn't flap.
+// Switching to a faster tier is immediate.
+
+enum class SampleTier : uint8_t {
+    Idle,
+    Cruise,
+    Ground,
+    Climb,
+    Approach,
+};
+
+const char* SampleTierName(SampleTier tier);
+
+struct RateConfig {
+    float cruise_hz = 1.0f;
+    float ground_hz = 2.0f;
+    float climb_hz = 5.0f;
+    float climb_enter_fpm = 500.0f;
+    float climb_exit_fpm = 250.0f;
+    float approach_agl_ft = 200.0f;
+    float approach_exit_agl_ft = 300.0f;
+    float touchdown_hold_s = 10.0f;
+    float slowdown_delay_s = 10.0f;
+};
+
+// approach_agl_ft = ..., cruise_hz = ..., etc. from OpenVolanta.ini
+RateConfig ReadRateConfig(const ConfigFile& file);
+
+class RateController {
+public:
+    explicit RateController(const RateConfig& config) : config_(config) {}
+
+    // Feeds the latest state; returns the sampling interval in seconds, or 0
+    // for "every frame". `now_s` is any monotonic clock in seconds.
+    float Update(const TelemetrySnapshot& snapshot, double now_s);
+
+    SampleTier Tier() const { return tier_; }
+    float IntervalSeconds() const;
+
+    // True once after each tier switch, for logging
+    bool TakeChanged();
+
+private:
+    SampleTier Wanted(const TelemetrySnapshot& snapshot, double now_s);
+    float      TierHz(SampleTier tier) const;
+
+    RateConfig config_;
+    SampleTier tier_ = SampleTier::Ground;
+    SampleTier pending_ = SampleTier::Ground;   // slower tier waiting out the delay
+    double     pending_since_ = 0.0;
+    double     hold_until_ = -1.0;              // touchdown/liftoff hold
+    int32_t    last_on_ground_ = -1;
+    bool       in_approach_ = false;
+    bool       in_climb_ = false;
+    bool       changed_ = false;
+};
+
+// Per-flight accounting of what was actually sent, compared with the old
+// fixed rate. Owned by whoever sends the position updates.
+struct RateStats {
+    double   elapsed_s = 0.0;     // time covered by updates (gaps capped)
+    uint64_t updates = 0;
+    uint64_t bytes = 0;
+    double   last_s = -1.0;
+
+    void     Record(double now_s, size_t message_bytes);
+    double   EffectiveHz() const;
+    // Bytes a flat `baseline_hz` would have needed over the same time, minus
+    // what was sent
+    int64_t  BytesSaved(double baseline_hz) const;
+    void     Reset() { *this = RateStats(); }
+};
+
+#define RATE_BASELINE_HZ 10.0
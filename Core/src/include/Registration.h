@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+#include <string_view>
+
+// Aircraft registration ("tail number") recognizer for livery folder names
+// such as "Ryanair EI-DCL (Sharklets)" or "Delta N801NW".
+//
+// Candidates are checked against the ICAO nationality prefix table with the
+// suffix shape each state uses (G-ABCD, EI-DCL, N801NW, JA8089, HL7782,
+// B-1234, RA-89001, ...). The prefix lookup is a constexpr two level table
+// indexed by the first two characters, so the text is scanned once with no
+// allocation. Registrations must stand alone: the characters around them
+// can't be letters or digits. Only upper case is recognized, as livery
+// authors write registrations that way and lower case hyphenated words would
+// otherwise match ("hi-res" would be a Dominican registration).
+
+// Finds the first registration in `text`. On success copies it to `out`
+// (always NUL-terminated, truncated to out_size - 1) and returns true.
+bool FindRegistration(std::string_view text, char* out, size_t out_size);
+
+// Last non-empty path component ("Aircraft/.../liveries/KLM PH-BXA/" -> "KLM PH-BXA"),
+// where the registration lives; aircraft folder names like "B-737" would
+// otherwise produce false matches
+std::string_view LiveryFolderName(std::string_view path);
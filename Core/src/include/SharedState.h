@@ -0,0 +1,112 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#include "Config.h"
+#include "Telemetry.h"
+
+// Latest aircraft state for programs on the same machine, without a socket
+// or JSON: the sim thread copies every frame's snapshot into a named shared
+// memory segment, and readers map it and take a copy whenever they like.
+//
+// The segment is one SharedStateBlock. A seqlock guards it: the writer makes
+// `sequence` odd, stores the words, then makes it even again; a reader copies
+// the words between two loads of `sequence` and keeps the copy only if both
+// were the same even value. Neither side takes a lock or makes a syscall, and
+// the writer never waits for a reader. The payload is stored as relaxed
+// 64-bit atomics, so a read racing a write is well defined, just discarded.
+//
+// Names are "/<name>" for shm_open, "Local\<name>" for CreateFileMapping.
+
+#define SHARED_STATE_MAGIC 0x53535600u    // "\0VSS", version in the low byte
+#define SHARED_STATE_VERSION 1
+#define SHARED_STATE_MAX_RETRIES 64       // a reader gives up after this many torn copies
+
+// What a reader gets
+struct SharedState {
+    uint64_t          update;     // 1 for the first publish, +1 every frame
+    double            time_s;     // sim time of the snapshot
+    TelemetrySnapshot snapshot;
+};
+
+static_assert(std::is_trivially_copyable_v<SharedState> && sizeof(SharedState) % 8 == 0,
+    "SharedState is copied as 64-bit words");
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+    "the seqlock lives in memory shared between processes");
+
+#define SHARED_STATE_WORDS (sizeof(SharedState) / 8)
+
+struct SharedStateBlock {
+    uint32_t              magic;          // SHARED_STATE_MAGIC | SHARED_STATE_VERSION
+    uint32_t              state_size;     // sizeof(SharedState)
+    std::atomic<uint32_t> live;           // 0 once the writer closed it
+    // Counter and payload share the lines every publish dirties anyway
+    alignas(64) std::atomic<uint64_t> sequence;   // odd while a write is in progress
+    std::atomic<uint64_t> words[SHARED_STATE_WORDS];
+};
+
+struct SharedStateConfig {
+    bool        enabled = false;
+    const char* name = "OpenVolanta";
+};
+
+// shared_memory, shared_memory_name from OpenVolanta.ini
+SharedStateConfig ReadSharedStateConfig(const ConfigFile& file);
+
+// Owned by the sim thread. Publish is a few dozen stores and never blocks.
+class SharedStateWriter {
+public:
+    SharedStateWriter() = default;
+    ~SharedStateWriter() { Close(); }
+    SharedStateWriter(const SharedStateWriter&) = delete;
+    SharedStateWriter& operator=(const SharedStateWriter&) = delete;
+
+    // Creates (or takes over a stale) segment. Returns false if it can't.
+    bool Open(const char* name);
+    void Publish(const TelemetrySnapshot& snapshot, double time_s);
+    // Marks the state stale for readers that still have it mapped
+    void Close();
+    bool IsOpen() const { return block_ != nullptr; }
+
+private:
+    SharedStateBlock* block_ = nullptr;
+    uint64_t          update_ = 0;
+    std::string       name_;
+#ifdef _WIN32
+    void*             mapping_ = nullptr;
+#endif
+};
+
+// Any number of these, in any process, on any thread each
+class SharedStateReader {
+public:
+    SharedStateReader() = default;
+    ~SharedStateReader() { Close(); }
+    SharedStateReader(const SharedStateReader&) = delete;
+    SharedStateReader& operator=(const SharedStateReader&) = delete;
+
+    // False until a writer has created the segment
+    bool Open(const char* name);
+    void Close();
+    bool IsOpen() const { return block_ != nullptr; }
+
+    // A consistent copy of the newest state. False if nothing was published
+    // yet, or the writer kept getting in the way (SHARED_STATE_MAX_RETRIES).
+    bool Read(SharedState& out) const;
+    // Cheap change check: differs whenever a new state has been published
+    uint64_t Sequence() const { return block_->sequence.load(std::memory_order_acquire); }
+    // False once the writer has closed the segment (the plugin was unloaded)
+    bool Live() const { return block_->live.load(std::memory_order_acquire) != 0; }
+
+    uint64_t Retries() const { return retries_; }
+
+private:
+    const SharedStateBlock* block_ = nullptr;
+    mutable uint64_t        retries_ = 0;
+#ifdef _WIN32
+    void*                   mapping_ = nullptr;
+#endif
+};
@@ -0,0 +1,64 @@
+#pragma once
+// Thin portability layer over Winsock and BSD sockets. Only what the bridges
+// actually use is wrapped; everything else is the plain socket API.
+#ifdef _WIN32
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    #pragma comment(lib, "ws2_32.lib")
+
+    typedef SOCKET socket_t;
+    #define SOCKET_INVALID INVALID_SOCKET
+    #define SOCKET_EWOULDBLOCK WSAEWOULDBLOCK
+    #define SOCKET_EINPROGRESS WSAEWOULDBLOCK
+    #define SOCKET_EINTR WSAEINTR
+    #define SOCKET_SEND_FLAGS 0
+#else
+    #include <arpa/inet.h>
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+
+    typedef int socket_t;
+    #define SOCKET_INVALID (-1)
+    #define SOCKET_EWOULDBLOCK EWOULDBLOCK
+    #define SOCKET_EINPROGRESS EINPROGRESS
+    #define SOCKET_EINTR EINTR
+    #ifdef MSG_NOSIGNAL
+        #define SOCKET_SEND_FLAGS MSG_NOSIGNAL  // a dead peer must not SIGPIPE the simulator
+    #else
+        #define SOCKET_SEND_FLAGS 0             // macOS uses SO_NOSIGPIPE, see ConfigureStreamSocket
+    #endif
+#endif
+
+// Reference counted WSAStartup/WSACleanup (no-ops elsewhere)
+bool SocketStartup();
+void SocketCleanup();
+
+int  SocketLastError();
+bool SocketWouldBlock(int error);
+bool SetNonBlocking(socket_t sock);
+// Non-blocking, TCP_NODELAY and no SIGPIPE: what every stream socket we own wants
+bool ConfigureStreamSocket(socket_t sock);
+void CloseSocket(socket_t& sock);  // also resets sock to SOCKET_INVALID
+
+// poll() / WSAPoll(). With no descriptors it simply sleeps for timeout_ms.
+int PollSockets(struct pollfd* fds, size_t count, int timeout_ms);
+
+// One piece of a gathered write
+struct SocketSlice {
+    const char* data;
+    size_t      length;
+};
+
+#define SOCKET_MAX_SLICES 16
+
+// sendmsg() / WSASend() of up to SOCKET_MAX_SLICES buffers in one call.
+// Returns the bytes written, or -1 (see SocketLastError).
+long SendGather(socket_t sock, const SocketSlice* slices, size_t count);
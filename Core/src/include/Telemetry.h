@@ -0,0 +1,168 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+#define METERS_TO_FT 3.28084
+#define MPS_TO_KNOTS 1.943844
+#define PARKING_BRAKE_SET 0.1       // parking_brake ratio above which it is "true"
+
+// Raw aircraft state as read from the simulator, before any unit conversion.
+// Every front end (X-Plane plugin, SimConnect bridge, ...) fills one of these
+// and hands it to the shared serializer, so the wire format only lives here.
+struct TelemetrySnapshot {
+    double  latitude;           // degrees
+    double  longitude;          // degrees
+    double  altitude_amsl;      // meters
+    double  altitude_agl;       // meters
+    float   pitch;              // degrees
+    float   bank;               // degrees
+    float   heading_true;       // degrees
+    float   ground_speed;       // as reported by the sim (m/s on X-Plane, knots on MSFS)
+    float   vertical_speed;     // feet/minute
+    float   fuel_kg;            // kilograms
+    float   gravity;            // g
+    float   g_load;             // g, normal load factor on the airframe
+    float   gear_deflection;    // meters, the most compressed tire/oleo
+    float   fps;                // frames/second
+    float   time_acceleration;  // multiplier
+    float   parking_brake;      // ratio (0-1)
+    float   wind_speed;         // knots
+    float   wind_direction;     // degrees
+    int32_t transponder;        // squawk code as a decimal number (e.g. 7000)
+    int32_t on_ground;          // boolean
+    int32_t slew;               // boolean
+    int32_t paused;             // boolean
+    int32_t in_replay_mode;     // boolean
+    int32_t autopilot_engaged;  // boolean
+    int32_t engines_running;    // boolean
+};
+
+// The parking brake as POSITION_UPDATE reports it, for everything that has
+// to agree with the wire
+inline bool ParkingBrakeSet(const TelemetrySnapshot& snapshot)
+{
+    return snapshot.parking_brake > (float)PARKING_BRAKE_SET;
+}
+
+// Simulator identity reported in every POSITION_UPDATE
+struct TelemetrySource {
+    std::string_view abbreviation;  // e.g. "xp12", "msfs"
+    std::string_view version;       // e.g. "12.320"
+};
+
+struct AircraftInfo {
+    const char* title;
+    const char* type;
+    const char* model;
+    const char* registration;
+    const char* airline;
+};
+
+enum class FieldType : uint8_t {
+    F64,
+    F32,
+    I32,
+};
+
+template <typename T> constexpr FieldType FieldTypeOf();
+template <> constexpr FieldType FieldTypeOf<double>() { return FieldType::F64; }
+template <> constexpr FieldType FieldTypeOf<float>() { return FieldType::F32; }
+template <> constexpr FieldType FieldTypeOf<int32_t>() { return FieldType::I32; }
+
+// Type and offset of a TelemetrySnapshot member, for the tables that fill
+// one from a simulator (DatarefSpec, SimVarSpec)
+#define SNAPSHOT_FIELD(member) \
+    FieldTypeOf<std::remove_extent_t<decltype(TelemetrySnapshot::member)>>(), (uint16_t)offsetof(TelemetrySnapshot, member)
+
+enum class FieldFormat : uint8_t {
+    Number,             // scale applied, printed with `precision` decimals
+    Bool,               // true when value > threshold
+    Transponder,        // quoted, zero padded to four digits
+    SimAbbreviation,    // TelemetrySource::abbreviation (no snapshot storage)
+    SimVersion,         // TelemetrySource::version (no snapshot storage)
+};
+
+struct TelemetryField {
+    std::string_view key;
+    FieldFormat      format;
+    FieldType        type;
+    uint16_t         offset;     // into TelemetrySnapshot
+    int8_t           precision;  // decimals for Number, -1 = shortest round-trip
+    double           scale;      // unit conversion applied to Number fields
+    double           threshold;  // Bool fields are true when value > threshold
+};
+
+#define TELEMETRY_NUMBER(key, member, type, precision, scale) \
+    { key, FieldFormat::Number, FieldType::type, offsetof(TelemetrySnapshot, member), precision, scale, 0.0 }
+#define TELEMETRY_BOOL(key, member, type, threshold) \
+    { key, FieldFormat::Bool, FieldType::type, offsetof(TelemetrySnapshot, member), 0, 1.0, threshold }
+
+// The POSITION_UPDATE payload, in wire order. This is the only place the keys,
+// units and precisions are declared.
+inline constexpr TelemetryField kPositionSchema[] = {
+    TELEMETRY_NUMBER("altitude_amsl",     altitude_amsl,     F64, 2, METERS_TO_FT),
+    TELEMETRY_NUMBER("altitude_agl",      altitude_agl,      F64, 2, METERS_TO_FT),
+    TELEMETRY_NUMBER("latitude",          latitude,          F64, 7, 1.0),
+    TELEMETRY_NUMBER("longitude",         longitude,         F64, 7, 1.0),
+    TELEMETRY_NUMBER("pitch",             pitch,             F32, 2, 1.0),
+    TELEMETRY_NUMBER("bank",              bank,              F32, 2, 1.0),
+    TELEMETRY_NUMBER("heading_true",      heading_true,      F32, 2, 1.0),
+    TELEMETRY_NUMBER("ground_speed",      ground_speed,      F32, 2, 1.0),
+    TELEMETRY_NUMBER("vertical_speed",    vertical_speed,    F32, 1, 1.0),
+    TELEMETRY_NUMBER("fuel_kg",           fuel_kg,           F32, 1, 1.0),
+    TELEMETRY_NUMBER("gravity",           gravity,           F32, 3, 1.0),
+    { "transponder", FieldFormat::Transponder, FieldType::I32, offsetof(TelemetrySnapshot, transponder), 0, 1.0, 0.0 },
+    TELEMETRY_BOOL("on_ground",           on_ground,         I32, 0.5),
+    TELEMETRY_BOOL("slew",                slew,              I32, 0.5),
+    TELEMETRY_BOOL("paused",              paused,            I32, 0.5),
+    TELEMETRY_BOOL("in_replay_mode",      in_replay_mode,    I32, 0.5),
+    TELEMETRY_NUMBER("fps",               fps,               F32, 1, 1.0),
+    TELEMETRY_NUMBER("time_acceleration", time_acceleration, F32, 2, 1.0),
+    TELEMETRY_BOOL("autopilot_engaged",   autopilot_engaged, I32, 0.5),
+    TELEMETRY_BOOL("engines_running",     engines_running,   I32, 0.5),
+    TELEMETRY_BOOL("parking_brake",       parking_brake,     F32, PARKING_BRAKE_SET),
+    { "sim_abbreviation", FieldFormat::SimAbbreviation, FieldType::I32, 0, 0, 1.0, 0.0 },
+    { "sim_version",      FieldFormat::SimVersion,      FieldType::I32, 0, 0, 1.0, 0.0 },
+    TELEMETRY_NUMBER("wind_speed",        wind_speed,        F32, 1, 1.0),
+    TELEMETRY_NUMBER("wind_direction",    wind_direction,    F32, 1, 1.0),
+};
+
+#undef TELEMETRY_NUMBER
+#undef TELEMETRY_BOOL
+
+// One touchdown, as measured by the LandingDetector
+struct LandingEvent {
+    float  landing_rate;        // feet/minute, negative when descending
+    float  gforce;              // g
+    float  pitch;               // degrees
+    float  roll;                // degrees
+    float  ground_speed;        // knots
+    double latitude;            // degrees
+    double longitude;           // degrees
+    float  heading;             // degrees true
+    float  wind_heading;        // degrees
+    float  wind_speed;          // knots
+};
+
+// A flight phase transition, see FlightPhase.h
+struct PhaseChangeEvent {
+    const char* phase;          // e.g. "climb"
+    const char* previous;
+    double      latitude;       // degrees
+    double      longitude;      // degrees
+    double      altitude_amsl;  // meters
+};
+
+// Large enough for any message we produce
+#define TELEMETRY_MAX_MESSAGE 2048
+
+// Serialize into a caller provided buffer. Returns the number of bytes written
+// (excluding the NUL terminator that is always appended), or 0 if the message
+// did not fit. Neither function allocates and both are locale independent.
+size_t SerializePositionUpdate(const TelemetrySnapshot& snapshot, const TelemetrySource& source, char* out, size_t out_size);
+size_t SerializeAircraftUpdate(const AircraftInfo& aircraft, char* out, size_t out_size);
+// Same keys and precision as the LandingRate.lua script
+size_t SerializeLandingEvent(const LandingEvent& landing, char* out, size_t out_size);
+size_t SerializePhaseChange(const PhaseChangeEvent& change, char* out, size_t out_size);
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "Config.h"
+#include "Telemetry.h"
+
+// Online dead-band filter for position updates. The last point sent is
+// extrapolated along the velocity it was moving at (taken from the sample
+// before it, so wind correction angle is included); a new point is only
+// sent once the actual position, altitude or heading has drifted from that
+// prediction by more than the tolerances, or a discrete field changed, or
+// max_interval_s passed. Offer is O(1) apart from the error bookkeeping
+// below, which runs once per point sent.
+//
+// Receivers draw straight lines between the points they get, so the error
+// reported per flight is measured against those chords: every point held
+// back is kept (up to TRACK_PENDING_MAX, after which a point is forced out)
+// and checked against the segment it ends up on. Distances use a local
+// equirectangular projection around the last point sent, which is well
+// within a meter over the few kilometers between points.
+
+#define TRACK_PENDING_MAX 512
+
+struct SimplifyConfig {
+    bool  enabled = true;
+    float position_m = 30.0f;
+    float altitude_ft = 30.0f;
+    float heading_deg = 3.0f;
+    float max_interval_s = 10.0f;
+};
+
+// track_simplify, track_position_m, track_altitude_ft, track_heading_deg,
+// track_max_interval_s from OpenVolanta.ini
+SimplifyConfig ReadSimplifyConfig(const ConfigFile& file);
+
+struct SimplifyStats {
+    uint64_t offered = 0;
+    uint64_t sent = 0;
+    double   max_position_error_m = 0.0;   // held-back points vs the chords sent
+    double   max_altitude_error_ft = 0.0;
+
+    double Ratio() const { return sent > 0 ? (double)offered / (double)sent : 0.0; }
+};
+
+class TrackSimplifier {
+public:
+    explicit TrackSimplifier(const SimplifyConfig& config) : config_(config) {}
+
+    // True if this snapshot should be sent. `now_s` is any monotonic clock
+    // in seconds. With `keep` it is sent regardless but still counted and
+    // used as the next anchor.
+    bool Offer(const TelemetrySnapshot& snapshot, double now_s, bool keep = false);
+
+    // The next Offer is sent regardless, e.g. after a reconnect
+    void ForceNext() { force_ = true; }
+
+    const SimplifyStats& Stats() const { return stats_; }
+    void ResetStats() { stats_ = SimplifyStats(); }
+
+private:
+    struct Point {
+        double t;
+        double latitude;
+        double longitude;
+        double altitude_m;
+    };
+
+    void Sent(const TelemetrySnapshot& snapshot, double now_s);
+    void MeasureChord(const Point& end);
+
+    SimplifyConfig    config_;
+    SimplifyStats     stats_;
+    bool              force_ = true;
+    TelemetrySnapshot anchor_ = {};         // last point sent
+    double            anchor_t_ = 0.0;
+    double            velocity_east_ = 0.0; // m/s at the anchor
+    double            velocity_north_ = 0.0;
+    Point             previous_ = {};       // sample before the current one
+    bool              have_previous_ = false;
+    Point             pending_[TRACK_PENDING_MAX];
+    size_t            pending_count_ = 0;
+};
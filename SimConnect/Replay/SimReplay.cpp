@@ -0,0 +1,752 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Socket.h"
+#include "Bridge.h"
+
+// Drives the SimConnect bridge without a simulator: the pSimConnect_*
+// pointers are filled in with fakes, and CallDispatch hands the bridge
+// SIMCONNECT_RECV blobs, either synthetic positions or a capture the bridge
+// wrote itself (dispatch_capture in OpenVolanta.ini). A local listener plays
+// Volanta and times every POSITION_UPDATE from the sim frame that produced
+// it (or, unpaced, from its dispatch) until its line arrived.
+//
+//   simreplay [--messages N] [--rate HZ] [--replay capture.bin] [--capture out.bin] [--verbose]
+//   simreplay --check
+//
+// Synthetic data is N sim frames, a climb and then cruise. With --rate the
+// fake sim runs at that frame rate and, like SimConnect, only delivers the
+// frames the bridge's position subscription asks for; WaitForSimConnect
+// sleeps until the next one. --rate 0 (the default) ignores the
+// subscription and dispatches every frame as fast as the bridge takes them.
+// Positions are encoded the way the subscription asks for, normally
+// CHANGED | TAGGED deltas against what was last sent. A capture is replayed
+// as recorded, at its recorded timing unless --rate is given. The listener
+// matches POSITION_UPDATE lines to dispatched positions in order.
+// --capture has the bridge write what it was fed, exactly as
+// dispatch_capture would next to the simulator.
+//
+// --check runs the tagged decoder against payloads built here instead:
+// merged deltas must track every frame, malformed ones must be refused.
+
+namespace {
+
+// Where the bridge finds its struct: dwData is the last DWORD of the header
+const size_t kDataOffset = sizeof(SIMCONNECT_RECV_SIMOBJECT_DATA) - sizeof(DWORD);
+
+struct Options {
+    uint64_t    messages = 100000;
+    double      rate = 0.0;
+    bool        rate_given = false;
+    const char* replay = nullptr;
+    const char* capture = nullptr;
+    bool        verbose = false;
+    bool        check = false;
+};
+
+struct Blob {
+    uint64_t             time_ns;       // sim time of the frame, from the start
+    std::vector<uint8_t> bytes;         // as sent, unless it is a synthetic frame
+    int64_t              frame = -1;    // into FakeSim::frames
+};
+
+struct FakeSim {
+    std::vector<Blob> blobs;
+    std::vector<TelemetrySnapshot> frames;  // synthetic positions, encoded on delivery
+    size_t            next = 0;
+    bool              pending = false;      // blobs[next] is due for delivery
+    std::vector<uint8_t> pending_bytes;     // ... encoded like this if it is a frame
+    std::chrono::steady_clock::time_point start;
+    double            interval_ns = 0.0;    // per blob, 0: recorded timing in time_ns
+    bool              use_recorded = false;
+    bool              unpaced = false;
+    bool              subscribed_only = false;  // only frames the subscription asks for
+
+    // The bridge's position subscription
+    SIMCONNECT_PERIOD period = SIMCONNECT_PERIOD_NEVER;
+    DWORD             period_interval = 0;
+    size_t            origin = 0;           // first blob of a SIM_FRAME subscription
+    uint64_t          next_second_ns = 0;   // next delivery of a SECOND subscription
+    SIMCONNECT_DATA_REQUEST_FLAG flags = 0;
+    TelemetrySnapshot sent = {};            // what CHANGED compares against
+    bool              sent_any = false;
+
+    uint64_t          definitions = 0;
+    uint64_t          position_requests = 0;
+    uint64_t          dispatched = 0;
+    uint64_t          positions = 0;
+    uint64_t          position_bytes = 0;   // SIMCONNECT_RECV messages, header included
+    uint64_t          waits = 0;
+    uint64_t          wakeups = 0;          // waits that returned data
+    double            dispatch_cpu_s = 0.0;     // inside the bridge's DispatchProc
+    std::unique_ptr<std::atomic<int64_t>[]> dispatch_ns;   // by sequence number
+};
+
+FakeSim gSim;
+
+int64_t NanosecondsNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+double ThreadCpuSeconds()
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+HRESULT WINAPI FakeOpen(HANDLE* phSimConnect, LPCSTR, HWND, DWORD, HANDLE, DWORD)
+{
+    *phSimConnect = (HANDLE)&gSim;
+    return S_OK;
+}
+
+HRESULT WINAPI FakeClose(HANDLE)
+{
+    return S_OK;
+}
+
+HRESULT WINAPI FakeAddToDataDefinition(HANDLE, SIMCONNECT_DATA_DEFINITION_ID, const char*, const char*, SIMCONNECT_DATATYPE, float, DWORD)
+{
+    gSim.definitions++;
+    return S_OK;
+}
+
+uint64_t DueNs(size_t index)
+{
+    if (gSim.use_recorded) {
+        return gSim.blobs[index].time_ns;
+    }
+    return (uint64_t)(gSim.interval_ns * (double)index);
+}
+
+uint64_t ElapsedNs()
+{
+    if (gSim.start == std::chrono::steady_clock::time_point()) {
+        return 0;
+    }
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - gSim.start).count();
+}
+
+// A new request for the same ID replaces the old one, starting with the
+// next frame
+HRESULT WINAPI FakeRequestDataOnSimObject(HANDLE, SIMCONNECT_DATA_REQUEST_ID request, SIMCONNECT_DATA_DEFINITION_ID, SIMCONNECT_OBJECT_ID, SIMCONNECT_PERIOD period, SIMCONNECT_DATA_REQUEST_FLAG flags, DWORD, DWORD interval, DWORD)
+{
+    if (request != REQUEST_POSITION) {
+        return S_OK;
+    }
+    gSim.position_requests++;
+    gSim.period = period;
+    gSim.period_interval = interval;
+    gSim.flags = flags;
+    gSim.sent_any = false;
+    gSim.origin = gSim.next;
+    gSim.next_second_ns = ElapsedNs();
+    gSim.pending = false;
+    return S_OK;
+}
+
+bool IsPosition(const std::vector<uint8_t>& bytes)
+{
+    const SIMCONNECT_RECV_SIMOBJECT_DATA* data = (const SIMCONNECT_RECV_SIMOBJECT_DATA*)bytes.data();
+    return bytes.size() >= kDataOffset
+        && data->dwID == SIMCONNECT_RECV_ID_SIMOBJECT_DATA
+        && data->dwRequestID == REQUEST_POSITION;
+}
+
+std::vector<uint8_t> MakeBlob(DATA_REQUEST_ID request, DATA_DEFINE_ID define, DWORD flags, DWORD values, const void* payload, size_t size)
+{
+    std::vector<uint8_t> bytes(kDataOffset + size);
+    SIMCONNECT_RECV_SIMOBJECT_DATA header = {};
+    header.dwSize = (DWORD)bytes.size();
+    header.dwVersion = 4;
+    header.dwID = SIMCONNECT_RECV_ID_SIMOBJECT_DATA;
+    header.dwRequestID = request;
+    header.dwObjectID = SIMCONNECT_OBJECT_ID_USER;
+    header.dwDefineID = define;
+    header.dwFlags = flags;
+    header.dwentrynumber = 1;
+    header.dwoutof = 1;
+    header.dwDefineCount = values;
+    memcpy(bytes.data(), &header, kDataOffset);
+    memcpy(bytes.data() + kDataOffset, payload, size);
+    return bytes;
+}
+
+double FieldValue(const SimVarSpec& spec, const TelemetrySnapshot& snapshot)
+{
+    const char* base = (const char*)&snapshot + spec.offset;
+    switch (spec.destination) {
+        case FieldType::F64: { double v; memcpy(&v, base, sizeof(v)); return v; }
+        case FieldType::F32: { float v; memcpy(&v, base, sizeof(v)); return v; }
+        case FieldType::I32: { int32_t v; memcpy(&v, base, sizeof(v)); return v; }
+    }
+    return 0.0;
+}
+
+bool FieldChanged(const SimVarSpec& spec, const TelemetrySnapshot& now, const TelemetrySnapshot& sent)
+{
+    double difference = std::fabs(FieldValue(spec, now) - FieldValue(spec, sent));
+    return spec.epsilon > 0.0f ? difference > spec.epsilon : difference != 0.0;
+}
+
+// What SimConnect would send for this frame under `flags`, against `sent`
+// (updated). Empty if CHANGED and nothing did.
+std::vector<uint8_t> EncodePosition(const TelemetrySnapshot& snapshot, DWORD flags, TelemetrySnapshot& sent, bool& sent_any)
+{
+    bool changed_only = (flags & SIMCONNECT_DATA_REQUEST_FLAG_CHANGED) && sent_any;
+    bool tagged = (flags & SIMCONNECT_DATA_REQUEST_FLAG_TAGGED) != 0;
+    char payload[512];
+    size_t size = 0;
+    DWORD values = 0;
+    bool any = false;
+    for (size_t i = 0; i < kPositionSimVarCount; i++) {
+        const SimVarSpec& spec = kPositionSimVars[i];
+        bool changed = !changed_only || FieldChanged(spec, snapshot, sent);
+        any |= changed;
+        if (tagged && !changed) {
+            continue;
+        }
+        size_t field = SimVarSize(spec.destination);
+        if (tagged) {
+            DWORD id = (DWORD)i;
+            memcpy(payload + size, &id, sizeof(id));
+            size += sizeof(id);
+        }
+        memcpy(payload + size, (const char*)&snapshot + spec.offset, field);
+        size += field;
+        values++;
+        if (changed) {
+            memcpy((char*)&sent + spec.offset, (const char*)&snapshot + spec.offset, field);
+        }
+    }
+    if (!any) {
+        return std::vector<uint8_t>();
+    }
+    sent_any = true;
+    return MakeBlob(REQUEST_POSITION, DEFINITION_POSITION, flags, values, payload, size);
+}
+
+// Would SimConnect send this frame under the current subscription?
+bool Subscribed(size_t index)
+{
+    if (!gSim.subscribed_only || gSim.blobs[index].frame < 0) {
+        return true;
+    }
+    switch (gSim.period) {
+        case SIMCONNECT_PERIOD_ONCE:
+            gSim.period = SIMCONNECT_PERIOD_NEVER;
+            return true;
+        case SIMCONNECT_PERIOD_VISUAL_FRAME:
+        case SIMCONNECT_PERIOD_SIM_FRAME:
+            return index >= gSim.origin && (index - gSim.origin) % (gSim.period_interval + 1) == 0;
+        case SIMCONNECT_PERIOD_SECOND:
+            if (DueNs(index) < gSim.next_second_ns) {
+                return false;
+            }
+            while (gSim.next_second_ns <= DueNs(index)) {
+                gSim.next_second_ns += (gSim.period_interval + 1ull) * 1000000000ull;
+            }
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Skips to the next frame the bridge will be sent, if any
+bool FindPending()
+{
+    if (gSim.start == std::chrono::steady_clock::time_point()) {
+        return false;
+    }
+    while (!gSim.pending && gSim.next < gSim.blobs.size()) {
+        const Blob& blob = gSim.blobs[gSim.next];
+        if (Subscribed(gSim.next)) {
+            gSim.pending_bytes = blob.frame < 0 ? blob.bytes
+                : EncodePosition(gSim.frames[blob.frame], gSim.flags, gSim.sent, gSim.sent_any);
+            gSim.pending = !gSim.pending_bytes.empty();
+        }
+        if (!gSim.pending) {
+            gSim.next++;
+        }
+    }
+    return gSim.pending;
+}
+
+// At most one blob per call; WaitForSimConnect returns right away while
+// more are due
+HRESULT WINAPI FakeCallDispatch(HANDLE, DispatchProc proc, void* context)
+{
+    if (!FindPending() || (!gSim.unpaced && ElapsedNs() < DueNs(gSim.next))) {
+        return E_FAIL;
+    }
+    std::vector<uint8_t> bytes;
+    bytes.swap(gSim.pending_bytes);
+    gSim.pending = false;
+    gSim.next++;
+
+    if (IsPosition(bytes)) {
+        uint64_t sequence = gSim.positions++;
+        gSim.position_bytes += bytes.size();
+        int64_t produced_ns = gSim.unpaced ? NanosecondsNow()
+            : std::chrono::duration_cast<std::chrono::nanoseconds>(gSim.start.time_since_epoch()).count() + (int64_t)DueNs(gSim.next - 1);
+        gSim.dispatch_ns[sequence].store(produced_ns, std::memory_order_relaxed);
+    }
+    gSim.dispatched++;
+    double cpu_start = ThreadCpuSeconds();
+    proc((SIMCONNECT_RECV*)bytes.data(), (DWORD)bytes.size(), context);
+    gSim.dispatch_cpu_s += ThreadCpuSeconds() - cpu_start;
+    return S_OK;
+}
+
+// An aircraft change, then one position per sim frame: a climb for the
+// first fifth, straight and level after that
+void MakeSyntheticBlobs(uint64_t messages, double fps)
+{
+    StructAircraft aircraft = {};
+    snprintf(aircraft.title, sizeof(aircraft.title), "Airbus A320neo Replay");
+    snprintf(aircraft.model, sizeof(aircraft.model), "A20N");
+    snprintf(aircraft.type, sizeof(aircraft.type), "Airbus");
+    snprintf(aircraft.registration, sizeof(aircraft.registration), "I-RPLY");
+    gSim.blobs.push_back({ 0, MakeBlob(REQUEST_AIRCRAFT, DEFINITION_AIRCRAFT, 0, 4, &aircraft, sizeof(aircraft)) });
+
+    TelemetrySnapshot position = {};
+    position.heading_true = 90.0f;
+    position.ground_speed = 450.0f;
+    position.fuel_kg = 8000.0f;
+    position.fps = fps > 0.0 ? (float)fps : 60.0f;
+    position.time_acceleration = 1.0f;
+    position.transponder = 4621;
+    position.autopilot_engaged = 1;
+    position.engines_running = 1;
+    position.wind_direction = 270.0f;
+    double frame_s = 1.0 / position.fps;
+    gSim.frames.reserve(messages);
+    for (uint64_t i = 0; i < messages; i++) {
+        double t = (double)i * frame_s;
+        bool climbing = i < messages / 5;
+        position.vertical_speed = climbing ? 1500.0f : 0.0f;
+        position.altitude_amsl = 11000.0 - (climbing ? (double)(messages / 5 - i) * frame_s * 1500.0 / 60.0 / METERS_TO_FT : 0.0);
+        position.altitude_agl = position.altitude_amsl - 200.0;
+        position.latitude = 45.63;
+        position.longitude = 8.72 + t * 450.0 / 3600.0 / 60.0;
+        position.pitch = (climbing ? 6.0f : 2.0f) + 0.3f * (float)std::sin(t * 0.3);
+        position.bank = 0.5f * (float)std::sin(t * 0.2);
+        position.fuel_kg = 8000.0f - (float)(t * 2500.0 / 3600.0);
+        position.wind_speed = 35.0f + 2.0f * (float)std::sin(t * 0.05);
+        gSim.frames.push_back(position);
+        Blob blob = { (uint64_t)(t * 1e9) };
+        blob.frame = (int64_t)i;
+        gSim.blobs.push_back(std::move(blob));
+    }
+}
+
+// The capture format is documented in Bridge.h
+bool ReadCapture(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return false;
+    }
+    uint32_t size;
+    uint64_t time_ns;
+    while (fread(&size, sizeof(size), 1, file) == 1 && fread(&time_ns, sizeof(time_ns), 1, file) == 1) {
+        if (size < sizeof(SIMCONNECT_RECV)) {
+            break;
+        }
+        Blob blob = { time_ns, std::vector<uint8_t>(size) };
+        if (fread(blob.bytes.data(), 1, size, file) != size) {
+            break;
+        }
+        gSim.blobs.push_back(std::move(blob));
+    }
+    fclose(file);
+    return !gSim.blobs.empty();
+}
+
+// Volanta's end of the connection: the n-th POSITION_UPDATE belongs to the
+// n-th position dispatched
+class LatencySink {
+public:
+    bool Start(size_t expected)
+    {
+        expected_ = expected;
+        latencies_.reserve(expected);
+        listener_ = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(addr);
+        if (listener_ == SOCKET_INVALID
+            || bind(listener_, (sockaddr*)&addr, sizeof(addr)) != 0
+            || listen(listener_, 1) != 0
+            || getsockname(listener_, (sockaddr*)&addr, &length) != 0) {
+            return false;
+        }
+        port_ = ntohs(addr.sin_port);
+        running_ = true;
+        thread_ = std::thread([this] { Run(); });
+        return true;
+    }
+
+    void Stop()
+    {
+        running_ = false;
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        CloseSocket(listener_);
+    }
+
+    uint16_t Port() const { return port_; }
+    uint64_t Lines() const { return lines_.load(); }
+    uint64_t Positions() const { return positions_.load(); }
+    uint64_t Bytes() const { return bytes_; }
+    std::vector<int64_t>& Latencies() { return latencies_; }
+
+private:
+    void Run()
+    {
+        socket_t client = SOCKET_INVALID;
+        std::string line;
+        char buffer[65536];
+        while (running_) {
+            struct pollfd pfd = { client != SOCKET_INVALID ? client : listener_, POLLIN, 0 };
+            if (PollSockets(&pfd, 1, 20) <= 0) {
+                continue;
+            }
+            if (client == SOCKET_INVALID) {
+                client = accept(listener_, NULL, NULL);
+                continue;
+            }
+            int received = (int)recv(client, buffer, sizeof(buffer), 0);
+            if (received <= 0) {
+                CloseSocket(client);
+                continue;
+            }
+            int64_t now_ns = NanosecondsNow();
+            bytes_ += (uint64_t)received;
+            for (int i = 0; i < received; i++) {
+                if (buffer[i] != '\n') {
+                    line += buffer[i];
+                    continue;
+                }
+                Line(line, now_ns);
+                line.clear();
+            }
+        }
+        CloseSocket(client);
+    }
+
+    void Line(const std::string& line, int64_t now_ns)
+    {
+        lines_++;
+        if (line.find("\"POSITION_UPDATE\"") == std::string::npos) {
+            return;
+        }
+        uint64_t sequence = positions_++;
+        int64_t produced_ns = sequence < expected_ ? gSim.dispatch_ns[sequence].load(std::memory_order_relaxed) : 0;
+        if (produced_ns != 0) {
+            latencies_.push_back(now_ns - produced_ns);
+        }
+    }
+
+    socket_t              listener_ = SOCKET_INVALID;
+    uint16_t              port_ = 0;
+    std::atomic<bool>     running_{false};
+    std::thread           thread_;
+    size_t                expected_ = 0;
+    std::atomic<uint64_t> lines_{0};
+    std::atomic<uint64_t> positions_{0};
+    uint64_t              bytes_ = 0;
+    std::vector<int64_t>  latencies_;
+};
+
+bool SameFields(const TelemetrySnapshot& a, const TelemetrySnapshot& b, bool within_epsilon)
+{
+    for (size_t i = 0; i < kPositionSimVarCount; i++) {
+        const SimVarSpec& spec = kPositionSimVars[i];
+        double difference = std::fabs(FieldValue(spec, a) - FieldValue(spec, b));
+        if (difference > (within_epsilon ? spec.epsilon : 0.0f)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Tagged deltas merged by DecodeSimVars must track the frames they came
+// from to within the thresholds, and what a broken message can't describe
+// must be refused without touching the state
+int CheckTaggedDecoder()
+{
+    MakeSyntheticBlobs(36000, 60.0);
+    const DWORD flags = SIMCONNECT_DATA_REQUEST_FLAG_CHANGED | SIMCONNECT_DATA_REQUEST_FLAG_TAGGED;
+    TelemetrySnapshot sent = {}, decoded = {};
+    bool sent_any = false;
+    uint64_t messages = 0, bytes = 0, values = 0, mismatches = 0;
+    for (const TelemetrySnapshot& frame : gSim.frames) {
+        std::vector<uint8_t> blob = EncodePosition(frame, flags, sent, sent_any);
+        if (!blob.empty()) {
+            const SIMCONNECT_RECV_SIMOBJECT_DATA* data = (const SIMCONNECT_RECV_SIMOBJECT_DATA*)blob.data();
+            messages++;
+            bytes += blob.size();
+            values += data->dwDefineCount;
+            if (!DecodeSimVars(kPositionSimVars, kPositionSimVarCount, data, (DWORD)blob.size(), &decoded)) {
+                mismatches++;
+            }
+        }
+        if (!SameFields(decoded, sent, false) || !SameFields(decoded, frame, true)) {
+            mismatches++;
+        }
+    }
+
+    // Untagged: the whole block in table order
+    TelemetrySnapshot untagged = {};
+    sent_any = false;
+    std::vector<uint8_t> full = EncodePosition(gSim.frames.back(), 0, sent, sent_any);
+    bool full_ok = DecodeSimVars(kPositionSimVars, kPositionSimVarCount, (const SIMCONNECT_RECV_SIMOBJECT_DATA*)full.data(), (DWORD)full.size(), &untagged)
+        && SameFields(untagged, gSim.frames.back(), false)
+        && full.size() == kDataOffset + SimVarBlockSize(kPositionSimVars, kPositionSimVarCount);
+
+    // Broken ones: truncated value, truncated ID, unknown ID, short block
+    sent_any = false;
+    std::vector<uint8_t> tagged = EncodePosition(gSim.frames.front(), flags, sent, sent_any);
+    DWORD unknown = (DWORD)kPositionSimVarCount;
+    std::vector<uint8_t> bad_id = tagged;
+    memcpy(bad_id.data() + kDataOffset, &unknown, sizeof(unknown));
+    struct { const std::vector<uint8_t>* blob; size_t size; } broken[] = {
+        { &tagged, tagged.size() - 1 },
+        { &tagged, kDataOffset + 2 },
+        { &bad_id, bad_id.size() },
+        { &full, full.size() - 4 },
+        { &full, kDataOffset - 1 },
+    };
+    size_t accepted = 0;
+    for (const auto& b : broken) {
+        TelemetrySnapshot state = gSim.frames.front();
+        if (DecodeSimVars(kPositionSimVars, kPositionSimVarCount, (const SIMCONNECT_RECV_SIMOBJECT_DATA*)b.blob->data(), (DWORD)b.size, &state)
+            || !SameFields(state, gSim.frames.front(), false)) {
+            accepted++;
+        }
+    }
+
+    uint64_t untagged_bytes = (uint64_t)gSim.frames.size() * full.size();
+    printf("tagged decoder: %zu frames, %llu messages, %.1f values and %.1f bytes per message\n",
+        gSim.frames.size(), (unsigned long long)messages,
+        messages > 0 ? (double)values / (double)messages : 0.0,
+        messages > 0 ? (double)bytes / (double)messages : 0.0);
+    printf("  %llu bytes vs %llu untagged every frame (%.1f%%)\n",
+        (unsigned long long)bytes, (unsigned long long)untagged_bytes, 100.0 * (double)bytes / (double)untagged_bytes);
+    printf("  merged state mismatches: %llu, untagged block %s, malformed accepted: %zu of %zu\n",
+        (unsigned long long)mismatches, full_ok ? "ok" : "FAILED", accepted, std::size(broken));
+    return mismatches == 0 && full_ok && accepted == 0 ? 0 : 1;
+}
+
+double Percentile(std::vector<int64_t>& sorted, double p)
+{
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t index = std::min(sorted.size() - 1, (size_t)(p * (double)sorted.size()));
+    return (double)sorted[index] / 1000.0;
+}
+
+bool ParseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--messages") == 0 && has_value) {
+            options.messages = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--rate") == 0 && has_value) {
+            options.rate = atof(argv[++i]);
+            options.rate_given = true;
+        }
+        else if (strcmp(argv[i], "--replay") == 0 && has_value) {
+            options.replay = argv[++i];
+        }
+        else if (strcmp(argv[i], "--capture") == 0 && has_value) {
+            options.capture = argv[++i];
+        }
+        else if (strcmp(argv[i], "--check") == 0) {
+            options.check = true;
+        }
+        else if (strcmp(argv[i], "--verbose") == 0) {
+            options.verbose = true;
+        }
+        else {
+            return false;
+        }
+    }
+    return options.messages > 0 && options.rate >= 0.0;
+}
+
+} // namespace
+
+// The bridge's wait: sleeps until the next frame it will be sent is due
+bool WaitForSimConnect(int timeout_ms)
+{
+    gSim.waits++;
+    if (!FindPending()) {
+        if (gSim.next < gSim.blobs.size()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(std::min(timeout_ms, 1)));
+        }
+        return false;
+    }
+    uint64_t elapsed_ns = ElapsedNs();
+    uint64_t due_ns = gSim.unpaced ? 0 : DueNs(gSim.next);
+    if (due_ns > elapsed_ns) {
+        if (due_ns - elapsed_ns > (uint64_t)timeout_ms * 1000000ull) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+            return false;
+        }
+        std::this_thread::sleep_until(gSim.start + std::chrono::nanoseconds(due_ns));
+    }
+    gSim.wakeups++;
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        fprintf(stderr, "usage: %s [--messages N] [--rate HZ] [--replay capture.bin] [--capture out.bin] [--verbose]\n"
+                        "       %s --check\n", argv[0], argv[0]);
+        return 2;
+    }
+
+    if (options.check) {
+        return CheckTaggedDecoder();
+    }
+
+    if (options.replay != nullptr) {
+        if (!ReadCapture(options.replay)) {
+            fprintf(stderr, "%s: not a SimConnect capture, or empty\n", options.replay);
+            return 1;
+        }
+        gSim.use_recorded = !options.rate_given;
+    }
+    else {
+        MakeSyntheticBlobs(options.messages, options.rate);
+        gSim.subscribed_only = options.rate > 0.0;
+    }
+    if (!gSim.use_recorded && options.rate > 0.0) {
+        gSim.interval_ns = 1e9 / options.rate;
+    }
+    gSim.unpaced = !gSim.use_recorded && gSim.interval_ns == 0.0;
+    gSim.dispatch_ns.reset(new std::atomic<int64_t>[gSim.blobs.size()]);
+
+    SocketStartup();
+    LatencySink sink;
+    if (!sink.Start(gSim.blobs.size())) {
+        fprintf(stderr, "could not listen on the loopback interface\n");
+        return 1;
+    }
+
+    // The bridge reads host and port like it would next to the executable
+    std::filesystem::path ini_path = std::filesystem::temp_directory_path() / ("openvolanta-replay-" + std::to_string(sink.Port()) + ".ini");
+    FILE* ini = fopen(ini_path.string().c_str(), "w");
+    if (ini == NULL) {
+        fprintf(stderr, "could not write %s\n", ini_path.string().c_str());
+        return 1;
+    }
+    fprintf(ini, "port = %u\n", (unsigned)sink.Port());
+    if (options.capture != nullptr) {
+        fprintf(ini, "dispatch_capture = %s\n", options.capture);
+    }
+    fclose(ini);
+    config_file.Load(ini_path.string().c_str());
+    std::filesystem::remove(ini_path);
+
+    // Keep the bridge's own printf's out of the report unless asked for
+    if (!options.verbose) {
+        freopen("/dev/null", "w", stdout);
+    }
+    ConfigureBridge();
+
+    pSimConnect_Open = FakeOpen;
+    pSimConnect_Close = FakeClose;
+    pSimConnect_CallDispatch = FakeCallDispatch;
+    pSimConnect_AddToDataDefinition = FakeAddToDataDefinition;
+    pSimConnect_RequestDataOnSimObject = FakeRequestDataOnSimObject;
+    if (!LoadSimConnect() || FAILED(pSimConnect_Open(&hSimConnect, "OpenVolanta SimReplay", NULL, 0, 0, 0))) {
+        fprintf(stderr, "could not open the fake SimConnect\n");
+        return 1;
+    }
+    StartBridge();
+
+    // Nothing is dispatched until the bridge is talking to the sink
+    auto connect_deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!IsVolantaConnected()) {
+        if (std::chrono::steady_clock::now() > connect_deadline) {
+            fprintf(stderr, "the bridge never connected to the sink\n");
+            return 1;
+        }
+        PumpBridge();
+    }
+
+    double cpu_start = ThreadCpuSeconds();
+    gSim.start = std::chrono::steady_clock::now();
+    uint64_t pumps = 0;
+    while (gSim.next < gSim.blobs.size()) {
+        PumpBridge();
+        pumps++;
+    }
+    double cpu_s = ThreadCpuSeconds() - cpu_start;
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - gSim.start).count();
+
+    // Let the last lines arrive
+    auto drain_deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (sink.Positions() < gSim.positions && std::chrono::steady_clock::now() < drain_deadline) {
+        PumpBridge();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    pSimConnect_Close(hSimConnect);
+    StopBridge();
+    sink.Stop();
+    SocketCleanup();
+
+    std::vector<int64_t>& latencies = sink.Latencies();
+    std::sort(latencies.begin(), latencies.end());
+    fprintf(stderr, "%s: %llu blobs (%llu positions) in %.2f s, %.0f msg/s dispatched\n",
+        options.replay ? options.replay : "synthetic",
+        (unsigned long long)gSim.dispatched,
+        (unsigned long long)gSim.positions,
+        wall_s,
+        wall_s > 0.0 ? (double)gSim.dispatched / wall_s : 0.0);
+    fprintf(stderr, "sink: %llu lines, %llu POSITION_UPDATE, %llu bytes, %llu positions lost\n",
+        (unsigned long long)sink.Lines(),
+        (unsigned long long)sink.Positions(),
+        (unsigned long long)sink.Bytes(),
+        (unsigned long long)(gSim.positions - std::min(gSim.positions, sink.Positions())));
+    fprintf(stderr, "%s to wire: p50 %.1f us, p99 %.1f us, max %.1f us\n",
+        gSim.unpaced ? "dispatch" : "sim frame",
+        Percentile(latencies, 0.50),
+        Percentile(latencies, 0.99),
+        latencies.empty() ? 0.0 : (double)latencies.back() / 1000.0);
+    fprintf(stderr, "bridge thread: %.2f us CPU per blob in the DispatchProc, %.3f ms CPU per second, %.1f wakeups per second (%llu of %llu waits with data)\n",
+        gSim.dispatched > 0 ? gSim.dispatch_cpu_s * 1e6 / (double)gSim.dispatched : 0.0,
+        wall_s > 0.0 ? cpu_s * 1e3 / wall_s : 0.0,
+        wall_s > 0.0 ? (double)pumps / wall_s : 0.0,
+        (unsigned long long)gSim.wakeups,
+        (unsigned long long)gSim.waits);
+    fprintf(stderr, "fake SimConnect: %llu data definitions, %llu position requests, %.1f bytes per position (%zu untagged)\n",
+        (unsigned long long)gSim.definitions,
+        (unsigned long long)gSim.position_requests,
+        gSim.positions > 0 ? (double)gSim.position_bytes / (double)gSim.positions : 0.0,
+        kDataOffset + SimVarBlockSize(kPositionSimVars, kPositionSimVarCount));
+    return 0;
+}
@@ -0,0 +1,318 @@
+#include "include/Bridge.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+#include "Telemetry.h"
+#include "FlightPhase.h"
+#include "RateController.h"
+
+#define BRIDGE_IDLE_MS 500          // longest wait for SimConnect while connected
+#define BRIDGE_BACKLOG_MS 10        // ... while the socket still has output queued
+#define BRIDGE_DEFAULT_FPS 30.0f    // until the first position reports one
+#define BRIDGE_RESEND_SLACK_S 0.25  // past the interval before an unchanged position is resent
+
+static const TelemetrySource kTelemetrySource = { "msfs", "11.0" };
+
+// Define SimConnect function pointers
+PfSimConnect_Open pSimConnect_Open = NULL;
+PfSimConnect_Close pSimConnect_Close = NULL;
+PfSimConnect_CallDispatch pSimConnect_CallDispatch = NULL;
+PfSimConnect_AddToDataDefinition pSimConnect_AddToDataDefinition = NULL;
+PfSimConnect_RequestDataOnSimObject pSimConnect_RequestDataOnSimObject = NULL;
+
+HANDLE  hSimConnect = NULL;
+
+static void LogLine(const char* line)
+{
+    fputs(line, stdout);
+}
+
+Connection* volanta = NULL;
+
+// Last AIRCRAFT_UPDATE, replayed whenever Volanta (re)connects since the sim
+// only tells us when the aircraft changes
+char last_aircraft_json[TELEMETRY_MAX_MESSAGE];
+size_t last_aircraft_length = 0;
+
+// Same for the current PHASE_CHANGE
+char last_phase_json[TELEMETRY_MAX_MESSAGE];
+size_t last_phase_length = 0;
+
+ConfigFile config_file;
+RateController rate_controller{ RateConfig() };
+FlightPhaseTracker flight_phase{ PhaseConfig() };
+RateStats flight_rate;
+
+// The standing position subscription: SimConnect delivers a sample every
+// `interval + 1` periods on its own, no request per sample
+SIMCONNECT_PERIOD position_period = SIMCONNECT_PERIOD_NEVER;
+DWORD position_interval = 0;
+
+// Tagged deltas merged so far. SimConnect stays quiet while nothing
+// changes, so the last state is resent once the interval is up.
+TelemetrySnapshot position_state;
+bool have_position = false;
+double last_position_s = 0.0;
+float position_interval_s = 0.0f;
+
+FILE* capture_file = NULL;
+std::chrono::steady_clock::time_point capture_start;
+
+bool SendToVolanta(const char* json, size_t length) {
+    return volanta && length > 0 && volanta->Send(json, length);
+}
+
+double SecondsNow() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void PrintFlightRate(const char* label) {
+    if (flight_rate.updates == 0) {
+        return;
+    }
+    printf("%s: %llu position updates over %.0f s, %.2f Hz effective, %lld bytes saved vs fixed %.0f Hz\n",
+        label,
+        (unsigned long long)flight_rate.updates,
+        flight_rate.elapsed_s,
+        flight_rate.EffectiveHz(),
+        (long long)flight_rate.BytesSaved(RATE_BASELINE_HZ),
+        RATE_BASELINE_HZ);
+}
+
+void ConfigureBridge() {
+    rate_controller = RateController(ReadRateConfig(config_file));
+    flight_phase = FlightPhaseTracker(ReadPhaseConfig(config_file, 1.0f));   // GROUND VELOCITY is in knots
+
+    const char* capture = config_file.GetString("dispatch_capture", "");
+    if (capture[0] != '\0') {
+        capture_file = fopen(capture, "wb");
+        if (capture_file) {
+            printf("Capturing SimConnect data to %s\n", capture);
+        }
+        else {
+            printf("Could not open %s for the SimConnect capture\n", capture);
+        }
+    }
+}
+
+static void CaptureBlob(const SIMCONNECT_RECV* pData, DWORD cbData) {
+    auto now = std::chrono::steady_clock::now();
+    if (ftell(capture_file) == 0) {
+        capture_start = now;
+    }
+    uint32_t size = cbData;
+    uint64_t time_ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(now - capture_start).count();
+    fwrite(&size, sizeof(size), 1, capture_file);
+    fwrite(&time_ns, sizeof(time_ns), 1, capture_file);
+    fwrite(pData, 1, size, capture_file);
+}
+
+// Connects, notices a lost peer and backs off between attempts; never blocks.
+// Returns how long the caller may wait before the next call.
+int UpdateVolantaConnection() {
+    struct pollfd pfd;
+    short revents = 0;
+    if (volanta->PreparePoll(pfd) && PollSockets(&pfd, 1, 0) > 0) {
+        revents = pfd.revents;
+    }
+    auto now = Connection::Clock::now();
+    volanta->Update(now, revents);
+    if (volanta->TakeJustConnected()) {
+        if (last_aircraft_length > 0) {
+            volanta->Send(last_aircraft_json, last_aircraft_length);
+        }
+        if (last_phase_length > 0) {
+            volanta->Send(last_phase_json, last_phase_length);
+        }
+        volanta->Flush(now);
+    }
+    if (volanta->PreparePoll(pfd) && (pfd.events & POLLOUT)) {
+        return BRIDGE_BACKLOG_MS;
+    }
+    return volanta->PollTimeoutMs(now, BRIDGE_IDLE_MS);
+}
+
+// (Re)subscribes when the wanted sampling interval no longer matches the
+// standing request. Whole seconds go by the sim clock, anything faster is
+// counted in sim frames at the frame rate last reported; small frame rate
+// swings are not worth a new request.
+void UpdatePositionSubscription(float interval_s, float fps) {
+    SIMCONNECT_PERIOD period = SIMCONNECT_PERIOD_SIM_FRAME;
+    DWORD interval = 0;
+    if (interval_s >= 1.0f) {
+        period = SIMCONNECT_PERIOD_SECOND;
+        interval = (DWORD)(interval_s + 0.5f) - 1;
+    }
+    else if (interval_s > 0.0f) {
+        float frames = interval_s * (fps > 1.0f ? fps : BRIDGE_DEFAULT_FPS);
+        interval = frames > 1.5f ? (DWORD)(frames + 0.5f) - 1 : 0;
+    }
+    if (period == position_period) {
+        DWORD slack = position_interval / 5;
+        DWORD difference = interval > position_interval ? interval - position_interval : position_interval - interval;
+        if (difference <= (slack > 1 ? slack : 1) && (interval == 0) == (position_interval == 0)) {
+            return;
+        }
+    }
+    pSimConnect_RequestDataOnSimObject(hSimConnect, REQUEST_POSITION, DEFINITION_POSITION, SIMCONNECT_OBJECT_ID_USER, period,
+        SIMCONNECT_DATA_REQUEST_FLAG_CHANGED | SIMCONNECT_DATA_REQUEST_FLAG_TAGGED, 0, interval, 0);
+    position_period = period;
+    position_interval = interval;
+}
+
+// POSITION_UPDATE for the merged state, plus everything that follows from a
+// new sample: phase, sampling rate and subscription
+void PublishPosition(double now) {
+    const TelemetrySnapshot& snapshot = position_state;
+    position_state.paused = position_state.time_acceleration < 0.001f;
+
+    char json[TELEMETRY_MAX_MESSAGE];
+    size_t length = SerializePositionUpdate(snapshot, kTelemetrySource, json, sizeof(json));
+
+    if (SendToVolanta(json, length)) {
+        flight_rate.Record(now, length);
+    }
+    last_position_s = now;
+    if (flight_phase.Update(snapshot, now)) {
+        printf("Phase %s -> %s\n", FlightPhaseName(flight_phase.Previous()), FlightPhaseName(flight_phase.Phase()));
+        last_phase_length = SerializePhaseChange(flight_phase.Event(snapshot), last_phase_json, sizeof(last_phase_json));
+        SendToVolanta(last_phase_json, last_phase_length);
+    }
+
+    // 0 means every frame
+    position_interval_s = rate_controller.Update(snapshot, now);
+    if (rate_controller.TakeChanged()) {
+        printf("Sampling %s every %dms\n", SampleTierName(rate_controller.Tier()), (int)(position_interval_s * 1000.0f));
+    }
+    UpdatePositionSubscription(position_interval_s, snapshot.fps);
+}
+
+bool IsVolantaConnected() {
+    return volanta && volanta->IsConnected();
+}
+
+void CALLBACK MyDispatchProcRD(SIMCONNECT_RECV* pData, DWORD cbData, void* pContext)
+{
+    if (capture_file) {
+        CaptureBlob(pData, cbData);
+    }
+
+    switch (pData->dwID)
+    {
+        case SIMCONNECT_RECV_ID_SIMOBJECT_DATA:
+        {
+            SIMCONNECT_RECV_SIMOBJECT_DATA* pTabData = (SIMCONNECT_RECV_SIMOBJECT_DATA*)pData;
+
+            if (pTabData->dwRequestID == REQUEST_POSITION)
+            {
+                if (DecodeSimVars(kPositionSimVars, kPositionSimVarCount, pTabData, cbData, &position_state)) {
+                    have_position = true;
+                    PublishPosition(SecondsNow());
+                }
+                else {
+                    printf("\nMalformed position data (%u bytes, %u values)", (unsigned)cbData, (unsigned)pTabData->dwDefineCount);
+                }
+            }
+            else if (pTabData->dwRequestID == REQUEST_AIRCRAFT)
+            {
+                StructAircraft* pS = (StructAircraft*)&pTabData->dwData;
+                printf("\n[Event] Aircraft Changed: %s (%s)\n", pS->title, pS->registration);
+                PrintFlightRate("Flight summary");
+                flight_rate.Reset();
+
+                const AircraftInfo aircraft = { pS->title, pS->type, pS->model, pS->registration, "" };
+                last_aircraft_length = SerializeAircraftUpdate(aircraft, last_aircraft_json, sizeof(last_aircraft_json));
+
+                SendToVolanta(last_aircraft_json, last_aircraft_length);
+            }
+            break;
+        }
+
+        case SIMCONNECT_RECV_ID_QUIT:
+        {
+            printf("\nQuit received.");
+            break;
+        }
+
+        case SIMCONNECT_RECV_ID_EXCEPTION:
+        {
+            SIMCONNECT_RECV_EXCEPTION* pObjData = (SIMCONNECT_RECV_EXCEPTION*)pData;
+            printf("\nException received: %d", pObjData->dwException);
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+void StartBridge() {
+    HRESULT hr;
+
+    ConnectionConfig config;
+    config.host = config_file.GetString("host", config.host);
+    config.port = (uint16_t)config_file.GetNumber("port", config.port);
+    config.log = LogLine;
+    volanta = new Connection(config);
+
+    // Set up Aircraft Definition
+    hr = pSimConnect_AddToDataDefinition(hSimConnect, DEFINITION_AIRCRAFT, "TITLE", NULL, SIMCONNECT_DATATYPE_STRING256, 0.0f, SIMCONNECT_UNUSED);
+    hr = pSimConnect_AddToDataDefinition(hSimConnect, DEFINITION_AIRCRAFT, "ATC MODEL", NULL, SIMCONNECT_DATATYPE_STRING256, 0.0f, SIMCONNECT_UNUSED);
+    hr = pSimConnect_AddToDataDefinition(hSimConnect, DEFINITION_AIRCRAFT, "ATC TYPE", NULL, SIMCONNECT_DATATYPE_STRING256, 0.0f, SIMCONNECT_UNUSED);
+    hr = pSimConnect_AddToDataDefinition(hSimConnect, DEFINITION_AIRCRAFT, "ATC ID", NULL, SIMCONNECT_DATATYPE_STRING256, 0.0f, SIMCONNECT_UNUSED);
+
+
+    // Request Aircraft Data - Only when changed
+    hr = pSimConnect_RequestDataOnSimObject(hSimConnect, REQUEST_AIRCRAFT, DEFINITION_AIRCRAFT, SIMCONNECT_OBJECT_ID_USER, SIMCONNECT_PERIOD_SIM_FRAME, SIMCONNECT_DATA_REQUEST_FLAG_CHANGED, 0, 0, 0);
+    (void)hr;
+
+    // Set up Position Definition
+    AddSimVarDefinitions(hSimConnect, DEFINITION_POSITION, kPositionSimVars, kPositionSimVarCount);
+
+    // Position every frame until the first sample picks a rate
+    position_state = TelemetrySnapshot();
+    position_state.gravity = 1.0f;
+    position_state.g_load = 1.0f;
+    have_position = false;
+    position_period = SIMCONNECT_PERIOD_NEVER;
+    UpdatePositionSubscription(0.0f, 0.0f);
+}
+
+void PumpBridge() {
+    int timeout_ms = UpdateVolantaConnection();
+    if (have_position) {
+        double resend_s = last_position_s + position_interval_s + BRIDGE_RESEND_SLACK_S - SecondsNow();
+        int resend_ms = resend_s > 0.0 ? (int)(resend_s * 1000.0) + 1 : 0;
+        timeout_ms = resend_ms < timeout_ms ? resend_ms : timeout_ms;
+    }
+
+    // Sleeps until SimConnect signals data or the connection needs us
+    bool dispatched = WaitForSimConnect(timeout_ms);
+    if (dispatched) {
+        pSimConnect_CallDispatch(hSimConnect, MyDispatchProcRD, NULL);
+    }
+
+    // Nothing changed for a whole interval: same position again
+    double now = SecondsNow();
+    if (have_position && now - last_position_s >= position_interval_s + BRIDGE_RESEND_SLACK_S) {
+        PublishPosition(now);
+        dispatched = true;
+    }
+
+    // Everything the dispatch queued goes out in one write
+    if (dispatched) {
+        volanta->Flush(Connection::Clock::now());
+    }
+}
+
+void StopBridge() {
+    PrintFlightRate("Flight summary");
+    delete volanta;
+    volanta = NULL;
+    if (capture_file) {
+        fclose(capture_file);
+        capture_file = NULL;
+    }
+}
@@ -0,0 +1,113 @@
+#include "include/SimVars.h"
+
+#include <string.h>
+
+#include "include/SimConnectDynamic.h"
+
+// One line per variable, in snapshot order. Units are what the snapshot
+// expects; booleans come as INT32 0/1. The thresholds sit below what the
+// serializer prints, so CHANGED only suppresses samples nobody would see
+// differ (fuel, wind and frame rate mostly).
+const SimVarSpec kPositionSimVars[] = {
+    { "PLANE LATITUDE",             "degrees",      0.0f,  SNAPSHOT_FIELD(latitude) },
+    { "PLANE LONGITUDE",            "degrees",      0.0f,  SNAPSHOT_FIELD(longitude) },
+    { "PLANE ALTITUDE",             "meters",       0.0f,  SNAPSHOT_FIELD(altitude_amsl) },
+    { "PLANE ALT ABOVE GROUND",     "meters",       0.0f,  SNAPSHOT_FIELD(altitude_agl) },
+
+    { "PLANE PITCH DEGREES",        "degrees",      0.01f, SNAPSHOT_FIELD(pitch) },
+    { "PLANE BANK DEGREES",         "degrees",      0.01f, SNAPSHOT_FIELD(bank) },
+    { "PLANE HEADING DEGREES TRUE", "degrees",      0.01f, SNAPSHOT_FIELD(heading_true) },
+    { "GROUND VELOCITY",            "knots",        0.05f, SNAPSHOT_FIELD(ground_speed) },
+    { "VERTICAL SPEED",             "feet/minute",  1.0f,  SNAPSHOT_FIELD(vertical_speed) },
+    { "FUEL TOTAL QUANTITY WEIGHT", "kilograms",    0.5f,  SNAPSHOT_FIELD(fuel_kg) },
+    { "FRAME RATE",                 "number",       1.0f,  SNAPSHOT_FIELD(fps) },
+    { "SIMULATION RATE",            "number",       0.0f,  SNAPSHOT_FIELD(time_acceleration) },
+    { "BRAKE PARKING POSITION",     "position",     0.01f, SNAPSHOT_FIELD(parking_brake) },
+    { "AMBIENT WIND VELOCITY",      "knots",        0.5f,  SNAPSHOT_FIELD(wind_speed) },
+    { "AMBIENT WIND DIRECTION",     "degrees",      1.0f,  SNAPSHOT_FIELD(wind_direction) },
+
+    { "TRANSPONDER CODE:1",         "number",       0.0f,  SNAPSHOT_FIELD(transponder) },
+    { "SIM ON GROUND",              "bool",         0.0f,  SNAPSHOT_FIELD(on_ground) },
+    { "IS SLEW ACTIVE",             "bool",         0.0f,  SNAPSHOT_FIELD(slew) },
+    { "AUTOPILOT MASTER",           "bool",         0.0f,  SNAPSHOT_FIELD(autopilot_engaged) },
+    { "GENERAL ENG COMBUSTION:1",   "bool",         0.0f,  SNAPSHOT_FIELD(engines_running) },
+};
+
+const size_t kPositionSimVarCount = sizeof(kPositionSimVars) / sizeof(kPositionSimVars[0]);
+
+SIMCONNECT_DATATYPE SimVarDataType(FieldType type)
+{
+    switch (type) {
+        case FieldType::F64: return SIMCONNECT_DATATYPE_FLOAT64;
+        case FieldType::F32: return SIMCONNECT_DATATYPE_FLOAT32;
+        case FieldType::I32: return SIMCONNECT_DATATYPE_INT32;
+    }
+    return SIMCONNECT_DATATYPE_INVALID;
+}
+
+size_t SimVarSize(FieldType type)
+{
+    return type == FieldType::F64 ? sizeof(double) : 4;
+}
+
+size_t SimVarBlockSize(const SimVarSpec* specs, size_t count)
+{
+    size_t size = 0;
+    for (size_t i = 0; i < count; i++) {
+        size += SimVarSize(specs[i].destination);
+    }
+    return size;
+}
+
+void AddSimVarDefinitions(HANDLE handle, SIMCONNECT_DATA_DEFINITION_ID define, const SimVarSpec* specs, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        pSimConnect_AddToDataDefinition(handle, define, specs[i].name, specs[i].units,
+            SimVarDataType(specs[i].destination), specs[i].epsilon, (DWORD)i);
+    }
+}
+
+bool DecodeSimVars(const SimVarSpec* specs, size_t count, const SIMCONNECT_RECV_SIMOBJECT_DATA* data, DWORD cbData, void* out)
+{
+    const size_t header = sizeof(SIMCONNECT_RECV_SIMOBJECT_DATA) - sizeof(DWORD);
+    if (cbData < header) {
+        return false;
+    }
+    const char* payload = (const char*)data + header;
+    size_t available = cbData - header;
+    char* base = (char*)out;
+
+    if (!(data->dwFlags & SIMCONNECT_DATA_REQUEST_FLAG_TAGGED)) {
+        if (available < SimVarBlockSize(specs, count)) {
+            return false;
+        }
+        for (size_t i = 0; i < count; i++) {
+            size_t size = SimVarSize(specs[i].destination);
+            memcpy(base + specs[i].offset, payload, size);
+            payload += size;
+        }
+        return true;
+    }
+
+    // Checked in full first so a bad message changes nothing
+    size_t used = 0;
+    for (DWORD n = 0; n < data->dwDefineCount; n++) {
+        DWORD id;
+        if (available - used < sizeof(id)) {
+            return false;
+        }
+        memcpy(&id, payload + used, sizeof(id));
+        if (id >= count || available - used - sizeof(id) < SimVarSize(specs[id].destination)) {
+            return false;
+        }
+        used += sizeof(id) + SimVarSize(specs[id].destination);
+    }
+    for (DWORD n = 0; n < data->dwDefineCount; n++) {
+        DWORD id;
+        memcpy(&id, payload, sizeof(id));
+        size_t size = SimVarSize(specs[id].destination);
+        memcpy(base + specs[id].offset, payload + sizeof(id), size);
+        payload += sizeof(id) + size;
+    }
+    return true;
+}
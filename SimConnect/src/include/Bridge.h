@@ -0,0 +1,73 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "Config.h"
+#include "Connection.h"
+#include "WinTypes.h"
+#include "SimConnect.h"
+#include "SimConnectDynamic.h"
+#include "SimVars.h"
+
+// Everything between SimConnect and Volanta: data definitions, the dispatch
+// callback and the Volanta connection. It only talks to SimConnect through
+// the pSimConnect_* pointers, so SimConnect/Replay can drive the exact same
+// code on any platform with recorded or synthetic SIMCONNECT_RECV blobs.
+// Positions are defined by kPositionSimVars and arrive as tagged deltas.
+// main.cpp adds the Windows parts: finding the config, loading the DLL and
+// the event SimConnect signals.
+
+enum DATA_DEFINE_ID {
+    DEFINITION_POSITION,
+    DEFINITION_AIRCRAFT
+};
+
+enum DATA_REQUEST_ID {
+    REQUEST_POSITION,
+    REQUEST_AIRCRAFT
+};
+
+struct StructAircraft {
+    char    title[256];         // TITLE
+    char    model[256];         // ATC MODEL
+    char    type[256];          // ATC TYPE
+    char    registration[256];  // ATC ID
+};
+
+// With dispatch_capture set in OpenVolanta.ini, every SIMCONNECT_RECV the
+// bridge receives is appended to that file as
+//
+//   uint32_t size, uint64_t ns since the first one, `size` bytes
+//
+// back to back and little endian, which SimConnect/Replay feeds back in.
+
+extern HANDLE hSimConnect;
+extern ConfigFile config_file;
+
+// Picks the rate, phase and capture settings up from config_file
+void ConfigureBridge();
+
+// Once SimConnect is open: creates the Volanta connection, adds the data
+// definitions and subscribes to aircraft changes and positions. The
+// position subscription is periodic and follows the sampling rate, so
+// nothing has to be requested per sample, and only delivers what changed;
+// when nothing did for a whole interval the last position is sent again.
+void StartBridge();
+
+// One pass of the main loop: Volanta connection upkeep, then a wait for
+// SimConnect, then CallDispatch and one write for everything that produced.
+// Blocks for at most the wait.
+void PumpBridge();
+
+// Provided by the host: blocks until SimConnect has something to dispatch
+// (true) or timeout_ms passes (false). main.cpp waits on the event handle it
+// gave SimConnect_Open; SimReplay on its own clock.
+bool WaitForSimConnect(int timeout_ms);
+
+// Prints the flight summary and drops the Volanta connection
+void StopBridge();
+
+bool IsVolantaConnected();
+
+void CALLBACK MyDispatchProcRD(SIMCONNECT_RECV* pData, DWORD cbData, void* pContext);
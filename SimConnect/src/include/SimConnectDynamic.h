@@ -1,5 +1,5 @@
 #pragma once
-#include <windows.h>
+#include "WinTypes.h"
 #include "SimConnect.h"
 
 typedef HRESULT (WINAPI *PfSimConnect_Open)(HANDLE*, LPCSTR, HWND, DWORD, HANDLE, DWORD);
@@ -14,7 +14,11 @@ extern PfSimConnect_CallDispatch pSimConnect_CallDispatch;
 extern PfSimConnect_AddToDataDefinition pSimConnect_AddToDataDefinition;
 extern PfSimConnect_RequestDataOnSimObject pSimConnect_RequestDataOnSimObject;
 
+// Resolves the entry points from SimConnect.dll. Anywhere else the pointers
+// have to be filled in by hand (SimConnect/Replay does), and this only
+// checks that they were.
 inline bool LoadSimConnect() {
+#ifdef _WIN32
     HMODULE hSimConnectDll = LoadLibrary(TEXT("SimConnect.dll"));
     if (!hSimConnectDll) return false;
 
@@ -23,6 +27,7 @@ inline bool LoadSimConnect() {
     pSimConnect_CallDispatch = (PfSimConnect_CallDispatch)GetProcAddress(hSimConnectDll, "SimConnect_CallDispatch");
     pSimConnect_AddToDataDefinition = (PfSimConnect_AddToDataDefinition)GetProcAddress(hSimConnectDll, "SimConnect_AddToDataDefinition");
     pSimConnect_RequestDataOnSimObject = (PfSimConnect_RequestDataOnSimObject)GetProcAddress(hSimConnectDll, "SimConnect_RequestDataOnSimObject");
+#endif
 
     return (pSimConnect_Open && pSimConnect_Close && pSimConnect_CallDispatch && pSimConnect_AddToDataDefinition && pSimConnect_RequestDataOnSimObject);
 }
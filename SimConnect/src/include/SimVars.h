@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "Telemetry.h"
+#include "WinTypes.h"
+#include "SimConnect.h"
+
+// Table driven SimConnect data definitions. Every simulation variable is
+// declared once with its units, the change threshold SimConnect applies
+// with SIMCONNECT_DATA_REQUEST_FLAG_CHANGED, and the snapshot field it lands
+// in. It is requested in that field's own type (INT32, FLOAT32 or FLOAT64)
+// and with its index in the table as the datum ID, so a TAGGED delivery can
+// carry just the variables that changed.
+//
+// Payloads, after the SIMCONNECT_RECV_SIMOBJECT_DATA header (dwData on):
+//
+//   untagged    every variable in table order, packed without padding
+//   tagged      dwDefineCount times (DWORD datum ID, value), changed ones only
+
+struct SimVarSpec {
+    const char* name;
+    const char* units;
+    float       epsilon;        // smallest change SimConnect reports
+    FieldType   destination;
+    uint16_t    offset;
+};
+
+SIMCONNECT_DATATYPE SimVarDataType(FieldType type);
+size_t SimVarSize(FieldType type);
+
+// Bytes of an untagged payload
+size_t SimVarBlockSize(const SimVarSpec* specs, size_t count);
+
+// AddToDataDefinition for every variable, through pSimConnect_*
+void AddSimVarDefinitions(HANDLE handle, SIMCONNECT_DATA_DEFINITION_ID define, const SimVarSpec* specs, size_t count);
+
+// Merges one SIMOBJECT_DATA message into `out`, which must be the struct the
+// spec offsets were taken from. Tagged (dwFlags) payloads only overwrite the
+// variables they carry. Returns false, leaving `out` alone, if the payload
+// is truncated or names a datum the table doesn't have.
+bool DecodeSimVars(const SimVarSpec* specs, size_t count, const SIMCONNECT_RECV_SIMOBJECT_DATA* data, DWORD cbData, void* out);
+
+// Everything the bridge reads into a TelemetrySnapshot
+extern const SimVarSpec kPositionSimVars[];
+extern const size_t kPositionSimVarCount;
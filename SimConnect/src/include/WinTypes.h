@@ -0,0 +1,40 @@
+#pragma once
+
+// The Windows types SimConnect.h is written against. On Windows that is
+// windows.h; elsewhere just enough of it, with the same sizes, for the
+// bridge logic and the replay harness in SimConnect/Replay to build.
+
+#ifdef _WIN32
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <cstdint>
+
+    typedef uint32_t    DWORD;
+    typedef uint8_t     BYTE;
+    typedef int32_t     BOOL;
+    typedef int32_t     HRESULT;
+    typedef void*       HANDLE;
+    typedef void*       HWND;
+    typedef const char* LPCSTR;
+
+    struct GUID {
+        uint32_t Data1;
+        uint16_t Data2;
+        uint16_t Data3;
+        uint8_t  Data4[8];
+    };
+
+    #define FALSE 0
+    #define TRUE 1
+    #define MAX_PATH 260
+    #define CALLBACK
+    #define WINAPI
+    #define __stdcall
+    #define S_OK ((HRESULT)0)
+    #define E_FAIL ((HRESULT)0x80004005)
+    #define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+    #define FAILED(hr) (((HRESULT)(hr)) < 0)
+#endif
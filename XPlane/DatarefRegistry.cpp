@@ -0,0 +1,145 @@
+#include "DatarefRegistry.h"
+
+#include <cstdio>
+#include <cstring>
+
+// One line per field. The order only matters for cache locality, so it
+// follows the snapshot layout.
+const DatarefSpec kSnapshotDatarefs[] = {
+    { "sim/flightmodel/position/latitude",              xplmType_Double,   1, DatarefReduce::None, SNAPSHOT_FIELD(latitude) },
+    { "sim/flightmodel/position/longitude",             xplmType_Double,   1, DatarefReduce::None, SNAPSHOT_FIELD(longitude) },
+    { "sim/flightmodel/position/elevation",             xplmType_Double,   1, DatarefReduce::None, SNAPSHOT_FIELD(altitude_amsl) },
+    { "sim/flightmodel/position/y_agl",                 xplmType_Float,    1, DatarefReduce::None, SNAPSHOT_FIELD(altitude_agl) },
+
+    { "sim/flightmodel/position/theta",                 xplmType_Float,    1, DatarefReduce::None, SNAPSHOT_FIELD(pitch) },
+    { "sim/flightmodel/position/phi",                   xplmType_Float,    1, DatarefReduce::None, SNAPSHOT_FIELD(bank) },
+    { "sim/flightmodel/position/psi",                   xplmType_Float,    1, DatarefReduce::None, SNAPSHOT_FIELD(heading_true) },
+    { "sim/flightmodel/position/groundspeed",           xplmType_Float,    1, DatarefReduce::None, SNAPSHOT_FIELD(ground_speed) },
+    { "sim/flightmodel/position/vh_ind_fpm",            xplmType_Float,    1, DatarefReduce::None, SNAPSHOT_FIELD(vertical_speed) },
+    { "sim/flightmodel/weight/m_fuel_total",            xplmType_Float,    1, DatarefReduce::None, SNAPSHOT_FIELD(fuel_kg) },
+    { "sim/physics/gravity_normal",                     xplmType_Float,    1, DatarefReduce::None, SNAPSHOT_FIELD(gravity) },
+    { "sim/flightmodel2/misc/gforce_normal",            xplmType_Float,    1, DatarefReduce::None, SNAPSHOT_FIELD(g_load) },
+    { "sim/flightmodel2/gear/tire_vertical_deflection_mtr", xplmType_FloatArray, 10, DatarefReduce::Max, SNAPSHOT_FIELD(gear_deflection) },
+    // fps comes from the per-frame timer in main.cpp, not framerate_period
+    { "sim/time/time_accel",                            xplmType_Float,    1, DatarefReduce::None, SNAPSHOT_FIELD(time_acceleration) },
+    { "sim/cockpit2/controls/parking_brake_ratio",      xplmType_Float,    1, DatarefReduce::None, SNAPSHOT_FIELD(parking_brake) },
+    { "sim/weather/wind_speed_kt",                      xplmType_Float,    1, DatarefReduce::None, SNAPSHOT_FIELD(wind_speed) },
+    { "sim/weather/wind_direction_degt",                xplmType_Float,    1, DatarefReduce::None, SNAPSHOT_FIELD(wind_direction) },
+
+    { "sim/cockpit/radios/transponder_code",            xplmType_Int,      1, DatarefReduce::None, SNAPSHOT_FIELD(transponder) },
+    { "sim/flightmodel/failures/onground_any",          xplmType_Int,      1, DatarefReduce::None, SNAPSHOT_FIELD(on_ground) },
+    { "sim/operation/override/override_planepath",      xplmType_IntArray, 1, DatarefReduce::Any,  SNAPSHOT_FIELD(slew) },
+    { "sim/time/paused",                                xplmType_Int,      1, DatarefReduce::None, SNAPSHOT_FIELD(paused) },
+    { "sim/operation/prefs/replay_mode",                xplmType_Int,      1, DatarefReduce::None, SNAPSHOT_FIELD(in_replay_mode) },
+    { "sim/cockpit/autopilot/autopilot_mode",           xplmType_Int,      1, DatarefReduce::None, SNAPSHOT_FIELD(autopilot_engaged) },
+    { "sim/flightmodel/engine/ENGN_running",            xplmType_IntArray, 8, DatarefReduce::Any,  SNAPSHOT_FIELD(engines_running) },
+};
+
+const size_t kSnapshotDatarefCount = sizeof(kSnapshotDatarefs) / sizeof(kSnapshotDatarefs[0]);
+
+namespace {
+
+template <typename T>
+inline void Store(char* base, uint16_t offset, FieldType type, T value)
+{
+    switch (type) {
+        case FieldType::F64: { double v = (double)value;   memcpy(base + offset, &v, sizeof(v)); break; }
+        case FieldType::F32: { float v = (float)value;     memcpy(base + offset, &v, sizeof(v)); break; }
+        case FieldType::I32: { int32_t v = (int32_t)value; memcpy(base + offset, &v, sizeof(v)); break; }
+    }
+}
+
+inline size_t FieldSize(FieldType type)
+{
+    return type == FieldType::F64 ? sizeof(double) : 4;
+}
+
+template <typename T>
+inline void StoreArray(char* base, uint16_t offset, uint8_t count,
+                       DatarefReduce reduce, FieldType type, const T* values, int n)
+{
+    if (reduce == DatarefReduce::None) {
+        size_t stride = FieldSize(type);
+        for (int i = 0; i < n && i < count; i++) {
+            Store(base, (uint16_t)(offset + i * stride), type, values[i]);
+        }
+        return;
+    }
+    T result = 0;
+    for (int i = 0; i < n; i++) {
+        switch (reduce) {
+            case DatarefReduce::Any: result = result || values[i] != 0; break;
+            case DatarefReduce::Sum: result += values[i]; break;
+            case DatarefReduce::Max: result = (i == 0 || values[i] > result) ? values[i] : result; break;
+            case DatarefReduce::None: break;
+        }
+    }
+    Store(base, offset, type, result);
+}
+
+} // namespace
+
+DatarefRegistry::DatarefRegistry(const DatarefSpec* specs, size_t count)
+    : specs_(specs), count_(count)
+{
+}
+
+size_t DatarefRegistry::Resolve(void (*log)(const char* line))
+{
+    entries_.clear();
+    entries_.reserve(count_);
+    for (size_t i = 0; i < count_; i++) {
+        const DatarefSpec& spec = specs_[i];
+        XPLMDataRef ref = XPLMFindDataRef(spec.name);
+        if (ref == NULL) {
+            if (log) {
+                char line[256];
+                snprintf(line, sizeof(line), "OpenVolanta: Dataref %s not found, leaving it at 0\n", spec.name);
+                log(line);
+            }
+            continue;
+        }
+        // Reading through the wrong getter silently returns 0, which is how
+        // ENGN_running (an int array) used to always report engines off
+        XPLMDataTypeID types = XPLMGetDataRefTypes(ref);
+        if (log && (types & spec.source) == 0) {
+            char line[256];
+            snprintf(line, sizeof(line), "OpenVolanta: Dataref %s has types %d, expected %d\n",
+                spec.name, (int)types, (int)spec.source);
+            log(line);
+        }
+        uint8_t elements = spec.count < DATAREF_MAX_ARRAY ? spec.count : DATAREF_MAX_ARRAY;
+        entries_.push_back({ ref, spec.source, spec.offset, elements, spec.reduce, spec.destination });
+    }
+    return entries_.size();
+}
+
+void DatarefRegistry::Read(void* out) const
+{
+    char* base = (char*)out;
+    for (const Entry& e : entries_) {
+        switch (e.source) {
+            case xplmType_Double:
+                Store(base, e.offset, e.destination, XPLMGetDatad(e.ref));
+                break;
+            case xplmType_Float:
+                Store(base, e.offset, e.destination, XPLMGetDataf(e.ref));
+                break;
+            case xplmType_Int:
+                Store(base, e.offset, e.destination, XPLMGetDatai(e.ref));
+                break;
+            case xplmType_IntArray: {
+                int values[DATAREF_MAX_ARRAY];
+                int n = XPLMGetDatavi(e.ref, values, 0, e.count);
+                StoreArray(base, e.offset, e.count, e.reduce, e.destination, values, n);
+                break;
+            }
+            case xplmType_FloatArray: {
+                float values[DATAREF_MAX_ARRAY];
+                int n = XPLMGetDatavf(e.ref, values, 0, e.count);
+                StoreArray(base, e.offset, e.count, e.reduce, e.destination, values, n);
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "XPLMDataAccess.h"
+#include "Telemetry.h"
+
+// Table driven dataref reads. Every tracked dataref is declared once with the
+// type X-Plane publishes it as and where its value lands in the destination
+// struct; the registry resolves the names once and then copies all of them in
+// a single pass over a compact array, using XPLMGetDatavi/vf for arrays.
+
+enum class DatarefReduce : uint8_t {
+    None,   // copy `count` elements into an array at the destination
+    Any,    // 1 if any element is non-zero (e.g. "an engine is running")
+    Sum,
+    Max,
+};
+
+struct DatarefSpec {
+    const char*    name;
+    XPLMDataTypeID source;      // xplmType_Int, _Float, _Double, _IntArray or _FloatArray
+    uint8_t        count;       // elements read from an array dataref
+    DatarefReduce  reduce;
+    FieldType      destination;
+    uint16_t       offset;
+};
+
+#define DATAREF_MAX_ARRAY 16
+
+class DatarefRegistry {
+public:
+    DatarefRegistry(const DatarefSpec* specs, size_t count);
+
+    // Looks every name up with XPLMFindDataRef. Datarefs that don't exist in
+    // this X-Plane version are reported through `log` and skipped by Read.
+    // Returns how many were found.
+    size_t Resolve(void (*log)(const char* line));
+
+    // Copies every resolved dataref into `out`, which must be the struct the
+    // spec offsets were taken from. Missing datarefs leave their field alone.
+    void Read(void* out) const;
+
+    size_t Size() const { return count_; }
+    size_t Resolved() const { return entries_.size(); }
+
+private:
+    struct Entry {
+        XPLMDataRef    ref;
+        XPLMDataTypeID source;
+        uint16_t       offset;
+        uint8_t        count;
+        DatarefReduce  reduce;
+        FieldType      destination;
+    };
+
+    const DatarefSpec* specs_;
+    size_t             count_;
+    std::vector<Entry> entries_;   // resolved ones only, in declaration order
+};
+
+// Everything the flight loop copies into a TelemetrySnapshot
+extern const DatarefSpec kSnapshotDatarefs[];
+extern const size_t kSnapshotDatarefCount;
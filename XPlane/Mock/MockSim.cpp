@@ -0,0 +1,610 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "XPLMDefs.h"
+#include "XPLMPlugin.h"
+
+#include "BinaryTelemetry.h"
+#include "DatarefRegistry.h"
+#include "FlightRecorder.h"
+#include "Socket.h"
+#include "Telemetry.h"
+#include "XPLMMock.h"
+
+// Headless X-Plane stand-in: loads the plugin against the mock XPLM, feeds
+// it a scripted flight (or a recording made by the plugin itself) one frame
+// at a time as fast as the plugin allows, and listens as Volanta on a local
+// port. Reports the flight loop's CPU cost per simulated frame.
+//
+//   mocksim [--hours H] [--fps F] [--speed X] [--replay flight.ovr] [--record]
+//           [--subscribers N] [--binary] [--verbose]
+//
+// --speed paces the run at X times real time (default: unpaced). The worker
+// and recorder threads run on the wall clock, so it takes pacing to see how
+// often positions are really sent, or to record every frame with --record.
+// --subscribers turns the fan-out server on and connects N local readers;
+// the last one reads slowly, to show its queue dropping frames while the
+// others keep up. With --binary they read the binary stream and convert it
+// back to JSON lines.
+
+PLUGIN_API int  XPluginStart(char* outName, char* outSig, char* outDesc);
+PLUGIN_API void XPluginStop(void);
+PLUGIN_API int  XPluginEnable(void);
+PLUGIN_API void XPluginDisable(void);
+PLUGIN_API void XPluginReceiveMessage(XPLMPluginID inFrom, int inMsg, void* inParam);
+
+namespace {
+
+#define MOCK_EARTH_RADIUS_M 6371008.8
+#define MOCK_DEG_TO_RAD 0.017453292519943295
+#define MOCK_FIELD_ELEVATION_M 120.0
+
+struct Options {
+    double      hours = 1.0;
+    double      fps = 60.0;
+    double      speed = 0.0;
+    const char* replay = nullptr;
+    bool        record = false;
+    int         subscribers = 0;
+    bool        binary = false;
+    bool        verbose = false;
+};
+
+// The scripted flight: taxi out, climb, cruise for whatever is left of
+// --hours, descend and land with a flare, taxi in
+struct Leg {
+    double seconds;     // < 0: the cruise leg, stretched to fit
+    float  knots;
+    float  fpm;
+    float  turn_deg_s;
+    int    on_ground;
+    int    engines;
+    float  brake;
+};
+
+const Leg kScript[] = {
+    {   60,   0,     0,  0, 1, 0, 1.0f },  // cold and dark
+    {   60,   0,     0,  0, 1, 1, 1.0f },  // engines running
+    {  240,  15,     0,  0, 1, 1, 0.0f },  // taxi
+    {   30,  12,     0,  3, 1, 1, 0.0f },
+    {   35, 100,     0,  0, 1, 1, 0.0f },  // takeoff roll
+    {  600, 250,  1800,  0, 0, 1, 0.0f },  // climb to FL180
+    {   -1, 420,     0,  0, 0, 1, 0.0f },  // cruise
+    {  900, 300, -1200,  0, 0, 1, 0.0f },  // descent
+    {   60, 200,     0,  2, 0, 1, 0.0f },  // base turn
+    {  600, 140,  -700,  0, 0, 1, 0.0f },  // final, until the wheels touch
+    {   25,  80,     0,  0, 1, 1, 0.0f },  // rollout
+    {  180,  15,     0,  0, 1, 1, 0.0f },  // taxi in
+    {   60,   0,     0,  0, 1, 0, 1.0f },  // shut down
+};
+
+class ScriptedFlight {
+public:
+    ScriptedFlight(double total_s)
+    {
+        double fixed = 0.0;
+        for (const Leg& leg : kScript) {
+            fixed += leg.seconds > 0 ? leg.seconds : 0.0;
+        }
+        cruise_s_ = std::max(60.0, total_s - fixed);
+    }
+
+    bool Next(double dt, TelemetrySnapshot& snap)
+    {
+        while (leg_ < std::size(kScript) && leg_time_ >= Duration(kScript[leg_])) {
+            leg_++;
+            leg_time_ = 0.0;
+        }
+        if (leg_ >= std::size(kScript)) {
+            return false;
+        }
+        const Leg& leg = kScript[leg_];
+        leg_time_ += dt;
+
+        heading_ = std::fmod(heading_ + leg.turn_deg_s * dt + 360.0, 360.0);
+        double speed = leg.knots / MPS_TO_KNOTS;
+        latitude_ += speed * std::cos(heading_ * MOCK_DEG_TO_RAD) * dt / MOCK_EARTH_RADIUS_M / MOCK_DEG_TO_RAD;
+        longitude_ += speed * std::sin(heading_ * MOCK_DEG_TO_RAD) * dt / (MOCK_EARTH_RADIUS_M * std::cos(latitude_ * MOCK_DEG_TO_RAD)) / MOCK_DEG_TO_RAD;
+
+        float fpm = leg.fpm;
+        bool on_ground = leg.on_ground != 0;
+        if (!on_ground) {
+            double agl_ft = (altitude_ - MOCK_FIELD_ELEVATION_M) * METERS_TO_FT;
+            if (fpm < 0.0f && agl_ft < 30.0) {
+                fpm = -150.0f;      // flare
+            }
+            altitude_ += fpm / 60.0 / METERS_TO_FT * dt;
+            if (altitude_ <= MOCK_FIELD_ELEVATION_M) {
+                // Touchdown ends the final early
+                altitude_ = MOCK_FIELD_ELEVATION_M;
+                on_ground = true;
+                leg_time_ = Duration(leg);
+            }
+        }
+
+        snap = {};
+        snap.latitude = latitude_;
+        snap.longitude = longitude_;
+        snap.altitude_amsl = altitude_;
+        snap.altitude_agl = altitude_ - MOCK_FIELD_ELEVATION_M;
+        snap.pitch = fpm / 400.0f;
+        snap.heading_true = (float)heading_;
+        snap.ground_speed = (float)speed;
+        snap.vertical_speed = on_ground ? 0.0f : fpm;
+        snap.fuel_kg = 8000.0f - (float)(elapsed_ / 3600.0 * 2500.0);
+        snap.gravity = 1.0f;
+        snap.g_load = 1.0f;
+        snap.gear_deflection = on_ground ? 0.12f : 0.0f;
+        snap.time_acceleration = 1.0f;
+        snap.parking_brake = leg.brake;
+        snap.transponder = 7000;
+        snap.on_ground = on_ground;
+        snap.engines_running = leg.engines;
+        elapsed_ += dt;
+        return true;
+    }
+
+private:
+    double Duration(const Leg& leg) const { return leg.seconds > 0 ? leg.seconds : cruise_s_; }
+
+    double cruise_s_;
+    size_t leg_ = 0;
+    double leg_time_ = 0.0;
+    double elapsed_ = 0.0;
+    double latitude_ = 45.63;
+    double longitude_ = 8.72;
+    double altitude_ = MOCK_FIELD_ELEVATION_M;
+    double heading_ = 350.0;
+};
+
+// Publishes a snapshot through the same dataref table the plugin reads it
+// back with
+void PublishSnapshotDatarefs(const TelemetrySnapshot& snapshot)
+{
+    const char* base = (const char*)&snapshot;
+    for (size_t i = 0; i < kSnapshotDatarefCount; i++) {
+        const DatarefSpec& spec = kSnapshotDatarefs[i];
+        double value = 0.0;
+        switch (spec.destination) {
+            case FieldType::F64: { double v; memcpy(&v, base + spec.offset, sizeof(v)); value = v; break; }
+            case FieldType::F32: { float v; memcpy(&v, base + spec.offset, sizeof(v)); value = v; break; }
+            case FieldType::I32: { int32_t v; memcpy(&v, base + spec.offset, sizeof(v)); value = v; break; }
+        }
+        switch (spec.source) {
+            case xplmType_Double: MockPublishDatad(spec.name, value); break;
+            case xplmType_Float:  MockPublishDataf(spec.name, (float)value); break;
+            case xplmType_Int:    MockPublishDatai(spec.name, (int)value); break;
+            case xplmType_IntArray: {
+                int values[DATAREF_MAX_ARRAY] = { (int)value };
+                MockPublishDatavi(spec.name, values, spec.count);
+                break;
+            }
+            case xplmType_FloatArray: {
+                float values[DATAREF_MAX_ARRAY] = { (float)value };
+                MockPublishDatavf(spec.name, values, spec.count);
+                break;
+            }
+        }
+    }
+}
+
+// Volanta's end of the connection: counts messages by name
+class FakeVolanta {
+public:
+    bool Start()
+    {
+        listener_ = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(addr);
+        if (listener_ == SOCKET_INVALID
+            || bind(listener_, (sockaddr*)&addr, sizeof(addr)) != 0
+            || listen(listener_, 1) != 0
+            || getsockname(listener_, (sockaddr*)&addr, &length) != 0) {
+            return false;
+        }
+        port_ = ntohs(addr.sin_port);
+        running_ = true;
+        thread_ = std::thread([this] { Run(); });
+        return true;
+    }
+
+    void Stop()
+    {
+        running_ = false;
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        CloseSocket(listener_);
+    }
+
+    uint16_t Port() const { return port_; }
+    uint64_t Bytes() const { return bytes_; }
+    const std::map<std::string, uint64_t>& Messages() const { return messages_; }
+
+private:
+    void Run()
+    {
+        socket_t client = SOCKET_INVALID;
+        std::string line;
+        char buffer[16384];
+        while (running_) {
+            struct pollfd pfd = { client != SOCKET_INVALID ? client : listener_, POLLIN, 0 };
+            if (PollSockets(&pfd, 1, 20) <= 0) {
+                continue;
+            }
+            if (client == SOCKET_INVALID) {
+                client = accept(listener_, NULL, NULL);
+                continue;
+            }
+            int received = (int)recv(client, buffer, sizeof(buffer), 0);
+            if (received <= 0) {
+                CloseSocket(client);
+                continue;
+            }
+            bytes_ += (uint64_t)received;
+            for (int i = 0; i < received; i++) {
+                if (buffer[i] != '\n') {
+                    line += buffer[i];
+                    continue;
+                }
+                size_t name = line.find("\"name\":\"");
+                size_t end = name == std::string::npos ? name : line.find('"', name + 8);
+                messages_[end == std::string::npos ? "other" : line.substr(name + 8, end - name - 8)]++;
+                line.clear();
+            }
+        }
+        CloseSocket(client);
+    }
+
+    socket_t                        listener_ = SOCKET_INVALID;
+    uint16_t                        port_ = 0;
+    std::atomic<bool>               running_{false};
+    std::thread                     thread_;
+    uint64_t                        bytes_ = 0;
+    std::map<std::string, uint64_t> messages_;
+};
+
+// A fan-out subscriber: counts messages and any line that isn't one whole
+// JSON object, which is what a torn frame would look like
+class FakeSubscriber {
+public:
+    bool Start(uint16_t port, bool slow, bool binary)
+    {
+        slow_ = slow;
+        binary_ = binary;
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(port);
+        // The plugin opens the port from its worker thread, shortly after
+        // XPluginStart
+        for (int attempt = 0; attempt < 100; attempt++) {
+            sock_ = socket(AF_INET, SOCK_STREAM, 0);
+            if (slow_) {
+                int size = 4096;
+                setsockopt(sock_, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+            }
+            if (connect(sock_, (sockaddr*)&addr, sizeof(addr)) == 0) {
+                running_ = true;
+                thread_ = std::thread([this] { Run(); });
+                return true;
+            }
+            CloseSocket(sock_);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return false;
+    }
+
+    void Stop()
+    {
+        running_ = false;
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        CloseSocket(sock_);
+    }
+
+    bool     Slow() const { return slow_; }
+    uint64_t Bytes() const { return bytes_; }
+    uint64_t Lines() const { return lines_; }
+    uint64_t Malformed() const { return malformed_; }
+    uint64_t Positions() const { return positions_; }
+    uint64_t Invalid() const { return invalid_; }
+
+private:
+    void Run()
+    {
+        std::string line;
+        std::vector<uint8_t> pending;
+        std::string converted;
+        char buffer[16384];
+        while (running_) {
+            struct pollfd pfd = { sock_, POLLIN, 0 };
+            if (PollSockets(&pfd, 1, 20) <= 0) {
+                continue;
+            }
+            int received = (int)recv(sock_, buffer, slow_ ? 512 : sizeof(buffer), 0);
+            if (received <= 0) {
+                return;
+            }
+            bytes_ += (uint64_t)received;
+            const char* text = buffer;
+            size_t text_size = (size_t)received;
+            if (binary_) {
+                pending.insert(pending.end(), buffer, buffer + received);
+                size_t used;
+                converted.clear();
+                if (!ConvertBinaryTelemetry(decoder_, pending.data(), pending.size(), used, converted)) {
+                    invalid_++;
+                    return;
+                }
+                pending.erase(pending.begin(), pending.begin() + (long)used);
+                text = converted.data();
+                text_size = converted.size();
+            }
+            for (size_t i = 0; i < text_size; i++) {
+                if (text[i] != '\n') {
+                    line += text[i];
+                    continue;
+                }
+                lines_++;
+                if (line.empty() || line.front() != '{' || line.back() != '}') {
+                    malformed_++;
+                }
+                else if (line.find("\"name\":\"POSITION_UPDATE\"") != std::string::npos) {
+                    positions_++;
+                }
+                line.clear();
+            }
+            if (slow_) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+        }
+    }
+
+    socket_t          sock_ = SOCKET_INVALID;
+    bool              slow_ = false;
+    bool              binary_ = false;
+    BinaryTelemetryDecoder decoder_;
+    std::atomic<bool> running_{false};
+    std::thread       thread_;
+    uint64_t          bytes_ = 0;
+    uint64_t          lines_ = 0;
+    uint64_t          malformed_ = 0;
+    uint64_t          positions_ = 0;
+    uint64_t          invalid_ = 0;
+};
+
+// A loopback port nobody is using right now
+uint16_t FreePort()
+{
+    socket_t sock = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(addr);
+    uint16_t port = 0;
+    if (sock != SOCKET_INVALID && bind(sock, (sockaddr*)&addr, sizeof(addr)) == 0
+        && getsockname(sock, (sockaddr*)&addr, &length) == 0) {
+        port = ntohs(addr.sin_port);
+    }
+    CloseSocket(sock);
+    return port;
+}
+
+double CpuSeconds(clockid_t clock)
+{
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+size_t gLogLines = 0;
+bool gVerbose = false;
+
+void CountLog(const char* text)
+{
+    gLogLines++;
+    if (gVerbose) {
+        fputs(text, stdout);
+    }
+}
+
+bool ParseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--hours") == 0 && has_value) {
+            options.hours = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--fps") == 0 && has_value) {
+            options.fps = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--speed") == 0 && has_value) {
+            options.speed = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--replay") == 0 && has_value) {
+            options.replay = argv[++i];
+        }
+        else if (strcmp(argv[i], "--subscribers") == 0 && has_value) {
+            options.subscribers = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--binary") == 0) {
+            options.binary = true;
+        }
+        else if (strcmp(argv[i], "--record") == 0) {
+            options.record = true;
+        }
+        else if (strcmp(argv[i], "--verbose") == 0) {
+            options.verbose = true;
+        }
+        else {
+            return false;
+        }
+    }
+    return options.fps > 0.0 && options.hours > 0.0 && options.subscribers >= 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        fprintf(stderr, "usage: %s [--hours H] [--fps F] [--speed X] [--replay flight.ovr] [--record] [--subscribers N] [--binary] [--verbose]\n", argv[0]);
+        return 2;
+    }
+    gVerbose = options.verbose;
+
+    std::vector<RecorderRecord> recording;
+    if (options.replay != nullptr) {
+        RecorderHeader header;
+        if (!ReadRecording(options.replay, header, recording) || recording.empty()) {
+            fprintf(stderr, "%s: not a flight recording, or empty\n", options.replay);
+            return 1;
+        }
+    }
+
+    SocketStartup();
+    FakeVolanta volanta;
+    if (!volanta.Start()) {
+        fprintf(stderr, "could not listen on the loopback interface\n");
+        return 1;
+    }
+
+    // A plugin folder of our own with an OpenVolanta.ini pointing at us
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / ("openvolanta-mock-" + std::to_string(volanta.Port()));
+    std::filesystem::create_directories(dir / "64");
+    FILE* ini = fopen((dir / "OpenVolanta.ini").string().c_str(), "w");
+    if (ini == NULL) {
+        fprintf(stderr, "could not write %s\n", (dir / "OpenVolanta.ini").string().c_str());
+        return 1;
+    }
+    fprintf(ini, "port = %u\nrecorder = %s\n", (unsigned)volanta.Port(), options.record ? "true" : "false");
+    uint16_t fanout_port = options.subscribers > 0 ? FreePort() : 0;
+    if (fanout_port != 0) {
+        fprintf(ini, "fanout = true\nfanout_port = %u\nfanout_format = %s\n", (unsigned)fanout_port, options.binary ? "binary" : "json");
+    }
+    fclose(ini);
+    MockSetPluginPath((dir / "64" / "lin.xpl").string().c_str());
+    MockSetDebugSink(CountLog);
+
+    TelemetrySnapshot snapshot = {};
+    ScriptedFlight script(options.hours * 3600.0);
+    if (recording.empty()) {
+        script.Next(0.0, snapshot);
+    }
+    else {
+        snapshot = recording[0].snapshot;
+    }
+    PublishSnapshotDatarefs(snapshot);
+    MockPublishDatab("sim/aircraft/view/acf_ICAO", "A320");
+    MockPublishDatab("sim/aircraft/view/acf_tailnum", "I-MOCK");
+    MockPublishDatab("sim/aircraft/view/acf_livery_path", "Aircraft/A320/liveries/Alitalia I-MOCK/");
+
+    char name[256], sig[256], desc[256];
+    XPluginStart(name, sig, desc);
+    XPluginEnable();
+    XPluginReceiveMessage(0, XPLM_MSG_LIVERY_LOADED, NULL);
+
+    std::vector<std::unique_ptr<FakeSubscriber>> subscribers;
+    for (int i = 0; i < options.subscribers; i++) {
+        subscribers.push_back(std::make_unique<FakeSubscriber>());
+        if (!subscribers.back()->Start(fanout_port, i > 0 && i == options.subscribers - 1, options.binary)) {
+            fprintf(stderr, "could not subscribe to the fan-out on port %u\n", (unsigned)fanout_port);
+            return 1;
+        }
+    }
+
+    std::vector<double> frame_cpu;
+    frame_cpu.reserve((size_t)(options.hours * 3600.0 * options.fps) + 16);
+    double frame_s = 1.0 / options.fps;
+    double process_start = CpuSeconds(CLOCK_PROCESS_CPUTIME_ID);
+    auto wall_start = std::chrono::steady_clock::now();
+    for (size_t i = 1;; i++) {
+        if (recording.empty()) {
+            if (!script.Next(frame_s, snapshot)) {
+                break;
+            }
+        }
+        else {
+            if (i >= recording.size()) {
+                break;
+            }
+            frame_s = recording[i].time_s - recording[i - 1].time_s;
+            snapshot = recording[i].snapshot;
+        }
+        PublishSnapshotDatarefs(snapshot);
+
+        double start = CpuSeconds(CLOCK_THREAD_CPUTIME_ID);
+        MockRunFrame((float)frame_s);
+        frame_cpu.push_back(CpuSeconds(CLOCK_THREAD_CPUTIME_ID) - start);
+
+        if (options.speed > 0.0) {
+            auto due = wall_start + std::chrono::duration<double>(MockElapsedTime() / options.speed);
+            std::this_thread::sleep_until(std::chrono::time_point_cast<std::chrono::steady_clock::duration>(due));
+        }
+    }
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+
+    // Let the worker flush what it has before it is stopped
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    XPluginDisable();
+    XPluginStop();
+    double process_s = CpuSeconds(CLOCK_PROCESS_CPUTIME_ID) - process_start;
+    volanta.Stop();
+    for (auto& subscriber : subscribers) {
+        subscriber->Stop();
+    }
+
+    std::vector<double> sorted = frame_cpu;
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&](double p) { return sorted.empty() ? 0.0 : sorted[(size_t)(p * (double)(sorted.size() - 1))] * 1e6; };
+    double total = 0.0;
+    for (double s : frame_cpu) {
+        total += s;
+    }
+    printf("simulated %.0f s in %.2f s wall (%.0fx), %zu frames, %zu log lines\n",
+        MockElapsedTime(), wall_s, MockElapsedTime() / wall_s, frame_cpu.size(), gLogLines);
+    printf("flight loop CPU per frame: mean %.2f us, p50 %.2f us, p99 %.2f us, max %.2f us\n",
+        frame_cpu.empty() ? 0.0 : total / (double)frame_cpu.size() * 1e6, percentile(0.5), percentile(0.99), percentile(1.0));
+    printf("process CPU (all threads, including the mock): %.2f s, %.2f us per frame\n",
+        process_s, frame_cpu.empty() ? 0.0 : process_s / (double)frame_cpu.size() * 1e6);
+    printf("Volanta received %llu bytes:", (unsigned long long)volanta.Bytes());
+    for (const auto& [message, count] : volanta.Messages()) {
+        printf(" %s %llu", message.c_str(), (unsigned long long)count);
+    }
+    printf("\n");
+    for (size_t i = 0; i < subscribers.size(); i++) {
+        const FakeSubscriber& subscriber = *subscribers[i];
+        printf("subscriber %zu%s received %llu bytes: %llu messages, %llu positions, %llu malformed, %llu invalid records\n",
+            i + 1, subscriber.Slow() ? " (slow)" : "",
+            (unsigned long long)subscriber.Bytes(),
+            (unsigned long long)subscriber.Lines(),
+            (unsigned long long)subscriber.Positions(),
+            (unsigned long long)subscriber.Malformed(),
+            (unsigned long long)subscriber.Invalid());
+    }
+    if (options.record) {
+        printf("recordings in %s\n", (dir / "recordings").string().c_str());
+    }
+    else {
+        std::filesystem::remove_all(dir);
+    }
+    SocketCleanup();
+    return 0;
+}
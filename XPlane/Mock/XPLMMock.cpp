@@ -0,0 +1,322 @@
+#include "XPLMMock.h"
+
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "XPLMPlugin.h"
+#include "XPLMUtilities.h"
+
+namespace {
+
+struct MockDataref {
+    std::string         name;
+    XPLMDataTypeID      types = xplmType_Unknown;
+    int                 i = 0;
+    float               f = 0.0f;
+    double              d = 0.0;
+    std::vector<int>    vi;
+    std::vector<float>  vf;
+    std::string         b;
+};
+
+struct MockFlightLoop {
+    XPLMFlightLoopPhaseType phase;
+    XPLMFlightLoop_f        callback;
+    void*                   refcon;
+    bool                    alive = true;
+    bool                    scheduled = false;
+    bool                    in_frames = false;  // `due` counts frames, not seconds
+    double                  due = 0.0;
+    double                  last_call = 0.0;
+};
+
+// deque: XPLMDataRefs and XPLMFlightLoopIDs are pointers to elements and
+// must stay put
+std::deque<MockDataref> gDatarefs;
+size_t gReads = 0;
+
+std::deque<MockFlightLoop> gFlightLoops;
+double gElapsed = 0.0;
+int gDispatches = 0;
+std::string gPluginPath;
+void (*gDebugSink)(const char* text) = nullptr;
+
+MockDataref& Publish(const char* name, XPLMDataTypeID types)
+{
+    for (MockDataref& ref : gDatarefs) {
+        if (ref.name == name) {
+            ref.types = types;
+            return ref;
+        }
+    }
+    gDatarefs.emplace_back();
+    gDatarefs.back().name = name;
+    gDatarefs.back().types = types;
+    return gDatarefs.back();
+}
+
+inline MockDataref* Get(XPLMDataRef ref)
+{
+    gReads++;
+    return (MockDataref*)ref;
+}
+
+// Negative intervals count frames, positive ones seconds, 0 stops the loop
+void Schedule(MockFlightLoop& loop, float interval, double from)
+{
+    loop.scheduled = interval != 0.0f;
+    loop.in_frames = interval < 0.0f;
+    loop.due = loop.in_frames ? -interval : from + interval;
+}
+
+template <typename T>
+int CopyArray(const std::vector<T>& source, T* out, int offset, int max)
+{
+    if (out == NULL) {
+        return (int)source.size();
+    }
+    int copied = 0;
+    for (int i = offset; i < (int)source.size() && copied < max; i++) {
+        out[copied++] = source[i];
+    }
+    return copied;
+}
+
+} // namespace
+
+// Numeric datarefs answer every scalar getter, like X-Plane's own
+// (double/float/int) ones do
+void MockPublishDatai(const char* name, int value)
+{
+    MockDataref& ref = Publish(name, xplmType_Int);
+    ref.i = value;
+    ref.f = (float)value;
+    ref.d = (double)value;
+}
+
+void MockPublishDataf(const char* name, float value)
+{
+    MockDataref& ref = Publish(name, xplmType_Float | xplmType_Double);
+    ref.i = (int)value;
+    ref.f = value;
+    ref.d = (double)value;
+}
+
+void MockPublishDatad(const char* name, double value)
+{
+    MockDataref& ref = Publish(name, xplmType_Float | xplmType_Double);
+    ref.i = (int)value;
+    ref.f = (float)value;
+    ref.d = value;
+}
+
+void MockPublishDatavi(const char* name, const int* values, size_t count)
+{
+    Publish(name, xplmType_IntArray).vi.assign(values, values + count);
+}
+
+void MockPublishDatavf(const char* name, const float* values, size_t count)
+{
+    Publish(name, xplmType_FloatArray).vf.assign(values, values + count);
+}
+
+void MockPublishDatab(const char* name, const char* value)
+{
+    Publish(name, xplmType_Data).b = value;
+}
+
+void MockResetDatarefs()
+{
+    gDatarefs.clear();
+    gReads = 0;
+}
+
+size_t MockDatarefReads()
+{
+    return gReads;
+}
+
+size_t MockRunFrame(float frame_s)
+{
+    gElapsed += frame_s;
+    gDispatches++;
+    size_t calls = 0;
+    for (XPLMFlightLoopPhaseType phase : { xplm_FlightLoop_Phase_BeforeFlightModel, xplm_FlightLoop_Phase_AfterFlightModel }) {
+        for (MockFlightLoop& loop : gFlightLoops) {
+            if (!loop.alive || !loop.scheduled || loop.phase != phase) {
+                continue;
+            }
+            bool due = loop.in_frames ? --loop.due <= 0.0 : gElapsed >= loop.due;
+            if (!due) {
+                continue;
+            }
+            float since = (float)(gElapsed - loop.last_call);
+            loop.last_call = gElapsed;
+            float next = loop.callback(since, frame_s, gDispatches, loop.refcon);
+            Schedule(loop, next, gElapsed);
+            calls++;
+        }
+    }
+    return calls;
+}
+
+double MockElapsedTime()
+{
+    return gElapsed;
+}
+
+size_t MockFlightLoopCount()
+{
+    size_t count = 0;
+    for (const MockFlightLoop& loop : gFlightLoops) {
+        count += loop.alive ? 1 : 0;
+    }
+    return count;
+}
+
+void MockSetPluginPath(const char* path)
+{
+    gPluginPath = path;
+}
+
+void MockSetDebugSink(void (*sink)(const char* text))
+{
+    gDebugSink = sink;
+}
+
+XPLMDataRef XPLMFindDataRef(const char* inDataRefName)
+{
+    for (MockDataref& ref : gDatarefs) {
+        if (ref.name == inDataRefName) {
+            return &ref;
+        }
+    }
+    return NULL;
+}
+
+int XPLMCanWriteDataRef(XPLMDataRef inDataRef)
+{
+    return inDataRef != NULL;
+}
+
+int XPLMIsDataRefGood(XPLMDataRef inDataRef)
+{
+    return inDataRef != NULL;
+}
+
+XPLMDataTypeID XPLMGetDataRefTypes(XPLMDataRef inDataRef)
+{
+    return ((MockDataref*)inDataRef)->types;
+}
+
+// Like the SDK, a getter that doesn't match the dataref's type returns 0
+int XPLMGetDatai(XPLMDataRef inDataRef)
+{
+    MockDataref* ref = Get(inDataRef);
+    return (ref->types & xplmType_Int) ? ref->i : 0;
+}
+
+float XPLMGetDataf(XPLMDataRef inDataRef)
+{
+    MockDataref* ref = Get(inDataRef);
+    return (ref->types & xplmType_Float) ? ref->f : 0.0f;
+}
+
+double XPLMGetDatad(XPLMDataRef inDataRef)
+{
+    MockDataref* ref = Get(inDataRef);
+    return (ref->types & xplmType_Double) ? ref->d : 0.0;
+}
+
+int XPLMGetDatavi(XPLMDataRef inDataRef, int* outValues, int inOffset, int inMax)
+{
+    return CopyArray(Get(inDataRef)->vi, outValues, inOffset, inMax);
+}
+
+int XPLMGetDatavf(XPLMDataRef inDataRef, float* outValues, int inOffset, int inMax)
+{
+    return CopyArray(Get(inDataRef)->vf, outValues, inOffset, inMax);
+}
+
+int XPLMGetDatab(XPLMDataRef inDataRef, void* outValue, int inOffset, int inMaxBytes)
+{
+    const std::string& b = Get(inDataRef)->b;
+    if (outValue == NULL) {
+        return (int)b.size();
+    }
+    int available = inOffset < (int)b.size() ? (int)b.size() - inOffset : 0;
+    int copied = available < inMaxBytes ? available : inMaxBytes;
+    memcpy(outValue, b.data() + inOffset, (size_t)copied);
+    return copied;
+}
+
+void XPLMDebugString(const char* inString)
+{
+    if (gDebugSink != nullptr) {
+        gDebugSink(inString);
+        return;
+    }
+    fputs(inString, stderr);
+}
+
+XPLMFlightLoopID XPLMCreateFlightLoop(XPLMCreateFlightLoop_t* inParams)
+{
+    gFlightLoops.emplace_back();
+    MockFlightLoop& loop = gFlightLoops.back();
+    loop.phase = inParams->phase;
+    loop.callback = inParams->callbackFunc;
+    loop.refcon = inParams->refcon;
+    loop.last_call = gElapsed;
+    return &loop;
+}
+
+// Destroyed loops keep their slot so IDs never get reused
+void XPLMDestroyFlightLoop(XPLMFlightLoopID inFlightLoopID)
+{
+    MockFlightLoop* loop = (MockFlightLoop*)inFlightLoopID;
+    loop->alive = false;
+    loop->scheduled = false;
+}
+
+void XPLMScheduleFlightLoop(XPLMFlightLoopID inFlightLoopID, float inInterval, int inRelativeToNow)
+{
+    MockFlightLoop* loop = (MockFlightLoop*)inFlightLoopID;
+    Schedule(*loop, inInterval, inRelativeToNow ? gElapsed : loop->last_call);
+}
+
+float XPLMGetElapsedTime(void)
+{
+    return (float)gElapsed;
+}
+
+XPLMPluginID XPLMGetMyID(void)
+{
+    return 1;
+}
+
+void XPLMGetPluginInfo(XPLMPluginID inPlugin, char* outName, char* outFilePath, char* outSignature, char* outDescription)
+{
+    (void)inPlugin;
+    if (outName != NULL) {
+        strcpy(outName, "OpenVolanta");
+    }
+    // The SDK fills up to 256 bytes
+    if (outFilePath != NULL) {
+        snprintf(outFilePath, 256, "%s", gPluginPath.c_str());
+    }
+    if (outSignature != NULL) {
+        strcpy(outSignature, "starnumber.openvolanta");
+    }
+    if (outDescription != NULL) {
+        outDescription[0] = '\0';
+    }
+}
+
+void XPLMEnableFeature(const char* inFeature, int inEnable)
+{
+    (void)inFeature;
+    (void)inEnable;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+
+#include "XPLMDataAccess.h"
+#include "XPLMProcessing.h"
+
+// In-process stand-in for the parts of the XPLM the plugin uses, so plugin
+// code can be built, exercised and benchmarked without X-Plane. Link this
+// instead of XPLM_64 and publish whatever datarefs the code under test reads.
+//
+// Datarefs live in a flat table and XPLMFindDataRef hands out pointers into
+// it, so reads cost a call and a load, roughly what the real SDK does for
+// X-Plane's own datarefs minus the cross-module jump.
+
+void MockPublishDatai(const char* name, int value);
+void MockPublishDataf(const char* name, float value);
+void MockPublishDatad(const char* name, double value);
+void MockPublishDatavi(const char* name, const int* values, size_t count);
+void MockPublishDatavf(const char* name, const float* values, size_t count);
+void MockPublishDatab(const char* name, const char* value);
+
+// Forgets every dataref (previously returned XPLMDataRefs become invalid)
+void MockResetDatarefs();
+
+// Number of XPLMGet* calls since the last reset, to check batching
+size_t MockDatarefReads();
+
+// Flight loops created with XPLMCreateFlightLoop run when the test says so:
+// each MockRunFrame advances the mock clock (XPLMGetElapsedTime and the
+// callbacks' elapsed arguments) by `frame_s` and calls every loop that is
+// due, before-flight-model ones first, rescheduling them from their return
+// value like X-Plane does. Nothing waits on the wall clock, so frames run as
+// fast as the callbacks allow. Returns the number of callbacks made.
+size_t MockRunFrame(float frame_s);
+double MockElapsedTime();
+size_t MockFlightLoopCount();   // created and not destroyed
+
+// What XPLMGetPluginInfo reports as this plugin's file path
+void MockSetPluginPath(const char* path);
+
+// Where XPLMDebugString output goes, stderr when null
+void MockSetDebugSink(void (*sink)(const char* text));
@@ -0,0 +1,175 @@
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <thread>
+
+#include "RecorderWorker.h"
+#include "SpscRing.h"
+
+#define RECORDER_DRAIN_MS 50
+#define RECORDER_STATS_INTERVAL_S 60
+
+struct RecordedFrame {
+    double            now_s;
+    TelemetrySnapshot snapshot;
+};
+
+// An aircraft change, stamped with how many frames were queued before it
+// so the frames still in the queue go to the flight they were taken in
+struct RecordedFlight {
+    uint64_t         after_frames;
+    AircraftIdentity aircraft;
+};
+
+// The writer's side of the two queues
+struct RecorderQueues {
+    uint64_t       frames_popped = 0;
+    RecordedFlight flight;
+    bool           have_flight = false;
+};
+
+// ~17 s of frames at 60 fps before anything is dropped
+static SpscRing<RecordedFrame, 1024> gFrames;
+static SpscRing<RecordedFlight, 4> gFlights;
+static uint64_t gFramesQueued = 0;  // sim thread only
+static SpscRing<LogLine, 16> gRecorderLog;
+
+static std::thread gRecorder;
+static std::atomic<bool> gRecorderRunning{false};
+static RecorderConfig gRecorderConfig;
+
+static void RecorderLog(const char* format, ...)
+{
+    LogLine line;
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line.text, sizeof(line.text), format, args);
+    va_end(args);
+    gRecorderLog.TryPush(line);
+}
+
+static void LogRecorderStats(const FlightRecorder& recorder, uint64_t records, uint64_t append_ns, double elapsed_s)
+{
+    const RecorderCounters& c = recorder.Counters();
+    RecorderLog("OpenVolanta: recorder %llu records (%.1f/s, %.2f us each), %llu dropped, %llu syncs %.2f ms avg %.2f ms max, %s\n",
+        (unsigned long long)records,
+        elapsed_s > 0.0 ? (double)records / elapsed_s : 0.0,
+        records > 0 ? (double)append_ns / (double)records / 1000.0 : 0.0,
+        (unsigned long long)gFrames.Dropped(),
+        (unsigned long long)c.syncs,
+        c.syncs > 0 ? (double)c.sync_ns_total / (double)c.syncs / 1e6 : 0.0,
+        (double)c.sync_ns_max / 1e6,
+        recorder.IsOpen() ? recorder.CurrentPath().c_str() : "no file open");
+}
+
+// Appends every queued frame, starting each new flight between the same
+// two frames the sim thread saw the aircraft change between. Returns the
+// records written.
+static uint64_t DrainFrames(FlightRecorder& recorder, RecorderQueues& queues)
+{
+    uint64_t records = 0;
+    for (;;) {
+        if (!queues.have_flight) {
+            queues.have_flight = gFlights.TryPop(queues.flight);
+        }
+        if (queues.have_flight && queues.frames_popped >= queues.flight.after_frames) {
+            const AircraftIdentity& aircraft = queues.flight.aircraft;
+            char name[sizeof(aircraft.icao) + 32];
+            snprintf(name, sizeof(name), "%s %.31s", aircraft.icao, aircraft.registration);
+            recorder.NewFlight(name);
+            queues.have_flight = false;
+            continue;
+        }
+        RecordedFrame frame;
+        if (!gFrames.TryPop(frame)) {
+            return records;
+        }
+        queues.frames_popped++;
+        if (recorder.Append(frame.snapshot, frame.now_s)) {
+            records++;
+        }
+    }
+}
+
+static void RecorderMain()
+{
+    FlightRecorder recorder(gRecorderConfig);
+    typedef std::chrono::steady_clock Clock;
+
+    auto next_stats = Clock::now() + std::chrono::seconds(RECORDER_STATS_INTERVAL_S);
+    uint64_t window_records = 0;
+    uint64_t window_append_ns = 0;
+    uint64_t open_failures = 0;
+    RecorderQueues queues;
+    while (gRecorderRunning.load(std::memory_order_relaxed)) {
+        auto start = Clock::now();
+        window_records += DrainFrames(recorder, queues);
+        auto now = Clock::now();
+        window_append_ns += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count();
+        recorder.Sync();
+
+        if (recorder.Counters().open_failures != open_failures) {
+            open_failures = recorder.Counters().open_failures;
+            RecorderLog("OpenVolanta: recorder can't create a file in %s, retrying\n", gRecorderConfig.directory.c_str());
+        }
+        if (now >= next_stats) {
+            LogRecorderStats(recorder, window_records, window_append_ns, RECORDER_STATS_INTERVAL_S);
+            window_records = 0;
+            window_append_ns = 0;
+            next_stats = now + std::chrono::seconds(RECORDER_STATS_INTERVAL_S);
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(RECORDER_DRAIN_MS));
+    }
+
+    DrainFrames(recorder, queues);
+    recorder.Close();
+}
+
+void StartFlightRecorder(const RecorderConfig& config)
+{
+    gRecorderConfig = config;
+    gRecorderRunning.store(true);
+    gRecorder = std::thread(RecorderMain);
+}
+
+void StopFlightRecorder()
+{
+    gRecorderRunning.store(false);
+    if (gRecorder.joinable()) {
+        gRecorder.join();
+    }
+}
+
+bool IsFlightRecorderRunning()
+{
+    return gRecorderRunning.load(std::memory_order_relaxed);
+}
+
+bool RecordSnapshot(const TelemetrySnapshot& snapshot, double now_s)
+{
+    RecordedFrame frame;
+    frame.now_s = now_s;
+    frame.snapshot = snapshot;
+    if (!gFrames.TryPush(frame)) {
+        return false;
+    }
+    gFramesQueued++;
+    return true;
+}
+
+bool RecordNewFlight(const AircraftIdentity& aircraft)
+{
+    RecordedFlight flight;
+    flight.after_frames = gFramesQueued;
+    flight.aircraft = aircraft;
+    return gFlights.TryPush(flight);
+}
+
+void DrainRecorderLog(LogSink sink)
+{
+    LogLine line;
+    while (gRecorderLog.TryPop(line)) {
+        sink(line.text);
+    }
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include "FlightRecorder.h"
+#include "TelemetryWorker.h"
+
+// Full-rate local recording. The flight loop pushes every captured snapshot
+// into a lock-free queue; a thread of its own appends them to the
+// FlightRecorder and does the periodic msync, so a slow disk can stall
+// neither the sim nor the Volanta connection. The sim thread's cost is one
+// queue push per frame.
+
+void StartFlightRecorder(const RecorderConfig& config);
+void StopFlightRecorder();
+bool IsFlightRecorderRunning();
+
+// Sim thread only. Never blocks; returns false (and counts a drop) if the
+// writer is behind.
+bool RecordSnapshot(const TelemetrySnapshot& snapshot, double now_s);
+// Closes the current recording once the snapshots recorded before this call
+// are written; the next snapshot starts a new file
+bool RecordNewFlight(const AircraftIdentity& aircraft);
+
+void DrainRecorderLog(LogSink sink);
@@ -0,0 +1,409 @@
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include "TelemetryWorker.h"
+#include "BinaryTelemetry.h"
+#include "Connection.h"
+#include "FanoutServer.h"
+#include "RateController.h"
+#include "SpscRing.h"
+#include "TrackSimplifier.h"
+
+#define WORKER_ACTIVE_MS 10    // ring polling period while connected or subscribed
+#define WORKER_IDLE_MS 100     // ... and while there is nobody to send to
+#define STATS_INTERVAL_S 60
+
+static const TelemetrySource kTelemetrySource = { "xp12", "12.320" };
+
+FlightLoopStats gFlightLoopStats;
+
+// Snapshots carry the sim time they were taken at, which is what the track
+// simplifier and the rate stats measure against, and the tier they were
+// sampled in
+struct PublishedSnapshot {
+    double            now_s;
+    SampleTier        tier;
+    TelemetrySnapshot snapshot;
+};
+
+static SpscRing<PublishedSnapshot, 64> gSnapshots;
+static SpscRing<AircraftIdentity, 4> gAircraft;
+static SpscRing<LandingEvent, 4> gLandings;
+static SpscRing<PhaseChangeEvent, 8> gPhases;
+static SpscRing<LogLine, 64> gLog;
+
+static std::thread gWorker;
+static std::atomic<bool> gRunning{false};
+static ConnectionConfig gConnectionConfig;
+static SimplifyConfig gSimplifyConfig;
+static FanoutConfig gFanoutConfig;
+
+// Position updates actually sent during the current flight (aircraft load)
+static RateStats gFlightRate;
+
+// Last aircraft seen, replayed to Volanta on every (re)connect
+static AircraftIdentity gCurrentAircraft;
+static bool gHaveAircraft = false;
+
+// Current flight phase, replayed on every (re)connect like the aircraft
+static PhaseChangeEvent gCurrentPhase;
+static bool gHavePhase = false;
+
+// A landing made while Volanta wasn't reachable, sent once it is
+static LandingEvent gPendingLanding;
+static bool gHavePendingLanding = false;
+
+static void WorkerLog(const char* format, ...)
+{
+    LogLine line;
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line.text, sizeof(line.text), format, args);
+    va_end(args);
+    gLog.TryPush(line);
+}
+
+static void WorkerLogLine(const char* line)
+{
+    WorkerLog("%s", line);
+}
+
+static size_t SerializeAircraft(const AircraftIdentity& identity, char* json, size_t capacity)
+{
+    const AircraftInfo aircraft = { "", identity.icao, identity.icao, identity.registration, "" };
+    return SerializeAircraftUpdate(aircraft, json, capacity);
+}
+
+// The Send* helpers take the message already serialized, since local
+// subscribers get the very same bytes
+static void SendAircraftUpdate(Connection& volanta, const char* json, size_t length)
+{
+    if (length > 0 && volanta.Send(json, length)) {
+        WorkerLog("OpenVolanta: Queued aircraft update\n");
+    }
+    else {
+        WorkerLog("OpenVolanta: Failed to send aircraft update\n");
+    }
+}
+
+static void SendPhaseChange(Connection& volanta, const char* json, size_t length)
+{
+    if (length == 0 || !volanta.Send(json, length)) {
+        WorkerLog("OpenVolanta: Failed to send phase change\n");
+    }
+}
+
+static void SendLanding(Connection& volanta, const LandingEvent& landing, const char* json, size_t length)
+{
+    if (length > 0 && volanta.Send(json, length)) {
+        WorkerLog("OpenVolanta: Queued landing, %.1f fpm, %.2f g\n", landing.landing_rate, landing.gforce);
+        gHavePendingLanding = false;
+    }
+    else {
+        WorkerLog("OpenVolanta: Failed to send landing, will retry on reconnect\n");
+        gPendingLanding = landing;
+        gHavePendingLanding = true;
+    }
+}
+
+// Subscribers get the JSON as is, or as a text record of the binary stream
+static void ToSubscribers(FanoutServer& fanout, const char* json, size_t length, bool greet)
+{
+    uint8_t record[TELEMETRY_MAX_MESSAGE + 8];
+    if (gFanoutConfig.binary) {
+        length = BinaryTelemetryEncoder::Json(json, length, record, sizeof(record));
+        json = (const char*)record;
+    }
+    if (greet) {
+        fanout.Greet(json, length);
+    }
+    else {
+        fanout.Broadcast(json, length);
+    }
+}
+
+static void LogConnectionStats(const Connection& volanta)
+{
+    const ConnectionCounters& c = volanta.Counters();
+    WorkerLog("OpenVolanta: Volanta %s, %llu/%llu connects, %llu disconnects, %llu sent (%llu bytes, %llu writes, %llu short), %llu dropped\n",
+        ConnectionStateName(volanta.State()),
+        (unsigned long long)c.connects,
+        (unsigned long long)c.connect_attempts,
+        (unsigned long long)c.disconnects,
+        (unsigned long long)c.messages_sent,
+        (unsigned long long)c.bytes_sent,
+        (unsigned long long)c.send_calls,
+        (unsigned long long)c.partial_writes,
+        (unsigned long long)c.messages_dropped);
+}
+
+static void LogFanoutStats(const FanoutServer& fanout)
+{
+    const FanoutCounters& c = fanout.Counters();
+    WorkerLog("OpenVolanta: Fan-out %u subscribers, %llu accepted, %llu rejected, %llu disconnects, %llu frames (%llu bytes, %llu writes), %llu dropped\n",
+        (unsigned)fanout.Clients(),
+        (unsigned long long)c.accepted,
+        (unsigned long long)c.rejected,
+        (unsigned long long)c.disconnected,
+        (unsigned long long)c.frames,
+        (unsigned long long)c.bytes_sent,
+        (unsigned long long)c.send_calls,
+        (unsigned long long)c.frames_dropped);
+}
+
+static void LogFlightRate(const char* label)
+{
+    if (gFlightRate.updates == 0) {
+        return;
+    }
+    WorkerLog("OpenVolanta: %s: %llu position updates over %.0f s, %.2f Hz effective, %lld bytes saved vs fixed %.0f Hz\n",
+        label,
+        (unsigned long long)gFlightRate.updates,
+        gFlightRate.elapsed_s,
+        gFlightRate.EffectiveHz(),
+        (long long)gFlightRate.BytesSaved(RATE_BASELINE_HZ),
+        RATE_BASELINE_HZ);
+}
+
+static void LogTrackStats(const char* label, const TrackSimplifier& track)
+{
+    const SimplifyStats& stats = track.Stats();
+    if (stats.sent == 0) {
+        return;
+    }
+    WorkerLog("OpenVolanta: %s: track %llu/%llu positions sent (%.1f:1), max error %.1f m, %.1f ft\n",
+        label,
+        (unsigned long long)stats.sent,
+        (unsigned long long)stats.offered,
+        stats.Ratio(),
+        stats.max_position_error_m,
+        stats.max_altitude_error_ft);
+}
+
+static void LogFlightLoopStats()
+{
+    uint64_t calls = gFlightLoopStats.calls.exchange(0, std::memory_order_relaxed);
+    uint64_t total_ns = gFlightLoopStats.total_ns.exchange(0, std::memory_order_relaxed);
+    uint64_t max_ns = gFlightLoopStats.max_ns.exchange(0, std::memory_order_relaxed);
+    if (calls == 0) {
+        return;
+    }
+    WorkerLog("OpenVolanta: flight loop %.2f us avg, %.2f us max over %llu calls, %llu snapshots dropped\n",
+        (double)total_ns / (double)calls / 1000.0,
+        (double)max_ns / 1000.0,
+        (unsigned long long)calls,
+        (unsigned long long)gSnapshots.Dropped());
+}
+
+static void WorkerMain()
+{
+    ConnectionConfig config = gConnectionConfig;
+    config.log = WorkerLogLine;
+    Connection volanta(config);
+    // Only positions that drift from the path already sent go out
+    TrackSimplifier track(gSimplifyConfig);
+
+    FanoutConfig fanout_config = gFanoutConfig;
+    fanout_config.log = WorkerLogLine;
+    FanoutServer fanout(fanout_config);
+    if (fanout_config.enabled) {
+        fanout.Start();
+    }
+    BinaryTelemetryEncoder encoder;
+    uint8_t record[BINARY_TELEMETRY_MAX_RECORD];
+
+    char json[TELEMETRY_MAX_MESSAGE];
+    size_t length;
+
+    auto next_stats = Connection::Clock::now() + std::chrono::seconds(STATS_INTERVAL_S);
+    // Volanta first when it has a socket, then whatever the fan-out waits on
+    struct pollfd fds[1 + FANOUT_MAX_POLL];
+    size_t volanta_fds = 0;
+    size_t fanout_fds = 0;
+    while (gRunning.load(std::memory_order_relaxed)) {
+        auto now = Connection::Clock::now();
+        volanta.Update(now, volanta_fds > 0 ? fds[0].revents : 0);
+        fanout.Update(fds + volanta_fds, fanout_fds);
+        if (volanta.TakeJustConnected()) {
+            track.ForceNext();
+            if (gHaveAircraft) {
+                length = SerializeAircraft(gCurrentAircraft, json, sizeof(json));
+                SendAircraftUpdate(volanta, json, length);
+            }
+            if (gHavePhase) {
+                length = SerializePhaseChange(gCurrentPhase, json, sizeof(json));
+                SendPhaseChange(volanta, json, length);
+            }
+            if (gHavePendingLanding) {
+                length = SerializeLandingEvent(gPendingLanding, json, sizeof(json));
+                SendLanding(volanta, gPendingLanding, json, length);
+            }
+        }
+        if (fanout.TakeNewClients()) {
+            if (fanout_config.binary) {
+                fanout.Greet((const char*)record, encoder.Header(kTelemetrySource, record, sizeof(record)));
+                // Deltas mean nothing to someone who just joined
+                encoder.ForceKeyFrame();
+            }
+            if (gHaveAircraft) {
+                ToSubscribers(fanout, json, SerializeAircraft(gCurrentAircraft, json, sizeof(json)), true);
+            }
+            if (gHavePhase) {
+                ToSubscribers(fanout, json, SerializePhaseChange(gCurrentPhase, json, sizeof(json)), true);
+            }
+        }
+
+        AircraftIdentity aircraft;
+        while (gAircraft.TryPop(aircraft)) {
+            LogFlightRate("Flight summary");
+            LogTrackStats("Flight summary", track);
+            gFlightRate.Reset();
+            track.ResetStats();
+            gCurrentAircraft = aircraft;
+            gHaveAircraft = true;
+            length = SerializeAircraft(aircraft, json, sizeof(json));
+            ToSubscribers(fanout, json, length, false);
+            if (volanta.IsConnected()) {
+                SendAircraftUpdate(volanta, json, length);
+            }
+        }
+
+        PhaseChangeEvent change;
+        while (gPhases.TryPop(change)) {
+            gCurrentPhase = change;
+            gHavePhase = true;
+            length = SerializePhaseChange(change, json, sizeof(json));
+            ToSubscribers(fanout, json, length, false);
+            if (volanta.IsConnected()) {
+                SendPhaseChange(volanta, json, length);
+            }
+        }
+
+        LandingEvent landing;
+        while (gLandings.TryPop(landing)) {
+            length = SerializeLandingEvent(landing, json, sizeof(json));
+            ToSubscribers(fanout, json, length, false);
+            if (volanta.IsConnected()) {
+                SendLanding(volanta, landing, json, length);
+            }
+            else {
+                gPendingLanding = landing;
+                gHavePendingLanding = true;
+            }
+        }
+
+        // Positions are handled in the order they were taken. Subscribers
+        // get every one. For Volanta only the newest is worth sending if we
+        // fell behind, except on approach, where every frame is kept for the
+        // touchdown rate, and of those only the simplified track. None of
+        // them are worth formatting while nobody is listening.
+        PublishedSnapshot published, next;
+        bool have_snapshot = gSnapshots.TryPop(published);
+        while (have_snapshot) {
+            bool newest = !gSnapshots.TryPop(next);
+            bool keep = published.tier == SampleTier::Approach;
+            bool to_volanta = (newest || keep) && volanta.IsConnected() && track.Offer(published.snapshot, published.now_s, keep);
+            bool to_fanout = fanout.Clients() > 0;
+            if (to_fanout && fanout_config.binary) {
+                fanout.Broadcast((const char*)record, encoder.Position(published.snapshot, record, sizeof(record)));
+                to_fanout = false;
+            }
+            if (to_volanta || to_fanout) {
+                length = SerializePositionUpdate(published.snapshot, kTelemetrySource, json, sizeof(json));
+                if (to_fanout) {
+                    fanout.Broadcast(json, length);
+                }
+                if (to_volanta && length > 0 && volanta.Send(json, length)) {
+                    gFlightRate.Record(published.now_s, length);
+                }
+            }
+            published = next;
+            have_snapshot = !newest;
+        }
+        // Whatever was queued this round goes out in one write
+        volanta.Flush(now);
+        fanout.Flush();
+
+        if (now >= next_stats) {
+            LogFlightLoopStats();
+            LogConnectionStats(volanta);
+            if (fanout_config.enabled) {
+                LogFanoutStats(fanout);
+            }
+            LogFlightRate("Flight so far");
+            LogTrackStats("Flight so far", track);
+            next_stats = now + std::chrono::seconds(STATS_INTERVAL_S);
+        }
+
+        volanta_fds = volanta.PreparePoll(fds[0]) ? 1 : 0;
+        fanout_fds = fanout.PreparePoll(fds + volanta_fds, FANOUT_MAX_POLL);
+        bool active = volanta.IsConnected() || fanout.Clients() > 0;
+        int timeout = volanta.PollTimeoutMs(now, active ? WORKER_ACTIVE_MS : WORKER_IDLE_MS);
+        if (PollSockets(fds, volanta_fds + fanout_fds, timeout) <= 0) {
+            for (size_t i = 0; i < volanta_fds + fanout_fds; i++) {
+                fds[i].revents = 0;
+            }
+        }
+    }
+    LogFlightRate("Flight summary");
+    LogTrackStats("Flight summary", track);
+}
+
+void StartTelemetryWorker(const ConnectionConfig& config, const SimplifyConfig& track, const FanoutConfig& fanout)
+{
+    gConnectionConfig = config;
+    gSimplifyConfig = track;
+    gFanoutConfig = fanout;
+    gRunning.store(true);
+    gWorker = std::thread(WorkerMain);
+}
+
+void StopTelemetryWorker()
+{
+    gRunning.store(false);
+    if (gWorker.joinable()) {
+        gWorker.join();
+    }
+}
+
+bool PublishSnapshot(const TelemetrySnapshot& snapshot, double now_s, SampleTier tier)
+{
+    return gSnapshots.TryPush(PublishedSnapshot{ now_s, tier, snapshot });
+}
+
+bool PublishAircraft(const AircraftIdentity& aircraft)
+{
+    return gAircraft.TryPush(aircraft);
+}
+
+bool PublishLanding(const LandingEvent& landing)
+{
+    return gLandings.TryPush(landing);
+}
+
+bool PublishPhaseChange(const PhaseChangeEvent& change)
+{
+    return gPhases.TryPush(change);
+}
+
+void RecordFlightLoopTime(uint64_t elapsed_ns)
+{
+    gFlightLoopStats.calls.fetch_add(1, std::memory_order_relaxed);
+    gFlightLoopStats.total_ns.fetch_add(elapsed_ns, std::memory_order_relaxed);
+    // Only the sim thread writes max_ns (the worker just resets it), so a
+    // plain compare is enough
+    if (elapsed_ns > gFlightLoopStats.max_ns.load(std::memory_order_relaxed)) {
+        gFlightLoopStats.max_ns.store(elapsed_ns, std::memory_order_relaxed);
+    }
+}
+
+void DrainWorkerLog(LogSink sink)
+{
+    LogLine line;
+    while (gLog.TryPop(line)) {
+        sink(line.text);
+    }
+}
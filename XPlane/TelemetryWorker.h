@@ -0,0 +1,53 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+#include "Connection.h"
+#include "FanoutServer.h"
+#include "RateController.h"
+#include "Telemetry.h"
+#include "TrackSimplifier.h"
+
+// Everything that touches the network runs on a dedicated worker thread. The
+// flight loop only copies dataref values into a TelemetrySnapshot and hands it
+// over through a lock-free queue, so sim frame time no longer depends on
+// whether Volanta is reachable.
+
+struct AircraftIdentity {
+    char icao[40];
+    char registration[256];
+};
+
+// Time spent inside the flight loop callback, written by the sim thread
+struct FlightLoopStats {
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> total_ns{0};
+    std::atomic<uint64_t> max_ns{0};
+};
+
+extern FlightLoopStats gFlightLoopStats;
+
+// `config.log` is replaced by the worker's own queue. Positions pass through
+// a TrackSimplifier with `track` on their way out. With `fanout.enabled` the
+// worker also serves every message, and every position, to local
+// subscribers.
+void StartTelemetryWorker(const ConnectionConfig& config, const SimplifyConfig& track, const FanoutConfig& fanout);
+void StopTelemetryWorker();
+
+// Sim thread only. Never blocks; returns false if the worker is behind.
+// `now_s` is the sim clock the snapshot was taken at, `tier` the sampling
+// tier it was taken in; Approach snapshots bypass the track simplifier.
+bool PublishSnapshot(const TelemetrySnapshot& snapshot, double now_s, SampleTier tier);
+bool PublishAircraft(const AircraftIdentity& aircraft);
+bool PublishLanding(const LandingEvent& landing);
+bool PublishPhaseChange(const PhaseChangeEvent& change);
+void RecordFlightLoopTime(uint64_t elapsed_ns);
+
+// XPLMDebugString may only be called from the sim thread, so the worker
+// queues its log lines and the flight loop prints them.
+struct LogLine {
+    char text[256];
+};
+
+typedef void (*LogSink)(const char* line);
+void DrainWorkerLog(LogSink sink);
@@ -1,9 +1,4 @@
 ﻿// Downloaded from https://developer.x-plane.com/code-sample/hello-world-sdk-3/
-#pragma comment(lib, "ws2_32.lib")
-#if IBM
-	#include <winsock2.h>
-    #include <ws2tcpip.h>
-#endif
 #include "XPLMDisplay.h"
 #include "XPLMGraphics.h"
 #include "XPLMDataAccess.h"
@@ -11,124 +6,54 @@
 #include "XPLMProcessing.h"
 #include "XPLMPlugin.h"
 #include "XPLMPlanes.h"
-#include <regex>
 #include <algorithm>
 #include <string.h>
-#if LIN
-	#include <GL/gl.h>
-#elif __GNUC__
-	#include <OpenGL/gl.h>
-#else
-	#include <GL/gl.h>
-#endif
 #include <cstdio>
+#include <chrono>
+#include <string>
+
+#include "Config.h"
+#include "DatarefRegistry.h"
+#include "FlightPhase.h"
+#include "FlightRecorder.h"
+#include "FrameStats.h"
+#include "LandingDetector.h"
+#include "RateController.h"
+#include "RecorderWorker.h"
+#include "Registration.h"
+#include "SharedState.h"
+#include "Telemetry.h"
+#include "TelemetryWorker.h"
 
 #ifndef XPLM300
 	#error This is made to be compiled against the XPLM300 SDK
 #endif
 
-#define METERS_TO_FT 3.28084
-
-XPLMDataRef dr_lat, dr_lon, dr_alt_amsl, dr_alt_agl;
-XPLMDataRef dr_pitch, dr_bank, dr_heading;
-XPLMDataRef dr_gs, dr_vs;
-XPLMDataRef dr_fuel_kg;
-XPLMDataRef dr_gravity;
-XPLMDataRef dr_transponder;
-XPLMDataRef dr_on_ground;
-XPLMDataRef dr_slew, dr_paused, dr_replay;
-XPLMDataRef dr_fps;
-XPLMDataRef dr_taccel;
-XPLMDataRef dr_ap_engaged;
-XPLMDataRef dr_eng_running;
-XPLMDataRef dr_parking_brake;
-XPLMDataRef dr_wind_speed, dr_wind_dir;
-XPLMDataRef livery_path;
-
-XPLMDataRef acf_icao, acf_reg;
-
-SOCKET tcp_sock;
-struct sockaddr_in tcp_addr;
-
-bool extract_registration_to_buffer(
-    const std::string& livery_name,
-    char* output_buffer,
-    size_t buffer_size)
-{
-    // Ensure the output buffer is null-terminated immediately in case of failure
-    if (buffer_size > 0) {
-        output_buffer[0] = '\0';
-    }
-    else {
-        return false; // Cannot write to a zero-size buffer
-    }
-
-    // 1. Define the Regular Expression (Same as disassembly)
-    const std::regex registration_regex(
-        "[A-Z]-[A-Z]{4}|"           // e.g., G-ABCD
-        "([A-Z]|[1-9]){2}-[A-Z]{3}|"        // e.g., EI-GJK, 9H-QDU
-        "N[0-9]{1,5}[A-Z]{0,2}",    // e.g., N12345, N1A, N12AB
-        std::regex::ECMAScript
-    );
-
-    // 2. Define the Match Results Container
-    std::smatch match_results;
-
-    // 3. Perform the Regex Search
-    if (std::regex_search(livery_name, match_results, registration_regex)) {
-
-        // The entire matched registration is at index 0
-        const std::string registration = match_results[0].str();
-
-        // 4. Copy the result to the C-style buffer
+// Snapshot datarefs are declared in DatarefRegistry.cpp
+DatarefRegistry gSnapshotDatarefs(kSnapshotDatarefs, kSnapshotDatarefCount);
 
-        // Determine the length to copy, ensuring it doesn't exceed the buffer size - 1
-        size_t copy_len = (((registration.length()) < (buffer_size - 1)) ? (registration.length()) : (buffer_size - 1));
+XPLMDataRef livery_path;
 
-        // Copy the characters
-        std::strncpy(output_buffer, registration.c_str(), copy_len);
+ConfigFile gConfig;
+RateController gRateController{ RateConfig() };
+double gSimTime = 0.0;
+double gNextPublish = 0.0;
+LandingDetector gLandingDetector{ LandingConfig() };
+FlightPhaseTracker gFlightPhase{ PhaseConfig() };
+FrameStats gFrameStats;
+SharedStateWriter gSharedState;
 
-        // Explicitly null-terminate the string in the buffer
-        output_buffer[copy_len] = '\0';
+#define FRAME_REPORT_INTERVAL_S 60
 
-        return true;
-    }
+XPLMDataRef acf_icao, acf_reg;
 
-    // No match found, buffer is already null-terminated by the initial check
-    return false;
+static void LogToXPlane(const char* line)
+{
+    XPLMDebugString(line);
 }
 
 void FindDatarefs() {
-	dr_lat = XPLMFindDataRef("sim/flightmodel/position/latitude");
-	dr_lon = XPLMFindDataRef("sim/flightmodel/position/longitude");
-	dr_alt_amsl = XPLMFindDataRef("sim/flightmodel/position/elevation");
-	dr_alt_agl = XPLMFindDataRef("sim/flightmodel/position/y_agl");
-
-	dr_pitch = XPLMFindDataRef("sim/flightmodel/position/theta");
-	dr_bank = XPLMFindDataRef("sim/flightmodel/position/phi");
-	dr_heading = XPLMFindDataRef("sim/flightmodel/position/psi");
-
-	dr_gs = XPLMFindDataRef("sim/flightmodel/position/groundspeed");
-	dr_vs = XPLMFindDataRef("sim/flightmodel/position/vh_ind_fpm");
-
-	dr_fuel_kg = XPLMFindDataRef("sim/flightmodel/weight/m_fuel_total");
-	dr_gravity = XPLMFindDataRef("sim/physics/gravity_normal");
-
-	dr_transponder = XPLMFindDataRef("sim/cockpit/radios/transponder_code");
-	dr_on_ground = XPLMFindDataRef("sim/flightmodel/failures/onground_any");
-	dr_slew = XPLMFindDataRef("sim/operation/override/override_planepath");
-	dr_paused = XPLMFindDataRef("sim/time/paused");
-	dr_replay = XPLMFindDataRef("sim/operation/prefs/replay_mode");
-
-	dr_fps = XPLMFindDataRef("sim/graphics/view/framerate_period");
-	dr_taccel = XPLMFindDataRef("sim/time/time_accel");
-
-	dr_ap_engaged = XPLMFindDataRef("sim/cockpit/autopilot/autopilot_mode");
-	dr_eng_running = XPLMFindDataRef("sim/flightmodel/engine/ENGN_running");
-	dr_parking_brake = XPLMFindDataRef("sim/cockpit2/controls/parking_brake_ratio");
-
-	dr_wind_speed = XPLMFindDataRef("sim/weather/wind_speed_kt");
-	dr_wind_dir = XPLMFindDataRef("sim/weather/wind_direction_degt");
+	gSnapshotDatarefs.Resolve(LogToXPlane);
 
 	acf_icao = XPLMFindDataRef("sim/aircraft/view/acf_ICAO");
     acf_reg = XPLMFindDataRef("sim/aircraft/view/acf_tailnum");
@@ -136,137 +61,162 @@ void FindDatarefs() {
     livery_path = XPLMFindDataRef("sim/aircraft/view/acf_livery_path");
 }
 
-void HandleAircraftLoad() {
+// The plugin folder, above the platform folders (plugins/OpenVolanta for
+// plugins/OpenVolanta/win_x64/OpenVolanta.xpl). OpenVolanta.ini lives here.
+static std::string PluginDirectory()
+{
+    char path[512] = "";
+    XPLMGetPluginInfo(XPLMGetMyID(), NULL, path, NULL, NULL);
+    std::string dir(path);
+    for (int level = 0; level < 2; level++) {
+        size_t slash = dir.find_last_of("/\\");
+        if (slash == std::string::npos) {
+            break;
+        }
+        std::string leaf = dir.substr(slash + 1);
+        bool platform_dir = leaf == "64" || leaf.ends_with("_x64");
+        if (level == 1 && !platform_dir) {
+            break;
+        }
+        dir.erase(slash);
+    }
+    return dir;
+}
 
+static void LoadConfig()
+{
+    std::string path = PluginDirectory() + "/" CONFIG_FILE_NAME;
+    if (gConfig.Load(path.c_str())) {
+        char line[600];
+        snprintf(line, sizeof(line), "OpenVolanta: Loaded %zu settings from %s\n", gConfig.Size(), path.c_str());
+        XPLMDebugString(line);
+    }
+    gRateController = RateController(ReadRateConfig(gConfig));
+    gLandingDetector = LandingDetector(ReadLandingConfig(gConfig));
+    gFlightPhase = FlightPhaseTracker(ReadPhaseConfig(gConfig, (float)MPS_TO_KNOTS));
 }
 
+void HandleAircraftLoad() {
+
+}
 
-void SetupTCPSocket()
+// Runs on the sim thread every frame: copy the datarefs, feed the recorder,
+// the landing detector and the phase tracker, and hand a snapshot to the
+// worker at the rate controller's pace
+float CaptureSnapshot(
+	float                inElapsedSinceLastCall,
+	float                inElapsedTimeSinceLastFlightLoop,
+	int                  inCounter,
+	void* inRefcon)
 {
-#ifdef _WIN32
-    WSADATA wsa;
-    WSAStartup(MAKEWORD(2, 2), &wsa);
-#endif
+    auto start = std::chrono::steady_clock::now();
+    // Sim time, from X-Plane's own frame timing rather than the wall clock,
+    // so the mock runtime can run flights faster than real time
+    gSimTime += inElapsedSinceLastCall;
+    double now = gSimTime;
+
+    TelemetrySnapshot snapshot = {};
+    gSnapshotDatarefs.Read(&snapshot);
+    snapshot.fps = gFrameStats.Fps();
+    if (gSharedState.IsOpen()) {
+        gSharedState.Publish(snapshot, now);
+    }
 
-	XPLMDebugString("OpenVolanta: Setting up TCP socket\n");
-    tcp_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-    memset(&tcp_addr, 0, sizeof(tcp_addr));
-    tcp_addr.sin_family = AF_INET;
-    tcp_addr.sin_port = htons(6746);
-    tcp_addr.sin_addr.s_addr = inet_addr("127.0.0.1");
-    u_long mode = 1;
-    ioctlsocket(tcp_sock, FIONBIO, &mode);
-    int result = connect(tcp_sock, (struct sockaddr*)&tcp_addr, sizeof(tcp_addr));
-    if (result < 0) {
-		XPLMDebugString("OpenVolanta: Unable to connect to Volanta\n");
+    if (IsFlightRecorderRunning()) {
+        RecordSnapshot(snapshot, now);
     }
+    LandingEvent landing;
+    if (gLandingDetector.Update(snapshot, now, landing)) {
+        char line[128];
+        snprintf(line, sizeof(line), "OpenVolanta: Touchdown at %.1f fpm, %.2f g\n", landing.landing_rate, landing.gforce);
+        XPLMDebugString(line);
+        if (!PublishLanding(landing)) {
+            XPLMDebugString("OpenVolanta: Failed to queue landing\n");
+        }
+    }
+
+    if (gFlightPhase.Update(snapshot, now)) {
+        char line[128];
+        snprintf(line, sizeof(line), "OpenVolanta: Phase %s -> %s\n", FlightPhaseName(gFlightPhase.Previous()), FlightPhaseName(gFlightPhase.Phase()));
+        XPLMDebugString(line);
+        PublishPhaseChange(gFlightPhase.Event(snapshot));
+    }
+
+    // Every frame, so a touchdown or liftoff is seen on the frame it happens;
+    // the interval only decides which frames are published. A faster tier
+    // doesn't wait out what is left of the slower one's interval.
+    float interval = gRateController.Update(snapshot, now);
+    if (gNextPublish > now + interval) {
+        gNextPublish = now;
+    }
+    if (now >= gNextPublish) {
+        PublishSnapshot(snapshot, now, gRateController.Tier());
+        // Keep the average rate when frames don't line up with the interval
+        gNextPublish = now - gNextPublish > interval ? now + interval : gNextPublish + interval;
+    }
+    if (gRateController.TakeChanged()) {
+        char line[128];
+        if (interval > 0.0f) {
+            snprintf(line, sizeof(line), "OpenVolanta: Sampling %s at %.1f Hz\n", SampleTierName(gRateController.Tier()), 1.0f / interval);
+        }
+        else {
+            snprintf(line, sizeof(line), "OpenVolanta: Sampling %s every frame\n", SampleTierName(gRateController.Tier()));
+        }
+        XPLMDebugString(line);
+    }
+    DrainWorkerLog(LogToXPlane);
+    DrainRecorderLog(LogToXPlane);
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    RecordFlightLoopTime((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+	return -1.0f;  // every frame
 }
 
-float SendPosition(
+// Runs every frame and only times it: framerate_period doesn't update
+// properly, so the frame time is taken from the flight loop instead
+float TimeFrame(
 	float                inElapsedSinceLastCall,
 	float                inElapsedTimeSinceLastFlightLoop,
 	int                  inCounter,
 	void* inRefcon)
 {
-    double lat = XPLMGetDatad(dr_lat);
-    double lon = XPLMGetDatad(dr_lon);
-    double altA = XPLMGetDatad(dr_alt_amsl);
-    double altG = XPLMGetDatad(dr_alt_agl);
-
-    float pitch = XPLMGetDataf(dr_pitch);
-    float bank = XPLMGetDataf(dr_bank);
-    float hdg = XPLMGetDataf(dr_heading);
-
-    float gs = XPLMGetDataf(dr_gs);
-    float vs = XPLMGetDataf(dr_vs);
-
-    float fuel = XPLMGetDataf(dr_fuel_kg);
-    float grav = XPLMGetDataf(dr_gravity);
-
-    int   xpndr = XPLMGetDatai(dr_transponder);
-    int   og = XPLMGetDatai(dr_on_ground);
-
-    int   slew = XPLMGetDatai(dr_slew);
-    int   paused = XPLMGetDatai(dr_paused);
-    int   replay = XPLMGetDatai(dr_replay);
-
-    // float fps = 1.0f / XPLMGetDataf(dr_fps);
-	float fps = 144; // doesnt seem to update properly, so just fake it
-    float taccel = XPLMGetDataf(dr_taccel);
-
-    int   ap_eng = XPLMGetDatai(dr_ap_engaged);
-    int   eng_run = XPLMGetDatai(dr_eng_running);
-    float brake = XPLMGetDataf(dr_parking_brake);
-
-    float windS = XPLMGetDataf(dr_wind_speed);
-    float windD = XPLMGetDataf(dr_wind_dir);
-
-    // Build JSON
-    char json[1024];
-    snprintf(json, sizeof(json),
-        "{\"type\":\"STREAM\",\"name\":\"POSITION_UPDATE\",\"data\":{"
-        "\"altitude_amsl\":%.6f,"
-        "\"altitude_agl\":%.6f,"
-        "\"latitude\":%.6f,"
-        "\"longitude\":%.6f,"
-        "\"pitch\":%.6f,"
-        "\"bank\":%.6f,"
-        "\"heading_true\":%.6f,"
-        "\"ground_speed\":%.6f,"
-        "\"vertical_speed\":%.6f,"
-        "\"fuel_kg\":%.6f,"
-        "\"gravity\":%.6f,"
-        "\"transponder\":\"%04d\","
-        "\"on_ground\":%s,"
-        "\"slew\":%s,"
-        "\"paused\":%s,"
-        "\"in_replay_mode\":%s,"
-        "\"fps\":%.6f,"
-        "\"time_acceleration\":%.6f,"
-        "\"autopilot_engaged\":%s,"
-        "\"engines_running\":%s,"
-        "\"parking_brake\":%s,"
-        "\"sim_abbreviation\":\"xp12\","
-        "\"sim_version\":\"12.320\","
-        "\"wind_speed\":%.6f,"
-        "\"wind_direction\":%.6f"
-        "}}",
-        altA * METERS_TO_FT, 
-        altG * METERS_TO_FT, 
-        lat, 
-        lon,
-        pitch, bank, hdg,
-        gs, vs, fuel, grav,
-        xpndr,
-        og ? "true" : "false",
-        slew ? "true" : "false",
-        paused ? "true" : "false",
-        replay ? "true" : "false",
-        fps, taccel,
-        ap_eng ? "true" : "false",
-        eng_run ? "true" : "false",
-        brake > 0.5f ? "true" : "false",
-        windS, windD
-    );
-
-    int sent = send(tcp_sock, json, (int)strlen(json), 0);
-    if (sent < 0) {
-		SetupTCPSocket();  // Try to reconnect
-        XPLMDebugString(json); // Log the failure
+    static bool first = true;
+    static double elapsed = 0.0;
+    static double next_report = FRAME_REPORT_INTERVAL_S;
+    // The first call's elapsed time is since the loop was scheduled
+    if (!first) {
+        gFrameStats.Record(inElapsedSinceLastCall);
     }
-	return 0.1f;  // Run again in .1 seconds
+    first = false;
+    elapsed += inElapsedSinceLastCall;
+
+    if (elapsed >= next_report) {
+        FramePercentiles frames = gFrameStats.Window();
+        char line[256];
+        snprintf(line, sizeof(line), "OpenVolanta: %.1f fps over %llu frames, frame time p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+            frames.mean_fps, (unsigned long long)frames.frames, frames.p50_ms, frames.p95_ms, frames.p99_ms, frames.max_ms);
+        XPLMDebugString(line);
+        gFrameStats.ResetWindow();
+        next_report = elapsed + FRAME_REPORT_INTERVAL_S;
+    }
+	return -1.0f;
 }
 
 XPLMFlightLoopID gFlightLoop = NULL;
+XPLMFlightLoopID gFrameLoop = NULL;
 
 void CreateMyFlightLoop() {
 	XPLMCreateFlightLoop_t params;
 	params.structSize = sizeof(params);
 	params.phase = xplm_FlightLoop_Phase_AfterFlightModel; // Usually safest
-	params.callbackFunc = SendPosition;
+	params.callbackFunc = CaptureSnapshot;
 	params.refcon = NULL;
 
 	gFlightLoop = XPLMCreateFlightLoop(&params);
+
+	params.phase = xplm_FlightLoop_Phase_BeforeFlightModel;
+	params.callbackFunc = TimeFrame;
+	gFrameLoop = XPLMCreateFlightLoop(&params);
 }
 
 PLUGIN_API int XPluginStart(
@@ -277,10 +227,25 @@ PLUGIN_API int XPluginStart(
 	strcpy(outName, "OpenVolanta");
 	strcpy(outSig, "starnumber.openvolanta");
 	strcpy(outDesc, "A drop-in replacement plugin for Volanta");
-	SetupTCPSocket();
+	XPLMEnableFeature("XPLM_USE_NATIVE_PATHS", 1);
+	LoadConfig();
+
+	ConnectionConfig connection;
+	connection.host = gConfig.GetString("host", connection.host);
+	connection.port = (uint16_t)gConfig.GetNumber("port", connection.port);
+	StartTelemetryWorker(connection, ReadSimplifyConfig(gConfig), ReadFanoutConfig(gConfig));
+	RecorderConfig recorder = ReadRecorderConfig(gConfig, PluginDirectory() + "/recordings");
+	if (recorder.enabled) {
+		StartFlightRecorder(recorder);
+	}
+	SharedStateConfig shared = ReadSharedStateConfig(gConfig);
+	if (shared.enabled && !gSharedState.Open(shared.name)) {
+		XPLMDebugString("OpenVolanta: Unable to create the shared memory segment\n");
+	}
 	FindDatarefs();
 	CreateMyFlightLoop();
 	XPLMScheduleFlightLoop(gFlightLoop, -1, 1);
+	XPLMScheduleFlightLoop(gFrameLoop, -1, 1);
     
 	return 1;
 }
@@ -288,23 +253,29 @@ PLUGIN_API int XPluginStart(
 PLUGIN_API void	XPluginStop(void)
 {
 	XPLMDestroyFlightLoop(gFlightLoop);
+	XPLMDestroyFlightLoop(gFrameLoop);
+	StopTelemetryWorker();
+	StopFlightRecorder();
+	gSharedState.Close();
+	DrainWorkerLog(LogToXPlane);
+	DrainRecorderLog(LogToXPlane);
 }
 
 PLUGIN_API void XPluginDisable(void) {}
 PLUGIN_API int  XPluginEnable(void)  { return 1; }
 PLUGIN_API void XPluginReceiveMessage(XPLMPluginID inFrom, int inMsg, void * inParam) {
 	char output[256];
-	snprintf(output, sizeof(output), "OpenVolanta: Received message %d from plugin %d - param: %d\n", inMsg, inFrom, (int)inParam);
+	snprintf(output, sizeof(output), "OpenVolanta: Received message %d from plugin %d - param: %d\n", inMsg, inFrom, (int)(intptr_t)inParam);
     XPLMDebugString(output);
 	if (inMsg == XPLM_MSG_LIVERY_LOADED) {
-        char icao[256];
+        char icao[256] = "";
         int icaoLength = XPLMGetDatab(acf_icao, NULL, 0, 0);
         if (icaoLength > 0 && icaoLength <= 40) {
             XPLMGetDatab(acf_icao, &icao, 0, icaoLength);
             icao[39] = '\0';
         }
 		char reg[256];
-		char current_livery_path[256];
+		char current_livery_path[256] = "";
         int liveryLength = XPLMGetDatab(livery_path, NULL, 0, 0);
         if (liveryLength > 0 && liveryLength <= 255) {
             XPLMGetDatab(livery_path, &current_livery_path, 0, liveryLength);
@@ -313,14 +284,14 @@ PLUGIN_API void XPluginReceiveMessage(XPLMPluginID inFrom, int inMsg, void * inP
         XPLMDebugString("OpenVolanta: Livery path: ");
 		XPLMDebugString(current_livery_path);
 
-		bool success = extract_registration_to_buffer(current_livery_path, reg, sizeof(reg));
+		bool success = FindRegistration(LiveryFolderName(current_livery_path), reg, sizeof(reg));
         if (!success) {
             // Fallback to acf_tailnum dataref
             reg[0] = '\0';
             int length = XPLMGetDatab(acf_reg, NULL, 0, 0);
             if (length > 0 && length <= 40) {
                 XPLMGetDatab(acf_reg, &reg, 0, length);
-                icao[39] = '\0';
+                reg[length] = '\0';
             }
         }
         else {
@@ -329,21 +300,14 @@ PLUGIN_API void XPluginReceiveMessage(XPLMPluginID inFrom, int inMsg, void * inP
         }
 		XPLMDebugString("OpenVolanta: Extracted registration: ");
         XPLMDebugString("OpenVolanta: Plane loaded, sending plane info to Volanta\n");
-        char json[1024];
-        snprintf(json, sizeof(json),
-            "{\"type\":\"STREAM\",\"name\":\"AIRCRAFT_UPDATE\",\"data\":{\"title\":\"\",\"type\":\"%s\",\"model\":\"%s\",\"registration\":\"%s\",\"airline\":\"\"}}",
-            icao,
-            icao,
-            reg
-        );
-        int sent = send(tcp_sock, json, (int)strlen(json), 0);
-        if (sent < 0) {
-            SetupTCPSocket();  // Try to reconnect
-            XPLMDebugString("OpenVolanta: Failed to send aircraft update\n");
-            XPLMDebugString(json); // Log the failure
+        AircraftIdentity aircraft;
+        snprintf(aircraft.icao, sizeof(aircraft.icao), "%s", icao);
+        snprintf(aircraft.registration, sizeof(aircraft.registration), "%s", reg);
+        if (!PublishAircraft(aircraft)) {
+            XPLMDebugString("OpenVolanta: Failed to queue aircraft update\n");
         }
-        else {
-            XPLMDebugString("OpenVolanta: Sent aircraft update\n");
+        if (IsFlightRecorderRunning()) {
+            RecordNewFlight(aircraft);
         }
     }
 }
\ No newline at end of file
@@ -0,0 +1,549 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Socket.h"
+#include "XPlaneUdp.h"
+
+// Local stand-in for X-Plane's UDP interface, to run the native bridge
+// without a simulator. Answers RREF subscriptions the way X-Plane does:
+// every subscription is sent `freq` times per second, all of a client's due
+// values batched into as few datagrams as fit, from a synthetic flight
+// advanced at --fps frames per second. RPOS requests get an RPOS packet at
+// the requested rate, DSEL a DATA packet with the selected groups at
+// --data-hz, as X-Plane sends DATA at its own Data Output rate. String
+// datarefs (acf_ICAO, acf_tailnum, acf_livery_path) answer byte by byte.
+//
+//   fakexplane [--port P] [--fps F] [--data-hz HZ] [--swap-aircraft S]
+//              [--seconds S] [--beacon]
+//
+// --fps 0 runs frames back to back and sends every subscription on every
+// frame, whatever its frequency, to find out how much a receiver takes.
+// RPOS and DATA are never sent more than once a frame, so --fps 500 gives
+// RPOS up to 500 Hz. --swap-aircraft loads another aircraft and livery
+// after S seconds.
+// --beacon multicasts a BECN packet once a second, with loopback on, so
+// discovery works on the same machine. At exit it prints what it sent.
+
+namespace {
+
+#define FAKE_EARTH_RADIUS_M 6371008.8
+#define FAKE_DEG_TO_RAD 0.017453292519943295
+#define FAKE_PACKET_SIZE (RREF_HEADER_SIZE + RREF_MAX_VALUES * 8)
+#define FAKE_SEND_BATCH 64          // datagrams per sendmmsg
+#define FAKE_DATA_HZ 20             // X-Plane's Data Output rate
+#define FAKE_MAX_GROUPS 32          // DATA groups selected per client
+
+volatile sig_atomic_t gStop = 0;
+
+void OnSignal(int)
+{
+    gStop = 1;
+}
+
+int64_t NanosecondsNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// A circuit at 1500 ft around a fixed point, one lap every 4 minutes
+struct FakeFlight {
+    double t = 0.0;
+    double latitude = 0.0;
+    double longitude = 0.0;
+    double elevation = 0.0;
+    float  heading = 0.0f;
+    float  pitch = 0.0f;
+    float  vertical_speed = 0.0f;   // feet/minute
+    float  frame_period = 1.0f / 60.0f;
+    int    aircraft = 0;            // row in the kFakeStrings values
+};
+
+#define FAKE_ROLL 15.0f
+#define FAKE_GROUND_SPEED 78.5f     // m/s
+
+void Advance(FakeFlight& flight, double t, double fps)
+{
+    const double radius_m = 3000.0;
+    double angle = t * 2.0 * M_PI / 240.0;
+    flight.t = t;
+    flight.latitude = 45.63 + radius_m * std::cos(angle) / FAKE_EARTH_RADIUS_M / FAKE_DEG_TO_RAD;
+    flight.longitude = 8.72 + radius_m * std::sin(angle) / (FAKE_EARTH_RADIUS_M * std::cos(45.63 * FAKE_DEG_TO_RAD)) / FAKE_DEG_TO_RAD;
+    flight.elevation = 457.0 + 3.0 * std::sin(t * 0.5);
+    flight.heading = (float)std::fmod(angle / FAKE_DEG_TO_RAD + 90.0, 360.0);
+    flight.pitch = 2.0f + 0.3f * (float)std::sin(t * 0.3);
+    flight.vertical_speed = 300.0f * (float)std::cos(t * 0.5);
+    flight.frame_period = (float)(1.0 / (fps > 0.0 ? fps : 60.0));
+}
+
+typedef float (*FakeGetter)(const FakeFlight& flight);
+
+struct FakeDataref {
+    const char* name;
+    FakeGetter  get;
+};
+
+// Everything else reads as 0, like a dataref X-Plane has but nobody moves
+const FakeDataref kFakeDatarefs[] = {
+    { "sim/flightmodel/position/elevation",             [](const FakeFlight& f) { return (float)f.elevation; } },
+    { "sim/flightmodel/position/y_agl",                 [](const FakeFlight& f) { return (float)(f.elevation - 120.0); } },
+    { "sim/flightmodel/position/latitude",              [](const FakeFlight& f) { return (float)f.latitude; } },
+    { "sim/flightmodel/position/longitude",             [](const FakeFlight& f) { return (float)f.longitude; } },
+    { "sim/flightmodel/position/theta",                 [](const FakeFlight& f) { return f.pitch; } },
+    { "sim/flightmodel/position/phi",                   [](const FakeFlight&) { return FAKE_ROLL; } },
+    { "sim/flightmodel/position/psi",                   [](const FakeFlight& f) { return f.heading; } },
+    { "sim/flightmodel/position/groundspeed",           [](const FakeFlight&) { return FAKE_GROUND_SPEED; } },
+    { "sim/flightmodel/position/vh_ind_fpm",            [](const FakeFlight& f) { return f.vertical_speed; } },
+    { "sim/flightmodel/weight/m_fuel_total",            [](const FakeFlight& f) { return 2000.0f - (float)f.t * 0.1f; } },
+    { "sim/physics/gravity_normal",                     [](const FakeFlight&) { return 1.0f; } },
+    { "sim/cockpit/radios/transponder_code",            [](const FakeFlight&) { return 7000.0f; } },
+    { "sim/operation/misc/frame_rate_period",           [](const FakeFlight& f) { return f.frame_period; } },
+    { "sim/time/time_accel",                            [](const FakeFlight&) { return 1.0f; } },
+    { "sim/cockpit/autopilot/autopilot_mode",           [](const FakeFlight&) { return 2.0f; } },
+    { "sim/flightmodel/engine/ENGN_running",            [](const FakeFlight&) { return 1.0f; } },
+    { "sim/weather/wind_speed_kt",                      [](const FakeFlight&) { return 12.0f; } },
+    { "sim/weather/wind_direction_degt",                [](const FakeFlight&) { return 270.0f; } },
+    { "sim/version/xplane_internal_version",            [](const FakeFlight&) { return 120320.0f; } },
+    { "sim/aircraft/view/acf_livery_index",             [](const FakeFlight& f) { return (float)f.aircraft; } },
+};
+
+// Byte array datarefs, one value per aircraft --swap-aircraft switches
+// between. The first livery has no registration in its name, so the
+// bridge falls back to the tail number.
+struct FakeString {
+    const char* name;
+    const char* values[2];
+};
+
+const FakeString kFakeStrings[] = {
+    { "sim/aircraft/view/acf_ICAO",         { "C172", "B738" } },
+    { "sim/aircraft/view/acf_tailnum",      { "N172SP", "N738ZB" } },
+    { "sim/aircraft/view/acf_livery_path",  { "Aircraft/Laminar Research/Cessna 172 SP/liveries/Blue Stripe/",
+                                              "Aircraft/Laminar Research/Boeing 737-800/liveries/Ryanair EI-DCL (Sharklets)/" } },
+};
+
+float Zero(const FakeFlight&)
+{
+    return 0.0f;
+}
+
+FakeGetter FindGetter(const char* name)
+{
+    for (const FakeDataref& dataref : kFakeDatarefs) {
+        if (strcmp(dataref.name, name) == 0) {
+            return dataref.get;
+        }
+    }
+    return Zero;
+}
+
+// "name[i]" of a kFakeStrings entry, or null
+const FakeString* FindString(const char* name, int32_t& byte)
+{
+    const char* bracket = strrchr(name, '[');
+    if (bracket == nullptr) {
+        return nullptr;
+    }
+    for (const FakeString& string : kFakeStrings) {
+        if (strlen(string.name) == (size_t)(bracket - name) && strncmp(string.name, name, (size_t)(bracket - name)) == 0) {
+            byte = atoi(bracket + 1);
+            return &string;
+        }
+    }
+    return nullptr;
+}
+
+struct Subscription {
+    int32_t           index;
+    int32_t           frequency;
+    FakeGetter        get;
+    const FakeString* string;       // instead of `get` for a string byte
+    int32_t           byte;
+    int64_t           next_ns;
+};
+
+float SubscriptionValue(const Subscription& s, const FakeFlight& flight)
+{
+    if (s.string == nullptr) {
+        return s.get(flight);
+    }
+    const char* text = s.string->values[flight.aircraft];
+    return s.byte >= 0 && (size_t)s.byte < strlen(text) ? (float)(uint8_t)text[s.byte] : 0.0f;
+}
+
+struct FakeClient {
+    sockaddr_in               addr;
+    std::vector<Subscription> subscriptions;
+    int32_t                   rpos_rate = 0;
+    int64_t                   rpos_next_ns = 0;
+    std::vector<int32_t>      data_groups;
+    int64_t                   data_next_ns = 0;
+};
+
+// The same flight as the datarefs, velocities in X-Plane's OpenGL frame
+RposPacket MakeRpos(const FakeFlight& flight)
+{
+    float heading = flight.heading * (float)FAKE_DEG_TO_RAD;
+    RposPacket rpos = {};
+    rpos.longitude = flight.longitude;
+    rpos.latitude = flight.latitude;
+    rpos.elevation = flight.elevation;
+    rpos.agl = (float)(flight.elevation - 120.0);
+    rpos.pitch = flight.pitch;
+    rpos.heading = flight.heading;
+    rpos.roll = FAKE_ROLL;
+    rpos.vx = FAKE_GROUND_SPEED * std::sin(heading);
+    rpos.vy = flight.vertical_speed / 60.0f / (float)METERS_TO_FT;
+    rpos.vz = -FAKE_GROUND_SPEED * std::cos(heading);
+    return rpos;
+}
+
+// Groups the bridge reads are filled in, any others are sent as zeros
+size_t MakeDataPacket(const FakeFlight& flight, const std::vector<int32_t>& groups, uint8_t* out, size_t out_size)
+{
+    memcpy(out, "DATA*", 5);
+    size_t size = 5;
+    for (int32_t group : groups) {
+        float v[8] = {};
+        switch (group) {
+            case DATA_GROUP_SPEEDS:
+                v[3] = FAKE_GROUND_SPEED * (float)MPS_TO_KNOTS;
+                break;
+            case DATA_GROUP_VVI:
+                v[2] = flight.vertical_speed;
+                break;
+            case DATA_GROUP_ATTITUDE:
+                v[0] = flight.pitch;
+                v[1] = FAKE_ROLL;
+                v[2] = flight.heading;
+                break;
+            case DATA_GROUP_POSITION:
+                v[0] = (float)flight.latitude;
+                v[1] = (float)flight.longitude;
+                v[2] = (float)(flight.elevation * METERS_TO_FT);
+                v[3] = (float)((flight.elevation - 120.0) * METERS_TO_FT);
+                break;
+            default:
+                break;
+        }
+        size += AppendDataRecord(group, v, out + size, out_size - size);
+    }
+    return size;
+}
+
+struct FakeCounters {
+    uint64_t frames = 0;
+    uint64_t requests = 0;
+    uint64_t packets = 0;
+    uint64_t values = 0;
+    uint64_t rpos_packets = 0;
+    uint64_t data_packets = 0;
+    uint64_t send_calls = 0;
+    uint64_t send_failures = 0;
+    uint64_t beacons = 0;
+};
+
+FakeClient& FindClient(std::vector<FakeClient>& clients, const sockaddr_in& addr)
+{
+    for (FakeClient& client : clients) {
+        if (client.addr.sin_addr.s_addr == addr.sin_addr.s_addr && client.addr.sin_port == addr.sin_port) {
+            return client;
+        }
+    }
+    clients.push_back({ addr, {} });
+    return clients.back();
+}
+
+// RPOS rate "0" stops RPOS; USEL unselects DATA groups
+void HandlePositionRequest(std::vector<FakeClient>& clients, const sockaddr_in& from, const uint8_t* packet, size_t size, FakeCounters& counters)
+{
+    if (size >= 6 && memcmp(packet, "RPOS", 5) == 0) {
+        counters.requests++;
+        char rate[16] = {};
+        memcpy(rate, packet + 5, std::min(size - 5, sizeof(rate) - 1));
+        FindClient(clients, from).rpos_rate = std::max(atoi(rate), 0);
+        return;
+    }
+    bool select = memcmp(packet, "DSEL", 5) == 0;
+    if (size < 9 || (!select && memcmp(packet, "USEL", 5) != 0)) {
+        return;
+    }
+    counters.requests++;
+    std::vector<int32_t>& groups = FindClient(clients, from).data_groups;
+    for (size_t at = 5; at + 4 <= size; at += 4) {
+        int32_t group;
+        memcpy(&group, packet + at, sizeof(group));
+        groups.erase(std::remove(groups.begin(), groups.end(), group), groups.end());
+        if (select && groups.size() < FAKE_MAX_GROUPS) {
+            groups.push_back(group);
+        }
+    }
+}
+
+// A new request for the same index replaces the old one; frequency 0 drops it
+void HandleRequest(std::vector<FakeClient>& clients, const sockaddr_in& from, const uint8_t* packet, size_t size, FakeCounters& counters)
+{
+    if (size < RREF_REQUEST_SIZE || memcmp(packet, "RREF", 5) != 0) {
+        HandlePositionRequest(clients, from, packet, size, counters);
+        return;
+    }
+    counters.requests++;
+    int32_t frequency, index;
+    memcpy(&frequency, packet + 5, sizeof(frequency));
+    memcpy(&index, packet + 9, sizeof(index));
+    char name[RREF_NAME_SIZE + 1] = {};
+    memcpy(name, packet + 13, RREF_NAME_SIZE);
+
+    FakeClient& client = FindClient(clients, from);
+    std::vector<Subscription>& subscriptions = client.subscriptions;
+    subscriptions.erase(std::remove_if(subscriptions.begin(), subscriptions.end(),
+        [index](const Subscription& s) { return s.index == index; }), subscriptions.end());
+    if (frequency > 0) {
+        int32_t byte = 0;
+        const FakeString* string = FindString(name, byte);
+        subscriptions.push_back({ index, frequency, FindGetter(name), string, byte, 0 });
+    }
+}
+
+class PacketSender {
+public:
+    explicit PacketSender(socket_t sock) : sock_(sock) {}
+
+    void Add(const sockaddr_in& to, int32_t index, float value, FakeCounters& counters)
+    {
+        if (count_ == 0 || !rref_[count_ - 1] || sizes_[count_ - 1] == FAKE_PACKET_SIZE || !SameAddress(to_[count_ - 1], to)) {
+            if (count_ == FAKE_SEND_BATCH) {
+                Flush(counters);
+            }
+            memcpy(packets_[count_], "RREF,", RREF_HEADER_SIZE);
+            sizes_[count_] = RREF_HEADER_SIZE;
+            to_[count_] = to;
+            rref_[count_] = true;
+            count_++;
+        }
+        uint8_t* pair = packets_[count_ - 1] + sizes_[count_ - 1];
+        memcpy(pair, &index, 4);
+        memcpy(pair + 4, &value, 4);
+        sizes_[count_ - 1] += 8;
+        counters.values++;
+    }
+
+    // A whole datagram of its own, RPOS or DATA
+    void AddPacket(const sockaddr_in& to, const uint8_t* packet, size_t size, FakeCounters& counters)
+    {
+        if (count_ == FAKE_SEND_BATCH) {
+            Flush(counters);
+        }
+        memcpy(packets_[count_], packet, std::min(size, (size_t)FAKE_PACKET_SIZE));
+        sizes_[count_] = std::min(size, (size_t)FAKE_PACKET_SIZE);
+        to_[count_] = to;
+        rref_[count_] = false;
+        count_++;
+    }
+
+    void Flush(FakeCounters& counters)
+    {
+        if (count_ == 0) {
+            return;
+        }
+#ifdef __linux__
+        struct mmsghdr messages[FAKE_SEND_BATCH];
+        struct iovec vectors[FAKE_SEND_BATCH];
+        for (size_t i = 0; i < count_; i++) {
+            vectors[i] = { packets_[i], sizes_[i] };
+            messages[i] = {};
+            messages[i].msg_hdr.msg_name = &to_[i];
+            messages[i].msg_hdr.msg_namelen = sizeof(to_[i]);
+            messages[i].msg_hdr.msg_iov = &vectors[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+        int sent = sendmmsg(sock_, messages, (unsigned)count_, 0);
+        counters.send_calls++;
+        counters.packets += sent > 0 ? (uint64_t)sent : 0;
+        counters.send_failures += count_ - (sent > 0 ? (size_t)sent : 0);
+#else
+        for (size_t i = 0; i < count_; i++) {
+            bool sent = sendto(sock_, (const char*)packets_[i], (int)sizes_[i], 0, (const sockaddr*)&to_[i], sizeof(to_[i])) > 0;
+            counters.send_calls++;
+            counters.packets += sent;
+            counters.send_failures += !sent;
+        }
+#endif
+        count_ = 0;
+    }
+
+private:
+    static bool SameAddress(const sockaddr_in& a, const sockaddr_in& b)
+    {
+        return a.sin_addr.s_addr == b.sin_addr.s_addr && a.sin_port == b.sin_port;
+    }
+
+    socket_t    sock_;
+    uint8_t     packets_[FAKE_SEND_BATCH][FAKE_PACKET_SIZE];
+    size_t      sizes_[FAKE_SEND_BATCH] = {};
+    sockaddr_in to_[FAKE_SEND_BATCH];
+    bool        rref_[FAKE_SEND_BATCH] = {};
+    size_t      count_ = 0;
+};
+
+void SendBeacon(socket_t sock, uint16_t port, FakeCounters& counters)
+{
+    XPlaneBeacon beacon = { 1, 2, 1, 120320, 1, port, "fakexplane" };
+    uint8_t packet[256];
+    size_t size = BuildBeacon(beacon, packet, sizeof(packet));
+    sockaddr_in group = {};
+    group.sin_family = AF_INET;
+    group.sin_port = htons(XPLANE_BEACON_PORT);
+    inet_pton(AF_INET, XPLANE_BEACON_GROUP, &group.sin_addr);
+    counters.beacons += sendto(sock, (const char*)packet, size, 0, (const sockaddr*)&group, sizeof(group)) > 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int port = XPLANE_UDP_PORT;
+    double fps = 60.0;
+    double data_hz = FAKE_DATA_HZ;
+    double seconds = 0.0;
+    double swap_s = 0.0;
+    bool beacon = false;
+    bool ok = true;
+    for (int i = 1; i < argc && ok; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--port") == 0 && has_value) {
+            port = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--fps") == 0 && has_value) {
+            fps = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--data-hz") == 0 && has_value) {
+            data_hz = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--swap-aircraft") == 0 && has_value) {
+            swap_s = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--seconds") == 0 && has_value) {
+            seconds = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--beacon") == 0) {
+            beacon = true;
+        }
+        else {
+            ok = false;
+        }
+    }
+    if (!ok || port <= 0 || port > 65535 || fps < 0.0 || data_hz <= 0.0) {
+        fprintf(stderr, "usage: %s [--port P] [--fps F] [--data-hz HZ] [--swap-aircraft S] [--seconds S] [--beacon]\n", argv[0]);
+        return 2;
+    }
+
+    SocketStartup();
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+    socket_t sock = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((uint16_t)port);
+    if (sock == SOCKET_INVALID || bind(sock, (sockaddr*)&addr, sizeof(addr)) != 0 || !SetNonBlocking(sock)) {
+        fprintf(stderr, "could not listen on UDP port %d\n", port);
+        return 1;
+    }
+    int one = 1;
+    setsockopt(sock, IPPROTO_IP, IP_MULTICAST_LOOP, (const char*)&one, sizeof(one));
+    fprintf(stderr, "fake X-Plane on UDP port %d at %s\n", port, fps > 0.0 ? (std::to_string((int)fps) + " fps").c_str() : "max fps");
+
+    std::vector<FakeClient> clients;
+    FakeCounters counters;
+    FakeFlight flight;
+    PacketSender sender(sock);
+    int64_t frame_ns = fps > 0.0 ? (int64_t)(1e9 / fps) : 0;
+    int64_t start_ns = NanosecondsNow();
+    int64_t next_frame_ns = start_ns;
+    int64_t next_beacon_ns = start_ns;
+    uint8_t packet[2048];
+    while (!gStop && (seconds <= 0.0 || NanosecondsNow() - start_ns < (int64_t)(seconds * 1e9))) {
+        int64_t now_ns = NanosecondsNow();
+        int timeout_ms = next_frame_ns > now_ns ? (int)((next_frame_ns - now_ns) / 1000000) : 0;
+        // With nobody subscribed there is nothing to hurry for
+        if (clients.empty()) {
+            timeout_ms = 100;
+        }
+        struct pollfd pfd = { sock, POLLIN, 0 };
+        if (PollSockets(&pfd, 1, timeout_ms) > 0) {
+            sockaddr_in from = {};
+            socklen_t length = sizeof(from);
+            long size;
+            while ((size = (long)recvfrom(sock, (char*)packet, sizeof(packet), 0, (sockaddr*)&from, &length)) > 0) {
+                HandleRequest(clients, from, packet, (size_t)size, counters);
+                length = sizeof(from);
+            }
+        }
+
+        now_ns = NanosecondsNow();
+        if (beacon && now_ns >= next_beacon_ns) {
+            SendBeacon(sock, (uint16_t)port, counters);
+            next_beacon_ns = now_ns + 1000000000;
+        }
+        if (now_ns < next_frame_ns) {
+            // poll has millisecond resolution; the rest is slept precisely
+            if (next_frame_ns - now_ns < 1000000) {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(next_frame_ns - now_ns));
+            }
+            continue;
+        }
+        next_frame_ns = std::max(next_frame_ns + frame_ns, now_ns - 10 * frame_ns);
+        counters.frames++;
+        Advance(flight, (double)(now_ns - start_ns) * 1e-9, fps);
+        if (swap_s > 0.0 && flight.aircraft == 0 && flight.t >= swap_s) {
+            flight.aircraft = 1;
+            fprintf(stderr, "swapped to %s\n", kFakeStrings[0].values[1]);
+        }
+        for (FakeClient& client : clients) {
+            for (Subscription& s : client.subscriptions) {
+                if (fps > 0.0 && now_ns < s.next_ns) {
+                    continue;
+                }
+                s.next_ns = std::max(s.next_ns + 1000000000 / s.frequency, now_ns);
+                sender.Add(client.addr, s.index, SubscriptionValue(s, flight), counters);
+            }
+            if (client.rpos_rate > 0 && (fps <= 0.0 || now_ns >= client.rpos_next_ns)) {
+                client.rpos_next_ns = std::max(client.rpos_next_ns + 1000000000 / client.rpos_rate, now_ns);
+                uint8_t rpos[RPOS_PACKET_SIZE];
+                sender.AddPacket(client.addr, rpos, BuildRposPacket(MakeRpos(flight), rpos, sizeof(rpos)), counters);
+                counters.rpos_packets++;
+            }
+            if (!client.data_groups.empty() && now_ns >= client.data_next_ns) {
+                client.data_next_ns = std::max(client.data_next_ns + (int64_t)(1e9 / data_hz), now_ns);
+                uint8_t data[5 + FAKE_MAX_GROUPS * DATA_RECORD_SIZE];
+                sender.AddPacket(client.addr, data, MakeDataPacket(flight, client.data_groups, data, sizeof(data)), counters);
+                counters.data_packets++;
+            }
+        }
+        sender.Flush(counters);
+    }
+    CloseSocket(sock);
+
+    double wall_s = (double)(NanosecondsNow() - start_ns) * 1e-9;
+    fprintf(stderr, "%llu frames, %llu requests, sent %llu packets (%.0f/s) with %llu values, %llu RPOS and %llu DATA in %llu calls, %llu failed, %llu beacons\n",
+        (unsigned long long)counters.frames,
+        (unsigned long long)counters.requests,
+        (unsigned long long)counters.packets,
+        wall_s > 0.0 ? (double)counters.packets / wall_s : 0.0,
+        (unsigned long long)counters.values,
+        (unsigned long long)counters.rpos_packets,
+        (unsigned long long)counters.data_packets,
+        (unsigned long long)counters.send_calls,
+        (unsigned long long)counters.send_failures,
+        (unsigned long long)counters.beacons);
+    SocketCleanup();
+    return 0;
+}
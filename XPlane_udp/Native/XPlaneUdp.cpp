@@ -0,0 +1,361 @@
+#include "include/XPlaneUdp.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+// Same datarefs as the Go bridge, in its order. Arrays without an index
+// answer with element 0. The first column marks what RPOS and DATA carry.
+const RrefSpec kRrefDatarefs[] = {
+    { "sim/flightmodel/position/elevation",             true,  RrefConvert::Copy,        SNAPSHOT_FIELD(altitude_amsl) },
+    { "sim/flightmodel/position/y_agl",                 true,  RrefConvert::Copy,        SNAPSHOT_FIELD(altitude_agl) },
+    { "sim/flightmodel/position/latitude",              true,  RrefConvert::Copy,        SNAPSHOT_FIELD(latitude) },
+    { "sim/flightmodel/position/longitude",             true,  RrefConvert::Copy,        SNAPSHOT_FIELD(longitude) },
+    { "sim/flightmodel/position/theta",                 true,  RrefConvert::Copy,        SNAPSHOT_FIELD(pitch) },
+    { "sim/flightmodel/position/phi",                   true,  RrefConvert::Copy,        SNAPSHOT_FIELD(bank) },
+    { "sim/flightmodel/position/psi",                   true,  RrefConvert::Copy,        SNAPSHOT_FIELD(heading_true) },
+    { "sim/flightmodel/position/groundspeed",           true,  RrefConvert::Copy,        SNAPSHOT_FIELD(ground_speed) },
+    { "sim/flightmodel/position/vh_ind_fpm",            true,  RrefConvert::Copy,        SNAPSHOT_FIELD(vertical_speed) },
+    { "sim/flightmodel/weight/m_fuel_total",            false, RrefConvert::Copy,        SNAPSHOT_FIELD(fuel_kg) },
+    { "sim/physics/gravity_normal",                     false, RrefConvert::Copy,        SNAPSHOT_FIELD(gravity) },
+    { "sim/cockpit/radios/transponder_code",            false, RrefConvert::Copy,        SNAPSHOT_FIELD(transponder) },
+    { "sim/flightmodel/failures/onground_any",          false, RrefConvert::Copy,        SNAPSHOT_FIELD(on_ground) },
+    { "sim/operation/override/override_planepath",      false, RrefConvert::Copy,        SNAPSHOT_FIELD(slew) },
+    { "sim/time/paused",                                false, RrefConvert::Copy,        SNAPSHOT_FIELD(paused) },
+    { "sim/operation/prefs/replay_mode",                false, RrefConvert::Copy,        SNAPSHOT_FIELD(in_replay_mode) },
+    // framerate_period doesn't update over UDP, frame_rate_period does
+    { "sim/operation/misc/frame_rate_period",           false, RrefConvert::FramePeriod, SNAPSHOT_FIELD(fps) },
+    { "sim/time/time_accel",                            false, RrefConvert::Copy,        SNAPSHOT_FIELD(time_acceleration) },
+    { "sim/cockpit/autopilot/autopilot_mode",           false, RrefConvert::Copy,        SNAPSHOT_FIELD(autopilot_engaged) },
+    { "sim/flightmodel/engine/ENGN_running",            false, RrefConvert::Copy,        SNAPSHOT_FIELD(engines_running) },
+    { "sim/cockpit2/controls/parking_brake_ratio",      false, RrefConvert::Copy,        SNAPSHOT_FIELD(parking_brake) },
+    { "sim/weather/wind_speed_kt",                      false, RrefConvert::Copy,        SNAPSHOT_FIELD(wind_speed) },
+    { "sim/weather/wind_direction_degt",                false, RrefConvert::Copy,        SNAPSHOT_FIELD(wind_direction) },
+};
+
+const size_t kRrefDatarefCount = sizeof(kRrefDatarefs) / sizeof(kRrefDatarefs[0]);
+
+// Indexes past the rows of kRrefDatarefs, which stay below 64. Lengths are
+// the ones the Go bridge uses.
+const RrefString kRrefIdentity[] = {
+    { "sim/aircraft/view/acf_ICAO",                     128, 40 },
+    { "sim/aircraft/view/acf_tailnum",                  168, 40 },
+    { "sim/aircraft/view/acf_livery_path",              208, 256 },
+};
+
+const size_t kRrefIdentityCount = sizeof(kRrefIdentity) / sizeof(kRrefIdentity[0]);
+
+const RrefString kRrefIdentityWatch = { "sim/aircraft/view/acf_ICAO", 65, 4 };
+
+namespace {
+
+// Byte by byte, so it is right on any host; compilers turn it into one load
+inline uint32_t LoadU32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+inline float LoadF32(const uint8_t* p)
+{
+    uint32_t bits = LoadU32(p);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+inline double LoadF64(const uint8_t* p)
+{
+    uint64_t bits = (uint64_t)LoadU32(p) | (uint64_t)LoadU32(p + 4) << 32;
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+inline void StoreU32(uint8_t* p, uint32_t value)
+{
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+inline void StoreF32(uint8_t* p, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    StoreU32(p, bits);
+}
+
+inline void StoreF64(uint8_t* p, double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    StoreU32(p, (uint32_t)bits);
+    StoreU32(p + 4, (uint32_t)(bits >> 32));
+}
+
+inline void Store(char* base, uint16_t offset, FieldType type, float value)
+{
+    switch (type) {
+        case FieldType::F64: { double v = value;                   memcpy(base + offset, &v, sizeof(v)); break; }
+        case FieldType::F32: { float v = value;                    memcpy(base + offset, &v, sizeof(v)); break; }
+        case FieldType::I32: { int32_t v = (int32_t)lroundf(value); memcpy(base + offset, &v, sizeof(v)); break; }
+    }
+}
+
+} // namespace
+
+size_t BuildRrefRequest(const char* dataref, int32_t frequency, int32_t index, uint8_t* out, size_t out_size)
+{
+    size_t length = strlen(dataref);
+    if (out_size < RREF_REQUEST_SIZE || length >= RREF_NAME_SIZE) {
+        return 0;
+    }
+    memcpy(out, "RREF", 5);
+    StoreU32(out + 5, (uint32_t)frequency);
+    StoreU32(out + 9, (uint32_t)index);
+    memset(out + 13, 0, RREF_NAME_SIZE);
+    memcpy(out + 13, dataref, length);
+    return RREF_REQUEST_SIZE;
+}
+
+int RrefTable::Decode(const uint8_t* packet, size_t size)
+{
+    // The fifth byte is ',' on current versions, older ones sent 'O'
+    if (size < RREF_HEADER_SIZE || memcmp(packet, "RREF", 4) != 0) {
+        return -1;
+    }
+    const uint8_t* p = packet + RREF_HEADER_SIZE;
+    size_t pairs = (size - RREF_HEADER_SIZE) / 8;
+    for (size_t i = 0; i < pairs; i++, p += 8) {
+        uint32_t index = LoadU32(p);
+        if (index >= RREF_MAX_INDEX) {
+            continue;
+        }
+        values_[index] = LoadF32(p + 4);
+        seen_[index] = 1;
+    }
+    return (int)pairs;
+}
+
+void ApplyRrefValues(const RrefSpec* specs, size_t count, const RrefTable& table, TelemetrySnapshot& out, float& frame_period)
+{
+    char* base = (char*)&out;
+    for (size_t i = 0; i < count && i < RREF_MAX_INDEX; i++) {
+        if (!table.Seen((int32_t)i)) {
+            continue;
+        }
+        float value = table.Value((int32_t)i);
+        if (specs[i].convert == RrefConvert::FramePeriod) {
+            // Sampled at the subscription rate, so this is an average
+            // rather than per-frame statistics
+            if (value > 0.0f) {
+                frame_period = frame_period == 0.0f ? value : frame_period + 0.2f * (value - frame_period);
+            }
+            value = frame_period > 0.0f ? 1.0f / frame_period : 0.0f;
+        }
+        Store(base, specs[i].offset, specs[i].destination, value);
+    }
+}
+
+size_t BuildRrefStringRequests(const RrefString& string, RrefStringBytes bytes, const RrefTable& table, int32_t frequency, uint8_t* out, size_t out_size)
+{
+    char name[RREF_NAME_SIZE];
+    size_t count = 0;
+    for (int32_t i = 0; i < string.length && (count + 1) * RREF_REQUEST_SIZE <= out_size; i++) {
+        int32_t index = string.first_index + i;
+        bool seen = index < RREF_MAX_INDEX && table.Seen(index);
+        if (bytes == RrefStringBytes::Missing && seen && table.Value(index) == 0.0f) {
+            break;
+        }
+        if ((bytes == RrefStringBytes::Missing && seen) || (bytes == RrefStringBytes::Seen && !seen)) {
+            continue;
+        }
+        snprintf(name, sizeof(name), "%s[%d]", string.name, (int)i);
+        if (BuildRrefRequest(name, frequency, string.first_index + i, out + count * RREF_REQUEST_SIZE, RREF_REQUEST_SIZE) == 0) {
+            break;
+        }
+        count++;
+    }
+    return count;
+}
+
+bool ReadRrefString(const RrefString& string, const RrefTable& table, char* out, size_t out_size)
+{
+    size_t length = 0;
+    for (int32_t i = 0; i < string.length; i++) {
+        int32_t index = string.first_index + i;
+        if (index >= RREF_MAX_INDEX || !table.Seen(index)) {
+            return false;
+        }
+        int byte = (int)table.Value(index);
+        if (byte == 0) {
+            break;
+        }
+        if (length + 1 < out_size) {
+            out[length++] = (char)byte;
+        }
+    }
+    if (out_size > 0) {
+        out[length] = '\0';
+    }
+    return true;
+}
+
+void ForgetRrefString(const RrefString& string, RrefTable& table)
+{
+    for (int32_t i = 0; i < string.length && string.first_index + i < RREF_MAX_INDEX; i++) {
+        table.Forget(string.first_index + i);
+    }
+}
+
+size_t BuildRposRequest(int rate_hz, uint8_t* out, size_t out_size)
+{
+    char rate[16];
+    int length = snprintf(rate, sizeof(rate), "%d", rate_hz > 0 ? rate_hz : 0);
+    if (out_size < 5 + (size_t)length + 1) {
+        return 0;
+    }
+    memcpy(out, "RPOS", 5);
+    memcpy(out + 5, rate, (size_t)length + 1);
+    return 5 + (size_t)length + 1;
+}
+
+bool ParseRpos(const uint8_t* packet, size_t size, RposPacket& out)
+{
+    if (size < RPOS_PACKET_SIZE || memcmp(packet, "RPOS", 4) != 0) {
+        return false;
+    }
+    const uint8_t* p = packet + 5;
+    out.longitude = LoadF64(p);
+    out.latitude = LoadF64(p + 8);
+    out.elevation = LoadF64(p + 16);
+    float* floats = &out.agl;
+    for (int i = 0; i < 10; i++) {
+        floats[i] = LoadF32(p + 24 + i * 4);
+    }
+    return true;
+}
+
+size_t BuildRposPacket(const RposPacket& rpos, uint8_t* out, size_t out_size)
+{
+    if (out_size < RPOS_PACKET_SIZE) {
+        return 0;
+    }
+    memcpy(out, "RPOS4", 5);
+    StoreF64(out + 5, rpos.longitude);
+    StoreF64(out + 13, rpos.latitude);
+    StoreF64(out + 21, rpos.elevation);
+    const float* floats = &rpos.agl;
+    for (int i = 0; i < 10; i++) {
+        StoreF32(out + 29 + i * 4, floats[i]);
+    }
+    return RPOS_PACKET_SIZE;
+}
+
+void ApplyRpos(const RposPacket& rpos, TelemetrySnapshot& out)
+{
+    out.latitude = rpos.latitude;
+    out.longitude = rpos.longitude;
+    out.altitude_amsl = rpos.elevation;
+    out.altitude_agl = rpos.agl;
+    out.pitch = rpos.pitch;
+    out.bank = rpos.roll;
+    out.heading_true = rpos.heading;
+    out.ground_speed = sqrtf(rpos.vx * rpos.vx + rpos.vz * rpos.vz);
+    out.vertical_speed = rpos.vy * 60.0f * (float)METERS_TO_FT;
+}
+
+size_t BuildDselRequest(const int32_t* groups, size_t count, bool select, uint8_t* out, size_t out_size)
+{
+    if (out_size < 5 + count * 4) {
+        return 0;
+    }
+    memcpy(out, select ? "DSEL" : "USEL", 5);
+    for (size_t i = 0; i < count; i++) {
+        StoreU32(out + 5 + i * 4, (uint32_t)groups[i]);
+    }
+    return 5 + count * 4;
+}
+
+int ApplyDataPacket(const uint8_t* packet, size_t size, TelemetrySnapshot& out)
+{
+    if (size < 5 || memcmp(packet, "DATA", 4) != 0) {
+        return -1;
+    }
+    int records = 0;
+    for (const uint8_t* p = packet + 5; p + DATA_RECORD_SIZE <= packet + size; p += DATA_RECORD_SIZE, records++) {
+        float v[8];
+        for (int i = 0; i < 8; i++) {
+            v[i] = LoadF32(p + 4 + i * 4);
+        }
+        switch (LoadU32(p)) {
+            case DATA_GROUP_SPEEDS:
+                out.ground_speed = v[3] / (float)MPS_TO_KNOTS;
+                break;
+            case DATA_GROUP_VVI:
+                out.vertical_speed = v[2];
+                break;
+            case DATA_GROUP_ATTITUDE:
+                out.pitch = v[0];
+                out.bank = v[1];
+                out.heading_true = v[2];
+                break;
+            case DATA_GROUP_POSITION:
+                out.latitude = v[0];
+                out.longitude = v[1];
+                out.altitude_amsl = v[2] / METERS_TO_FT;
+                out.altitude_agl = v[3] / METERS_TO_FT;
+                break;
+            default:
+                break;
+        }
+    }
+    return records;
+}
+
+size_t AppendDataRecord(int32_t group, const float values[8], uint8_t* out, size_t out_size)
+{
+    if (out_size < DATA_RECORD_SIZE) {
+        return 0;
+    }
+    StoreU32(out, (uint32_t)group);
+    for (int i = 0; i < 8; i++) {
+        StoreF32(out + 4 + i * 4, values[i]);
+    }
+    return DATA_RECORD_SIZE;
+}
+
+bool ParseBeacon(const uint8_t* packet, size_t size, XPlaneBeacon& out)
+{
+    if (size < 21 || memcmp(packet, "BECN", 5) != 0) {
+        return false;
+    }
+    out.major = packet[5];
+    out.minor = packet[6];
+    out.host_id = (int32_t)LoadU32(packet + 7);
+    out.version = (int32_t)LoadU32(packet + 11);
+    out.role = LoadU32(packet + 15);
+    out.port = (uint16_t)(packet[19] | packet[20] << 8);
+    const char* name = (const char*)packet + 21;
+    out.hostname.assign(name, strnlen(name, size - 21));
+    return out.major == 1 && out.minor <= 2 && out.host_id == 1;
+}
+
+size_t BuildBeacon(const XPlaneBeacon& beacon, uint8_t* out, size_t out_size)
+{
+    size_t size = 21 + beacon.hostname.size() + 1;
+    if (out_size < size) {
+        return 0;
+    }
+    memcpy(out, "BECN", 5);
+    out[5] = beacon.major;
+    out[6] = beacon.minor;
+    StoreU32(out + 7, (uint32_t)beacon.host_id);
+    StoreU32(out + 11, (uint32_t)beacon.version);
+    StoreU32(out + 15, beacon.role);
+    out[19] = (uint8_t)beacon.port;
+    out[20] = (uint8_t)(beacon.port >> 8);
+    memcpy(out + 21, beacon.hostname.c_str(), beacon.hostname.size() + 1);
+    return size;
+}
@@ -0,0 +1,186 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "Telemetry.h"
+
+// The parts of X-Plane's UDP data protocol the native bridge uses. All
+// integers and floats are little endian, as X-Plane sends them.
+//
+//   "RREF\0" int32 freq, int32 index, char[400] dataref    subscribe, freq 0 stops
+//   "RREF,"  { int32 index, float value }...             X-Plane's answer
+//   "RPOS\0" rate as NUL terminated text, "0" stops      ask for RPOS packets
+//   "RPOS4"  RposPacket                                  position and attitude
+//   "DSEL\0" int32 group...                              select DATA output groups
+//   "USEL\0" int32 group...                              unselect them
+//   "DATA*"  { int32 group, float[8] }...                 the selected groups
+//   "BECN\0" see ParseBeacon                             multicast discovery
+//
+// The index of a subscription is ours to pick and comes back with every
+// value. The bridge uses its row in a table like kRrefDatarefs, so decoding
+// a packet is a store into a flat array per value and nothing is looked up
+// by name after subscribing.
+//
+// RPOS carries everything that changes every frame (position, attitude,
+// velocity) in one fixed 64 byte struct, with latitude, longitude and
+// elevation as doubles. DATA carries the same fields as floats, at the rate
+// set in X-Plane's Data Output screen. Either one replaces the RREF rows
+// marked `position`; the slow rest still comes by RREF.
+
+#define XPLANE_UDP_PORT 49000
+#define XPLANE_BEACON_GROUP "239.255.1.1"
+#define XPLANE_BEACON_PORT 49707
+
+#define RREF_NAME_SIZE 400
+#define RREF_REQUEST_SIZE (5 + 4 + 4 + RREF_NAME_SIZE)
+#define RREF_HEADER_SIZE 5
+#define RREF_MAX_VALUES 183         // pairs in one 1472 byte datagram
+#define RREF_MAX_INDEX 1024         // subscription indexes an RrefTable holds
+
+// What a subscribed float turns into
+enum class RrefConvert : uint8_t {
+    Copy,           // into the snapshot field, converted to its type
+    FramePeriod,    // seconds per frame, smoothed into fps
+};
+
+struct RrefSpec {
+    const char* name;
+    bool        position;           // also in RPOS and DATA
+    RrefConvert convert;
+    FieldType   destination;
+    uint16_t    offset;             // into TelemetrySnapshot
+};
+
+// The datarefs the Go bridge subscribes, row number = subscription index
+extern const RrefSpec kRrefDatarefs[];
+extern const size_t kRrefDatarefCount;
+
+// An RREF subscription request. Returns its size, or 0 if `out` is too small
+// or the name too long.
+size_t BuildRrefRequest(const char* dataref, int32_t frequency, int32_t index, uint8_t* out, size_t out_size);
+
+// The latest value of every subscription index
+class RrefTable {
+public:
+    // Stores every pair of one "RREF," packet. Returns the number of pairs,
+    // or -1 if the packet isn't an RREF answer. Pairs whose index is outside
+    // the table are skipped.
+    int Decode(const uint8_t* packet, size_t size);
+
+    float Value(int32_t index) const { return values_[index]; }
+    bool  Seen(int32_t index) const { return seen_[index] != 0; }
+    void  Forget(int32_t index) { values_[index] = 0.0f; seen_[index] = 0; }
+
+private:
+    float   values_[RREF_MAX_INDEX] = {};
+    uint8_t seen_[RREF_MAX_INDEX] = {};
+};
+
+// Copies rows [0, count) of `specs` from the table into `out`, indexes
+// being rows. Rows nothing arrived for yet leave their field alone.
+// `frame_period` carries the smoothed frame period between calls.
+void ApplyRrefValues(const RrefSpec* specs, size_t count, const RrefTable& table, TelemetrySnapshot& out, float& frame_period);
+
+// String datarefs (byte arrays such as acf_ICAO) come over RREF one byte
+// per subscription, "name[i]" sent as a float. A fetch subscribes every
+// byte in one burst at consecutive indexes, reads the string out of the
+// RrefTable as soon as everything up to the NUL arrived, and unsubscribes.
+struct RrefString {
+    const char* name;
+    int32_t     first_index;
+    int32_t     length;             // bytes subscribed
+};
+
+// The identity the bridge sends in AIRCRAFT_UPDATE, fetched on a change
+#define RREF_IDENTITY_ICAO 0
+#define RREF_IDENTITY_TAILNUM 1
+#define RREF_IDENTITY_LIVERY 2
+extern const RrefString kRrefIdentity[];
+extern const size_t kRrefIdentityCount;
+
+// Subscribed all the time at 1 Hz, five values instead of the Go bridge's
+// hundreds: the first bytes of acf_ICAO and the livery index. Either one
+// changing means a new aircraft or livery.
+extern const RrefString kRrefIdentityWatch;
+#define RREF_LIVERY_INDEX_DATAREF "sim/aircraft/view/acf_livery_index"
+#define RREF_LIVERY_INDEX 64
+
+// Which bytes BuildRrefStringRequests asks for. A burst of hundreds of
+// requests can overflow X-Plane's receive buffer, so a fetch asks again for
+// what is missing and unsubscribes bytes that still come after it ended.
+enum class RrefStringBytes : uint8_t {
+    All,
+    Missing,        // not in the table, up to the first NUL that is
+    Seen,           // in the table
+};
+
+// Requests for the `bytes` of `string`, RREF_REQUEST_SIZE apart in `out`.
+// Returns how many fit.
+size_t BuildRrefStringRequests(const RrefString& string, RrefStringBytes bytes, const RrefTable& table, int32_t frequency, uint8_t* out, size_t out_size);
+
+// True once every byte up to the first NUL (or all `length` of them) has
+// arrived, with the text copied to `out` (NUL terminated, truncated to fit)
+bool ReadRrefString(const RrefString& string, const RrefTable& table, char* out, size_t out_size);
+
+// So the next fetch waits for fresh bytes
+void ForgetRrefString(const RrefString& string, RrefTable& table);
+
+#define RPOS_PACKET_SIZE (5 + 64)
+#define DATA_RECORD_SIZE 36
+
+// The RPOS payload, packed, after the 5 byte header. Velocities are in
+// X-Plane's local OpenGL frame: x east, y up, z south.
+struct RposPacket {
+    double longitude;               // degrees
+    double latitude;                // degrees
+    double elevation;               // meters MSL
+    float  agl;                     // meters
+    float  pitch;                   // degrees
+    float  heading;                 // degrees true
+    float  roll;                    // degrees
+    float  vx, vy, vz;              // m/s
+    float  p, q, r;                 // rad/s
+};
+
+size_t BuildRposRequest(int rate_hz, uint8_t* out, size_t out_size);
+bool   ParseRpos(const uint8_t* packet, size_t size, RposPacket& out);
+size_t BuildRposPacket(const RposPacket& rpos, uint8_t* out, size_t out_size);
+
+// The `position` fields from RPOS: ground speed is the horizontal velocity
+// (m/s, like the groundspeed dataref), vertical speed its y in feet/minute
+void ApplyRpos(const RposPacket& rpos, TelemetrySnapshot& out);
+
+// DATA groups with `position` fields: 3 speeds (ground speed in knots is
+// converted to m/s), 4 Mach/VVI/g, 17 pitch/roll/heading, 20 lat/lon/alt
+#define DATA_GROUP_SPEEDS 3
+#define DATA_GROUP_VVI 4
+#define DATA_GROUP_ATTITUDE 17
+#define DATA_GROUP_POSITION 20
+
+// DSEL, or USEL when `select` is false
+size_t BuildDselRequest(const int32_t* groups, size_t count, bool select, uint8_t* out, size_t out_size);
+
+// Applies the groups above from one DATA packet and ignores the others.
+// Returns the records read, or -1 if it isn't a DATA packet.
+int ApplyDataPacket(const uint8_t* packet, size_t size, TelemetrySnapshot& out);
+
+// One DATA record into `out`, for stand-ins; returns 0 if `out` is too small
+size_t AppendDataRecord(int32_t group, const float values[8], uint8_t* out, size_t out_size);
+
+// What X-Plane multicasts about itself once a second
+struct XPlaneBeacon {
+    uint8_t     major;
+    uint8_t     minor;
+    int32_t     host_id;            // 1 = X-Plane, 2 = PlaneMaker
+    int32_t     version;            // e.g. 120320
+    uint32_t    role;               // 1 master, 2 extern visual, 3 IOS
+    uint16_t    port;               // where it takes RREF requests
+    std::string hostname;
+};
+
+// "BECN\0" u8 major, u8 minor, i32 host id, i32 version, u32 role, u16 port,
+// NUL terminated hostname. False unless it is a beacon version 1.0 to 1.2
+// from X-Plane itself.
+bool ParseBeacon(const uint8_t* packet, size_t size, XPlaneBeacon& out);
+size_t BuildBeacon(const XPlaneBeacon& beacon, uint8_t* out, size_t out_size);
@@ -0,0 +1,802 @@
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+#include "Config.h"
+#include "Connection.h"
+#include "Registration.h"
+#include "Socket.h"
+#include "Telemetry.h"
+#include "XPlaneUdp.h"
+
+#ifdef __linux__
+    #include <ifaddrs.h>
+    #include <net/if.h>
+#endif
+
+// Native version of the Go bridge in ../src: subscribes the same datarefs
+// over RREF and sends POSITION_UPDATE to Volanta, no plugin needed.
+//
+//   udpbridge [--xplane ADDR:PORT] [--volanta ADDR:PORT] [--rate HZ]
+//             [--position rref|rpos|data] [--cache FILE | --no-cache]
+//             [--seconds S] [--stats S]
+//
+// Without --xplane it finds X-Plane by its multicast beacon and, like the
+// Go bridge, doesn't wait for one at startup: the last X-Plane that
+// answered is kept in --cache (by default openvolanta-udpbridge.ini in the
+// user's cache directory) and subscribed right away, with a version probe
+// to confirm it is there. The beacon socket stays open the whole time; a
+// beacon from another address or port while the current X-Plane is silent
+// moves the subscriptions over, and a silent X-Plane is subscribed again
+// every few seconds, which picks up a restart at the same address.
+//
+// Each RREF value lands in a flat array at its subscription
+// index; positions are built from that array and serialized at --rate.
+// Receiving is one recvmmsg call per batch of datagrams on Linux. Every
+// --stats seconds (and at exit) it prints packets/s and decode ns/value.
+//
+// --position rpos asks for RPOS packets at --rate and --position data
+// selects the DATA groups with the same fields (sent at the rate set in
+// X-Plane's Data Output screen), so position and attitude come in one
+// datagram each. The rows RPOS and DATA cover are then not subscribed and
+// the rest comes by RREF at no more than 10 Hz.
+//
+// AIRCRAFT_UPDATE is sent whenever the first bytes of acf_ICAO or the
+// livery index change: every byte of the ICAO, tail number and livery path
+// is subscribed in one burst, the strings are read from the table as soon
+// as they are complete and the bytes unsubscribed again, so it takes one
+// round trip. The registration comes from the livery folder name, else the
+// tail number.
+
+namespace {
+
+#define BRIDGE_DEFAULT_RATE 10      // Hz, both the subscription and the sends
+#define BRIDGE_RECV_BATCH 64        // datagrams per recvmmsg
+#define BRIDGE_PACKET_SIZE 2048
+#define BRIDGE_PROBE_MS 500         // cached X-Plane, before saying it didn't answer
+#define BRIDGE_STALE_MS 2000        // nothing received: subscribe again, or switch
+#define BRIDGE_PROBE_INDEX 69       // past the identity watch
+#define BRIDGE_PROBE_DATAREF "sim/version/xplane_internal_version"
+#define BRIDGE_CACHE_FILE "openvolanta-udpbridge.ini"
+#define BRIDGE_SLOW_RATE 10         // Hz, RREF rows besides RPOS or DATA
+#define BRIDGE_SEND_BATCH 64        // datagrams per sendmmsg
+#define BRIDGE_WATCH_RATE 1         // Hz, kRrefIdentityWatch
+#define BRIDGE_FETCH_RATE 30        // Hz, identity bytes until they all arrived
+#define BRIDGE_FETCH_RESEND_MS 100  // asks again for bytes that didn't come
+#define BRIDGE_FETCH_TIMEOUT_MS 3000
+#define BRIDGE_FETCH_RETRY_MS 5000
+#define BRIDGE_IDENTITY_BYTES 336   // bytes of all kRrefIdentity strings
+
+// Where position and attitude come from
+enum class PositionSource {
+    Rref,
+    Rpos,
+    Data,
+};
+
+const int32_t kDataGroups[] = { DATA_GROUP_SPEEDS, DATA_GROUP_VVI, DATA_GROUP_ATTITUDE, DATA_GROUP_POSITION };
+
+const TelemetrySource kTelemetrySource = { "xp12", "12.320" };
+
+volatile sig_atomic_t gStop = 0;
+
+void OnSignal(int)
+{
+    gStop = 1;
+}
+
+void LogLine(const char* line)
+{
+    fputs(line, stderr);
+}
+
+void Log(const char* format, ...)
+{
+    char line[512];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    LogLine(line);
+}
+
+int64_t NanosecondsNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool ParseEndpoint(const char* text, sockaddr_in& addr)
+{
+    const char* colon = strrchr(text, ':');
+    std::string host = colon != nullptr ? std::string(text, (size_t)(colon - text)) : std::string("127.0.0.1");
+    int port = atoi(colon != nullptr ? colon + 1 : text);
+    addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    return port > 0 && port < 65536 && inet_pton(AF_INET, host.c_str(), &addr.sin_addr) == 1;
+}
+
+// Joins the beacon group on every multicast capable interface. The socket
+// stays open while the bridge runs.
+socket_t OpenBeaconSocket()
+{
+    socket_t sock = socket(AF_INET, SOCK_DGRAM, 0);
+    int one = 1;
+    sockaddr_in bind_addr = {};
+    bind_addr.sin_family = AF_INET;
+    bind_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    bind_addr.sin_port = htons(XPLANE_BEACON_PORT);
+    if (sock == SOCKET_INVALID
+        || setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (const char*)&one, sizeof(one)) != 0
+        || bind(sock, (sockaddr*)&bind_addr, sizeof(bind_addr)) != 0
+        || !SetNonBlocking(sock)) {
+        Log("could not listen for beacons on port %d\n", XPLANE_BEACON_PORT);
+        CloseSocket(sock);
+        return SOCKET_INVALID;
+    }
+    ip_mreq membership = {};
+    inet_pton(AF_INET, XPLANE_BEACON_GROUP, &membership.imr_multiaddr);
+    int joined = 0;
+#ifdef __linux__
+    ifaddrs* interfaces = nullptr;
+    if (getifaddrs(&interfaces) == 0) {
+        for (ifaddrs* i = interfaces; i != nullptr; i = i->ifa_next) {
+            if (i->ifa_addr == nullptr || i->ifa_addr->sa_family != AF_INET
+                || !(i->ifa_flags & IFF_UP) || !(i->ifa_flags & IFF_MULTICAST)) {
+                continue;
+            }
+            membership.imr_interface = ((sockaddr_in*)i->ifa_addr)->sin_addr;
+            joined += setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, (const char*)&membership, sizeof(membership)) == 0;
+        }
+        freeifaddrs(interfaces);
+    }
+#endif
+    if (joined == 0) {
+        membership.imr_interface.s_addr = htonl(INADDR_ANY);
+        joined += setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, (const char*)&membership, sizeof(membership)) == 0;
+    }
+    if (joined == 0) {
+        Log("could not join the beacon group on any interface\n");
+        CloseSocket(sock);
+        return SOCKET_INVALID;
+    }
+    return sock;
+}
+
+// The last valid beacon waiting on the socket, with `xplane` set to where
+// its RREF port is
+bool ReadBeacons(socket_t sock, sockaddr_in& xplane, XPlaneBeacon& beacon)
+{
+    uint8_t packet[BRIDGE_PACKET_SIZE];
+    bool found = false;
+    for (;;) {
+        sockaddr_in sender = {};
+        socklen_t length = sizeof(sender);
+        long size = (long)recvfrom(sock, (char*)packet, sizeof(packet), 0, (sockaddr*)&sender, &length);
+        if (size < 0) {
+            return found;
+        }
+        if (ParseBeacon(packet, (size_t)size, beacon)) {
+            xplane = sender;
+            xplane.sin_port = htons(beacon.port);
+            found = true;
+        }
+    }
+}
+
+bool SameEndpoint(const sockaddr_in& a, const sockaddr_in& b)
+{
+    return a.sin_addr.s_addr == b.sin_addr.s_addr && a.sin_port == b.sin_port;
+}
+
+// The last X-Plane that answered, as `key = value` lines ConfigFile reads
+struct DiscoveryCache {
+    sockaddr_in xplane = {};
+    int32_t     version = 0;
+    std::string hostname;
+};
+
+std::string DefaultCachePath()
+{
+    const char* xdg = getenv("XDG_CACHE_HOME");
+    const char* home = getenv("HOME");
+    std::filesystem::path dir;
+    if (xdg != nullptr && xdg[0] != '\0') {
+        dir = xdg;
+    }
+    else if (home != nullptr && home[0] != '\0') {
+        dir = std::filesystem::path(home) / ".cache";
+    }
+    return (dir / BRIDGE_CACHE_FILE).string();
+}
+
+bool LoadDiscoveryCache(const std::string& path, DiscoveryCache& cache)
+{
+    ConfigFile file;
+    if (path.empty() || !file.Load(path.c_str())) {
+        return false;
+    }
+    std::string endpoint = std::string(file.GetString("host", "")) + ":" + file.GetString("port", "");
+    cache.version = (int32_t)file.GetNumber("version", 0.0);
+    cache.hostname = file.GetString("hostname", "");
+    return ParseEndpoint(endpoint.c_str(), cache.xplane);
+}
+
+// Written next to the old file and renamed over it, so a crash mid-write
+// leaves the previous one
+void SaveDiscoveryCache(const std::string& path, const DiscoveryCache& cache)
+{
+    if (path.empty()) {
+        return;
+    }
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+    std::string temporary = path + ".tmp";
+    FILE* file = fopen(temporary.c_str(), "w");
+    if (file == nullptr) {
+        Log("could not write %s\n", temporary.c_str());
+        return;
+    }
+    char host[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &cache.xplane.sin_addr, host, sizeof(host));
+    fprintf(file, "# Last X-Plane udpbridge talked to, tried first at startup\n");
+    fprintf(file, "host = %s\nport = %u\nversion = %d\nhostname = %s\n", host, (unsigned)ntohs(cache.xplane.sin_port), (int)cache.version, cache.hostname.c_str());
+    bool written = fclose(file) == 0;
+    std::filesystem::rename(temporary, path, error);
+    if (!written || error) {
+        Log("could not write %s\n", path.c_str());
+    }
+}
+
+struct BridgeCounters {
+    uint64_t packets = 0;
+    uint64_t bytes = 0;
+    uint64_t other_packets = 0;     // neither RREF nor the position source
+    uint64_t recv_calls = 0;
+    uint64_t values = 0;
+    uint64_t decode_ns = 0;
+    uint64_t position_packets = 0;  // RPOS or DATA
+    uint64_t position_ns = 0;
+    uint64_t positions = 0;
+};
+
+// Subscribes every row, or stops them with frequency 0. With RPOS or DATA
+// the rows they carry are left out and the rest is sent at `slow_frequency`.
+void Subscribe(socket_t sock, const sockaddr_in& xplane, PositionSource source, int32_t frequency, int32_t slow_frequency)
+{
+    uint8_t request[RREF_REQUEST_SIZE];
+    for (size_t i = 0; i < kRrefDatarefCount; i++) {
+        if (source != PositionSource::Rref && kRrefDatarefs[i].position) {
+            continue;
+        }
+        int32_t rate = source == PositionSource::Rref ? frequency : slow_frequency;
+        size_t size = BuildRrefRequest(kRrefDatarefs[i].name, rate, (int32_t)i, request, sizeof(request));
+        sendto(sock, (const char*)request, size, 0, (const sockaddr*)&xplane, sizeof(xplane));
+    }
+    size_t size = 0;
+    if (source == PositionSource::Rpos) {
+        size = BuildRposRequest(frequency, request, sizeof(request));
+    }
+    else if (source == PositionSource::Data) {
+        size = BuildDselRequest(kDataGroups, sizeof(kDataGroups) / sizeof(kDataGroups[0]), frequency > 0, request, sizeof(request));
+    }
+    if (size > 0) {
+        sendto(sock, (const char*)request, size, 0, (const sockaddr*)&xplane, sizeof(xplane));
+    }
+}
+
+// Requests laid out RREF_REQUEST_SIZE apart, in as few calls as possible
+void SendRequests(socket_t sock, const sockaddr_in& xplane, const uint8_t* requests, size_t count)
+{
+#ifdef __linux__
+    for (size_t at = 0; at < count; ) {
+        struct mmsghdr messages[BRIDGE_SEND_BATCH];
+        struct iovec vectors[BRIDGE_SEND_BATCH];
+        size_t batch = std::min(count - at, (size_t)BRIDGE_SEND_BATCH);
+        for (size_t i = 0; i < batch; i++) {
+            vectors[i] = { (void*)(requests + (at + i) * RREF_REQUEST_SIZE), RREF_REQUEST_SIZE };
+            messages[i] = {};
+            messages[i].msg_hdr.msg_name = (void*)&xplane;
+            messages[i].msg_hdr.msg_namelen = sizeof(xplane);
+            messages[i].msg_hdr.msg_iov = &vectors[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+        int sent = sendmmsg(sock, messages, (unsigned)batch, 0);
+        if (sent <= 0) {
+            return;
+        }
+        at += (size_t)sent;
+    }
+#else
+    for (size_t i = 0; i < count; i++) {
+        sendto(sock, (const char*)requests + i * RREF_REQUEST_SIZE, RREF_REQUEST_SIZE, 0, (const sockaddr*)&xplane, sizeof(xplane));
+    }
+#endif
+}
+
+void SubscribeIdentityWatch(socket_t sock, const sockaddr_in& xplane, const RrefTable& table, int32_t frequency)
+{
+    uint8_t requests[8 * RREF_REQUEST_SIZE];
+    size_t count = BuildRrefStringRequests(kRrefIdentityWatch, RrefStringBytes::All, table, frequency, requests, sizeof(requests));
+    count += BuildRrefRequest(RREF_LIVERY_INDEX_DATAREF, frequency, RREF_LIVERY_INDEX, requests + count * RREF_REQUEST_SIZE, RREF_REQUEST_SIZE) > 0;
+    SendRequests(sock, xplane, requests, count);
+}
+
+// The `bytes` of every identity string in one burst. Returns the requests.
+size_t SubscribeIdentity(socket_t sock, const sockaddr_in& xplane, RrefStringBytes bytes, const RrefTable& table, int32_t frequency)
+{
+    static uint8_t requests[BRIDGE_IDENTITY_BYTES * RREF_REQUEST_SIZE];
+    size_t count = 0;
+    for (size_t i = 0; i < kRrefIdentityCount; i++) {
+        count += BuildRrefStringRequests(kRrefIdentity[i], bytes, table, frequency,
+            requests + count * RREF_REQUEST_SIZE, sizeof(requests) - count * RREF_REQUEST_SIZE);
+    }
+    SendRequests(sock, xplane, requests, count);
+    return count;
+}
+
+void ForgetIdentity(RrefTable& table)
+{
+    for (size_t i = 0; i < kRrefIdentityCount; i++) {
+        ForgetRrefString(kRrefIdentity[i], table);
+    }
+}
+
+struct IdentityFetch {
+    char    watched[64] = "";       // ICAO prefix and livery index last sent
+    char    pending[64] = "";       // the same, for the fetch under way
+    bool    fetching = false;
+    int64_t started_ns = 0;
+    int64_t requested_ns = 0;       // last burst, during a fetch or after it
+    int64_t retry_ns = 0;
+    size_t  resent = 0;             // requests asked again in this fetch
+    char    json[TELEMETRY_MAX_MESSAGE];
+    size_t  json_length = 0;        // last AIRCRAFT_UPDATE, again on reconnect
+};
+
+// Starts a fetch when the watched values change and finishes it once every
+// string is complete, or gives up after BRIDGE_FETCH_TIMEOUT_MS
+void UpdateIdentity(IdentityFetch& fetch, socket_t sock, const sockaddr_in& xplane, RrefTable& table, Connection& volanta, int64_t now_ns)
+{
+    bool resend = now_ns - fetch.requested_ns >= (int64_t)BRIDGE_FETCH_RESEND_MS * 1000000;
+    if (!fetch.fetching) {
+        // Bytes whose unsubscribe got lost
+        if (resend && SubscribeIdentity(sock, xplane, RrefStringBytes::Seen, table, 0) > 0) {
+            ForgetIdentity(table);
+            fetch.requested_ns = now_ns;
+        }
+        char prefix[8];
+        if (!ReadRrefString(kRrefIdentityWatch, table, prefix, sizeof(prefix)) || !table.Seen(RREF_LIVERY_INDEX) || now_ns < fetch.retry_ns) {
+            return;
+        }
+        snprintf(fetch.pending, sizeof(fetch.pending), "%s/%d", prefix, (int)table.Value(RREF_LIVERY_INDEX));
+        if (strcmp(fetch.pending, fetch.watched) == 0) {
+            return;
+        }
+        ForgetIdentity(table);
+        SubscribeIdentity(sock, xplane, RrefStringBytes::All, table, BRIDGE_FETCH_RATE);
+        fetch.fetching = true;
+        fetch.started_ns = now_ns;
+        fetch.requested_ns = now_ns;
+        fetch.resent = 0;
+        return;
+    }
+
+    char icao[64], tailnum[64], livery[300];
+    bool complete = ReadRrefString(kRrefIdentity[RREF_IDENTITY_ICAO], table, icao, sizeof(icao))
+        && ReadRrefString(kRrefIdentity[RREF_IDENTITY_TAILNUM], table, tailnum, sizeof(tailnum))
+        && ReadRrefString(kRrefIdentity[RREF_IDENTITY_LIVERY], table, livery, sizeof(livery));
+    if (!complete && now_ns - fetch.started_ns < (int64_t)BRIDGE_FETCH_TIMEOUT_MS * 1000000) {
+        if (resend) {
+            fetch.resent += SubscribeIdentity(sock, xplane, RrefStringBytes::Missing, table, BRIDGE_FETCH_RATE);
+            fetch.requested_ns = now_ns;
+        }
+        return;
+    }
+    SubscribeIdentity(sock, xplane, RrefStringBytes::All, table, 0);
+    ForgetIdentity(table);
+    fetch.fetching = false;
+    fetch.requested_ns = now_ns;
+    if (!complete) {
+        Log("Aircraft identity incomplete after %d ms, trying again\n", BRIDGE_FETCH_TIMEOUT_MS);
+        fetch.retry_ns = now_ns + (int64_t)BRIDGE_FETCH_RETRY_MS * 1000000;
+        return;
+    }
+    snprintf(fetch.watched, sizeof(fetch.watched), "%s", fetch.pending);
+
+    char registration[64];
+    if (!FindRegistration(LiveryFolderName(livery), registration, sizeof(registration))) {
+        snprintf(registration, sizeof(registration), "%s", tailnum);
+    }
+    const AircraftInfo aircraft = { "", icao, icao, registration, "" };
+    fetch.json_length = SerializeAircraftUpdate(aircraft, fetch.json, sizeof(fetch.json));
+    Log("Aircraft %s %s (livery \"%s\"), fetched in %.1f ms, %zu bytes asked again\n",
+        icao, registration, livery, (double)(now_ns - fetch.started_ns) * 1e-6, fetch.resent);
+    if (fetch.json_length > 0 && volanta.IsConnected()) {
+        volanta.Send(fetch.json, fetch.json_length);
+    }
+}
+
+// RPOS and DATA go straight into the snapshot; the RREF rows for the same
+// fields aren't subscribed, so nothing overwrites them
+bool ApplyPositionPacket(PositionSource source, const uint8_t* packet, size_t size, TelemetrySnapshot& snapshot)
+{
+    if (source == PositionSource::Rpos) {
+        RposPacket rpos;
+        if (!ParseRpos(packet, size, rpos)) {
+            return false;
+        }
+        ApplyRpos(rpos, snapshot);
+        return true;
+    }
+    return source == PositionSource::Data && ApplyDataPacket(packet, size, snapshot) >= 0;
+}
+
+// Everything that is waiting on the socket, in as few calls as possible.
+// Only what comes from `xplane` counts; after a switch the old one may still
+// be sending.
+void ReceiveAll(socket_t sock, const sockaddr_in& xplane, PositionSource source, RrefTable& table, TelemetrySnapshot& snapshot, BridgeCounters& counters)
+{
+    static uint8_t packets[BRIDGE_RECV_BATCH][BRIDGE_PACKET_SIZE];
+    size_t sizes[BRIDGE_RECV_BATCH];
+    sockaddr_in senders[BRIDGE_RECV_BATCH];
+    for (;;) {
+        int received = 0;
+#ifdef __linux__
+        struct mmsghdr messages[BRIDGE_RECV_BATCH];
+        struct iovec vectors[BRIDGE_RECV_BATCH];
+        for (int i = 0; i < BRIDGE_RECV_BATCH; i++) {
+            vectors[i] = { packets[i], BRIDGE_PACKET_SIZE };
+            messages[i] = {};
+            messages[i].msg_hdr.msg_name = &senders[i];
+            messages[i].msg_hdr.msg_namelen = sizeof(senders[i]);
+            messages[i].msg_hdr.msg_iov = &vectors[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+        received = recvmmsg(sock, messages, BRIDGE_RECV_BATCH, MSG_DONTWAIT, NULL);
+        for (int i = 0; i < received; i++) {
+            sizes[i] = messages[i].msg_len;
+        }
+#else
+        while (received < BRIDGE_RECV_BATCH) {
+            socklen_t length = sizeof(senders[received]);
+            long size = (long)recvfrom(sock, (char*)packets[received], BRIDGE_PACKET_SIZE, 0, (sockaddr*)&senders[received], &length);
+            if (size < 0) {
+                break;
+            }
+            sizes[received++] = (size_t)size;
+        }
+#endif
+        if (received <= 0) {
+            return;
+        }
+        counters.recv_calls++;
+
+        for (int i = 0; i < received; i++) {
+            if (!SameEndpoint(senders[i], xplane)) {
+                counters.other_packets++;
+                continue;
+            }
+            int64_t start_ns = NanosecondsNow();
+            int values = table.Decode(packets[i], sizes[i]);
+            if (values >= 0) {
+                counters.values += (uint64_t)values;
+                counters.decode_ns += (uint64_t)(NanosecondsNow() - start_ns);
+            }
+            else if (ApplyPositionPacket(source, packets[i], sizes[i], snapshot)) {
+                counters.position_packets++;
+                counters.position_ns += (uint64_t)(NanosecondsNow() - start_ns);
+            }
+            else {
+                counters.other_packets++;
+            }
+            counters.bytes += sizes[i];
+        }
+        counters.packets += (uint64_t)received;
+        if (received < BRIDGE_RECV_BATCH) {
+            return;
+        }
+    }
+}
+
+void PrintStats(const char* label, const BridgeCounters& now, const BridgeCounters& then, double seconds, const Connection& volanta)
+{
+    uint64_t packets = now.packets - then.packets;
+    uint64_t values = now.values - then.values;
+    uint64_t calls = now.recv_calls - then.recv_calls;
+    uint64_t position_packets = now.position_packets - then.position_packets;
+    char position[96] = "";
+    if (position_packets > 0) {
+        snprintf(position, sizeof(position), ", %.0f RPOS/DATA packets/s at %.0f ns/packet",
+            seconds > 0.0 ? (double)position_packets / seconds : 0.0,
+            (double)(now.position_ns - then.position_ns) / (double)position_packets);
+    }
+    Log("%s: %.0f packets/s (%.1f per recv call), %.0f bytes/s, %.0f values/s, decode %.2f ns/value%s, %llu positions sent, %llu dropped\n",
+        label,
+        seconds > 0.0 ? (double)packets / seconds : 0.0,
+        calls > 0 ? (double)packets / (double)calls : 0.0,
+        seconds > 0.0 ? (double)(now.bytes - then.bytes) / seconds : 0.0,
+        seconds > 0.0 ? (double)values / seconds : 0.0,
+        values > 0 ? (double)(now.decode_ns - then.decode_ns) / (double)values : 0.0,
+        position,
+        (unsigned long long)(now.positions - then.positions),
+        (unsigned long long)volanta.Counters().messages_dropped);
+}
+
+void SubscribeProbe(socket_t sock, const sockaddr_in& xplane, int32_t frequency)
+{
+    uint8_t request[RREF_REQUEST_SIZE];
+    size_t size = BuildRrefRequest(BRIDGE_PROBE_DATAREF, frequency, BRIDGE_PROBE_INDEX, request, sizeof(request));
+    sendto(sock, (const char*)request, size, 0, (const sockaddr*)&xplane, sizeof(xplane));
+}
+
+// The X-Plane the subscriptions go to
+struct XPlaneSession {
+    sockaddr_in xplane = {};
+    bool        active = false;
+    bool        answered = false;   // the version probe came back
+    bool        silent = false;     // said so in the log
+    int64_t     started_ns = 0;
+    int64_t     data_ns = 0;        // last packet from it, or the start
+    int64_t     retry_ns = 0;       // subscribe again no earlier than this
+    uint64_t    packets = 0;        // counters.packets - other_packets then
+};
+
+void StopSession(XPlaneSession& session, socket_t sock, PositionSource source, const RrefTable& table, const IdentityFetch& identity)
+{
+    if (!session.active) {
+        return;
+    }
+    Subscribe(sock, session.xplane, source, 0, 0);
+    SubscribeIdentityWatch(sock, session.xplane, table, 0);
+    if (identity.fetching) {
+        SubscribeIdentity(sock, session.xplane, RrefStringBytes::All, table, 0);
+    }
+    if (!session.answered) {
+        SubscribeProbe(sock, session.xplane, 0);
+    }
+    session.active = false;
+}
+
+// Everything subscribed at `xplane` from scratch, the aircraft fetched again
+void StartSession(XPlaneSession& session, const sockaddr_in& xplane, socket_t sock, PositionSource source, int32_t frequency,
+    RrefTable& table, IdentityFetch& identity, float& frame_period, int64_t now_ns)
+{
+    table = RrefTable();
+    identity = IdentityFetch();
+    frame_period = 0.0f;
+    session.xplane = xplane;
+    session.active = true;
+    session.answered = false;
+    session.silent = false;
+    session.started_ns = now_ns;
+    session.data_ns = now_ns;
+    session.retry_ns = 0;
+    Subscribe(sock, xplane, source, frequency, std::min(frequency, BRIDGE_SLOW_RATE));
+    SubscribeIdentityWatch(sock, xplane, table, BRIDGE_WATCH_RATE);
+    SubscribeProbe(sock, xplane, BRIDGE_FETCH_RATE);
+}
+
+std::string EndpointText(const sockaddr_in& addr)
+{
+    char host[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &addr.sin_addr, host, sizeof(host));
+    return std::string(host) + ":" + std::to_string(ntohs(addr.sin_port));
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const char* xplane_at = nullptr;
+    const char* volanta_at = "127.0.0.1:6746";
+    double rate = BRIDGE_DEFAULT_RATE;
+    double seconds = 0.0;
+    double stats_s = 10.0;
+    PositionSource source = PositionSource::Rref;
+    std::string cache_path = DefaultCachePath();
+    bool ok = true;
+    for (int i = 1; i < argc && ok; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--xplane") == 0 && has_value) {
+            xplane_at = argv[++i];
+        }
+        else if (strcmp(argv[i], "--volanta") == 0 && has_value) {
+            volanta_at = argv[++i];
+        }
+        else if (strcmp(argv[i], "--rate") == 0 && has_value) {
+            rate = atof(argv[++i]);
+            ok = rate > 0.0;
+        }
+        else if (strcmp(argv[i], "--position") == 0 && has_value) {
+            const char* name = argv[++i];
+            if (strcmp(name, "rref") == 0) {
+                source = PositionSource::Rref;
+            }
+            else if (strcmp(name, "rpos") == 0) {
+                source = PositionSource::Rpos;
+            }
+            else if (strcmp(name, "data") == 0) {
+                source = PositionSource::Data;
+            }
+            else {
+                ok = false;
+            }
+        }
+        else if (strcmp(argv[i], "--cache") == 0 && has_value) {
+            cache_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--no-cache") == 0) {
+            cache_path.clear();
+        }
+        else if (strcmp(argv[i], "--seconds") == 0 && has_value) {
+            seconds = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--stats") == 0 && has_value) {
+            stats_s = atof(argv[++i]);
+        }
+        else {
+            ok = false;
+        }
+    }
+    sockaddr_in volanta_addr;
+    sockaddr_in xplane = {};
+    if (!ok || !ParseEndpoint(volanta_at, volanta_addr) || (xplane_at != nullptr && !ParseEndpoint(xplane_at, xplane))) {
+        fprintf(stderr, "usage: %s [--xplane ADDR:PORT] [--volanta ADDR:PORT] [--rate HZ] [--position rref|rpos|data] [--cache FILE | --no-cache] [--seconds S] [--stats S]\n", argv[0]);
+        return 2;
+    }
+
+    SocketStartup();
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+
+    int64_t start_ns = NanosecondsNow();
+    socket_t sock = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    int buffer_bytes = 1 << 20;
+    if (sock == SOCKET_INVALID || bind(sock, (sockaddr*)&local, sizeof(local)) != 0 || !SetNonBlocking(sock)) {
+        Log("could not open a UDP socket\n");
+        return 1;
+    }
+    // Room for bursts while the loop is busy sending
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (const char*)&buffer_bytes, sizeof(buffer_bytes));
+    int32_t frequency = (int32_t)(rate + 0.5);
+
+    // With --xplane there is nothing to discover or remember
+    bool discover = xplane_at == nullptr;
+    socket_t beacon_sock = discover ? OpenBeaconSocket() : SOCKET_INVALID;
+    DiscoveryCache cache;
+    bool cached = discover && LoadDiscoveryCache(cache_path, cache);
+    if (cached) {
+        xplane = cache.xplane;
+        Log("Trying X-Plane %d at %s (%s) from %s\n", (int)cache.version, EndpointText(xplane).c_str(), cache.hostname.c_str(), cache_path.c_str());
+    }
+    else if (discover) {
+        Log("Looking for X-Plane...\n");
+    }
+
+    char volanta_host[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &volanta_addr.sin_addr, volanta_host, sizeof(volanta_host));
+    ConnectionConfig config;
+    config.host = volanta_host;
+    config.port = ntohs(volanta_addr.sin_port);
+    config.log = LogLine;
+    Connection volanta(config);
+
+    RrefTable table;
+    TelemetrySnapshot snapshot = {};
+    float frame_period = 0.0f;
+    IdentityFetch identity;
+    XPlaneSession session;
+    if (!discover || cached) {
+        StartSession(session, xplane, sock, source, frequency, table, identity, frame_period, NanosecondsNow());
+    }
+    BridgeCounters counters, reported;
+    char json[TELEMETRY_MAX_MESSAGE];
+    int64_t period_ns = (int64_t)(1e9 / rate);
+    int64_t next_send_ns = start_ns + period_ns;
+    int64_t next_stats_ns = start_ns + (int64_t)(stats_s * 1e9);
+    int64_t reported_ns = start_ns;
+    Log("Bridge running, forwarding to %s\n", volanta_at);
+
+    while (!gStop && (seconds <= 0.0 || NanosecondsNow() - start_ns < (int64_t)(seconds * 1e9))) {
+        auto now = Connection::Clock::now();
+        int64_t now_ns = NanosecondsNow();
+        int timeout_ms = next_send_ns > now_ns ? (int)((next_send_ns - now_ns) / 1000000) : 0;
+        timeout_ms = std::min(timeout_ms, volanta.PollTimeoutMs(now, 100));
+
+        struct pollfd fds[3] = { { sock, POLLIN, 0 }, { beacon_sock, POLLIN, 0 } };
+        size_t count = beacon_sock != SOCKET_INVALID ? 2 : 1;
+        size_t volanta_at_fd = count;
+        count += volanta.PreparePoll(fds[volanta_at_fd]) ? 1 : 0;
+        PollSockets(fds, count, timeout_ms);
+        if (fds[0].revents & POLLIN) {
+            ReceiveAll(sock, session.xplane, source, table, snapshot, counters);
+        }
+        now = Connection::Clock::now();
+        volanta.Update(now, count > volanta_at_fd ? fds[volanta_at_fd].revents : 0);
+
+        now_ns = NanosecondsNow();
+        uint64_t packets = counters.packets - counters.other_packets;
+        if (packets != session.packets) {
+            session.packets = packets;
+            session.data_ns = now_ns;
+            session.silent = false;
+        }
+        // A beacon only takes over from an X-Plane that never answered or
+        // has gone quiet, so two of them on one network don't take turns
+        XPlaneBeacon beacon;
+        if (beacon_sock != SOCKET_INVALID && (fds[1].revents & POLLIN) && ReadBeacons(beacon_sock, xplane, beacon)
+            && (!session.active || (!SameEndpoint(xplane, session.xplane)
+                && (!session.answered || now_ns - session.data_ns >= (int64_t)BRIDGE_STALE_MS * 1000000)))) {
+            Log("Found X-Plane %d at %s (%s)\n", beacon.version, EndpointText(xplane).c_str(), beacon.hostname.c_str());
+            StopSession(session, sock, source, table, identity);
+            StartSession(session, xplane, sock, source, frequency, table, identity, frame_period, now_ns);
+            cache.hostname = beacon.hostname;
+        }
+        if (session.active && !session.answered && table.Seen(BRIDGE_PROBE_INDEX)) {
+            session.answered = true;
+            SubscribeProbe(sock, session.xplane, 0);
+            int32_t version = (int32_t)table.Value(BRIDGE_PROBE_INDEX);
+            Log("X-Plane %d at %s answered %.1f ms after start\n", (int)version, EndpointText(session.xplane).c_str(), (double)(now_ns - start_ns) * 1e-6);
+            if (discover && (!SameEndpoint(cache.xplane, session.xplane) || cache.version != version || !cached)) {
+                cache.xplane = session.xplane;
+                cache.version = version;
+                cached = true;
+                SaveDiscoveryCache(cache_path, cache);
+            }
+        }
+        // Subscriptions don't survive an X-Plane restart, and the cached one
+        // may not be there at all
+        if (session.active && now_ns >= session.retry_ns
+            && now_ns - session.data_ns >= (int64_t)(session.answered ? BRIDGE_STALE_MS : BRIDGE_PROBE_MS) * 1000000) {
+            if (!session.silent) {
+                Log("No answer from X-Plane at %s, %s\n", EndpointText(session.xplane).c_str(),
+                    discover ? "subscribing again and waiting for beacons" : "subscribing again");
+            }
+            int64_t data_ns = session.data_ns;
+            StartSession(session, session.xplane, sock, source, frequency, table, identity, frame_period, now_ns);
+            session.data_ns = data_ns;
+            session.silent = true;
+            session.retry_ns = now_ns + (int64_t)BRIDGE_STALE_MS * 1000000;
+        }
+        if (volanta.TakeJustConnected() && identity.json_length > 0) {
+            volanta.Send(identity.json, identity.json_length);
+        }
+        if (session.active) {
+            UpdateIdentity(identity, sock, session.xplane, table, volanta, now_ns);
+        }
+        if (now_ns >= next_send_ns) {
+            // A late loop doesn't make up for the sends it missed
+            next_send_ns = std::max(next_send_ns + period_ns, now_ns);
+            ApplyRrefValues(kRrefDatarefs, kRrefDatarefCount, table, snapshot, frame_period);
+            if (counters.values + counters.position_packets > 0 && volanta.IsConnected()) {
+                size_t length = SerializePositionUpdate(snapshot, kTelemetrySource, json, sizeof(json));
+                if (length > 0 && volanta.Send(json, length)) {
+                    counters.positions++;
+                }
+                volanta.Flush(now);
+            }
+        }
+        if (stats_s > 0.0 && now_ns >= next_stats_ns) {
+            PrintStats("last interval", counters, reported, (double)(now_ns - reported_ns) * 1e-9, volanta);
+            reported = counters;
+            reported_ns = now_ns;
+            next_stats_ns = now_ns + (int64_t)(stats_s * 1e9);
+        }
+    }
+
+    StopSession(session, sock, source, table, identity);
+    CloseSocket(sock);
+    CloseSocket(beacon_sock);
+    PrintStats("total", counters, BridgeCounters(), (double)(NanosecondsNow() - start_ns) * 1e-9, volanta);
+    SocketCleanup();
+    return 0;
+}
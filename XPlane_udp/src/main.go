@@ -6,10 +6,16 @@ import (
 	"encoding/binary"
 	"encoding/json"
 	"fmt"
+	"errors"
 	"log"
 	"net"
+	"os"
+	"path/filepath"
 	"regexp"
+	"strconv"
+	"strings"
 	"sync"
+	"sync/atomic"
 	"syscall"
 	"time"
 
@@ -23,6 +29,18 @@ const (
 	VOLANTA_TCP_ADDR   = "127.0.0.1:6746"
 	METERS_TO_FT       = 3.28084
 	UPDATE_FREQ        = 10 // Hz
+	PROBE_DATAREF      = "sim/version/xplane_internal_version"
+	PROBE_WAIT         = 500 * time.Millisecond      // cached X-Plane, before saying it didn't answer
+	STALE_AFTER        = 2 * time.Second             // nothing received: subscribe again, or switch
+	CACHE_FILE         = "openvolanta-udpbridge.ini" // same file as the native bridge
+	LIVERY_DATAREF     = "sim/aircraft/view/acf_livery_index"
+	STRING_INDEX_BASE  = 1000                        // identity bytes, past anything AddDataRef hands out
+	STRING_BYTES       = 336                         // bytes of all identityStrings
+	FETCH_FREQ         = 30                          // Hz, identity bytes until they all arrived
+	FETCH_POLL         = 10 * time.Millisecond       // how soon a complete identity is noticed
+	FETCH_RESEND       = 100 * time.Millisecond      // asks again for bytes that didn't come
+	FETCH_TIMEOUT      = 3 * time.Second
+	FETCH_RETRY        = 5 * time.Second
 )
 
 // Errors
@@ -41,14 +59,25 @@ type BeaconData struct {
 	Role          int
 }
 
+// At reports whether the beacon came from `addr`.
+func (b BeaconData) At(addr *net.UDPAddr) bool {
+	return addr != nil && addr.IP.Equal(net.ParseIP(b.IP)) && addr.Port == b.Port
+}
+
 // XPlaneUdp handles communication with X-Plane.
 type XPlaneUdp struct {
 	socket       *net.UDPConn
 	destAddr     *net.UDPAddr
+	addrMutex    sync.RWMutex // Protects destAddr and BeaconData
 	datarefIdx   int
 	datarefs     map[int]string
+	datarefFreqs map[int]int // Sent again to a new or restarted X-Plane
 	xplaneValues map[string]float32
-	valuesMutex  sync.RWMutex // Protects xplaneValues
+	stringValues [STRING_BYTES]float32 // identity bytes, by index - STRING_INDEX_BASE
+	stringSeen   [STRING_BYTES]bool
+	valuesMutex  sync.RWMutex // Protects xplaneValues, datarefs, datarefFreqs and the identity bytes
+	lastData     atomic.Int64 // UnixNano of the last RREF packet from destAddr
+	generation   atomic.Int32 // Bumped whenever destAddr changes
 	BeaconData   BeaconData
 	defaultFreq  int
 }
@@ -57,31 +86,99 @@ type XPlaneUdp struct {
 func NewXPlaneUdp() *XPlaneUdp {
 	return &XPlaneUdp{
 		datarefs:     make(map[int]string),
+		datarefFreqs: make(map[int]int),
 		xplaneValues: make(map[string]float32),
 		defaultFreq:  UPDATE_FREQ,
 	}
 }
 
-// InitSocket initializes the main UDP socket for communication.
+// InitSocket initializes the main UDP socket for communication. Datarefs can
+// be added before X-Plane is known; SetXPlane subscribes them.
 func (xp *XPlaneUdp) InitSocket() error {
-	if xp.BeaconData.IP == "" {
-		return fmt.Errorf("beacon data not available, run FindIp first")
-	}
-
 	var err error
-	xp.destAddr, err = net.ResolveUDPAddr("udp", fmt.Sprintf("%s:%d", xp.BeaconData.IP, xp.BeaconData.Port))
+	xp.socket, err = net.ListenUDP("udp", nil) // Listen on a random ephemeral port
 	if err != nil {
-		return fmt.Errorf("could not resolve x-plane address: %w", err)
+		return fmt.Errorf("could not listen on udp port: %w", err)
 	}
 
-	xp.socket, err = net.ListenUDP("udp", nil) // Listen on a random ephemeral port
+	return nil
+}
+
+// SetXPlane moves every subscription to the X-Plane in `beacon`: the previous
+// one is unsubscribed, its values are dropped, and everything is subscribed
+// again at the new address.
+func (xp *XPlaneUdp) SetXPlane(beacon BeaconData) error {
+	addr, err := net.ResolveUDPAddr("udp", fmt.Sprintf("%s:%d", beacon.IP, beacon.Port))
 	if err != nil {
-		return fmt.Errorf("could not listen on udp port: %w", err)
+		return fmt.Errorf("could not resolve x-plane address: %w", err)
 	}
 
+	xp.sendAll(false)
+	xp.addrMutex.Lock()
+	xp.destAddr = addr
+	xp.BeaconData = beacon
+	xp.addrMutex.Unlock()
+
+	xp.valuesMutex.Lock()
+	xp.xplaneValues = make(map[string]float32)
+	xp.stringSeen = [STRING_BYTES]bool{}
+	xp.valuesMutex.Unlock()
+	xp.lastData.Store(time.Now().UnixNano())
+	xp.generation.Add(1)
+	xp.sendAll(true)
 	return nil
 }
 
+// Destination returns where subscriptions currently go, nil before X-Plane is known.
+func (xp *XPlaneUdp) Destination() *net.UDPAddr {
+	xp.addrMutex.RLock()
+	defer xp.addrMutex.RUnlock()
+	return xp.destAddr
+}
+
+// XPlane returns the beacon data of the current X-Plane.
+func (xp *XPlaneUdp) XPlane() BeaconData {
+	xp.addrMutex.RLock()
+	defer xp.addrMutex.RUnlock()
+	return xp.BeaconData
+}
+
+// SinceData returns how long the current X-Plane has been silent.
+func (xp *XPlaneUdp) SinceData() time.Duration {
+	return time.Since(time.Unix(0, xp.lastData.Load()))
+}
+
+// Resubscribe sends every subscription again; X-Plane forgets them when it restarts.
+func (xp *XPlaneUdp) Resubscribe() {
+	xp.sendAll(true)
+}
+
+// sendAll subscribes, or unsubscribes, every dataref at the current X-Plane.
+func (xp *XPlaneUdp) sendAll(subscribe bool) {
+	type subscription struct {
+		dataref string
+		freq    int
+		idx     int
+	}
+
+	xp.valuesMutex.RLock()
+	subscriptions := make([]subscription, 0, len(xp.datarefs))
+	for idx, dataref := range xp.datarefs {
+		freq := 0
+		if subscribe {
+			freq = xp.datarefFreqs[idx]
+		}
+		subscriptions = append(subscriptions, subscription{dataref, freq, idx})
+	}
+	xp.valuesMutex.RUnlock()
+
+	for _, s := range subscriptions {
+		if err := xp.sendRref(s.dataref, s.freq, s.idx); err != nil {
+			log.Printf("Failed to subscribe to %s: %v", s.dataref, err)
+		}
+	}
+}
+
 // Close unsubscribes from all datarefs and closes the socket.
 func (xp *XPlaneUdp) Close() {
 	if xp.socket == nil {
@@ -98,12 +195,14 @@ func (xp *XPlaneUdp) Close() {
 			log.Printf("Warning: failed to unsubscribe from dataref %s: %v", dataref, err)
 		}
 	}
+	xp.SubscribeStrings(allBytes, 0)
 	xp.socket.Close()
 	log.Println("Connection closed.")
 }
 
-// FindIp finds the IP of an X-Plane Host by replicating the Python script's low-level socket logic.
-func (xp *XPlaneUdp) FindIp() (BeaconData, error) {
+// OpenBeaconSocket joins the X-Plane beacon group on every multicast capable
+// interface, replicating the Python script's low-level socket logic.
+func OpenBeaconSocket() (net.PacketConn, error) {
 	lc := net.ListenConfig{
 		Control: func(network, address string, c syscall.RawConn) error {
 			var soErr error
@@ -119,16 +218,16 @@ func (xp *XPlaneUdp) FindIp() (BeaconData, error) {
 
 	conn, err := lc.ListenPacket(context.Background(), "udp4", fmt.Sprintf("0.0.0.0:%d", MCAST_PORT))
 	if err != nil {
-		return BeaconData{}, fmt.Errorf("failed to listen on udp port with ListenConfig: %w", err)
+		return nil, fmt.Errorf("failed to listen on udp port with ListenConfig: %w", err)
 	}
-	defer conn.Close()
 
 	p := ipv4.NewPacketConn(conn)
 	group := net.ParseIP(MCAST_GRP)
 
 	ifaces, err := net.Interfaces()
 	if err != nil {
-		return BeaconData{}, fmt.Errorf("could not get interfaces: %w", err)
+		conn.Close()
+		return nil, fmt.Errorf("could not get interfaces: %w", err)
 	}
 
 	var joinedAny bool
@@ -145,24 +244,43 @@ func (xp *XPlaneUdp) FindIp() (BeaconData, error) {
 	}
 
 	if !joinedAny {
-		return BeaconData{}, fmt.Errorf("failed to join multicast group on any viable interface")
-	}
-
-	if err := conn.SetReadDeadline(time.Now().Add(5 * time.Second)); err != nil {
-		return BeaconData{}, err
+		conn.Close()
+		return nil, fmt.Errorf("failed to join multicast group on any viable interface")
 	}
+	return conn, nil
+}
 
+// WatchBeacons passes every valid beacon on `conn` to `found` until the socket
+// is closed. X-Plane sends one a second, so a beacon arriving while `found` is
+// full can just be dropped.
+func WatchBeacons(conn net.PacketConn, found chan<- BeaconData) {
 	buf := make([]byte, 2048)
-	n, sender, err := conn.ReadFrom(buf)
-	if err != nil {
-		if netErr, ok := err.(net.Error); ok && netErr.Timeout() {
-			return BeaconData{}, ErrXPlaneIpNotFound
+	for {
+		n, sender, err := conn.ReadFrom(buf)
+		if err != nil {
+			if errors.Is(err, net.ErrClosed) {
+				return
+			}
+			log.Printf("Error reading beacon packet: %v", err)
+			time.Sleep(1 * time.Second)
+			continue
+		}
+
+		beacon, err := ParseBeacon(buf[:n], sender)
+		if err != nil {
+			log.Printf("Ignoring beacon: %v", err)
+			continue
+		}
+		select {
+		case found <- beacon:
+		default:
 		}
-		return BeaconData{}, fmt.Errorf("error reading beacon packet: %w", err)
 	}
+}
 
-	packet := buf[:n]
-	if !bytes.HasPrefix(packet, []byte("BECN\x00")) {
+// ParseBeacon decodes a BECN packet received from `sender`.
+func ParseBeacon(packet []byte, sender net.Addr) (BeaconData, error) {
+	if len(packet) < 21 || !bytes.HasPrefix(packet, []byte("BECN\x00")) {
 		return BeaconData{}, fmt.Errorf("received non-beacon packet from %v", sender)
 	}
 
@@ -197,22 +315,84 @@ func (xp *XPlaneUdp) FindIp() (BeaconData, error) {
 		return BeaconData{}, fmt.Errorf("sender address is not a UDP address")
 	}
 
-	xp.BeaconData = BeaconData{
+	return BeaconData{
 		IP:            senderUDPAddr.IP.String(),
 		Port:          int(beacon.Port),
 		Hostname:      hostname,
 		XPlaneVersion: int(beacon.VersionNumber),
 		Role:          int(beacon.Role),
+	}, nil
+}
+
+// CachePath is where the last X-Plane that answered is kept, or "" if there
+// is no cache directory.
+func CachePath() string {
+	dir, err := os.UserCacheDir()
+	if err != nil {
+		return ""
 	}
-	return xp.BeaconData, nil
+	return filepath.Join(dir, CACHE_FILE)
 }
 
-// AddDataRef requests X-Plane to send a dataref at a given frequency.
+// LoadDiscoveryCache reads the `key = value` file SaveDiscoveryCache writes.
+func LoadDiscoveryCache(path string) (BeaconData, bool) {
+	if path == "" {
+		return BeaconData{}, false
+	}
+	data, err := os.ReadFile(path)
+	if err != nil {
+		return BeaconData{}, false
+	}
+
+	var beacon BeaconData
+	for _, line := range strings.Split(string(data), "\n") {
+		key, value, ok := strings.Cut(line, "=")
+		key = strings.TrimSpace(key)
+		if !ok || key == "" || key[0] == '#' || key[0] == ';' {
+			continue
+		}
+		value = strings.TrimSpace(value)
+		switch key {
+		case "host":
+			beacon.IP = value
+		case "port":
+			beacon.Port, _ = strconv.Atoi(value)
+		case "version":
+			beacon.XPlaneVersion, _ = strconv.Atoi(value)
+		case "hostname":
+			beacon.Hostname = value
+		}
+	}
+	return beacon, beacon.IP != "" && beacon.Port > 0
+}
+
+// SaveDiscoveryCache writes next to the old file and renames over it, so a
+// crash mid-write leaves the previous one.
+func SaveDiscoveryCache(path string, beacon BeaconData) {
+	if path == "" {
+		return
+	}
+	os.MkdirAll(filepath.Dir(path), 0755)
+	text := fmt.Sprintf("# Last X-Plane the UDP bridge talked to, tried first at startup\nhost = %s\nport = %d\nversion = %d\nhostname = %s\n",
+		beacon.IP, beacon.Port, beacon.XPlaneVersion, beacon.Hostname)
+	temporary := path + ".tmp"
+	if err := os.WriteFile(temporary, []byte(text), 0644); err != nil {
+		log.Printf("Could not write %s: %v", temporary, err)
+		return
+	}
+	if err := os.Rename(temporary, path); err != nil {
+		log.Printf("Could not write %s: %v", path, err)
+	}
+}
+
+// AddDataRef requests X-Plane to send a dataref at a given frequency. Before
+// X-Plane is known the subscription is only recorded.
 func (xp *XPlaneUdp) AddDataRef(dataref string, freq int) error {
 	if xp.socket == nil {
 		return fmt.Errorf("socket not initialized, call InitSocket first")
 	}
 
+	xp.valuesMutex.Lock()
 	idx := -9999
 	for k, v := range xp.datarefs {
 		if v == dataref {
@@ -223,16 +403,29 @@ func (xp *XPlaneUdp) AddDataRef(dataref string, freq int) error {
 
 	if idx != -9999 {
 		if freq == 0 {
-			xp.valuesMutex.Lock()
 			delete(xp.xplaneValues, dataref)
-			xp.valuesMutex.Unlock()
 			delete(xp.datarefs, idx)
+			delete(xp.datarefFreqs, idx)
+		} else {
+			xp.datarefFreqs[idx] = freq
 		}
 	} else if freq > 0 {
 		idx = xp.datarefIdx
 		xp.datarefs[xp.datarefIdx] = dataref
+		xp.datarefFreqs[xp.datarefIdx] = freq
 		xp.datarefIdx++
 	}
+	xp.valuesMutex.Unlock()
+
+	return xp.sendRref(dataref, freq, idx)
+}
+
+// sendRref sends one RREF request to the current X-Plane, if there is one.
+func (xp *XPlaneUdp) sendRref(dataref string, freq int, idx int) error {
+	dest := xp.Destination()
+	if dest == nil {
+		return nil
+	}
 
 	buf := new(bytes.Buffer)
 	buf.Write([]byte("RREF\x00"))
@@ -243,7 +436,7 @@ func (xp *XPlaneUdp) AddDataRef(dataref string, freq int) error {
 	copy(datarefBytes, dataref)
 	buf.Write(datarefBytes)
 
-	if _, err := xp.socket.WriteTo(buf.Bytes(), xp.destAddr); err != nil {
+	if _, err := xp.socket.WriteTo(buf.Bytes(), dest); err != nil {
 		return fmt.Errorf("failed to send RREF command: %w", err)
 	}
 	return nil
@@ -259,7 +452,7 @@ func (xp *XPlaneUdp) Listen() {
 		}
 		
 		xp.socket.SetReadDeadline(time.Now().Add(5 * time.Second))
-		n, _, err := xp.socket.ReadFromUDP(buf)
+		n, sender, err := xp.socket.ReadFromUDP(buf)
 		if err != nil {
 			if netErr, ok := err.(net.Error); ok && netErr.Timeout() {
 				// Timeout is expected if no data, just loop
@@ -269,8 +462,14 @@ func (xp *XPlaneUdp) Listen() {
 			continue
 		}
 
+		// A previous X-Plane may still be sending to us
+		if dest := xp.Destination(); dest == nil || !sender.IP.Equal(dest.IP) || sender.Port != dest.Port {
+			continue
+		}
+
 		data := buf[:n]
 		if bytes.HasPrefix(data, []byte("RREF,")) {
+			xp.lastData.Store(time.Now().UnixNano())
 			valuesData := data[5:]
 			lenValue := 8
 			numValues := len(valuesData) / lenValue
@@ -285,7 +484,10 @@ func (xp *XPlaneUdp) Listen() {
 				binary.Read(r, binary.LittleEndian, &idx)
 				binary.Read(r, binary.LittleEndian, &value)
 
-				if name, ok := xp.datarefs[int(idx)]; ok {
+				if at := int(idx) - STRING_INDEX_BASE; at >= 0 && at < STRING_BYTES {
+					xp.stringValues[at] = value
+					xp.stringSeen[at] = true
+				} else if name, ok := xp.datarefs[int(idx)]; ok {
 					if value < 0.0 && value > -0.001 {
 						value = 0.0
 					}
@@ -305,155 +507,241 @@ func (xp *XPlaneUdp) GetValueSafe(dataref string) (float32, bool) {
 	return val, ok
 }
 
-// GetString fetches a string dataref by subscribing to individual byte indices.
-// It subscribes, waits for data, constructs the string, and unsubscribes.
-func (xp *XPlaneUdp) GetString(datarefBase string, length int) string {
-	// 1. Subscribe to all indices
-	// To avoid UDP packet loss/overload, we batch the subscriptions slightly or just send them.
-	// X-Plane handles bursts reasonably well.
-	for i := 0; i < length; i++ {
-		dr := fmt.Sprintf("%s[%d]", datarefBase, i)
-		xp.AddDataRef(dr, 1) // 1 Hz is enough, we just need one value
-	}
+// identityString is a string dataref fetched one byte per RREF index, at
+// STRING_INDEX_BASE + first onwards.
+type identityString struct {
+	dataref string
+	first   int
+	length  int
+}
 
-	// 2. Wait for data
-	// We wait until we have a contiguous set of bytes up to a null terminator or length
-	timeout := time.After(3 * time.Second)
-	ticker := time.NewTicker(100 * time.Millisecond)
-	defer ticker.Stop()
+// Laid out back to back, so one burst covers all three
+var (
+	identityICAO    = identityString{"sim/aircraft/view/acf_ICAO", 0, 40}
+	identityTailnum = identityString{"sim/aircraft/view/acf_tailnum", 40, 40}
+	identityLivery  = identityString{"sim/aircraft/view/acf_livery_path", 80, 256}
+	identityStrings = []identityString{identityICAO, identityTailnum, identityLivery}
+)
 
-	var result []byte
-	
-	// Inner loop to check readiness
-Loop:
-	for {
-		select {
-		case <-timeout:
-			break Loop
-		case <-ticker.C:
-			currentBytes := make([]byte, 0, length)
-			complete := false
-			for i := 0; i < length; i++ {
-				dr := fmt.Sprintf("%s[%d]", datarefBase, i)
-				val, ok := xp.GetValueSafe(dr)
-				if !ok {
-					// Missing a byte, keep waiting
-					break
-				}
-				b := byte(val)
-				if b == 0 {
-					complete = true
-					break // Null terminator found
-				}
-				currentBytes = append(currentBytes, b)
-				if i == length-1 {
-					complete = true // Reached max length
-				}
+// Watched all the time: a change in either one fetches the identity
+var identityWatchRefs = []string{
+	"sim/aircraft/view/acf_ICAO[0]",
+	"sim/aircraft/view/acf_ICAO[1]",
+	"sim/aircraft/view/acf_ICAO[2]",
+	"sim/aircraft/view/acf_ICAO[3]",
+	LIVERY_DATAREF,
+}
+
+// stringBytes selects which bytes of the identity strings SubscribeStrings sends.
+type stringBytes int
+
+const (
+	allBytes     stringBytes = iota
+	missingBytes             // not arrived yet, up to the first NUL that did
+	seenBytes                // arrived, e.g. still sent after being unsubscribed
+)
+
+// SubscribeStrings sends one RREF per selected identity byte back to back,
+// built in a single buffer rather than through AddDataRef. Returns how many
+// were sent.
+func (xp *XPlaneUdp) SubscribeStrings(which stringBytes, freq int) int {
+	dest := xp.Destination()
+	if dest == nil {
+		return 0
+	}
+
+	xp.valuesMutex.RLock()
+	seen := xp.stringSeen
+	values := xp.stringValues
+	xp.valuesMutex.RUnlock()
+
+	request := make([]byte, 413)
+	copy(request, "RREF\x00")
+	binary.LittleEndian.PutUint32(request[5:], uint32(freq))
+	sent := 0
+	for _, s := range identityStrings {
+		for i := 0; i < s.length; i++ {
+			at := s.first + i
+			if which == missingBytes && seen[at] && values[at] == 0 {
+				break
+			}
+			if (which == missingBytes && seen[at]) || (which == seenBytes && !seen[at]) {
+				continue
 			}
-			if complete {
-				result = currentBytes
-				break Loop
+
+			binary.LittleEndian.PutUint32(request[9:], uint32(STRING_INDEX_BASE+at))
+			name := append(request[13:13], s.dataref...)
+			name = append(name, '[')
+			name = strconv.AppendInt(name, int64(i), 10)
+			name = append(name, ']')
+			clear(request[13+len(name):])
+			if _, err := xp.socket.WriteTo(request, dest); err != nil {
+				log.Printf("Failed to subscribe to %s[%d]: %v", s.dataref, i, err)
+				return sent
 			}
+			sent++
 		}
 	}
+	return sent
+}
 
-	// 3. Unsubscribe
-	for i := 0; i < length; i++ {
-		dr := fmt.Sprintf("%s[%d]", datarefBase, i)
-		xp.AddDataRef(dr, 0)
+// forgetStrings drops every identity byte received so far.
+func (xp *XPlaneUdp) forgetStrings() {
+	xp.valuesMutex.Lock()
+	xp.stringSeen = [STRING_BYTES]bool{}
+	xp.valuesMutex.Unlock()
+}
+
+// readString returns `s` once every byte up to its NUL, or all of them, arrived.
+func (xp *XPlaneUdp) readString(s identityString) (string, bool) {
+	xp.valuesMutex.RLock()
+	defer xp.valuesMutex.RUnlock()
+
+	text := make([]byte, 0, s.length)
+	for i := 0; i < s.length; i++ {
+		at := s.first + i
+		if !xp.stringSeen[at] {
+			return "", false
+		}
+		if xp.stringValues[at] == 0 {
+			break
+		}
+		text = append(text, byte(xp.stringValues[at]))
 	}
+	return string(text), true
+}
 
-	return string(result)
+// watchedAircraft returns the ICAO prefix and livery index as one key, once
+// all of them arrived.
+func (xp *XPlaneUdp) watchedAircraft() (string, bool) {
+	prefix := make([]byte, 0, 4)
+	for _, dr := range identityWatchRefs[:4] {
+		val, ok := xp.GetValueSafe(dr)
+		if !ok {
+			return "", false
+		}
+		if byte(val) == 0 {
+			break
+		}
+		prefix = append(prefix, byte(val))
+	}
+	livery, ok := xp.GetValueSafe(LIVERY_DATAREF)
+	if !ok {
+		return "", false
+	}
+	return fmt.Sprintf("%s/%d", prefix, int(livery)), true
 }
 
-// ManageAircraftUpdates monitors for aircraft changes and sends updates to Volanta.
+// ManageAircraftUpdates sends AIRCRAFT_UPDATE to Volanta whenever the watched
+// ICAO prefix or livery index changes. Every byte of the ICAO type, tail
+// number and livery path is subscribed in one burst at FETCH_FREQ, the strings
+// are read as soon as each one is complete up to its NUL, and then all of them
+// are unsubscribed, so a fetch takes about one X-Plane frame.
 func (xp *XPlaneUdp) ManageAircraftUpdates(volanta *VolantaClient) {
-	// We monitor ICAO changes by keeping a persistent subscription to the first few chars of ICAO.
-	// sim/aircraft/view/acf_ICAO is 40 chars max.
-	
-	// Initial subscription to ICAO trigger
-	icaoTriggerRefs := []string{
-		"sim/aircraft/view/acf_ICAO[0]",
-		"sim/aircraft/view/acf_ICAO[1]",
-		"sim/aircraft/view/acf_ICAO[2]",
-		"sim/aircraft/view/acf_ICAO[3]",
-	}
-	for _, dr := range icaoTriggerRefs {
+	for _, dr := range identityWatchRefs {
 		xp.AddDataRef(dr, 1)
 	}
 
-	var lastICAO string
-	
 	// Regex for registration extraction (ported from C++)
 	regRegex := regexp.MustCompile(`[A-Z]-[A-Z]{4}|([A-Z]|[1-9]){2}-[A-Z]{3}|N[0-9]{1,5}[A-Z]{0,2}`)
 
-	ticker := time.NewTicker(2 * time.Second)
+	var watched, pending string // key last sent, and the one being fetched
+	var fetching bool
+	var started, requested, retry, nextSend time.Time
+	var resent int
+	var generation int32
+	var update []byte // not sent yet, Volanta isn't there
+
+	ticker := time.NewTicker(FETCH_POLL)
 	defer ticker.Stop()
 
 	for range ticker.C {
-		// Reconstruct current ICAO prefix
-		currentICAOBytes := make([]byte, 0, 4)
-		for _, dr := range icaoTriggerRefs {
-			val, ok := xp.GetValueSafe(dr)
-			if ok && byte(val) != 0 {
-				currentICAOBytes = append(currentICAOBytes, byte(val))
-			}
+		now := time.Now()
+
+		// A different X-Plane gets its aircraft sent even if the key matches
+		if current := xp.generation.Load(); current != generation {
+			generation = current
+			watched = ""
+			fetching = false
+			retry = time.Time{}
 		}
-		currentICAOPrefix := string(currentICAOBytes)
-
-		// If we have some data and it looks different (or we haven't sent anything yet)
-		// Note: This is a fuzzy check. A robust check fetches the full string if the prefix changes.
-		if currentICAOPrefix != "" && currentICAOPrefix != lastICAO {
-			log.Printf("Aircraft change detected (ICAO prefix: %s). Fetching details...", currentICAOPrefix)
-			
-			// Fetch full details
-			fullICAO := xp.GetString("sim/aircraft/view/acf_ICAO", 40)
-			tailNum := xp.GetString("sim/aircraft/view/acf_tailnum", 40)
-			liveryPath := xp.GetString("sim/aircraft/view/acf_livery_path", 255)
-			
-			// Extract Registration
-			// Try Livery Path first
-			reg := ""
-			// Clean up livery path (sometimes comes with path separators)
-			// The regex searches the whole string, so path separators are fine.
-			match := regRegex.FindString(liveryPath)
-			if match != "" {
-				reg = match
+
+		if update != nil && now.After(nextSend) {
+			if err := volanta.Send(update); err != nil {
+				nextSend = now.Add(time.Second)
 			} else {
-				// Fallback to tailnum
-				reg = tailNum
+				update = nil
 			}
+		}
 
-			// Send Update
-			log.Printf("Sending Aircraft Update: ICAO=%s, Reg=%s", fullICAO, reg)
-			
-			msg := map[string]interface{}{
-				"type": "STREAM",
-				"name": "AIRCRAFT_UPDATE",
-				"data": map[string]string{
-					"title":        "",
-					"type":         fullICAO,
-					"model":        fullICAO,
-					"registration": reg,
-					"airline":      "",
-				},
+		resend := now.Sub(requested) >= FETCH_RESEND
+		if !fetching {
+			// Bytes still coming after a fetch: the unsubscribe got lost
+			if resend && xp.SubscribeStrings(seenBytes, 0) > 0 {
+				xp.forgetStrings()
+				requested = now
 			}
-			
-			jsonBytes, _ := json.Marshal(msg)
-			if err := volanta.Send(jsonBytes); err != nil {
-				log.Printf("Failed to send aircraft update: %v", err)
-			} else {
-				lastICAO = currentICAOPrefix // Update last seen only on success? or always.
-				// If fullICAO is short (e.g. 3 chars), lastICAO (prefix) might match fullICAO.
-				// We update lastICAO to the prefix we monitor.
-				if len(fullICAO) > 0 && len(fullICAO) < 4 {
-					lastICAO = fullICAO
-				} else if len(fullICAO) >= 4 {
-					lastICAO = fullICAO[:4]
-				} else {
-					lastICAO = currentICAOPrefix
-				}
+			key, ok := xp.watchedAircraft()
+			if !ok || now.Before(retry) || key == watched {
+				continue
 			}
+			log.Printf("Aircraft change detected (%s). Fetching details...", key)
+			pending = key
+			xp.forgetStrings()
+			xp.SubscribeStrings(allBytes, FETCH_FREQ)
+			fetching, started, requested, resent = true, now, now, 0
+			continue
+		}
+
+		fullICAO, okICAO := xp.readString(identityICAO)
+		tailNum, okTail := xp.readString(identityTailnum)
+		liveryPath, okLivery := xp.readString(identityLivery)
+		complete := okICAO && okTail && okLivery
+		if !complete && now.Sub(started) < FETCH_TIMEOUT {
+			if resend {
+				resent += xp.SubscribeStrings(missingBytes, FETCH_FREQ)
+				requested = now
+			}
+			continue
+		}
+
+		xp.SubscribeStrings(allBytes, 0)
+		xp.forgetStrings()
+		fetching = false
+		requested = now
+		if !complete {
+			log.Printf("Aircraft identity incomplete after %v, trying again", FETCH_TIMEOUT)
+			retry = now.Add(FETCH_RETRY)
+			continue
+		}
+		watched = pending
+
+		// The livery folder name first, then the tail number
+		reg := regRegex.FindString(liveryPath)
+		if reg == "" {
+			reg = tailNum
+		}
+		log.Printf("Sending Aircraft Update: ICAO=%s, Reg=%s (fetched in %.1f ms, %d bytes asked again)",
+			fullICAO, reg, float64(now.Sub(started).Microseconds())/1000, resent)
+
+		msg := map[string]interface{}{
+			"type": "STREAM",
+			"name": "AIRCRAFT_UPDATE",
+			"data": map[string]string{
+				"title":        "",
+				"type":         fullICAO,
+				"model":        fullICAO,
+				"registration": reg,
+				"airline":      "",
+			},
+		}
+
+		update, _ = json.Marshal(msg)
+		if err := volanta.Send(update); err != nil {
+			log.Printf("Failed to send aircraft update: %v", err)
+			nextSend = now.Add(time.Second)
+		} else {
+			update = nil
 		}
 	}
 }
@@ -487,25 +775,71 @@ func (vc *VolantaClient) Send(data []byte) error {
 	return nil
 }
 
+// xplaneSession tracks the X-Plane the subscriptions go to.
+type xplaneSession struct {
+	active   bool
+	answered bool // the version probe came back
+	silent   bool // said so in the log
+	started  time.Time
+	retry    time.Time // subscribe again no earlier than this
+}
+
+// Start subscribes everything, plus a version probe, at `beacon`.
+func (s *xplaneSession) Start(xp *XPlaneUdp, beacon BeaconData) {
+	if err := xp.SetXPlane(beacon); err != nil {
+		log.Printf("Failed to use X-Plane at %s:%d: %v", beacon.IP, beacon.Port, err)
+		return
+	}
+	xp.AddDataRef(PROBE_DATAREF, xp.defaultFreq)
+	*s = xplaneSession{active: true, started: time.Now()}
+}
+
+// Update remembers an X-Plane once its probe answers, and subscribes again
+// while it is silent: subscriptions don't survive an X-Plane restart, and the
+// cached one may not be there at all.
+func (s *xplaneSession) Update(xp *XPlaneUdp, cachePath string) {
+	if !s.answered {
+		if version, ok := xp.GetValueSafe(PROBE_DATAREF); ok {
+			s.answered = true
+			xp.AddDataRef(PROBE_DATAREF, 0)
+			beacon := xp.XPlane()
+			beacon.XPlaneVersion = int(version)
+			log.Printf("X-Plane %d at %s:%d answered %.1f ms after start", beacon.XPlaneVersion, beacon.IP, beacon.Port,
+				float64(time.Since(s.started).Microseconds())/1000)
+			SaveDiscoveryCache(cachePath, beacon)
+		}
+	}
+
+	wait := PROBE_WAIT
+	if s.answered {
+		wait = STALE_AFTER
+	}
+	if xp.SinceData() < wait {
+		s.silent = false
+		return
+	}
+	if now := time.Now(); now.After(s.retry) {
+		if !s.silent {
+			beacon := xp.XPlane()
+			log.Printf("No answer from X-Plane at %s:%d, subscribing again and waiting for beacons", beacon.IP, beacon.Port)
+		}
+		xp.Resubscribe()
+		s.silent = true
+		s.retry = now.Add(STALE_AFTER)
+	}
+}
+
 func main() {
 	log.Println("OpenVolanta UDP Bridge starting...")
 	xp := NewXPlaneUdp()
 
-	// 1. Find X-Plane
-	log.Println("Looking for X-Plane...")
-	beacon, err := xp.FindIp()
-	if err != nil {
-		log.Fatalf("Failed to find X-Plane: %v", err)
-	}
-	log.Printf("Found X-Plane at %s:%d (Hostname: %s)", beacon.IP, beacon.Port, beacon.Hostname)
-
-	// 2. Initialize UDP Socket
+	// 1. Initialize UDP Socket
 	if err := xp.InitSocket(); err != nil {
 		log.Fatalf("Failed to initialize socket: %v", err)
 	}
 	defer xp.Close()
 
-	// 3. Subscribe to DataRefs
+	// 2. Subscribe to DataRefs; they go out once X-Plane is known
 	datarefs := []string{
 		"sim/flightmodel/position/elevation", // alt_amsl
 		"sim/flightmodel/position/y_agl",     // alt_agl
@@ -523,7 +857,7 @@ func main() {
 		"sim/operation/override/override_planepath", // slew
 		"sim/time/paused",
 		"sim/operation/prefs/replay_mode",
-		"sim/graphics/view/framerate_period", // fps = 1/period
+		"sim/operation/misc/frame_rate_period", // fps = 1/period, framerate_period doesn't update
 		"sim/time/time_accel",
 		"sim/cockpit/autopilot/autopilot_mode",
 		"sim/flightmodel/engine/ENGN_running",
@@ -538,9 +872,32 @@ func main() {
 		}
 	}
 
-	// 4. Start Listening
+	// 3. Start Listening
 	go xp.Listen()
 
+	// 4. Find X-Plane. The last one that answered is subscribed straight away;
+	// the beacon socket stays open in case it isn't there, or goes away and
+	// another one starts.
+	beacons := make(chan BeaconData, 1)
+	beaconConn, err := OpenBeaconSocket()
+	if err != nil {
+		log.Printf("Not listening for X-Plane beacons: %v", err)
+	} else {
+		defer beaconConn.Close()
+		go WatchBeacons(beaconConn, beacons)
+	}
+
+	var session xplaneSession
+	cachePath := CachePath()
+	if cached, ok := LoadDiscoveryCache(cachePath); ok {
+		log.Printf("Trying X-Plane %d at %s:%d (Hostname: %s) from %s", cached.XPlaneVersion, cached.IP, cached.Port, cached.Hostname, cachePath)
+		session.Start(xp, cached)
+	} else if beaconConn == nil {
+		log.Fatalf("Failed to find X-Plane: %v", ErrXPlaneIpNotFound)
+	} else {
+		log.Println("Looking for X-Plane...")
+	}
+
 	// 5. Setup Volanta Client
 	volanta := &VolantaClient{}
 
@@ -553,7 +910,32 @@ func main() {
 
 	log.Printf("Bridge running. Forwarding data to %s", VOLANTA_TCP_ADDR)
 
-	for range ticker.C {
+	// Smoothed frame period; RREF only samples it at UPDATE_FREQ so this is
+	// an average rather than per-frame statistics
+	var framePeriod float32
+
+	for {
+		select {
+		case beacon := <-beacons:
+			// A beacon only takes over from an X-Plane that never answered or
+			// has gone quiet, so two of them on one network don't take turns
+			if !session.active || (!beacon.At(xp.Destination()) && (!session.answered || xp.SinceData() >= STALE_AFTER)) {
+				log.Printf("Found X-Plane at %s:%d (Hostname: %s)", beacon.IP, beacon.Port, beacon.Hostname)
+				session.Start(xp, beacon)
+			}
+			continue
+		case <-ticker.C:
+		}
+
+		if !session.active {
+			continue
+		}
+		session.Update(xp, cachePath)
+		// Nothing to send before the first values arrive
+		if _, ok := xp.GetValueSafe("sim/flightmodel/position/latitude"); !ok {
+			continue
+		}
+
 		// Prepare data
 		// Helper to get value or 0.0
 		val := func(name string) float32 {
@@ -579,12 +961,17 @@ func main() {
 		paused := val("sim/time/paused") > 0.5
 		replay := val("sim/operation/prefs/replay_mode") > 0.5
 		
-		// fpsPeriod := val("sim/graphics/view/framerate_period")
-		// fps := float32(0)
-		// if fpsPeriod > 0 {
-		// 	fps = 1.0 / fpsPeriod
-		// }
-		fps := 144.0 // Hardcoded as in C++ version for now
+		if period := val("sim/operation/misc/frame_rate_period"); period > 0 {
+			if framePeriod == 0 {
+				framePeriod = period
+			} else {
+				framePeriod += 0.2 * (period - framePeriod)
+			}
+		}
+		fps := float32(0)
+		if framePeriod > 0 {
+			fps = 1.0 / framePeriod
+		}
 
 		taccel := val("sim/time/time_accel")
 		ap_eng := val("sim/cockpit/autopilot/autopilot_mode") > 0
@@ -0,0 +1,773 @@
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Socket.h"
+
+// Records what plugins send to Volanta's port 6746 and plays it back.
+//
+//   capture record [--listen ADDR:PORT] [--out FILE] [--seconds S]
+//   capture replay FILE [--to ADDR:PORT] [--speed X | --max]
+//   capture info FILE
+//
+// record takes the port in Volanta's place (stop Volanta first) and writes
+// every client's whole byte stream, each recv() stamped with a monotonic
+// nanosecond clock, until Ctrl+C or --seconds. replay opens one connection
+// per recorded client and sends each message when it is due: at the recorded
+// timing, X times faster with --speed, or back to back with --max. It
+// reports how late the sends were and the throughput it got, which is what
+// the receiver at --to managed to take.
+//
+// Capture file (little endian):
+//
+//   CaptureHeader
+//   { CaptureChunk, length bytes }...     in arrival order
+//   CaptureClient[clients]                the index, written on close
+//   CaptureMessage[messages]
+//   CaptureFooter
+//
+// A chunk opens a client (its bytes are the peer address), carries data, or
+// closes it. A message is one newline terminated line of a client's stream,
+// or one top level JSON object for clients that send them back to back with
+// no delimiter (the Go UDP bridge), stamped with the chunk that completed
+// it. A capture that was killed has no footer; reading it rebuilds the index
+// from the chunks.
+
+namespace {
+
+#define CAPTURE_MAGIC "OVCAP\0\0\1"
+#define CAPTURE_INDEX_MAGIC "OVCAPIDX"
+#define CAPTURE_VERSION 1
+#define CAPTURE_RECV_SIZE (256 * 1024)
+#define CAPTURE_SEND_SIZE (64 * 1024)   // consecutive due messages are sent together up to this
+
+enum : uint8_t {
+    CHUNK_OPEN = 'O',
+    CHUNK_DATA = 'D',
+    CHUNK_CLOSE = 'C',
+};
+
+struct CaptureHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    int64_t  start_unix_ns;     // wall clock when recording started
+    uint8_t  reserved[40];
+};
+
+struct CaptureChunk {
+    uint64_t time_ns;           // since the start of the recording
+    uint32_t client;
+    uint32_t length;
+    uint8_t  kind;
+    uint8_t  reserved[7];
+};
+
+struct CaptureClient {
+    uint32_t id;
+    uint32_t reserved;
+    uint64_t open_ns;
+    uint64_t close_ns;
+    uint64_t bytes;
+    uint64_t messages;
+    char     peer[48];
+};
+
+struct CaptureMessage {
+    uint64_t time_ns;
+    uint64_t offset;            // into the client's stream
+    uint32_t client;
+    uint32_t length;            // newline included, if any
+};
+
+struct CaptureFooter {
+    uint64_t index_offset;
+    uint64_t clients;
+    uint64_t messages;
+    char     magic[8];
+};
+
+static_assert(sizeof(CaptureHeader) == 64, "CaptureHeader changed size, bump CAPTURE_VERSION");
+static_assert(sizeof(CaptureChunk) == 24, "CaptureChunk changed size, bump CAPTURE_VERSION");
+
+volatile sig_atomic_t gStop = 0;
+
+void OnSignal(int)
+{
+    gStop = 1;
+}
+
+int64_t NanosecondsNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool ParseEndpoint(const char* text, sockaddr_in& addr)
+{
+    const char* colon = strrchr(text, ':');
+    std::string host = colon != nullptr ? std::string(text, (size_t)(colon - text)) : std::string("127.0.0.1");
+    int port = atoi(colon != nullptr ? colon + 1 : text);
+    addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    return port > 0 && port < 65536 && inet_pton(AF_INET, host.c_str(), &addr.sin_addr) == 1;
+}
+
+std::string FormatEndpoint(const sockaddr_in& addr)
+{
+    char host[INET_ADDRSTRLEN] = "?";
+    inet_ntop(AF_INET, &addr.sin_addr, host, sizeof(host));
+    return std::string(host) + ":" + std::to_string(ntohs(addr.sin_port));
+}
+
+// Where a client's stream is between messages. A newline ends a message,
+// and so does the brace closing a top level JSON object; a newline straight
+// after that brace still belongs to the object's message, so newline
+// delimited streams split exactly as before.
+struct MessageSplitter {
+    uint64_t start = 0;             // of the unfinished message
+    uint32_t depth = 0;             // JSON object/array nesting
+    bool     in_string = false;
+    bool     escaped = false;
+    bool     closed = false;        // the last message ended at a brace, nothing since
+    size_t   last = 0;              // ... and is messages[last]
+};
+
+// Finds the messages completed by `size` more bytes of a client's stream
+void IndexMessages(uint32_t client, uint64_t time_ns, const char* data, size_t size, uint64_t stream_offset,
+    MessageSplitter& splitter, std::vector<CaptureMessage>& messages)
+{
+    for (size_t i = 0; i < size; i++) {
+        char c = data[i];
+        uint64_t end = stream_offset + i + 1;
+        if (c == '\n') {
+            if (splitter.closed) {
+                messages[splitter.last].length++;
+            }
+            else {
+                messages.push_back({ time_ns, splitter.start, client, (uint32_t)(end - splitter.start) });
+            }
+            splitter = MessageSplitter{ end };
+            continue;
+        }
+        splitter.closed = false;
+        if (splitter.in_string) {
+            if (splitter.escaped) {
+                splitter.escaped = false;
+            }
+            else if (c == '\\') {
+                splitter.escaped = true;
+            }
+            else if (c == '"') {
+                splitter.in_string = false;
+            }
+        }
+        else if (c == '"') {
+            splitter.in_string = true;
+        }
+        else if (c == '{' || c == '[') {
+            splitter.depth++;
+        }
+        else if ((c == '}' || c == ']') && splitter.depth > 0 && --splitter.depth == 0 && c == '}') {
+            splitter.last = messages.size();
+            messages.push_back({ time_ns, splitter.start, client, (uint32_t)(end - splitter.start) });
+            splitter.start = end;
+            splitter.closed = true;
+        }
+    }
+}
+
+// ---------------------------------------------------------------- record
+
+struct RecordingClient {
+    socket_t sock;
+    uint32_t id;
+};
+
+class CaptureWriter {
+public:
+    bool Open(const char* path)
+    {
+        file_ = fopen(path, "wb");
+        if (file_ == NULL) {
+            return false;
+        }
+        setvbuf(file_, NULL, _IOFBF, 1 << 20);
+        CaptureHeader header = {};
+        memcpy(header.magic, CAPTURE_MAGIC, sizeof(header.magic));
+        header.version = CAPTURE_VERSION;
+        header.header_size = sizeof(CaptureHeader);
+        header.start_unix_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        start_ns_ = NanosecondsNow();
+        return fwrite(&header, sizeof(header), 1, file_) == 1;
+    }
+
+    uint64_t Elapsed(int64_t now_ns) const { return (uint64_t)(now_ns - start_ns_); }
+
+    uint32_t OpenClient(const std::string& peer)
+    {
+        CaptureClient client = {};
+        client.id = (uint32_t)clients_.size();
+        client.open_ns = Elapsed(NanosecondsNow());
+        snprintf(client.peer, sizeof(client.peer), "%s", peer.c_str());
+        clients_.push_back(client);
+        splitters_.emplace_back();
+        Write(client.id, client.open_ns, CHUNK_OPEN, peer.data(), peer.size());
+        return client.id;
+    }
+
+    void Data(uint32_t id, uint64_t time_ns, const char* data, size_t size)
+    {
+        CaptureClient& client = clients_[id];
+        IndexMessages(id, time_ns, data, size, client.bytes, splitters_[id], messages_);
+        client.bytes += size;
+        Write(id, time_ns, CHUNK_DATA, data, size);
+    }
+
+    void CloseClient(uint32_t id)
+    {
+        CaptureClient& client = clients_[id];
+        client.close_ns = Elapsed(NanosecondsNow());
+        // An unterminated last message still counts as one
+        uint64_t start = splitters_[id].start;
+        if (start < client.bytes) {
+            messages_.push_back({ client.close_ns, start, id, (uint32_t)(client.bytes - start) });
+            splitters_[id].start = client.bytes;
+        }
+        Write(id, client.close_ns, CHUNK_CLOSE, nullptr, 0);
+    }
+
+    // Makes what was recorded so far survive a kill
+    void Flush() { fflush(file_); }
+
+    // Writes the index and footer
+    bool Close()
+    {
+        for (const CaptureMessage& message : messages_) {
+            clients_[message.client].messages++;
+        }
+        CaptureFooter footer = {};
+        footer.index_offset = file_bytes_ + sizeof(CaptureHeader);
+        footer.clients = clients_.size();
+        footer.messages = messages_.size();
+        memcpy(footer.magic, CAPTURE_INDEX_MAGIC, sizeof(footer.magic));
+        bool ok = fwrite(clients_.data(), sizeof(CaptureClient), clients_.size(), file_) == clients_.size()
+            && fwrite(messages_.data(), sizeof(CaptureMessage), messages_.size(), file_) == messages_.size()
+            && fwrite(&footer, sizeof(footer), 1, file_) == 1;
+        ok = fclose(file_) == 0 && ok;
+        file_ = NULL;
+        return ok;
+    }
+
+    const std::vector<CaptureClient>& Clients() const { return clients_; }
+    size_t Messages() const { return messages_.size(); }
+    uint64_t Chunks() const { return chunks_; }
+    uint64_t FileBytes() const { return file_bytes_; }
+
+private:
+    void Write(uint32_t id, uint64_t time_ns, uint8_t kind, const char* data, size_t size)
+    {
+        CaptureChunk chunk = {};
+        chunk.time_ns = time_ns;
+        chunk.client = id;
+        chunk.length = (uint32_t)size;
+        chunk.kind = kind;
+        fwrite(&chunk, sizeof(chunk), 1, file_);
+        if (size > 0) {
+            fwrite(data, 1, size, file_);
+        }
+        chunks_++;
+        file_bytes_ += sizeof(chunk) + size;
+    }
+
+    FILE*                        file_ = NULL;
+    int64_t                      start_ns_ = 0;
+    std::vector<CaptureClient>   clients_;
+    std::vector<MessageSplitter> splitters_;
+    std::vector<CaptureMessage>  messages_;
+    uint64_t                     chunks_ = 0;
+    uint64_t                     file_bytes_ = 0;
+};
+
+int Record(const char* listen_at, const char* out, double seconds)
+{
+    sockaddr_in addr;
+    if (!ParseEndpoint(listen_at, addr)) {
+        fprintf(stderr, "not an address: %s\n", listen_at);
+        return 2;
+    }
+    socket_t listener = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    if (listener == SOCKET_INVALID
+        || setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char*)&one, sizeof(one)) != 0
+        || bind(listener, (sockaddr*)&addr, sizeof(addr)) != 0
+        || listen(listener, 16) != 0) {
+        fprintf(stderr, "could not listen on %s (is Volanta still running?)\n", listen_at);
+        return 1;
+    }
+    CaptureWriter writer;
+    if (!writer.Open(out)) {
+        fprintf(stderr, "could not write %s\n", out);
+        return 1;
+    }
+    fprintf(stderr, "recording %s to %s, Ctrl+C to stop\n", listen_at, out);
+
+    std::vector<struct pollfd> fds;
+    std::vector<RecordingClient> clients;
+    std::vector<char> buffer(CAPTURE_RECV_SIZE);
+    uint64_t recvs = 0;
+    int64_t start_ns = NanosecondsNow();
+    int64_t next_flush_ns = start_ns + 1000000000;
+    while (!gStop && (seconds <= 0.0 || (double)(NanosecondsNow() - start_ns) < seconds * 1e9)) {
+        fds.resize(1 + clients.size());
+        fds[0] = { listener, POLLIN, 0 };
+        for (size_t i = 0; i < clients.size(); i++) {
+            fds[1 + i] = { clients[i].sock, POLLIN, 0 };
+        }
+        int ready = PollSockets(fds.data(), fds.size(), 100);
+        int64_t now_ns = NanosecondsNow();
+        if (now_ns >= next_flush_ns) {
+            writer.Flush();
+            next_flush_ns = now_ns + 1000000000;
+        }
+        if (ready <= 0) {
+            continue;
+        }
+        for (size_t i = clients.size(); i-- > 0;) {
+            if (fds[1 + i].revents == 0) {
+                continue;
+            }
+            long received = (long)recv(clients[i].sock, buffer.data(), buffer.size(), 0);
+            if (received > 0) {
+                writer.Data(clients[i].id, writer.Elapsed(NanosecondsNow()), buffer.data(), (size_t)received);
+                recvs++;
+                continue;
+            }
+            writer.CloseClient(clients[i].id);
+            CloseSocket(clients[i].sock);
+            clients.erase(clients.begin() + (long)i);
+        }
+        if (fds[0].revents & POLLIN) {
+            sockaddr_in peer = {};
+            socklen_t length = sizeof(peer);
+            socket_t sock = accept(listener, (sockaddr*)&peer, &length);
+            if (sock != SOCKET_INVALID) {
+                clients.push_back({ sock, writer.OpenClient(FormatEndpoint(peer)) });
+            }
+        }
+    }
+    for (RecordingClient& client : clients) {
+        writer.CloseClient(client.id);
+        CloseSocket(client.sock);
+    }
+    CloseSocket(listener);
+    double wall_s = (double)(NanosecondsNow() - start_ns) * 1e-9;
+    if (!writer.Close()) {
+        fprintf(stderr, "could not finish %s\n", out);
+        return 1;
+    }
+
+    uint64_t bytes = 0;
+    for (const CaptureClient& client : writer.Clients()) {
+        bytes += client.bytes;
+    }
+    fprintf(stderr, "%zu clients, %llu bytes in %llu recv calls, %zu messages in %.1f s (%.1f MB/s), %llu bytes written\n",
+        writer.Clients().size(),
+        (unsigned long long)bytes,
+        (unsigned long long)recvs,
+        writer.Messages(),
+        wall_s,
+        wall_s > 0.0 ? (double)bytes / wall_s / 1e6 : 0.0,
+        (unsigned long long)(writer.FileBytes() + sizeof(CaptureHeader)));
+    return 0;
+}
+
+// ---------------------------------------------------------------- read
+
+struct Capture {
+    CaptureHeader                  header = {};
+    std::vector<CaptureClient>     clients;
+    std::vector<CaptureMessage>    messages;
+    std::vector<std::vector<char>> streams;     // by client
+    bool                           indexed = false;
+};
+
+bool ReadCapture(const char* path, Capture& capture)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return false;
+    }
+    std::vector<char> bytes;
+    char block[1 << 16];
+    size_t got;
+    while ((got = fread(block, 1, sizeof(block), file)) > 0) {
+        bytes.insert(bytes.end(), block, block + got);
+    }
+    fclose(file);
+    if (bytes.size() < sizeof(CaptureHeader)) {
+        return false;
+    }
+    memcpy(&capture.header, bytes.data(), sizeof(CaptureHeader));
+    if (memcmp(capture.header.magic, CAPTURE_MAGIC, sizeof(capture.header.magic)) != 0
+        || capture.header.version != CAPTURE_VERSION) {
+        return false;
+    }
+
+    // The footer says where the chunks end; without one they run to the end
+    // of whatever was flushed
+    size_t chunks_end = bytes.size();
+    CaptureFooter footer = {};
+    if (bytes.size() >= sizeof(CaptureHeader) + sizeof(CaptureFooter)) {
+        memcpy(&footer, bytes.data() + bytes.size() - sizeof(footer), sizeof(footer));
+        uint64_t index_size = footer.clients * sizeof(CaptureClient) + footer.messages * sizeof(CaptureMessage);
+        capture.indexed = memcmp(footer.magic, CAPTURE_INDEX_MAGIC, sizeof(footer.magic)) == 0
+            && footer.index_offset >= sizeof(CaptureHeader)
+            && footer.index_offset + index_size + sizeof(footer) == bytes.size();
+        if (capture.indexed) {
+            chunks_end = (size_t)footer.index_offset;
+        }
+    }
+
+    std::vector<CaptureMessage> rebuilt;
+    std::vector<MessageSplitter> splitters;
+    size_t at = sizeof(CaptureHeader);
+    while (at + sizeof(CaptureChunk) <= chunks_end) {
+        CaptureChunk chunk;
+        memcpy(&chunk, bytes.data() + at, sizeof(chunk));
+        if (chunk.length > chunks_end - at - sizeof(chunk)) {
+            break;      // cut short by a kill
+        }
+        const char* data = bytes.data() + at + sizeof(chunk);
+        at += sizeof(chunk) + chunk.length;
+        if (chunk.kind == CHUNK_OPEN && chunk.client == capture.streams.size()) {
+            capture.streams.emplace_back();
+            splitters.emplace_back();
+            if (!capture.indexed) {
+                CaptureClient client = {};
+                client.id = chunk.client;
+                client.open_ns = chunk.time_ns;
+                client.close_ns = chunk.time_ns;
+                snprintf(client.peer, sizeof(client.peer), "%.*s", (int)chunk.length, data);
+                capture.clients.push_back(client);
+            }
+            continue;
+        }
+        if (chunk.client >= capture.streams.size()) {
+            return false;
+        }
+        std::vector<char>& stream = capture.streams[chunk.client];
+        if (!capture.indexed) {
+            CaptureClient& client = capture.clients[chunk.client];
+            IndexMessages(chunk.client, chunk.time_ns, data, chunk.length, stream.size(), splitters[chunk.client], rebuilt);
+            client.close_ns = chunk.time_ns;
+            client.bytes += chunk.length;
+        }
+        stream.insert(stream.end(), data, data + chunk.length);
+    }
+
+    if (capture.indexed) {
+        const char* index = bytes.data() + footer.index_offset;
+        capture.clients.resize((size_t)footer.clients);
+        capture.messages.resize((size_t)footer.messages);
+        memcpy(capture.clients.data(), index, capture.clients.size() * sizeof(CaptureClient));
+        memcpy(capture.messages.data(), index + capture.clients.size() * sizeof(CaptureClient), capture.messages.size() * sizeof(CaptureMessage));
+        // The index must describe the streams it came with
+        if (capture.clients.size() != capture.streams.size()) {
+            return false;
+        }
+        for (const CaptureMessage& message : capture.messages) {
+            if (message.client >= capture.streams.size() || message.offset + message.length > capture.streams[message.client].size()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    for (size_t i = 0; i < capture.clients.size(); i++) {
+        uint64_t start = splitters[i].start;
+        if (start < capture.clients[i].bytes) {
+            rebuilt.push_back({ capture.clients[i].close_ns, start, (uint32_t)i, (uint32_t)(capture.clients[i].bytes - start) });
+        }
+    }
+    std::stable_sort(rebuilt.begin(), rebuilt.end(), [](const CaptureMessage& a, const CaptureMessage& b) {
+        return a.time_ns < b.time_ns;
+    });
+    for (const CaptureMessage& message : rebuilt) {
+        capture.clients[message.client].messages++;
+    }
+    capture.messages = std::move(rebuilt);
+    return true;
+}
+
+// FNV-1a, to compare a replay's capture with the original
+uint64_t Fingerprint(const std::vector<char>& stream)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : stream) {
+        hash = (hash ^ (uint8_t)c) * 1099511628211ull;
+    }
+    return hash;
+}
+
+int Info(const char* path)
+{
+    Capture capture;
+    if (!ReadCapture(path, capture)) {
+        fprintf(stderr, "%s: not a capture\n", path);
+        return 1;
+    }
+    printf("%s: %zu clients, %zu messages%s\n", path, capture.clients.size(), capture.messages.size(),
+        capture.indexed ? "" : " (not closed cleanly, index rebuilt from the chunks)");
+    for (const CaptureClient& client : capture.clients) {
+        std::map<std::string, uint64_t> names;
+        const std::vector<char>& stream = capture.streams[client.id];
+        for (const CaptureMessage& message : capture.messages) {
+            if (message.client != client.id) {
+                continue;
+            }
+            std::string line(stream.data() + message.offset, message.length);
+            size_t name = line.find("\"name\":\"");
+            size_t end = name == std::string::npos ? name : line.find('"', name + 8);
+            names[end == std::string::npos ? "other" : line.substr(name + 8, end - name - 8)]++;
+        }
+        double duration_s = (double)(client.close_ns - client.open_ns) * 1e-9;
+        printf("  client %u from %s: %.3f s to %.3f s, %llu bytes, %llu messages (%.1f/s), fingerprint %016llx\n",
+            client.id, client.peer,
+            (double)client.open_ns * 1e-9,
+            (double)client.close_ns * 1e-9,
+            (unsigned long long)client.bytes,
+            (unsigned long long)client.messages,
+            duration_s > 0.0 ? (double)client.messages / duration_s : 0.0,
+            (unsigned long long)Fingerprint(stream));
+        for (const auto& [name, count] : names) {
+            printf("    %s %llu\n", name.c_str(), (unsigned long long)count);
+        }
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------- replay
+
+bool SendAll(socket_t sock, const char* data, size_t size)
+{
+    while (size > 0) {
+        long sent = (long)send(sock, data, size, SOCKET_SEND_FLAGS);
+        if (sent < 0 && SocketLastError() == SOCKET_EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        size -= (size_t)sent;
+    }
+    return true;
+}
+
+double Percentile(std::vector<int64_t>& sorted, double p)
+{
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t index = std::min(sorted.size() - 1, (size_t)(p * (double)sorted.size()));
+    return (double)sorted[index] / 1000.0;
+}
+
+// What happens to a client connection, and when
+struct ReplayEvent {
+    uint64_t time_ns;
+    uint32_t client;
+    uint8_t  kind;
+    size_t   message;           // for CHUNK_DATA
+};
+
+int Replay(const char* path, const char* to, double speed)
+{
+    Capture capture;
+    if (!ReadCapture(path, capture)) {
+        fprintf(stderr, "%s: not a capture\n", path);
+        return 1;
+    }
+    sockaddr_in addr;
+    if (!ParseEndpoint(to, addr)) {
+        fprintf(stderr, "not an address: %s\n", to);
+        return 2;
+    }
+
+    // Connections open and close when they did, messages go in between
+    std::vector<ReplayEvent> events;
+    events.reserve(capture.messages.size() + 2 * capture.clients.size());
+    for (const CaptureClient& client : capture.clients) {
+        events.push_back({ client.open_ns, client.id, CHUNK_OPEN, 0 });
+    }
+    for (size_t i = 0; i < capture.messages.size(); i++) {
+        events.push_back({ capture.messages[i].time_ns, capture.messages[i].client, CHUNK_DATA, i });
+    }
+    for (const CaptureClient& client : capture.clients) {
+        events.push_back({ client.close_ns, client.id, CHUNK_CLOSE, 0 });
+    }
+    std::stable_sort(events.begin(), events.end(), [](const ReplayEvent& a, const ReplayEvent& b) {
+        return a.time_ns < b.time_ns;
+    });
+
+    std::vector<socket_t> socks(capture.clients.size(), SOCKET_INVALID);
+    std::vector<int64_t> lateness;
+    lateness.reserve(capture.messages.size());
+    uint64_t bytes = 0, sends = 0, messages = 0;
+    int failed = 0;
+    int64_t start_ns = NanosecondsNow();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < events.size(); i++) {
+        const ReplayEvent& event = events[i];
+        int64_t due_ns = speed > 0.0 ? (int64_t)((double)event.time_ns / speed) : 0;
+        if (speed > 0.0 && NanosecondsNow() - start_ns < due_ns) {
+            std::this_thread::sleep_until(start + std::chrono::nanoseconds(due_ns));
+        }
+        socket_t& sock = socks[event.client];
+        if (event.kind == CHUNK_OPEN) {
+            sock = socket(AF_INET, SOCK_STREAM, 0);
+            int one = 1;
+            if (sock == SOCKET_INVALID
+                || setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (const char*)&one, sizeof(one)) != 0
+                || connect(sock, (sockaddr*)&addr, sizeof(addr)) != 0) {
+                fprintf(stderr, "client %u could not connect to %s\n", event.client, to);
+                CloseSocket(sock);
+                failed++;
+            }
+            continue;
+        }
+        if (event.kind == CHUNK_CLOSE) {
+            CloseSocket(sock);
+            continue;
+        }
+        if (sock == SOCKET_INVALID) {
+            continue;
+        }
+
+        // This message and the ones after it that are already due, as long as
+        // they are the same client's and follow on in its stream
+        const CaptureMessage& first = capture.messages[event.message];
+        uint64_t length = first.length;
+        int64_t now_ns = NanosecondsNow() - start_ns;
+        size_t last = i;
+        while (last + 1 < events.size() && length < CAPTURE_SEND_SIZE) {
+            const ReplayEvent& next = events[last + 1];
+            const CaptureMessage& message = capture.messages[next.message];
+            if (next.kind != CHUNK_DATA || next.client != event.client
+                || message.offset != first.offset + length
+                || (speed > 0.0 && (int64_t)((double)next.time_ns / speed) > now_ns)) {
+                break;
+            }
+            length += message.length;
+            last++;
+        }
+        for (size_t j = i; j <= last; j++) {
+            lateness.push_back(now_ns - (speed > 0.0 ? (int64_t)((double)events[j].time_ns / speed) : now_ns));
+        }
+        if (!SendAll(sock, capture.streams[event.client].data() + first.offset, (size_t)length)) {
+            fprintf(stderr, "client %u: the receiver closed the connection\n", event.client);
+            CloseSocket(sock);
+            failed++;
+        }
+        bytes += length;
+        messages += last - i + 1;
+        sends++;
+        i = last;
+    }
+    for (socket_t& sock : socks) {
+        CloseSocket(sock);
+    }
+    double wall_s = (double)(NanosecondsNow() - start_ns) * 1e-9;
+
+    std::sort(lateness.begin(), lateness.end());
+    char pace[32];
+    snprintf(pace, sizeof(pace), speed > 0.0 ? "%gx" : "max speed", speed);
+    fprintf(stderr, "%s at %s to %s: %llu messages, %llu bytes in %llu sends, %.3f s\n",
+        path, pace, to,
+        (unsigned long long)messages,
+        (unsigned long long)bytes,
+        (unsigned long long)sends,
+        wall_s);
+    fprintf(stderr, "  %.0f msg/s, %.1f MB/s", wall_s > 0.0 ? (double)messages / wall_s : 0.0, wall_s > 0.0 ? (double)bytes / wall_s / 1e6 : 0.0);
+    if (speed > 0.0) {
+        fprintf(stderr, ", late by p50 %.1f us, p99 %.1f us, max %.1f us",
+            Percentile(lateness, 0.50),
+            Percentile(lateness, 0.99),
+            lateness.empty() ? 0.0 : (double)lateness.back() / 1000.0);
+    }
+    fprintf(stderr, "\n");
+    return failed > 0 ? 1 : 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const char* command = argc > 1 ? argv[1] : "";
+    const char* file = nullptr;
+    const char* listen_at = "127.0.0.1:6746";
+    const char* to = "127.0.0.1:6746";
+    const char* out = "volanta.ovcap";
+    double seconds = 0.0;
+    double speed = 1.0;
+    bool ok = argc > 1;
+    for (int i = 2; i < argc && ok; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--listen") == 0 && has_value) {
+            listen_at = argv[++i];
+        }
+        else if (strcmp(argv[i], "--out") == 0 && has_value) {
+            out = argv[++i];
+        }
+        else if (strcmp(argv[i], "--seconds") == 0 && has_value) {
+            seconds = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--to") == 0 && has_value) {
+            to = argv[++i];
+        }
+        else if (strcmp(argv[i], "--speed") == 0 && has_value) {
+            speed = atof(argv[++i]);
+            ok = speed > 0.0;
+        }
+        else if (strcmp(argv[i], "--max") == 0) {
+            speed = 0.0;
+        }
+        else if (argv[i][0] != '-' && file == nullptr) {
+            file = argv[i];
+        }
+        else {
+            ok = false;
+        }
+    }
+
+    bool record = strcmp(command, "record") == 0;
+    bool replay = strcmp(command, "replay") == 0;
+    bool info = strcmp(command, "info") == 0;
+    if (!ok || !(record || replay || info) || (!record && file == nullptr)) {
+        fprintf(stderr, "usage: %s record [--listen ADDR:PORT] [--out FILE] [--seconds S]\n"
+                        "       %s replay FILE [--to ADDR:PORT] [--speed X | --max]\n"
+                        "       %s info FILE\n", argv[0], argv[0], argv[0]);
+        return 2;
+    }
+
+    SocketStartup();
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+#ifdef SIGPIPE
+    signal(SIGPIPE, SIG_IGN);
+#endif
+    int result = record ? Record(listen_at, out, seconds)
+        : replay ? Replay(file, to, speed)
+        : Info(file);
+    SocketCleanup();
+    return result;
+}